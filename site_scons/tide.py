@@ -232,6 +232,20 @@ class BuildConfig(object):
             if self.is_osx() or self.is_linux():
                 libs = ['boost_system-mt', 'boost_thread-mt']
 
+        elif name is 'sqlite':
+            if self.is_win32():
+                cpppath = [self.tp('sqlite', 'include')]
+                libpath = [self.tp('sqlite', 'lib')]
+            libs = ['sqlite3']
+
+        elif name is 'zlib':
+            if self.is_win32():
+                cpppath = [self.tp('zlib', 'include')]
+                libpath = [self.tp('zlib', 'lib')]
+                libs = ['zlib']
+            else:
+                libs = ['z']
+
         elif name is 'boost_include':
             if not self.is_linux():
                 cpppath = [self.tp('boost', 'include')]
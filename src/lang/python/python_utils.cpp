@@ -643,7 +643,6 @@ namespace tide
             {
                 PyObject* arg = PyTuple_GetItem(args, c);
                 ValueRef kValue = PythonUtils::ToTiValue(arg);
-                Value::Unwrap(kValue);
                 a.push_back(kValue);
             }
 
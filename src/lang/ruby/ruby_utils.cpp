@@ -210,7 +210,6 @@ namespace tide
         {
             VALUE rarg = rb_ary_entry(args, i);
             ValueRef arg = RubyUtils::ToTiValue(rarg);
-            Value::Unwrap(arg);
             kargs.push_back(arg);
         }
 
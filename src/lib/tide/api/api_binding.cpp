@@ -43,6 +43,7 @@ using namespace TideUtils;
 #include "environment_binding.h"
 #include "script_binding.h"
 #include <tide/thread_manager.h>
+#include <tide/thread_pool.h>
 #include <algorithm>
 
 using std::string;
@@ -231,8 +232,9 @@ namespace tide
 
         /**
          * @tiapi(method=True,name=API.createBytes,since=0.9) Create a Tide Bytes object.
-         * @tiarg[String, contents, optional=true] The contents of the new Bytes.
-         * @tiarg The blob will be empty if none are given.
+         * @tiarg[String|Number|Array, contents, optional=true] The contents of the new Bytes:
+         * @tiarg a string, a size, or an array (or Uint8Array) of byte values. The blob
+         * @tiarg will be empty if none are given.
          * @tiresult[Bytes] A new Bytes.
          */
         this->SetMethod("createBytes", &APIBinding::_CreateBytes);
@@ -322,6 +324,85 @@ namespace tide
          * @tiarg[Any, data] data to print
          */
         this->SetMethod("print", &APIBinding::_Print);
+
+        /**
+         * @tiapi(method=True,name=API.getThreadPoolStats,since=1.3.2)
+         * @tiapi Get the counters of the shared background thread pool
+         * @tiresult[Object] an object with the threads, idle, queued, executed, stolen,
+         * @tiresult rejected and reaped counts and the total, average and maximum
+         * @tiresult time (in milliseconds) that jobs spent waiting in the queue
+         */
+        this->SetMethod("getThreadPoolStats", &APIBinding::_GetThreadPoolStats);
+
+        /**
+         * @tiapi(method=True,name=API.getMainThreadQueueStats,since=1.3.2)
+         * @tiapi Get the counters of the queue of jobs waiting to run on the main thread
+         * @tiresult[Object] an object with the current and maximum depth, the number of
+         * @tiresult executed and coalesced jobs, and latency and depth histograms (lists
+         * @tiresult of objects with a bucket upper bound "max" and a "count")
+         */
+        this->SetMethod("getMainThreadQueueStats", &APIBinding::_GetMainThreadQueueStats);
+
+        /**
+         * @tiapi(method=True,name=API.setMainThreadJobBudget,since=1.3.2)
+         * @tiapi Set the time the main thread may spend running queued jobs before
+         * @tiapi yielding back to the user interface
+         * @tiarg[Number, milliseconds] the time budget per turn of the event loop
+         */
+        this->SetMethod("setMainThreadJobBudget", &APIBinding::_SetMainThreadJobBudget);
+
+        /**
+         * @tiapi(method=True,name=API.getMainThreadJobBudget,since=1.3.2)
+         * @tiapi Get the time the main thread may spend running queued jobs before
+         * @tiapi yielding back to the user interface
+         * @tiresult[Number] the time budget per turn of the event loop in milliseconds
+         */
+        this->SetMethod("getMainThreadJobBudget", &APIBinding::_GetMainThreadJobBudget);
+
+        /**
+         * @tiapi(method=True,name=API.startProfiling,since=1.3.2)
+         * @tiapi Start recording the time spent in API calls and property accesses
+         * @tiarg[Boolean, clear, optional=True] false to keep what an earlier run
+         * @tiarg recorded (default: true)
+         */
+        this->SetMethod("startProfiling", &APIBinding::_StartProfiling);
+
+        /**
+         * @tiapi(method=True,name=API.stopProfiling,since=1.3.2)
+         * @tiapi Stop recording API calls. What has been recorded is kept until
+         * @tiapi the profiler is cleared or started again.
+         */
+        this->SetMethod("stopProfiling", &APIBinding::_StopProfiling);
+
+        /**
+         * @tiapi(method=True,name=API.isProfiling,since=1.3.2)
+         * @tiresult[Boolean] true if the profiler is recording, false otherwise
+         */
+        this->SetMethod("isProfiling", &APIBinding::_IsProfiling);
+
+        /**
+         * @tiapi(method=True,name=API.clearProfile,since=1.3.2)
+         * @tiapi Discard everything the profiler has recorded
+         */
+        this->SetMethod("clearProfile", &APIBinding::_ClearProfile);
+
+        /**
+         * @tiapi(method=True,name=API.getProfileStats,since=1.3.2)
+         * @tiapi Get the profiler's counters for every recorded API path
+         * @tiresult[Object] an object with the number of recorded and dropped events and a
+         * @tiresult "paths" list holding, for each path (eg. "Filesystem.getFile"), the
+         * @tiresult type, count, total, average and maximum time in milliseconds and a
+         * @tiresult latency histogram, ordered by total time
+         */
+        this->SetMethod("getProfileStats", &APIBinding::_GetProfileStats);
+
+        /**
+         * @tiapi(method=True,name=API.writeProfileTrace,since=1.3.2)
+         * @tiapi Write every recorded event to a file in the Chrome trace event format,
+         * @tiapi which can be loaded into chrome://tracing
+         * @tiarg[String, path] the path of the file to write
+         */
+        this->SetMethod("writeProfileTrace", &APIBinding::_WriteProfileTrace);
     
         // These are properties for log severity levels
 
@@ -527,6 +608,59 @@ namespace tide
         result->SetInt(Logger::GetRootLogger()->GetLevel());
     }
 
+    void APIBinding::_GetThreadPoolStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(host->GetThreadPool()->GetStatsObject());
+    }
+
+    void APIBinding::_GetMainThreadQueueStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(host->GetMainThreadJobQueue().GetStatsObject());
+    }
+
+    void APIBinding::_SetMainThreadJobBudget(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setMainThreadJobBudget", "n");
+        host->SetMainThreadJobBudget(args.GetInt(0));
+    }
+
+    void APIBinding::_GetMainThreadJobBudget(const ValueList& args, ValueRef result)
+    {
+        result->SetInt(host->GetMainThreadJobBudget());
+    }
+
+    void APIBinding::_StartProfiling(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("startProfiling", "?b");
+        Profiler::Start(args.GetBool(0, true));
+    }
+
+    void APIBinding::_StopProfiling(const ValueList& args, ValueRef result)
+    {
+        Profiler::Stop();
+    }
+
+    void APIBinding::_IsProfiling(const ValueList& args, ValueRef result)
+    {
+        result->SetBool(Profiler::IsEnabled());
+    }
+
+    void APIBinding::_ClearProfile(const ValueList& args, ValueRef result)
+    {
+        Profiler::Clear();
+    }
+
+    void APIBinding::_GetProfileStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(Profiler::GetStatsObject());
+    }
+
+    void APIBinding::_WriteProfileTrace(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("writeProfileTrace", "s");
+        Profiler::WriteTrace(args.GetString(0));
+    }
+
     void APIBinding::_Print(const ValueList& args, ValueRef result)
     {
         for (size_t c=0; c < args.size(); c++)
@@ -988,9 +1122,10 @@ namespace tide
     
     void APIBinding::_CreateBytes(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("createBytes", "?s|n");
+        args.VerifyException("createBytes", "?s|n|l|o");
 
         BytesRef bytes;
+        std::string data;
 
         if (args.size() == 0)
         {
@@ -1001,10 +1136,19 @@ namespace tide
             std::string str(args.GetString(0));
             bytes = new Bytes(str);
         }
-        else
+        else if (args.at(0)->IsNumber())
         {
             bytes = new Bytes(args.GetInt(0));
         }
+        else if (Bytes::ReadArray(args.at(0), data))
+        {
+            bytes = new Bytes(data.data(), data.size());
+        }
+        else
+        {
+            throw ValueException::FromString(
+                "createBytes expects a string, a size or an array of numbers");
+        }
 
         result->SetObject(bytes);
     }
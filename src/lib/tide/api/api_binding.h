@@ -86,6 +86,16 @@ namespace tide
         void _GetLogLevel(const ValueList& args, ValueRef result);
         void _RunOnMainThread(const ValueList& args, ValueRef result);
         void _RunOnMainThreadAsync(const ValueList& args, ValueRef result);
+        void _GetThreadPoolStats(const ValueList& args, ValueRef result);
+        void _GetMainThreadQueueStats(const ValueList& args, ValueRef result);
+        void _SetMainThreadJobBudget(const ValueList& args, ValueRef result);
+        void _GetMainThreadJobBudget(const ValueList& args, ValueRef result);
+        void _StartProfiling(const ValueList& args, ValueRef result);
+        void _StopProfiling(const ValueList& args, ValueRef result);
+        void _IsProfiling(const ValueList& args, ValueRef result);
+        void _ClearProfile(const ValueList& args, ValueRef result);
+        void _GetProfileStats(const ValueList& args, ValueRef result);
+        void _WriteProfileTrace(const ValueList& args, ValueRef result);
 
         void _Print(const ValueList& args, ValueRef result);
         void _Log(const ValueList& args, ValueRef result);
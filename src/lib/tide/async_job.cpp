@@ -34,19 +34,30 @@
 
 #include "tide.h"
 #include "thread_manager.h"
-#include <Poco/Bugcheck.h>
+#include "thread_pool.h"
 
 namespace tide
 {
+    /**
+     * Keeps an AsyncJob alive while it sits in the thread pool queue.
+     */
+    class AsyncJobRunnable : public Poco::Runnable
+    {
+    public:
+        AsyncJobRunnable(AsyncJob* job) : job(job, true) {}
+        void run() { this->job->RunThreadTarget(); }
+
+    private:
+        AutoPtr<AsyncJob> job;
+    };
+
     AsyncJob::AsyncJob(TiMethodRef job) :
         StaticBoundObject(),
         job(job),
         completed(false),
         result(Value::Undefined),
         hadError(false),
-        cancelled(false),
-        thread(0),
-        adapter(0)
+        cancelled(false)
     {
         this->SetProgress(0.0);
         this->SetMethod("getProgress", &AsyncJob::_GetProgress);
@@ -64,30 +75,22 @@ namespace tide
 
     void AsyncJob::RunAsynchronously()
     {
-        this->adapter = new Poco::RunnableAdapter<AsyncJob>(*this,
-            &AsyncJob::RunThreadTarget);
-        this->thread = new Poco::Thread();
-        this->thread->start(*this->adapter);
+        SharedRunnable runnable(new AsyncJobRunnable(this));
+        if (!Host::GetInstance()->GetThreadPool()->start(runnable))
+        {
+            throw ValueException::FromString(
+                "Too many pending asynchronous jobs, try again later");
+        }
     }
 
     void AsyncJob::RunThreadTarget()
     {
-        // We are now in a new thread -- on OSX we need to do some 
+        // We are now in a pooled thread -- on OSX we need to do some 
         // basic bookkeeping for the reference counter, but other
         // than that, everything past here is like executing a job
         // in a synchronous fashion.
         START_TIDE_THREAD;
         this->Run();
-
-        try
-        {
-            delete this->adapter;
-        }
-        catch (Poco::BugcheckException& bge)
-        {
-            std::cerr << bge.what() << std::endl;
-        }
-
         END_TIDE_THREAD;
     }
 
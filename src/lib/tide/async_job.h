@@ -58,13 +58,14 @@ namespace tide
         void Run();
 
         /*
-         * Run an async job asynchronously (on the different thread).
+         * Run an async job asynchronously (on a thread of the
+         * host's shared thread pool).
          */
         void RunAsynchronously();
 
         /*
          * The target method of an asynchronous job execution. This does
-         * whatever bookkeeping is necessary at the start of a new thread
+         * whatever bookkeeping is necessary on the pooled thread
          * and then calls Run().
          */
         void RunThreadTarget();
@@ -74,6 +75,12 @@ namespace tide
          */
         void Cancel();
 
+        /**
+         * Whether someone has asked for this job to stop. Long-running
+         * jobs should check this periodically and return early.
+         */
+        bool IsCancelled() { return cancelled; }
+
         /**
          * The result of the execution of this job. On an execution
          * error and before the job is completed this will be Undefined;
@@ -170,8 +177,6 @@ namespace tide
         std::vector<TiMethodRef> completedCallbacks;
         std::vector<TiMethodRef> errorCallbacks;
 
-        Poco::Thread* thread;
-        Poco::RunnableAdapter<AsyncJob>* adapter;
         void DoCallback(TiMethodRef, bool reportErrors=false);
     };
 }
@@ -0,0 +1,130 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _TIDE_ATOMIC_H_
+#define _TIDE_ATOMIC_H_
+
+#ifdef OS_WIN32
+#include <windows.h>
+#endif
+
+namespace tide
+{
+    /**
+     * The handful of atomic primitives needed by the lock-free queues.
+     * Poco::AtomicCounter only covers increment and decrement, so these
+     * map straight onto the compiler / platform intrinsics.
+     */
+    namespace Atomic
+    {
+        inline void Barrier()
+        {
+#ifdef OS_WIN32
+            MemoryBarrier();
+#else
+            __sync_synchronize();
+#endif
+        }
+
+        inline unsigned int Load(volatile unsigned int* value)
+        {
+            unsigned int result = *value;
+            Barrier();
+            return result;
+        }
+
+        inline void Store(volatile unsigned int* value, unsigned int newValue)
+        {
+            Barrier();
+            *value = newValue;
+        }
+
+        // Unlike Poco::AtomicCounter these work on plain integers, which
+        // are zero before any static constructor has run.
+        inline unsigned int Increment(volatile unsigned int* value)
+        {
+#ifdef OS_WIN32
+            return (unsigned int) InterlockedIncrement((volatile LONG*) value);
+#else
+            return __sync_add_and_fetch(value, 1);
+#endif
+        }
+
+        inline unsigned int Decrement(volatile unsigned int* value)
+        {
+#ifdef OS_WIN32
+            return (unsigned int) InterlockedDecrement((volatile LONG*) value);
+#else
+            return __sync_sub_and_fetch(value, 1);
+#endif
+        }
+
+        inline bool CompareAndSwap(volatile unsigned int* value,
+            unsigned int oldValue, unsigned int newValue)
+        {
+#ifdef OS_WIN32
+            return InterlockedCompareExchange((volatile LONG*) value,
+                (LONG) newValue, (LONG) oldValue) == (LONG) oldValue;
+#else
+            return __sync_bool_compare_and_swap(value, oldValue, newValue);
+#endif
+        }
+
+        inline void* LoadPointer(void* volatile* value)
+        {
+            void* result = *value;
+            Barrier();
+            return result;
+        }
+
+        inline void StorePointer(void* volatile* value, void* newValue)
+        {
+            Barrier();
+            *value = newValue;
+        }
+
+        inline bool CompareAndSwapPointer(void* volatile* value,
+            void* oldValue, void* newValue)
+        {
+#ifdef OS_WIN32
+            return InterlockedCompareExchangePointer(value,
+                newValue, oldValue) == oldValue;
+#else
+            return __sync_bool_compare_and_swap(value, oldValue, newValue);
+#endif
+        }
+    }
+}
+
+#endif
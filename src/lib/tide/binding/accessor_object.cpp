@@ -38,24 +38,54 @@
 
 namespace tide
 {
-    AccessorObject::AccessorObject(const char* name)
-        : StaticBoundObject(name)
+    AccessorObject::AccessorObject(const char* name, const Prototype* prototype)
+        : StaticBoundObject(name, prototype)
     {
     }
 
     bool AccessorObject::HasProperty(const char* name)
     {
-        return StaticBoundObject::HasProperty(name) || this->HasGetterFor(name);
+        return StaticBoundObject::HasProperty(name) || this->HasGetterFor(name) ||
+            (this->prototype && this->prototype->FindGetter(name));
     }
 
     void AccessorObject::Set(const char* name, ValueRef value)
     {
-        if (!this->UseSetter(name, value, StaticBoundObject::Get(name)))
-            StaticBoundObject::Set(name, value);
+        ValueRef existingValue(StaticBoundObject::Get(name));
+        if (this->UseSetter(name, value, existingValue))
+            return;
+
+        // Accessors recorded on the instance take precedence over the
+        // ones its prototype provides.
+        if (existingValue->IsUndefined() && this->prototype)
+        {
+            ValueRef setter(this->PrototypeAccessor(this->prototype->FindSetter(name)));
+            if (setter->IsMethod())
+            {
+                setter->ToMethod()->Call(value);
+                return;
+            }
+        }
+
+        StaticBoundObject::Set(name, value);
     }
 
     ValueRef AccessorObject::Get(const char* name)
     {
-        return this->UseGetter(name, StaticBoundObject::Get(name));
+        ValueRef value(this->UseGetter(name, StaticBoundObject::Get(name)));
+        if (!value->IsUndefined() || !this->prototype)
+            return value;
+
+        ValueRef getter(this->PrototypeAccessor(this->prototype->FindGetter(name)));
+        if (!getter->IsMethod())
+            return value;
+        return getter->ToMethod()->Call();
+    }
+
+    ValueRef AccessorObject::PrototypeAccessor(const Atom* accessor)
+    {
+        if (!accessor)
+            return Value::Undefined;
+        return StaticBoundObject::Get(accessor->Name());
     }
 }
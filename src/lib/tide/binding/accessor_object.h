@@ -40,12 +40,15 @@ namespace tide
     class TIDE_API AccessorObject : public StaticBoundObject, public Accessor
     {
     public:
-        AccessorObject(const char* name = "AccessorObject");
+        AccessorObject(const char* name = "AccessorObject",
+            const Prototype* prototype = 0);
         virtual void Set(const char* name, ValueRef value);
         virtual ValueRef Get(const char* name);
         virtual bool HasProperty(const char* name);
 
     private:
+        ValueRef PrototypeAccessor(const Atom* accessor);
+
         DISALLOW_EVIL_CONSTRUCTORS(AccessorObject);
     };
 }
@@ -40,62 +40,57 @@ namespace tide
 
     ArgList::ArgList()
     {
-        this->args = new std::vector<ValueRef>;
     }
 
     ArgList::ArgList(ValueRef a)
     {
-        this->args = new std::vector<ValueRef>;
-        this->args->push_back(a);
+        this->args.push_back(a);
     }
 
     ArgList::ArgList(ValueRef a, ValueRef b)
     {
-        this->args = new std::vector<ValueRef>;
-        this->args->push_back(a);
-        this->args->push_back(b);
+        this->args.push_back(a);
+        this->args.push_back(b);
     }
 
     ArgList::ArgList(ValueRef a, ValueRef b, ValueRef c)
     {
-        this->args = new std::vector<ValueRef>;
-        this->args->push_back(a);
-        this->args->push_back(b);
-        this->args->push_back(c);
+        this->args.push_back(a);
+        this->args.push_back(b);
+        this->args.push_back(c);
     }
 
     ArgList::ArgList(ValueRef a, ValueRef b, ValueRef c, ValueRef d)
     {
-        this->args = new std::vector<ValueRef>;
-        this->args->push_back(a);
-        this->args->push_back(b);
-        this->args->push_back(c);
-        this->args->push_back(d);
+        this->args.push_back(a);
+        this->args.push_back(b);
+        this->args.push_back(c);
+        this->args.push_back(d);
     }
 
-    ArgList::ArgList(const ArgList& other)
+    ArgList::ArgList(const ArgList& other) :
+        args(other.args)
     {
-        this->args = other.args;
     }
 
     void ArgList::push_back(ValueRef v)
     {
-        this->args->push_back(v);
+        this->args.push_back(v);
     }
 
     size_t ArgList::size() const
     {
-        return this->args->size();
+        return this->args.size();
     }
 
     const ValueRef& ArgList::at(size_t index) const
     {
-        return this->args->at(index);
+        return this->args.at(index);
     }
 
     const ValueRef& ArgList::operator[](size_t index) const
     {
-        return this->args->at(index);
+        return this->args.at(index);
     }
 
     std::string ArgList::GenerateSignature(const char* name,
@@ -39,6 +39,7 @@
 #include <string>
 #include <map>
 #include "callback.h"
+#include "small_value_list.h"
 
 namespace tide
 {
@@ -79,7 +80,7 @@ namespace tide
         TiListRef GetList(size_t index, TiListRef defaultValue=NULL) const;
 
         private:
-        SharedPtr<std::vector<ValueRef> > args;
+        SmallValueList args;
 
         static inline bool VerifyArg(ValueRef arg, char t);
         static std::string GenerateSignature(const char* name, std::string& argSpec);
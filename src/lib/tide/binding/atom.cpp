@@ -0,0 +1,190 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "../tide.h"
+#include "../atomic.h"
+#include <cstring>
+#include <cstdlib>
+#include <Poco/Mutex.h>
+
+namespace tide
+{
+    // The intern table is an insert-only, open-addressed array of Atom
+    // pointers. Readers probe it without locking; writers take the mutex,
+    // publish each new slot with a barrier and swap in a larger table when
+    // it becomes half full. Superseded tables are never freed, since a
+    // reader may still be probing them, but they only ever total the size
+    // of the current table.
+    struct AtomTable
+    {
+        size_t capacity;
+        size_t count;
+        const Atom* volatile* slots;
+    };
+
+    static const size_t INITIAL_ATOM_CAPACITY = 1024;
+
+    static AtomTable* NewAtomTable(size_t capacity)
+    {
+        AtomTable* table = new AtomTable();
+        table->capacity = capacity;
+        table->count = 0;
+        table->slots = new const Atom* volatile[capacity];
+        for (size_t i = 0; i < capacity; i++)
+            table->slots[i] = 0;
+        return table;
+    }
+
+    // Bound objects may be created during static initialization, so the
+    // table is created on first use rather than at load time.
+    static AtomTable* volatile& CurrentTable()
+    {
+        static AtomTable* volatile table = NewAtomTable(INITIAL_ATOM_CAPACITY);
+        return table;
+    }
+
+    static Poco::FastMutex& InternMutex()
+    {
+        static Poco::FastMutex* mutex = new Poco::FastMutex();
+        return *mutex;
+    }
+
+    static const Atom* LoadAtom(const Atom* volatile* slot)
+    {
+        return (const Atom*) Atomic::LoadPointer((void* volatile*) slot);
+    }
+
+    static const Atom* FindInTable(AtomTable* table, const char* name, unsigned int hash)
+    {
+        size_t mask = table->capacity - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            const Atom* atom = LoadAtom(&table->slots[i]);
+            if (!atom)
+                return 0;
+            if (atom->Matches(name, hash))
+                return atom;
+        }
+    }
+
+    static void InsertIntoTable(AtomTable* table, const Atom* atom)
+    {
+        size_t mask = table->capacity - 1;
+        size_t i = atom->HashCode() & mask;
+        while (table->slots[i])
+            i = (i + 1) & mask;
+
+        Atomic::StorePointer((void* volatile*) &table->slots[i], (void*) atom);
+        table->count++;
+    }
+
+    Atom::Atom(const char* name, unsigned int hash, bool interned) :
+        name(strdup(name)),
+        hash(hash),
+        interned(interned)
+    {
+    }
+
+    Atom::~Atom()
+    {
+        free((void*) name);
+    }
+
+    const Atom* Atom::NewLocal(const char* name, unsigned int hash)
+    {
+        return new Atom(name, hash, false);
+    }
+
+    void Atom::DeleteLocal(const Atom* atom)
+    {
+        if (atom && !atom->interned)
+            delete atom;
+    }
+
+    bool Atom::Matches(const char* name, unsigned int hash) const
+    {
+        return this->hash == hash && !strcmp(this->name, name);
+    }
+
+    unsigned int Atom::Hash(const char* name)
+    {
+        // FNV-1a
+        unsigned int hash = 2166136261U;
+        while (*name)
+        {
+            hash ^= (unsigned char) *name++;
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    const Atom* Atom::Find(const char* name)
+    {
+        AtomTable* table = (AtomTable*) Atomic::LoadPointer((void* volatile*) &CurrentTable());
+        return FindInTable(table, name, Hash(name));
+    }
+
+    const Atom* Atom::Intern(const char* name)
+    {
+        unsigned int hash = Hash(name);
+        AtomTable* table = (AtomTable*) Atomic::LoadPointer((void* volatile*) &CurrentTable());
+        const Atom* atom = FindInTable(table, name, hash);
+        if (atom)
+            return atom;
+
+        Poco::FastMutex::ScopedLock lock(InternMutex());
+
+        // Someone may have interned this name while we waited for the lock.
+        table = CurrentTable();
+        atom = FindInTable(table, name, hash);
+        if (atom)
+            return atom;
+
+        if ((table->count + 1) * 2 > table->capacity)
+        {
+            AtomTable* larger = NewAtomTable(table->capacity * 2);
+            for (size_t i = 0; i < table->capacity; i++)
+            {
+                if (table->slots[i])
+                    InsertIntoTable(larger, table->slots[i]);
+            }
+            Atomic::StorePointer((void* volatile*) &CurrentTable(), larger);
+            table = larger;
+        }
+
+        atom = new Atom(name, hash, true);
+        InsertIntoTable(table, atom);
+        return atom;
+    }
+}
@@ -0,0 +1,95 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _ATOM_H_
+#define _ATOM_H_
+
+namespace tide
+{
+    /**
+     * A unique, interned copy of a property name. There is only ever one
+     * interned Atom for a given string, so once a name has been interned it
+     * can be compared by pointer. Interned Atoms live for the lifetime of the
+     * process, so only names known to native code should be interned.
+     * Find() never blocks, so it is safe to call on hot paths.
+     *
+     * Names which come from script instead get a local Atom, which is not
+     * interned and belongs to whoever created it. It only equals an Atom
+     * with the same name by comparing names, see Matches().
+     */
+    class TIDE_API Atom
+    {
+    public:
+        /**
+         * Return the Atom for the given name, creating it if necessary.
+         */
+        static const Atom* Intern(const char* name);
+
+        /**
+         * Return the Atom for the given name or NULL if the name
+         * has never been interned.
+         */
+        static const Atom* Find(const char* name);
+
+        /**
+         * Create a local Atom for the given name. Free it with DeleteLocal.
+         */
+        static const Atom* NewLocal(const char* name, unsigned int hash);
+        static void DeleteLocal(const Atom* atom);
+
+        static unsigned int Hash(const char* name);
+
+        const char* Name() const { return name; }
+        unsigned int HashCode() const { return hash; }
+        bool IsInterned() const { return interned; }
+
+        bool Matches(const char* name, unsigned int hash) const;
+        bool Matches(const Atom* atom) const
+        {
+            // Two interned Atoms are only equal if they are the same one.
+            return atom == this || ((!interned || !atom->interned) &&
+                Matches(atom->name, atom->hash));
+        }
+
+    private:
+        Atom(const char* name, unsigned int hash, bool interned);
+        ~Atom();
+
+        const char* name;
+        unsigned int hash;
+        bool interned;
+    };
+}
+
+#endif
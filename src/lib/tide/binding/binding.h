@@ -42,16 +42,18 @@ namespace tide
     class Event;
     class EventListener;
     class EventObject;
-    class ProfiledGlobalObject;
 }
 
 #include "object.h"
 #include "method.h"
 #include "list.h"
 #include "value.h"
+#include "atom.h"
+#include "property_table.h"
 #include "static_bound_list.h"
 #include "static_bound_method.h"
 #include "static_bound_object.h"
+#include "prototype.h"
 #include "function_ptr_method.h"
 #include "arg_list.h"
 #include "value_exception.h"
@@ -68,11 +70,7 @@ namespace tide
 #include "read_event.h"
 #include "event_object.h"
 #include "event_method.h"
-#include "profiled_bound_object.h"
-#include "profiled_bound_list.h"
-#include "profiled_bound_method.h"
 #include "global_object.h"
-#include "profiled_global_object.h"
 #include "stream.h"
 
 #endif
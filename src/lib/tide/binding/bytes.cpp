@@ -33,58 +33,208 @@
 **/
 
 #include "bytes.h"
+#include "../atomic.h"
 #include <cstring>
-#include <Poco/String.h>
-#include <Poco/StringTokenizer.h>
+#include <climits>
+#include <cstdio>
+#include <cmath>
+#include <Poco/Mutex.h>
 
 namespace tide
 {
+    // Small buffers are handed out from power-of-two size classes and
+    // recycled, since pipe, socket and HTTP reads churn through many
+    // short-lived Bytes of similar sizes. Anything larger than the biggest
+    // class goes straight to the heap.
+    static const size_t MIN_CLASS_SHIFT = 6; // 64 bytes
+    static const size_t MAX_CLASS_SHIFT = 16; // 64 kilobytes
+    static const size_t CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static const size_t MAX_FREE_PER_CLASS = 64;
+
+    // Array-like objects are read one element at a time, so a length past
+    // this is taken to be a bogus object rather than something to allocate.
+    static const double MAX_ARRAY_LENGTH = 64 * 1024 * 1024;
+
+    struct BytesSizeClass
+    {
+        Poco::FastMutex mutex;
+        std::vector<char*> freeBuffers;
+    };
+
+    // Intentionally leaked so that Bytes which outlive static
+    // destruction can still return their buffers safely.
+    static BytesSizeClass* sizeClasses = new BytesSizeClass[CLASS_COUNT];
+
+    static int SizeClassFor(size_t size)
+    {
+        size_t shift = MIN_CLASS_SHIFT;
+        while (shift <= MAX_CLASS_SHIFT)
+        {
+            if (size <= ((size_t) 1 << shift))
+                return shift - MIN_CLASS_SHIFT;
+            shift++;
+        }
+        return -1;
+    }
+
+    static char* AllocateBuffer(size_t size)
+    {
+        if (size == 0)
+            return 0;
+
+        int sizeClass = SizeClassFor(size);
+        if (sizeClass < 0)
+            return new char[size];
+
+        BytesSizeClass& bucket = sizeClasses[sizeClass];
+        {
+            Poco::FastMutex::ScopedLock lock(bucket.mutex);
+            if (!bucket.freeBuffers.empty())
+            {
+                char* buffer = bucket.freeBuffers.back();
+                bucket.freeBuffers.pop_back();
+                return buffer;
+            }
+        }
+        return new char[(size_t) 1 << (sizeClass + MIN_CLASS_SHIFT)];
+    }
+
+    static void ReleaseBuffer(char* buffer, size_t size)
+    {
+        if (!buffer)
+            return;
+
+        int sizeClass = SizeClassFor(size);
+        if (sizeClass >= 0)
+        {
+            BytesSizeClass& bucket = sizeClasses[sizeClass];
+            Poco::FastMutex::ScopedLock lock(bucket.mutex);
+            if (bucket.freeBuffers.size() < MAX_FREE_PER_CLASS)
+            {
+                bucket.freeBuffers.push_back(buffer);
+                return;
+            }
+        }
+        delete [] buffer;
+    }
+
+    // Find needle in haystack, letting memchr do the scanning for the first
+    // byte, which libc implements with vector instructions on most platforms.
+    static const char* FindBytes(const char* haystack, size_t haystackLength,
+        const char* needle, size_t needleLength)
+    {
+        if (needleLength == 0)
+            return haystack;
+        if (needleLength > haystackLength)
+            return 0;
+
+        const char* end = haystack + (haystackLength - needleLength) + 1;
+        const char* cursor = haystack;
+        while (cursor < end)
+        {
+            cursor = (const char*) memchr(cursor, needle[0], end - cursor);
+            if (!cursor)
+                return 0;
+            if (memcmp(cursor + 1, needle + 1, needleLength - 1) == 0)
+                return cursor;
+            cursor++;
+        }
+        return 0;
+    }
+
+    static const char* FindLastBytes(const char* haystack, size_t haystackLength,
+        const char* needle, size_t needleLength, size_t start)
+    {
+        if (needleLength > haystackLength)
+            return 0;
+
+        size_t position = haystackLength - needleLength;
+        if (start < position)
+            position = start;
+
+        while (true)
+        {
+            if (memcmp(haystack + position, needle, needleLength) == 0)
+                return haystack + position;
+            if (position == 0)
+                return 0;
+            position--;
+        }
+    }
+
+    BytesStorage::BytesStorage(size_t size) :
+        data(AllocateBuffer(size)),
+        size(size)
+    {
+    }
+
+    BytesStorage::~BytesStorage()
+    {
+        ReleaseBuffer(this->data, this->size);
+    }
+
     Bytes::Bytes() :
-        StaticBoundObject("Bytes"),
+        StaticBoundObject("Bytes", Bytes::GetPrototype()),
         buffer(0),
-        size(0)
+        size(0),
+        lazy(false)
     {
         this->SetupBinding();
     }
 
     Bytes::Bytes(size_t size) :
-        StaticBoundObject("Bytes"),
-        size(size)
+        StaticBoundObject("Bytes", Bytes::GetPrototype()),
+        size(size),
+        lazy(false),
+        storage(new BytesStorage(size))
     {
-        this->buffer = new char[size];
+        this->buffer = this->storage->data;
         this->SetupBinding();
     }
 
     Bytes::Bytes(BytesRef source, size_t offset, size_t length) :
-        StaticBoundObject("Bytes")
+        StaticBoundObject("Bytes", Bytes::GetPrototype()),
+        lazy(false)
     {
-        this->size = (length > 0) ? length : source->Length() - offset;
+        size_t sourceLength = source->Length();
+        if (offset > sourceLength)
+            offset = sourceLength;
+        if (length == (size_t) -1 || length > sourceLength - offset)
+            length = sourceLength - offset;
+
+        this->size = length;
         this->buffer = source->Pointer() + offset;
-        this->source = source;
+
+        // Share the memory itself, so that neither the source nor slices
+        // of slices are kept alive just because this slice is.
+        this->storage = source->storage;
         this->SetupBinding();
     }
 
-    Bytes::Bytes(std::string& str) : StaticBoundObject("Bytes")
+    Bytes::Bytes(std::string& str) :
+        StaticBoundObject("Bytes", Bytes::GetPrototype()),
+        size(str.length()),
+        lazy(false),
+        storage(new BytesStorage(str.length()))
     {
-        this->size = str.length();
-        this->buffer = new char[this->size];
-        memcpy(this->buffer, str.c_str(), this->size);
+        this->buffer = this->storage->data;
+        memcpy(this->buffer, str.data(), this->size);
         this->SetupBinding();
     }
 
     Bytes::Bytes(const char* str, size_t length) :
-        StaticBoundObject("Bytes")
+        StaticBoundObject("Bytes", Bytes::GetPrototype()),
+        size((length == (size_t) -1) ? strlen(str) : length),
+        lazy(false)
     {
-        this->size = (length > 0) ? length : strlen(str);
-        this->buffer = new char[this->size];
+        this->storage = new BytesStorage(this->size);
+        this->buffer = this->storage->data;
         memcpy(this->buffer, str, this->size);
         this->SetupBinding();
     }
 
     Bytes::~Bytes()
     {
-        if (this->source.isNull() && this->buffer)
-            delete [] this->buffer;
     }
 
     size_t Bytes::ExtraMemoryCost()
@@ -92,8 +242,29 @@ namespace tide
         return this->size;
     }
 
+    void Bytes::Detach()
+    {
+        if (this->lazy)
+            this->Flatten();
+
+        // Memory shared with a slice or chain is left to the others, and
+        // this object writes to a private copy of its region. The old
+        // storage goes away with the last of them.
+        if (!this->storage.isNull() && this->storage->referenceCount() > 1)
+        {
+            AutoPtr<BytesStorage> copy(new BytesStorage(this->size));
+            memcpy(copy->data, this->buffer, this->size);
+            this->storage = copy;
+            this->buffer = copy->data;
+        }
+    }
+
     size_t Bytes::Write(const char* data, size_t length, size_t offset)
     {
+        if (offset >= this->size)
+            return 0;
+
+        this->Detach();
         size_t maxWriteSize = this->size - offset;
         size_t writeSize = (length > maxWriteSize) ? maxWriteSize : length;
         memcpy(this->buffer + offset, data, writeSize);
@@ -102,39 +273,125 @@ namespace tide
 
     size_t Bytes::Write(BytesRef source, size_t offset)
     {
-        return this->Write(source->Pointer(), source->Length(), offset);
+        std::vector<BytesRef> segments;
+        source->GetSegments(segments);
+
+        size_t written = 0;
+        for (size_t i = 0; i < segments.size(); i++)
+        {
+            BytesRef segment(segments[i]);
+            size_t count = this->Write(segment->Pointer(), segment->Length(), offset + written);
+            written += count;
+            if (count < segment->Length())
+                break;
+        }
+        return written;
     }
 
     std::string Bytes::AsString()
     {
-        if (this->size > 0)
-            return std::string(this->buffer, this->size);
-        else
+        if (this->size == 0)
             return std::string("");
+
+        if (!this->lazy)
+            return std::string(this->buffer, this->size);
+
+        std::vector<BytesRef> segments;
+        this->GetSegments(segments);
+
+        std::string result;
+        result.reserve(this->size);
+        for (size_t i = 0; i < segments.size(); i++)
+            result.append(segments[i]->Pointer(), segments[i]->Length());
+        return result;
     }
 
-    void Bytes::SetupBinding()
+    /*static*/
+    bool Bytes::ReadArray(ValueRef value, std::string& data)
+    {
+        if (value->IsList())
+        {
+            TiListRef list(value->ToList());
+            size_t length = list->Size();
+            data.resize(length);
+            for (size_t i = 0; i < length; i++)
+            {
+                ValueRef element(list->At(i));
+                data[i] = element->IsNumber() ? (char) (int) element->ToNumber() : 0;
+            }
+            return true;
+        }
+
+        if (!value->IsObject())
+            return false;
+
+        TiObjectRef object(value->ToObject());
+        ValueRef lengthValue(object->Get("length"));
+        if (!lengthValue->IsNumber())
+            return false;
+
+        double lengthNumber = lengthValue->ToNumber();
+        if (!(lengthNumber >= 0 && lengthNumber <= MAX_ARRAY_LENGTH) ||
+            lengthNumber != floor(lengthNumber))
+        {
+            throw ValueException::FromFormat("Invalid array length: %g", lengthNumber);
+        }
+
+        size_t length = (size_t) lengthNumber;
+        data.resize(length);
+        char name[32];
+        for (size_t i = 0; i < length; i++)
+        {
+            snprintf(name, sizeof(name), "%lu", (unsigned long) i);
+            ValueRef element(object->Get(name));
+            data[i] = element->IsNumber() ? (char) (int) element->ToNumber() : 0;
+        }
+        return true;
+    }
+
+    void Bytes::GetSegments(std::vector<BytesRef>& segments)
+    {
+        if (this->size > 0)
+            segments.push_back(BytesRef(this, true));
+    }
+
+    Prototype* Bytes::CreatePrototype()
+    {
+        Prototype* prototype = new Prototype();
+        prototype->SetMethod("write", &Bytes::_Write);
+        prototype->SetMethod("toString", &Bytes::_ToString);
+        prototype->SetMethod("indexOf", &Bytes::_IndexOf);
+        prototype->SetMethod("lastIndexOf", &Bytes::_LastIndexOf);
+        prototype->SetMethod("charAt", &Bytes::_CharAt);
+        prototype->SetMethod("byteAt", &Bytes::_ByteAt);
+        prototype->SetMethod("split", &Bytes::_Split);
+        prototype->SetMethod("substring", &Bytes::_Substring);
+        prototype->SetMethod("substr", &Bytes::_Substr);
+        prototype->SetMethod("toLowerCase", &Bytes::_ToLowerCase);
+        prototype->SetMethod("toUpperCase", &Bytes::_ToUpperCase);
+        prototype->SetMethod("concat", &Bytes::_Concat);
+        prototype->SetMethod("slice", &Bytes::_Slice);
+        prototype->SetMethod("toArray", &Bytes::_ToArray);
+        return prototype;
+    }
+
+    static const Prototype* volatile bytesPrototype = 0;
+
+    const Prototype* Bytes::GetPrototype()
     {
-        this->SetMethod("write", &Bytes::_Write);
-        this->SetMethod("toString", &Bytes::_ToString);
-        this->SetMethod("indexOf", &Bytes::_IndexOf);
-        this->SetMethod("lastIndexOf", &Bytes::_LastIndexOf);
-        this->SetMethod("charAt", &Bytes::_CharAt);
-        this->SetMethod("byteAt", &Bytes::_ByteAt);
-        this->SetMethod("split", &Bytes::_Split);
-        this->SetMethod("substring", &Bytes::_Substring);
-        this->SetMethod("substr", &Bytes::_Substr);
-        this->SetMethod("toLowerCase", &Bytes::_ToLowerCase);
-        this->SetMethod("toUpperCase", &Bytes::_ToUpperCase);
-        this->SetMethod("concat", &Bytes::_Concat);
-        this->SetMethod("slice", &Bytes::_Slice);
+        // Bytes are created for every read, so the methods are shared
+        // and only "length" is stored on each instance.
+        return Prototype::GetOnce(&bytesPrototype, &Bytes::CreatePrototype);
+    }
 
+    void Bytes::SetupBinding()
+    {
         this->Set("length", Value::NewInt(this->size));
     }
 
     void Bytes::_Write(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("write", "s|o ?n");
+        args.VerifyException("write", "s|o|l ?n");
         int offset = args.GetInt(1, 0);
         int bytesWritten;
 
@@ -144,14 +401,19 @@ namespace tide
             size_t length = strlen(str);
             bytesWritten = Write(str, length, offset);
         }
+        else if (args.at(0)->IsObject() && !args.GetObject(0).cast<Bytes>().isNull())
+        {
+            bytesWritten = Write(args.GetObject(0).cast<Bytes>(), offset);
+        }
         else
         {
-            BytesRef data(args.GetObject(0).cast<Bytes>());
-            if (data.isNull())
+            std::string data;
+            if (!ReadArray(args.at(0), data))
             {
-                throw ValueException::FromString("May only write strings or Bytes object");
+                throw ValueException::FromString(
+                    "May only write strings, arrays of numbers or Bytes object");
             }
-            bytesWritten = Write(data, offset);
+            bytesWritten = Write(data.data(), data.size(), offset);
         }
 
         result->SetInt(bytesWritten);
@@ -159,8 +421,7 @@ namespace tide
 
     void Bytes::_ToString(const ValueList& args, ValueRef result)
     {
-        std::string str(this->AsString());
-        result->SetString(str);
+        result->SetString(this->Pointer(), this->size);
     }
 
     void Bytes::_IndexOf(const ValueList& args, ValueRef result)
@@ -168,19 +429,28 @@ namespace tide
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/indexOf
         args.VerifyException("Bytes.indexOf", "s,?i");
 
-        std::string target(this->AsString());
+        std::string needle(args.GetString(0));
         int start = args.GetInt(1, 0);
         if (start < 0) start = 0;
-         size_t pos = target.find(args.GetString(0), start);
 
-        if (pos == std::string::npos)
+        if ((size_t) start > this->size)
+        {
+            result->SetInt(-1);
+            return;
+        }
+
+        const char* haystack = this->Pointer();
+        const char* match = FindBytes(haystack + start, this->size - start,
+            needle.data(), needle.size());
+
+        if (!match)
         {
             // No matches found
             result->SetInt(-1);
         }
         else
         {
-            result->SetInt(pos);
+            result->SetInt(match - haystack);
         }
     }
 
@@ -189,19 +459,22 @@ namespace tide
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/lastIndexOf
         args.VerifyException("Bytes.lastIndexOf", "s,?i");
 
-        std::string target(this->AsString());
-        int start = args.GetInt(1, target.length() + 1);
+        std::string needle(args.GetString(0));
+        int start = args.GetInt(1, this->size + 1);
         if (start < 0) start = 0;
-        size_t pos = target.rfind(args.GetString(0), start);
 
-        if (pos == std::string::npos)
+        const char* haystack = this->Pointer();
+        const char* match = FindLastBytes(haystack, this->size,
+            needle.data(), needle.size(), start);
+
+        if (!match)
         {
             // No matches found
             result->SetInt(-1);
         }
         else
         {
-            result->SetInt(pos);
+            result->SetInt(match - haystack);
         }
     }
 
@@ -214,7 +487,7 @@ namespace tide
         char buf[2] = {'\0', '\0'};
         if (position >= 0 && position < this->size)
         {
-            buf[0] = this->buffer[position];
+            buf[0] = this->Pointer()[position];
         }
         result->SetString(buf);
     }
@@ -226,7 +499,7 @@ namespace tide
         
         if (position >= 0 && position < this->size)
         {
-            result->SetInt(static_cast<unsigned char>(this->buffer[position]));
+            result->SetInt(static_cast<unsigned char>(this->Pointer()[position]));
         }
     }
 
@@ -240,55 +513,42 @@ namespace tide
         TiListRef list = new StaticBoundList();
         result->SetList(list);
 
-        std::string target = "";
-        if (this->size > 0)
-        {
-            target = this->buffer;
-        }
-        else
+        const char* target = this->Pointer();
+        if (this->size == 0 || args.size() <= 0)
         {
-            list->Append(Value::NewString(target));
+            list->Append(Value::NewString(target ? target : "", this->size));
             return;
         }
 
-        if (args.size() <= 0)
+        std::string separator(args.GetString(0));
+        int limit = args.GetInt(1, INT_MAX);
+
+        // An empty separator splits the data into individual characters.
+        if (separator.empty())
         {
-            list->Append(Value::NewString(target));
+            for (size_t i = 0; i < this->size && (int) list->Size() < limit; i++)
+                list->Append(Value::NewString(target + i, 1));
             return;
         }
 
-        std::string separator = args.GetString(0);
-
-        int limit = args.GetInt(1, INT_MAX);
-
-        // We could use Poco's tokenizer here, but it doesn't split strings
-        // like "abc,def,," -> ['abc', 'def', '', ''] correctly. It produces
-        // ['abc', 'def', ''] which is a different behavior than the JS split.
-        // So we roll our own for now -- it's not very efficient right now, but
-        // it should be correct.
-        size_t next = target.find(separator);
-        while (target.size() > 0 && next != std::string::npos)
+        // Poco's tokenizer doesn't split strings like "abc,def,," into
+        // ['abc', 'def', '', ''] like JavaScript does, so walk the buffer
+        // ourselves and create each token straight from it.
+        const char* cursor = target;
+        const char* end = target + this->size;
+        while ((int) list->Size() < limit)
         {
-            std::string token;
-            if (separator.size() == 0)
+            const char* match = FindBytes(cursor, end - cursor,
+                separator.data(), separator.size());
+            if (!match)
             {
-                token = target.substr(0, 1);
+                list->Append(Value::NewString(cursor, end - cursor));
+                break;
             }
-            else
-            {
-                token = target.substr(0, next);
-            }
-            target = target.substr(next + 1);
-            next = target.find(separator);
-
-            if ((int) list->Size() >= limit)
-                return;
 
-            list->Append(Value::NewString(token));
+            list->Append(Value::NewString(cursor, match - cursor));
+            cursor = match + separator.size();
         }
-
-        if ((int) list->Size() < limit && separator.size() != 0)
-            list->Append(Value::NewString(target));
     }
 
     void Bytes::_Substr(const ValueList& args, ValueRef result)
@@ -296,25 +556,25 @@ namespace tide
         // This method now follows the spec located at:
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/substr
         args.VerifyException("Bytes.substr", "i,?i");
-        std::string target(this->buffer, this->size);
 
-        int start = args.GetInt(0);
-        if (start > 0 && start >= (int)target.length())
+        long targetLength = this->size;
+        long start = args.GetInt(0);
+        if (start > 0 && start >= targetLength)
         {
             result->SetString("");
             return;
         }
 
-        if (start < 0 && (-1*start) > (int)target.length())
+        if (start < 0 && (-1*start) > targetLength)
         {
             start = 0;
         }
         else if (start < 0)
         {
-            start = target.length() + start;
+            start = targetLength + start;
         }
 
-        long length = target.length() - start;
+        long length = targetLength - start;
         if (args.size() > 1)
         {
             length = args.GetInt(1);
@@ -326,8 +586,9 @@ namespace tide
             return;
         }
 
-        std::string r = target.substr(start, length);
-        result->SetString(r);
+        if (length > targetLength - start)
+            length = targetLength - start;
+        result->SetString(this->Pointer() + start, length);
     }
 
     void Bytes::_Substring(const ValueList& args, ValueRef result)
@@ -335,54 +596,61 @@ namespace tide
         // This method now follows the spec located at:
         // https://developer.mozilla.org/en/Core_JavaScript_1.5_Reference/Global_Objects/String/substring
         args.VerifyException("Bytes.substring", "i,?i");
-        std::string target = "";
-        if (this->size > 0)
-        {
-            target = this->buffer;
-        }
 
+        long targetLength = this->size;
         long indexA = args.GetInt(0);
         if (indexA < 0)
             indexA = 0;
-        if (indexA > (long) target.size())
-            indexA = target.size();
+        if (indexA > targetLength)
+            indexA = targetLength;
 
-        if (args.size() < 2)
-        {
-            std::string r = target.substr(indexA);
-            result->SetString(r);
-        }
-        else
+        long indexB = targetLength;
+        if (args.size() > 1)
         {
-            long indexB = args.GetInt(1);
+            indexB = args.GetInt(1);
             if (indexB < 0)
                 indexB = 0;
-            if (indexB > (long) target.size())
-                indexB = target.size();
+            if (indexB > targetLength)
+                indexB = targetLength;
+        }
 
-            if (indexA == indexB)
-            {
-                result->SetString("");
-                return;
-            }
-            if (indexA > indexB)
-            {
-                long temp = indexA;
-                indexA = indexB;
-                indexB = temp;
-            }
-            std::string r = target.substr(indexA, indexB - indexA);
-            result->SetString(r);
+        if (indexA == indexB)
+        {
+            result->SetString("");
+            return;
+        }
+        if (indexA > indexB)
+        {
+            long temp = indexA;
+            indexA = indexB;
+            indexB = temp;
         }
+        result->SetString(this->Pointer() + indexA, indexB - indexA);
+    }
+
+    static ValueRef TransformCase(const char* data, size_t size, bool upper)
+    {
+        char* scratch = AllocateBuffer(size);
+        char from = upper ? 'a' : 'A';
+        char to = upper ? 'A' : 'a';
+        for (size_t i = 0; i < size; i++)
+        {
+            char c = data[i];
+            if (c >= from && c <= from + ('z' - 'a'))
+                c = c - from + to;
+            scratch[i] = c;
+        }
+
+        ValueRef transformed(Value::NewString(scratch, size));
+        ReleaseBuffer(scratch, size);
+        return transformed;
     }
 
     void Bytes::_ToLowerCase(const ValueList& args, ValueRef result)
     {
         if (this->size > 0)
         {
-            std::string target(this->buffer, this->size);
-            std::string r = Poco::toLower(target);
-            result->SetString(r);
+            result->SetValue(TransformCase(this->Pointer(), this->size, false));
         }
         else
         {
@@ -394,9 +662,7 @@ namespace tide
     {
         if (this->size > 0)
         {
-            std::string target(this->buffer, this->size);
-            std::string r = Poco::toUpper(target);
-            result->SetString(r);
+            result->SetValue(TransformCase(this->Pointer(), this->size, true));
         }
         else
         {
@@ -406,25 +672,15 @@ namespace tide
     
     BytesRef Bytes::Concat(std::vector<BytesRef>& bytes)
     {
-        size_t size = 0;
-        for (size_t i = 0; i < bytes.size(); i++)
-        {
-            size += bytes.at(i)->Length();
-        }
-
-        BytesRef newBytes = new Bytes(size);
+        if (bytes.empty())
+            return new Bytes();
 
-        // Write the rest of the Bytes objects
-        size_t bytesConcated = 0;
-        std::vector<BytesRef>::iterator i = bytes.begin();
-        while (i != bytes.end())
-        {
-            BytesRef source = *i++;
-            newBytes->Write(source, bytesConcated);
-            bytesConcated += source->Length();
-        }
+        // A single object can simply be shared as a slice, which will
+        // still copy its data if anyone writes to the result.
+        if (bytes.size() == 1)
+            return new Bytes(bytes.at(0));
 
-        return newBytes;
+        return new BytesChain(bytes);
     }
 
     void Bytes::_Concat(const ValueList& args, ValueRef result)
@@ -437,7 +693,7 @@ namespace tide
             if (args.at(i)->IsObject())
             {
                 BytesRef bytesObject(args.GetObject(i).cast<Bytes>());
-                if (!bytesObject.isNull());
+                if (!bytesObject.isNull())
                 {
                     bytes.push_back(bytesObject);
                 }
@@ -462,4 +718,94 @@ namespace tide
         BytesRef slice = new Bytes(BytesRef(this, true), offset, length);
         result->SetObject(slice);
     }
+
+    void Bytes::_ToArray(const ValueList& args, ValueRef result)
+    {
+        // The JavaScript bridge answers this itself, building the array
+        // directly from Pointer(); this version serves the other languages.
+        args.VerifyException("toArray", "?i i");
+
+        int startArgument = args.GetInt(0, 0);
+        int lengthArgument = args.GetInt(1, 0);
+        if (startArgument < 0 || lengthArgument < 0)
+            throw ValueException::FromString("toArray start and length must not be negative");
+
+        size_t start = startArgument;
+        size_t length = args.size() > 1 ? (size_t) lengthArgument : this->size;
+        if (start > this->size)
+            start = this->size;
+        if (length > this->size - start)
+            length = this->size - start;
+
+        const unsigned char* data = reinterpret_cast<unsigned char*>(this->Pointer());
+        TiListRef list(new StaticBoundList());
+        for (size_t i = 0; i < length; i++)
+            list->Append(Value::NewInt(data[start + i]));
+        result->SetList(list);
+    }
+
+    BytesChain::BytesChain(std::vector<BytesRef>& inputs) :
+        Bytes()
+    {
+        // Nested chains are expanded so that a chain only ever holds
+        // plain, contiguous segments.
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (!inputs[i].isNull())
+                inputs[i]->GetSegments(this->segments);
+        }
+
+        // Hold slices rather than the inputs themselves, so that writing
+        // to an input afterwards does not change the chain.
+        for (size_t i = 0; i < this->segments.size(); i++)
+        {
+            this->segments[i] = new Bytes(this->segments[i]);
+            this->size += this->segments[i]->Length();
+        }
+
+        this->lazy = this->size > 0;
+        this->Set("length", Value::NewInt(this->size));
+    }
+
+    BytesChain::~BytesChain()
+    {
+    }
+
+    void BytesChain::GetSegments(std::vector<BytesRef>& segments)
+    {
+        Poco::FastMutex::ScopedLock lock(this->flattenMutex);
+        if (!this->lazy)
+        {
+            Bytes::GetSegments(segments);
+            return;
+        }
+
+        segments.insert(segments.end(), this->segments.begin(), this->segments.end());
+    }
+
+    void BytesChain::Flatten()
+    {
+        Poco::FastMutex::ScopedLock lock(this->flattenMutex);
+        if (!this->lazy)
+            return;
+
+        AutoPtr<BytesStorage> flattened(new BytesStorage(this->size));
+        size_t offset = 0;
+        for (size_t i = 0; i < this->segments.size(); i++)
+        {
+            BytesRef segment(this->segments[i]);
+            memcpy(flattened->data + offset, segment->Pointer(), segment->Length());
+            offset += segment->Length();
+        }
+
+        // The segments are no longer needed, which lets go of the
+        // storage they shared with their sources.
+        this->storage = flattened;
+        this->buffer = flattened->data;
+        this->segments.clear();
+
+        // Make sure other threads see the buffer before the flag flips.
+        Atomic::Barrier();
+        this->lazy = false;
+    }
 }
@@ -43,6 +43,24 @@
 
 namespace tide
 {
+    /**
+     * The memory behind one or more Bytes. Slices and chain segments hold
+     * on to the storage of the data they refer to, rather than to the
+     * Bytes which created it, so it is released with the last of them.
+     */
+    class TIDE_API BytesStorage : public ReferenceCounted
+    {
+    public:
+        BytesStorage(size_t size);
+        virtual ~BytesStorage();
+
+        char* data;
+        size_t size;
+
+    private:
+        DISALLOW_EVIL_CONSTRUCTORS(BytesStorage);
+    };
+
     /**
      * An object that represents an arbitrary amount of binary data§
      */
@@ -56,7 +74,8 @@ namespace tide
         Bytes(size_t size);
 
         // Reference an existing bytes object. An offset and length
-        // may be provided to "slice" only a part of the data.
+        // may be provided to "slice" only a part of the data. Slices
+        // share their parent's memory until either of them is written to.
         Bytes(BytesRef source, size_t offset = 0, size_t length = -1);
 
         // Create bytes object from a string.
@@ -67,8 +86,15 @@ namespace tide
 
         size_t ExtraMemoryCost();
 
-        // A pointer to the internal byte buffer
-        char* Pointer() { return buffer; }
+        // A pointer to the internal byte buffer. For a lazily
+        // concatenated object this will first flatten the data
+        // into a single contiguous buffer.
+        char* Pointer()
+        {
+            if (this->lazy)
+                this->Flatten();
+            return buffer;
+        }
 
         // Returns length of bytes this object has in capacity
         size_t Length() { return size; }
@@ -81,10 +107,38 @@ namespace tide
         // Return a string representation
         std::string AsString();
 
+        // Read a list of numbers, or an array-like object with a numeric
+        // length (e.g. a JavaScript Uint8Array), as bytes. Returns false if
+        // the value is neither.
+        static bool ReadArray(ValueRef value, std::string& data);
+
+        // Append the contiguous pieces of data which make up this object
+        // to the given list without flattening them. Most Bytes consist
+        // of a single segment, while a BytesChain may have many.
+        virtual void GetSegments(std::vector<BytesRef>& segments);
+
+        // Join several Bytes objects together. The result references
+        // the original data instead of copying it.
         static BytesRef Concat(std::vector<BytesRef>& bytes);
 
+    protected:
+        // Collapse lazily-joined data into this->buffer.
+        virtual void Flatten() {}
+
+        char* buffer;
+        size_t size;
+        volatile bool lazy;
+
+        // What buffer points into. While a slice or chain shares it,
+        // writes go to a private copy instead.
+        AutoPtr<BytesStorage> storage;
+
     private:
+        void Detach();
+
         // Binding methods
+        static Prototype* CreatePrototype();
+        static const Prototype* GetPrototype();
         void SetupBinding();
         void _Write(const ValueList& args, ValueRef result);
         void _ToString(const ValueList& args, ValueRef result);
@@ -100,10 +154,32 @@ namespace tide
         void _Replace(const ValueList& args, ValueRef result);
         void _Concat(const ValueList& args, ValueRef result);
         void _Slice(const ValueList& args, ValueRef result);
+        void _ToArray(const ValueList& args, ValueRef result);
+    };
 
-        char* buffer;
-        size_t size;
-        BytesRef source;
+    /**
+     * A Bytes object made up of several other Bytes objects, laid end
+     * to end without copying. The data is only gathered into one
+     * contiguous buffer if someone asks for Pointer().
+     */
+    class TIDE_API BytesChain : public Bytes
+    {
+    public:
+        BytesChain(std::vector<BytesRef>& segments);
+        virtual ~BytesChain();
+
+        size_t SegmentCount() { return segments.size(); }
+        BytesRef SegmentAt(size_t index) { return segments.at(index); }
+        virtual void GetSegments(std::vector<BytesRef>& segments);
+
+    protected:
+        virtual void Flatten();
+
+    private:
+        std::vector<BytesRef> segments;
+        Poco::FastMutex flattenMutex;
+
+        DISALLOW_EVIL_CONSTRUCTORS(BytesChain);
     };
 }
 
@@ -72,18 +72,12 @@ namespace tide
     std::string Event::HTTP_DATA_RECEIVED = "http.datareceived";
 
     Event::Event(AutoPtr<EventObject> target, const std::string& eventName) :
-        AccessorObject("Event"),
+        AccessorObject("Event", Event::GetPrototype()),
         target(target),
         eventName(eventName),
         stopped(false),
         preventedDefault(false)
     {
-        Event::SetEventConstants(this);
-        this->SetMethod("getTarget", &Event::_GetTarget);
-        this->SetMethod("getType", &Event::_GetType);
-        this->SetMethod("getTimestamp", &Event::_GetTimestamp);
-        this->SetMethod("stopPropagation", &Event::_StopPropagation);
-        this->SetMethod("preventDefault", &Event::_PreventDefault);
     }
 
     void Event::_GetTarget(const ValueList&, ValueRef result)
@@ -112,7 +106,10 @@ namespace tide
         this->preventedDefault = true;
     }
 
-    void Event::SetEventConstants(TiObject* target)
+    // Shared by objects, which get their own copies of the constants, and by
+    // the prototype which events and event objects look them up in.
+    template <typename T>
+    static void SetConstants(T* target)
     {
         // @tiproperty[String, ALL, since=0.6] The ALL event constant
         // @tiproperty[String, FOCUSED, since=0.6] The FOCUSED event constant
@@ -187,4 +184,42 @@ namespace tide
         target->Set("HTTP_DATA_RECEIVED", Value::NewString(Event::HTTP_DATA_RECEIVED));
     }
 
+    void Event::SetEventConstants(TiObject* target)
+    {
+        SetConstants(target);
+    }
+
+    static Prototype* CreateConstantsPrototype()
+    {
+        Prototype* prototype = new Prototype();
+        SetConstants(prototype);
+        return prototype;
+    }
+
+    static const Prototype* volatile constantsPrototype = 0;
+    static const Prototype* volatile eventPrototype = 0;
+
+    const Prototype* Event::GetConstantsPrototype()
+    {
+        return Prototype::GetOnce(&constantsPrototype, &CreateConstantsPrototype);
+    }
+
+    Prototype* Event::CreatePrototype()
+    {
+        Prototype* prototype = new Prototype(Event::GetConstantsPrototype());
+        prototype->SetMethod("getTarget", &Event::_GetTarget);
+        prototype->SetMethod("getType", &Event::_GetType);
+        prototype->SetMethod("getTimestamp", &Event::_GetTimestamp);
+        prototype->SetMethod("stopPropagation", &Event::_StopPropagation);
+        prototype->SetMethod("preventDefault", &Event::_PreventDefault);
+        return prototype;
+    }
+
+    const Prototype* Event::GetPrototype()
+    {
+        // An Event is created for every dispatch, so its methods and the
+        // event constants are shared rather than set on each one.
+        return Prototype::GetOnce(&eventPrototype, &Event::CreatePrototype);
+    }
+
 }
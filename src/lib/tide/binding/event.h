@@ -48,6 +48,12 @@ namespace tide
         void _PreventDefault(const ValueList&, ValueRef result);
         static void SetEventConstants(TiObject* target);
 
+        /**
+         * A prototype holding only the event constants, for
+         * classes which expose them on every instance.
+         */
+        static const Prototype* GetConstantsPrototype();
+
         AutoPtr<EventObject> target;
         std::string eventName;
         Poco::Timestamp timestamp;
@@ -87,6 +93,10 @@ namespace tide
         static std::string HTTP_DATA_SENT;
         static std::string HTTP_DATA_RECEIVED;
         static std::string OPEN_REQUEST;
+
+    private:
+        static Prototype* CreatePrototype();
+        static const Prototype* GetPrototype();
     };
 }
 
@@ -33,22 +33,147 @@
 **/
 
 #include "../tide.h"
+#include "../atomic.h"
+#include <algorithm>
+#include <cstring>
 
 namespace tide
 {
+    static const Atom* AllEvents()
+    {
+        static const Atom* atom = Atom::Intern(Event::ALL.c_str());
+        return atom;
+    }
+
+    // Marks a dispatch in progress on an object. While it exists, the
+    // listener index it loaded and every listener in it stay alive.
+    class DispatchGuard
+    {
+    public:
+        DispatchGuard(EventObject* object) : object(object)
+        {
+            while (true)
+            {
+                unsigned int epoch = Atomic::Load(&object->dispatchEpoch);
+                counter = &object->dispatchers[epoch & 1];
+                Atomic::Increment(counter);
+
+                // A writer which flipped the epoch in between may already
+                // have found this counter empty.
+                if (Atomic::Load(&object->dispatchEpoch) == epoch)
+                    break;
+                Atomic::Decrement(counter);
+            }
+
+            index = (EventListenerIndex*)
+                Atomic::LoadPointer((void* volatile*) &object->listeners);
+        }
+
+        ~DispatchGuard()
+        {
+            object->FinishDispatch(counter);
+        }
+
+        EventListenerIndex* index;
+
+    private:
+        EventObject* object;
+        volatile unsigned int* counter;
+    };
+
+    static const Atom* EventAtom(const char* event)
+    {
+        if (!strcmp(event, Event::ALL.c_str()))
+            return AllEvents();
+
+        const Atom* atom = Atom::Find(event);
+        if (atom)
+            return atom;
+        return Atom::NewLocal(event, Atom::Hash(event));
+    }
+
+    // Walks the listeners for one event in registration order, merging the
+    // event's own bucket with the ALL bucket.
+    class ListenerCursor
+    {
+    public:
+        ListenerCursor(const EventListenerIndex* index, const char* event) :
+            event(event),
+            hash(Atom::Hash(event)),
+            named(0),
+            all(0),
+            namedIndex(0),
+            allIndex(0)
+        {
+            if (!index)
+                return;
+
+            all = &index->all;
+            EventListenerIndex::BucketMap::const_iterator i = index->buckets.find(hash);
+            if (i != index->buckets.end())
+                named = &i->second;
+        }
+
+        EventListener* Next()
+        {
+            // Events whose names hash alike share a bucket.
+            while (named && namedIndex < named->size() &&
+                !named->at(namedIndex)->Handles(event, hash))
+                namedIndex++;
+
+            bool hasNamed = named && namedIndex < named->size();
+            bool hasAll = all && allIndex < all->size();
+            if (hasNamed && (!hasAll ||
+                named->at(namedIndex)->Order() < all->at(allIndex)->Order()))
+                return named->at(namedIndex++);
+            if (hasAll)
+                return all->at(allIndex++);
+            return 0;
+        }
+
+    private:
+        const char* event;
+        unsigned int hash;
+        const EventListenerList* named;
+        const EventListenerList* all;
+        size_t namedIndex;
+        size_t allIndex;
+    };
+
     EventObject::EventObject(const char *type) :
-        AccessorObject(type)
+        AccessorObject(type, EventObject::GetPrototype()),
+        listeners(0),
+        dispatchEpoch(0),
+        nextListenerOrder(0),
+        retiredCount(0)
     {
-        this->SetMethod("on", &EventObject::_AddEventListener);
-        this->SetMethod("addEventListener", &EventObject::_AddEventListener);
-        this->SetMethod("removeEventListener", &EventObject::_RemoveEventListener);
+        dispatchers[0] = 0;
+        dispatchers[1] = 0;
+    }
 
-        Event::SetEventConstants(this);
+    static Prototype* CreateEventObjectPrototype()
+    {
+        Prototype* prototype = new Prototype(Event::GetConstantsPrototype());
+        prototype->SetMethod("on", &EventObject::_AddEventListener);
+        prototype->SetMethod("addEventListener", &EventObject::_AddEventListener);
+        prototype->SetMethod("removeEventListener", &EventObject::_RemoveEventListener);
+        return prototype;
+    }
+
+    static const Prototype* volatile eventObjectPrototype = 0;
+
+    const Prototype* EventObject::GetPrototype()
+    {
+        return Prototype::GetOnce(&eventObjectPrototype, &CreateEventObjectPrototype);
     }
 
     EventObject::~EventObject()
     {
         this->RemoveAllEventListeners();
+
+        // Nothing can be dispatching on an object which is being destroyed.
+        Free(this->retired);
+        Free(this->draining);
     }
 
     AutoPtr<Event> EventObject::CreateEvent(const std::string& eventName)
@@ -58,45 +183,141 @@ namespace tide
 
     void EventObject::AddEventListener(const char* event, TiMethodRef callback)
     {
-        Poco::FastMutex::ScopedLock lock(this->listenersMutex);
-        listeners.push_back(new EventListener(event, callback));
+        std::string eventName(event);
+        this->AddEventListener(eventName, callback);
     }
 
     void EventObject::AddEventListener(std::string& event, TiMethodRef callback)
     {
         Poco::FastMutex::ScopedLock lock(this->listenersMutex);
-        listeners.push_back(new EventListener(event, callback));
+
+        EventListener* listener = new EventListener(event, callback,
+            this->nextListenerOrder++);
+        EventListenerIndex* index = this->listeners ?
+            new EventListenerIndex(*this->listeners) : new EventListenerIndex();
+        if (listener->TargetedEvent() == AllEvents())
+            index->all.push_back(listener);
+        else
+            index->buckets[listener->TargetedEvent()->HashCode()].push_back(listener);
+
+        this->Publish(index);
     }
 
     void EventObject::RemoveEventListener(std::string& event, TiMethodRef callback)
     {
         Poco::FastMutex::ScopedLock lock(this->listenersMutex);
 
-        EventListenerList::iterator i = this->listeners.begin();
-        while (i != this->listeners.end())
+        // Remove the earliest listener which would have been called
+        // for this event, including ALL listeners.
+        ListenerCursor cursor(this->listeners, event.c_str());
+        EventListener* listener;
+        while ((listener = cursor.Next()))
         {
-            EventListener* listener = *i;
-            if (listener->Handles(event.c_str()) && listener->Callback()->Equals(callback))
-            {
-                this->listeners.erase(i);
-                delete listener;
+            if (listener->Callback()->Equals(callback))
                 break;
-            }
-            i++;
         }
+
+        if (!listener)
+            return;
+
+        EventListenerIndex* index = new EventListenerIndex(*this->listeners);
+        const Atom* targetedEvent = listener->TargetedEvent();
+        EventListenerList& bucket = targetedEvent == AllEvents() ?
+            index->all : index->buckets[targetedEvent->HashCode()];
+        bucket.erase(std::find(bucket.begin(), bucket.end(), listener));
+        if (bucket.empty() && targetedEvent != AllEvents())
+            index->buckets.erase(targetedEvent->HashCode());
+
+        this->retired.listeners.push_back(listener);
+        this->Publish(index);
     }
 
     void EventObject::RemoveAllEventListeners()
     {
         Poco::FastMutex::ScopedLock lock(this->listenersMutex);
+        if (!this->listeners)
+            return;
+
+        EventListenerIndex* index = this->listeners;
+        EventListenerList& retiredListeners = this->retired.listeners;
+        retiredListeners.insert(retiredListeners.end(),
+            index->all.begin(), index->all.end());
+        EventListenerIndex::BucketMap::iterator i = index->buckets.begin();
+        while (i != index->buckets.end())
+        {
+            retiredListeners.insert(retiredListeners.end(),
+                i->second.begin(), i->second.end());
+            i++;
+        }
+
+        this->Publish(0);
+    }
 
-        EventListenerList::iterator i = this->listeners.begin();
-        while (i != this->listeners.end())
+    void EventObject::Publish(EventListenerIndex* index)
+    {
+        // Called with listenersMutex held.
+        EventListenerIndex* oldIndex = this->listeners;
+        Atomic::StorePointer((void* volatile*) &this->listeners, index);
+        if (oldIndex)
+            this->retired.indexes.push_back(oldIndex);
+
+        this->Reclaim();
+    }
+
+    void EventObject::Free(Retired& retired)
+    {
+        for (size_t i = 0; i < retired.indexes.size(); i++)
+            delete retired.indexes[i];
+        for (size_t i = 0; i < retired.listeners.size(); i++)
+            delete retired.listeners[i];
+        retired.indexes.clear();
+        retired.listeners.clear();
+    }
+
+    void EventObject::Reclaim()
+    {
+        // Called with listenersMutex held, after the retired items were
+        // unpublished. Only dispatches of the epoch before the last flip
+        // can still be using what is draining.
+        Atomic::Barrier();
+        if (!this->draining.IsEmpty())
+        {
+            unsigned int oldEpoch = Atomic::Load(&this->dispatchEpoch) - 1;
+            if (Atomic::Load(&this->dispatchers[oldEpoch & 1]) == 0)
+                Free(this->draining);
+        }
+
+        // Everything retired so far was unpublished before the flip, so
+        // dispatches which start in the new epoch can't reach it.
+        if (this->draining.IsEmpty() && !this->retired.IsEmpty())
         {
-            delete *i++;
+            this->draining.indexes.swap(this->retired.indexes);
+            this->draining.listeners.swap(this->retired.listeners);
+            unsigned int oldEpoch = Atomic::Load(&this->dispatchEpoch);
+            Atomic::Store(&this->dispatchEpoch, oldEpoch + 1);
+            Atomic::Barrier();
+            if (Atomic::Load(&this->dispatchers[oldEpoch & 1]) == 0)
+                Free(this->draining);
         }
 
-        this->listeners.clear();
+        Atomic::Store(&this->retiredCount,
+            this->retired.indexes.size() + this->retired.listeners.size() +
+            this->draining.indexes.size() + this->draining.listeners.size());
+    }
+
+    void EventObject::FinishDispatch(volatile unsigned int* counter)
+    {
+        // Any dispatch which finishes moves reclamation along, unless a
+        // writer is busy, in which case that writer will.
+        Atomic::Decrement(counter);
+        if (Atomic::Load(&this->retiredCount) == 0)
+            return;
+
+        if (this->listenersMutex.tryLock())
+        {
+            this->Reclaim();
+            this->listenersMutex.unlock();
+        }
     }
 
     void EventObject::FireEvent(const char* event)
@@ -106,37 +327,25 @@ namespace tide
 
     void EventObject::FireEvent(const char* event, const ValueList& args)
     {
-        // Make a copy of the listeners map here, because firing the event might
-        // take a while and we don't want to block other threads that just need
-        // too add event listeners.
-        EventListenerList listenersCopy;
-        {
-            Poco::FastMutex::ScopedLock lock(this->listenersMutex);
-            listenersCopy = listeners;
-        }
-
         TiObjectRef thisObject(this, true);
-        EventListenerList::iterator li = listenersCopy.begin();
-        while (li != listenersCopy.end())
+        DispatchGuard guard(this);
+        ListenerCursor cursor(guard.index, event);
+        while (EventListener* listener = cursor.Next())
         {
-            EventListener* listener = *li++;
-            if (listener->Handles(event))
+            try
             {
-                try
-                {
-                    if (!listener->Dispatch(thisObject, args, true))
-                    {
-                        // Stop event dispatch if callback tells us
-                        break;
-                    }
-                }
-                catch (ValueException& e)
+                if (!listener->Dispatch(thisObject, args, true))
                 {
-                    this->ReportDispatchError(e.ToString());
+                    // Stop event dispatch if callback tells us
                     break;
                 }
             }
-        }    
+            catch (ValueException& e)
+            {
+                this->ReportDispatchError(e.ToString());
+                break;
+            }
+        }
     }
 
     bool EventObject::FireEvent(std::string& eventName, bool synchronous)
@@ -147,25 +356,17 @@ namespace tide
 
     bool EventObject::FireEvent(AutoPtr<Event> event, bool synchronous)
     {
-        // Make a copy of the listeners map here, because firing the event might
-        // take a while and we don't want to block other threads that just need
-        // too add event listeners.
-        EventListenerList listenersCopy;
+        // Firing the event might take a while, so dispatch works from the
+        // current listener index rather than holding the lock, which would
+        // block other threads that just need to add event listeners.
         {
-            Poco::FastMutex::ScopedLock lock(listenersMutex);
-            listenersCopy = listeners;
-        }
-
-        TiObjectRef thisObject(this, true);
-        EventListenerList::iterator li = listenersCopy.begin();
-        while (li != listenersCopy.end())
-        {
-            EventListener* listener = *li++;
-            if (listener->Handles(event->eventName.c_str()))
+            TiObjectRef thisObject(this, true);
+            DispatchGuard guard(this);
+            ListenerCursor cursor(guard.index, event->eventName.c_str());
+            ValueList args(Value::NewObject(event));
+            while (EventListener* listener = cursor.Next())
             {
-                ValueList args(Value::NewObject(event));
                 bool result = false;
-
                 try
                 {
                     result = listener->Dispatch(thisObject, args, synchronous);
@@ -229,21 +430,35 @@ namespace tide
             this->GetType().c_str(), reason.c_str());
     }
 
-    EventListener::EventListener(std::string& targetedEvent, TiMethodRef callback) :
-        targetedEvent(targetedEvent),
-        callback(callback)
+    EventListener::EventListener(std::string& targetedEvent, TiMethodRef callback,
+        unsigned int order) :
+        targetedEvent(EventAtom(targetedEvent.c_str())),
+        callback(callback),
+        order(order)
+    {
+    }
+
+    EventListener::EventListener(const char* targetedEvent, TiMethodRef callback,
+        unsigned int order) :
+        targetedEvent(EventAtom(targetedEvent)),
+        callback(callback),
+        order(order)
+    {
+    }
+
+    EventListener::~EventListener()
     {
+        Atom::DeleteLocal(targetedEvent);
     }
 
-    EventListener::EventListener(const char* targetedEvent, TiMethodRef callback) :
-        targetedEvent(targetedEvent),
-        callback(callback)
+    bool EventListener::Handles(const char* event)
     {
+        return this->Handles(event, Atom::Hash(event));
     }
 
-    inline bool EventListener::Handles(const char* event)
+    bool EventListener::Handles(const char* event, unsigned int hash)
     {
-        return targetedEvent.compare(event) == 0 || targetedEvent == Event::ALL;
+        return targetedEvent == AllEvents() || targetedEvent->Matches(event, hash);
     }
 
     inline TiMethodRef EventListener::Callback()
@@ -35,13 +35,26 @@
 #ifndef _EVENT_OBJECT_H_
 #define _EVENT_OBJECT_H_
 
-#include <list>
+#include <map>
+#include <vector>
 #include <Poco/Mutex.h>
 
 namespace tide
 {
     class EventListener;
-    typedef std::list<EventListener*> EventListenerList;
+    typedef std::vector<EventListener*> EventListenerList;
+
+    /**
+     * An immutable snapshot of an EventObject's listeners, indexed by the
+     * hash of the name of the event they listen for. Listeners for Event::ALL
+     * are kept in a bucket of their own. Each bucket is in registration order.
+     */
+    struct EventListenerIndex
+    {
+        typedef std::map<unsigned int, EventListenerList> BucketMap;
+        BucketMap buckets;
+        EventListenerList all;
+    };
 
     class TIDE_API EventObject : public AccessorObject
     {
@@ -67,25 +80,66 @@ namespace tide
         void _RemoveAllEventListeners(const ValueList&, ValueRef result);
 
     private:
+        struct Retired
+        {
+            std::vector<EventListenerIndex*> indexes;
+            EventListenerList listeners;
+            bool IsEmpty() { return indexes.empty() && listeners.empty(); }
+        };
+
+        static const Prototype* GetPrototype();
+        static void Free(Retired& retired);
         void ReportDispatchError(std::string& reason);
+        void Publish(EventListenerIndex* index);
+        void Reclaim();
+        void FinishDispatch(volatile unsigned int* counter);
 
-        EventListenerList listeners;
+        // Dispatch reads the current index without locking or copying it.
+        // Changes build a new index under listenersMutex and publish it.
+        // Dispatches are counted in one of two epochs, as reads of a
+        // PropertyTable are in one of two phases. Replaced indexes and
+        // removed listeners wait in retired until the epoch is flipped,
+        // and in draining until the dispatches of the old epoch are done.
+        // Dispatches which started later never hold them up.
+        EventListenerIndex* volatile listeners;
+        volatile unsigned int dispatchEpoch;
+        volatile unsigned int dispatchers[2];
         Poco::FastMutex listenersMutex;
+        unsigned int nextListenerOrder;
+        Retired retired;
+        Retired draining;
+        volatile unsigned int retiredCount;
+
+        friend class DispatchGuard;
     };
 
     class EventListener
     {
     public:
-        EventListener(std::string& targetedEvent, TiMethodRef callback);
-        EventListener(const char* targetedEvent, TiMethodRef callback);
+        EventListener(std::string& targetedEvent, TiMethodRef callback,
+            unsigned int order = 0);
+        EventListener(const char* targetedEvent, TiMethodRef callback,
+            unsigned int order = 0);
+        ~EventListener();
 
         bool Handles(const char* event);
+        bool Handles(const char* event, unsigned int hash);
         bool Dispatch(TiObjectRef thisObject, const ValueList& args, bool synchronous);
         TiMethodRef Callback();
+        const Atom* TargetedEvent() { return targetedEvent; }
+
+        // The position of this listener among all listeners of its
+        // EventObject, which dispatch follows across buckets.
+        unsigned int Order() { return order; }
 
     private:
-        std::string targetedEvent;
+        // Interned if native code knows the event, otherwise local to
+        // this listener, so that names from script are not kept forever.
+        const Atom* targetedEvent;
         TiMethodRef callback;
+        unsigned int order;
+
+        DISALLOW_EVIL_CONSTRUCTORS(EventListener);
     };
 }
 
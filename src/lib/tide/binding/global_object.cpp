@@ -69,10 +69,4 @@ namespace tide
     {
         result->SetString(OS_NAME);
     }
-
-    /*static*/
-    void GlobalObject::TurnOnProfiling()
-    {
-        instance = new ProfiledGlobalObject(instance);
-    }
 }
@@ -42,7 +42,6 @@ namespace tide
     public:
         GlobalObject();
         ~GlobalObject();
-        static void TurnOnProfiling();
 
         inline static AutoPtr<GlobalObject> GetInstance()
         {
@@ -108,18 +108,4 @@ namespace tide
 
         return result;
     }
-
-    /*static*/
-    TiListRef TiList::Unwrap(TiListRef o)
-    {
-        AutoPtr<ProfiledBoundList> plist = o.cast<ProfiledBoundList>();
-        if (plist.isNull())
-        {
-            return o;
-        }
-        else
-        {
-            return plist->GetDelegate();
-        }
-    }
 }
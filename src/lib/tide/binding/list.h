@@ -128,11 +128,6 @@ namespace tide
          */
         static unsigned int ToIndex(const std::string& str);
 
-        /**
-         * Return the unwrapped version of this object
-         */
-        static TiListRef Unwrap(TiListRef);
-
     private:
         DISALLOW_EVIL_CONSTRUCTORS(TiList);
     };
@@ -114,17 +114,4 @@ namespace tide
         args.push_back(three);
         return this->Call(args);
     }
-
-    TiMethodRef TiMethod::Unwrap(TiMethodRef o)
-    {
-        AutoPtr<ProfiledBoundMethod> pmeth = o.cast<ProfiledBoundMethod>();
-        if (pmeth.isNull())
-        {
-            return o;
-        }
-        else
-        {
-            return pmeth->GetDelegate();
-        }
-    }
 }
@@ -88,11 +88,6 @@ namespace tide
          */
         SharedString DisplayString(int levels);
 
-        /**
-         * Return the unwrapped version of this object
-         */
-        static TiMethodRef Unwrap(TiMethodRef);
-
         /* Convenience methods below */
         ValueRef Call(ValueRef one);
         ValueRef Call(ValueRef one, ValueRef two);
@@ -394,18 +394,4 @@ namespace tide
     {
         return type;
     }
-
-    TiObjectRef TiObject::Unwrap(TiObjectRef o)
-    {
-        AutoPtr<ProfiledBoundObject> pobj = o.cast<ProfiledBoundObject>();
-        if (pobj.isNull())
-        {
-            return o;
-        }
-        else
-        {
-            return pobj->GetDelegate();
-        }
-    }
-
 }
@@ -347,11 +347,6 @@ namespace tide
          */
         virtual std::string& GetType();
 
-        /**
-         * Return the unwrapped version of this object
-         */
-        static TiObjectRef Unwrap(TiObjectRef);
-
         /**
          * If this object is already exposed as an AutoPtr, this method
          * returns a shared version of this object
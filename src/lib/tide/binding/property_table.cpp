@@ -0,0 +1,457 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "../tide.h"
+#include "../atomic.h"
+#include <algorithm>
+#include <Poco/Thread.h>
+
+namespace tide
+{
+    static const size_t INITIAL_CAPACITY = 16;
+
+    // Past this many retired items a writer stops waiting for a moment
+    // with no readers at all and waits out a grace period instead.
+    static const size_t RETIRE_LIMIT = 32;
+
+    template <typename T>
+    static inline T* LoadSlot(T* volatile* slot)
+    {
+        return (T*) Atomic::LoadPointer((void* volatile*) slot);
+    }
+
+    template <typename T>
+    static inline void StoreSlot(T* volatile* slot, T* value)
+    {
+        Atomic::StorePointer((void* volatile*) slot, (void*) value);
+    }
+
+    // Readers are counted in one of two phases. A grace period flips the
+    // phase and waits for the readers of the old one to leave, after which
+    // nothing unpublished before the flip can still be in use. The counters
+    // are shared by every table and spread over separate cache lines, so
+    // threads reading the same hot object do not all update one counter.
+    // They are plain integers so that they are usable during static
+    // initialization.
+    static const size_t READER_STRIPES = 16;
+
+    struct ReaderStripe
+    {
+        volatile unsigned int count;
+        char padding[64 - sizeof(unsigned int)];
+    };
+
+    static ReaderStripe readerStripes[2][READER_STRIPES];
+    static volatile unsigned int readerPhase;
+    static volatile unsigned int graceLock;
+
+    static size_t StripeForThread()
+    {
+        // Threads have their stacks in different places, so the address of
+        // a local spreads them over the stripes without a thread-local lookup.
+        char local;
+        size_t page = (size_t) &local >> 12;
+        return ((page * 2654435761u) >> 8) % READER_STRIPES;
+    }
+
+    // Marks this thread as reading a table for the duration of a lookup,
+    // which prevents writers from freeing anything it might still touch.
+    class ReadGuard
+    {
+    public:
+        ReadGuard()
+        {
+            size_t stripe = StripeForThread();
+            while (true)
+            {
+                unsigned int phase = Atomic::Load(&readerPhase);
+                counter = &readerStripes[phase & 1][stripe].count;
+                Atomic::Increment(counter);
+
+                // A grace period which flipped the phase in between may
+                // already have found this counter empty.
+                if (Atomic::Load(&readerPhase) == phase)
+                    break;
+                Atomic::Decrement(counter);
+            }
+        }
+
+        ~ReadGuard() { Atomic::Decrement(counter); }
+
+    private:
+        volatile unsigned int* counter;
+    };
+
+    static bool NoActiveReaders()
+    {
+        // A reader which increments a counter after it was checked arrived
+        // after the retired items were unpublished and cannot reach them.
+        for (size_t phase = 0; phase < 2; phase++)
+        {
+            for (size_t i = 0; i < READER_STRIPES; i++)
+            {
+                if (Atomic::Load(&readerStripes[phase][i].count) != 0)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    static void WaitForReaders()
+    {
+        // Grace periods run one at a time, otherwise a second flip would
+        // send new readers back to the counters the first one waits on.
+        while (!Atomic::CompareAndSwap(&graceLock, 0, 1))
+            Poco::Thread::yield();
+
+        unsigned int phase = Atomic::Load(&readerPhase);
+        Atomic::Store(&readerPhase, phase + 1);
+        Atomic::Barrier();
+
+        ReaderStripe* old = readerStripes[phase & 1];
+        for (size_t i = 0; i < READER_STRIPES; i++)
+        {
+            while (Atomic::Load(&old[i].count) != 0)
+                Poco::Thread::yield();
+        }
+
+        Atomic::Store(&graceLock, 0);
+    }
+
+    PropertyTable::PropertyTable() :
+        table(0),
+        localAtoms(0)
+    {
+    }
+
+    PropertyTable::~PropertyTable()
+    {
+        Table* current = this->table;
+        if (current)
+        {
+            for (size_t i = 0; i < current->capacity; i++)
+            {
+                if (current->slots[i].value)
+                    current->slots[i].value->release();
+                Atom::DeleteLocal(current->slots[i].atom);
+            }
+            DeleteTable(current);
+        }
+
+        for (size_t i = 0; i < retiredValues.size(); i++)
+            retiredValues[i]->release();
+        for (size_t i = 0; i < retiredTables.size(); i++)
+            DeleteTable(retiredTables[i]);
+        for (size_t i = 0; i < retiredAtoms.size(); i++)
+            Atom::DeleteLocal(retiredAtoms[i]);
+    }
+
+    PropertyTable::Table* PropertyTable::NewTable(size_t capacity)
+    {
+        Table* table = new Table();
+        table->capacity = capacity;
+        table->used = 0;
+        table->slots = new Slot[capacity];
+        for (size_t i = 0; i < capacity; i++)
+        {
+            table->slots[i].atom = 0;
+            table->slots[i].value = 0;
+        }
+        return table;
+    }
+
+    void PropertyTable::DeleteTable(Table* table)
+    {
+        delete [] table->slots;
+        delete table;
+    }
+
+    PropertyTable::Slot* PropertyTable::FindSlot(Table* table, const Atom* atom)
+    {
+        // Returns the slot holding the atom, or the empty slot
+        // where it would be inserted.
+        size_t mask = table->capacity - 1;
+        for (size_t i = atom->HashCode() & mask; ; i = (i + 1) & mask)
+        {
+            const Atom* slotAtom = LoadSlot(&table->slots[i].atom);
+            if (!slotAtom || slotAtom->Matches(atom))
+                return &table->slots[i];
+        }
+    }
+
+    PropertyTable::Slot* PropertyTable::FindSlot(Table* table,
+        const char* name, unsigned int hash)
+    {
+        size_t mask = table->capacity - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            const Atom* slotAtom = LoadSlot(&table->slots[i].atom);
+            if (!slotAtom || slotAtom->Matches(name, hash))
+                return &table->slots[i];
+        }
+    }
+
+    ValueRef PropertyTable::ValueOf(Slot* slot)
+    {
+        // Called inside a ReadGuard, so that we take our reference
+        // before the value can be released.
+        if (!slot->atom)
+            return 0;
+
+        Value* value = LoadSlot(&slot->value);
+        if (!value)
+            return 0;
+        return ValueRef(value, true);
+    }
+
+    ValueRef PropertyTable::Get(const char* name)
+    {
+        // Without local keys a name which was never interned can't be
+        // here, and the interned table answers that without a guard.
+        if (Atomic::Load(&this->localAtoms) == 0)
+        {
+            const Atom* atom = Atom::Find(name);
+            return atom ? this->Get(atom) : 0;
+        }
+
+        unsigned int hash = Atom::Hash(name);
+        ReadGuard guard;
+        Table* current = LoadSlot(&this->table);
+        if (!current)
+            return 0;
+        return ValueOf(FindSlot(current, name, hash));
+    }
+
+    ValueRef PropertyTable::Get(const Atom* atom)
+    {
+        ReadGuard guard;
+        Table* current = LoadSlot(&this->table);
+        if (!current)
+            return 0;
+        return ValueOf(FindSlot(current, atom));
+    }
+
+    bool PropertyTable::Has(const char* name)
+    {
+        return !this->Get(name).isNull();
+    }
+
+    void PropertyTable::Set(const char* name, ValueRef value)
+    {
+        // Names known to native code are interned already. Script-supplied
+        // ones are not interned for them, since interned names are never freed.
+        const Atom* atom = Atom::Find(name);
+        if (atom)
+        {
+            this->Set(atom, value);
+            return;
+        }
+
+        Poco::FastMutex::ScopedLock lock(writeMutex);
+        unsigned int hash = Atom::Hash(name);
+        Slot* slot = this->table ? FindSlot(this->table, name, hash) : 0;
+        if (slot && slot->atom)
+            this->Replace(slot, value);
+        else
+            this->Insert(Atom::NewLocal(name, hash), value);
+    }
+
+    void PropertyTable::Set(const Atom* atom, ValueRef value)
+    {
+        Poco::FastMutex::ScopedLock lock(writeMutex);
+        Slot* slot = this->table ? FindSlot(this->table, atom) : 0;
+        if (slot && slot->atom)
+            this->Replace(slot, value);
+        else
+            this->Insert(atom, value);
+    }
+
+    void PropertyTable::Replace(Slot* slot, ValueRef value)
+    {
+        // Called with the write lock held.
+        Value* newValue = value.get();
+        if (newValue)
+            newValue->duplicate();
+
+        Value* oldValue = slot->value;
+        StoreSlot(&slot->value, newValue);
+        this->Retire(oldValue);
+        this->Reclaim();
+    }
+
+    void PropertyTable::Insert(const Atom* atom, ValueRef value)
+    {
+        // Called with the write lock held.
+        Value* newValue = value.get();
+        if (newValue)
+            newValue->duplicate();
+
+        if (!this->table || (this->table->used + 1) * 4 > this->table->capacity * 3)
+            this->Grow();
+        Slot* slot = FindSlot(this->table, atom);
+
+        // Publish the value before the key, so that a reader which
+        // finds the key is guaranteed to also see the value.
+        StoreSlot(&slot->value, newValue);
+        StoreSlot(&slot->atom, atom);
+        this->table->used++;
+        if (!atom->IsInterned())
+            Atomic::Store(&this->localAtoms, this->localAtoms + 1);
+        this->Reclaim();
+    }
+
+    void PropertyTable::Unset(const char* name)
+    {
+        Poco::FastMutex::ScopedLock lock(writeMutex);
+        if (!this->table)
+            return;
+
+        // The key stays behind so that the slot can be reused
+        // if the property is set again.
+        Slot* slot = FindSlot(this->table, name, Atom::Hash(name));
+        if (!slot->atom || !slot->value)
+            return;
+
+        Value* oldValue = slot->value;
+        StoreSlot(&slot->value, (Value*) 0);
+        this->Retire(oldValue);
+        this->Reclaim();
+    }
+
+    void PropertyTable::GetNames(StringList& names)
+    {
+        std::vector<std::string> sorted;
+        {
+            ReadGuard guard;
+            Table* current = LoadSlot(&this->table);
+            if (!current)
+                return;
+
+            for (size_t i = 0; i < current->capacity; i++)
+            {
+                const Atom* atom = LoadSlot(&current->slots[i].atom);
+                if (atom && LoadSlot(&current->slots[i].value))
+                    sorted.push_back(atom->Name());
+            }
+        }
+
+        // Callers have always received names in sorted order.
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); i++)
+            names.push_back(new std::string(sorted[i]));
+    }
+
+    void PropertyTable::Grow()
+    {
+        // Called with the write lock held. Removed properties are
+        // dropped here rather than copied into the new table, along
+        // with their keys if those are local.
+        Table* oldTable = this->table;
+        size_t capacity = INITIAL_CAPACITY;
+        if (oldTable)
+        {
+            size_t live = 0;
+            for (size_t i = 0; i < oldTable->capacity; i++)
+            {
+                if (oldTable->slots[i].value)
+                    live++;
+            }
+            while ((live + 1) * 2 > capacity)
+                capacity *= 2;
+        }
+
+        Table* newTable = NewTable(capacity);
+        if (oldTable)
+        {
+            for (size_t i = 0; i < oldTable->capacity; i++)
+            {
+                Slot& oldSlot = oldTable->slots[i];
+                if (!oldSlot.value)
+                {
+                    const Atom* atom = oldSlot.atom;
+                    if (atom && !atom->IsInterned())
+                    {
+                        retiredAtoms.push_back(atom);
+                        Atomic::Store(&this->localAtoms, this->localAtoms - 1);
+                    }
+                    continue;
+                }
+
+                Slot* slot = FindSlot(newTable, oldSlot.atom);
+                slot->atom = oldSlot.atom;
+                slot->value = oldSlot.value;
+                newTable->used++;
+            }
+            retiredTables.push_back(oldTable);
+        }
+
+        StoreSlot(&this->table, newTable);
+    }
+
+    void PropertyTable::Retire(Value* value)
+    {
+        if (value)
+            retiredValues.push_back(value);
+    }
+
+    void PropertyTable::Reclaim()
+    {
+        // Called with the write lock held, after the retired items were
+        // unpublished. A reader which arrives after this point can no longer
+        // reach them, so if no reader is active right now they are safe to free.
+        size_t retired = retiredValues.size() + retiredTables.size() +
+            retiredAtoms.size();
+        if (retired == 0)
+            return;
+
+        Atomic::Barrier();
+        if (!NoActiveReaders())
+        {
+            // Under steady reads that moment may never come.
+            if (retired < RETIRE_LIMIT)
+                return;
+            WaitForReaders();
+        }
+
+        for (size_t i = 0; i < retiredValues.size(); i++)
+            retiredValues[i]->release();
+        for (size_t i = 0; i < retiredTables.size(); i++)
+            DeleteTable(retiredTables[i]);
+        for (size_t i = 0; i < retiredAtoms.size(); i++)
+            Atom::DeleteLocal(retiredAtoms[i]);
+        retiredValues.clear();
+        retiredTables.clear();
+        retiredAtoms.clear();
+    }
+}
@@ -0,0 +1,109 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _PROPERTY_TABLE_H_
+#define _PROPERTY_TABLE_H_
+
+#include <vector>
+#include <Poco/Mutex.h>
+
+namespace tide
+{
+    /**
+     * The property storage behind StaticBoundObject: an open-addressed hash
+     * table keyed by Atom pointers. Names which were never interned, such as
+     * the keys of script which uses an object as a map, get local Atoms owned
+     * by the table, which are freed once their property is gone.
+     *
+     * Reads never take a lock and never allocate. Writers are serialized on
+     * a mutex and never modify anything a reader might be looking at in
+     * place. Values which are replaced or removed, and tables which are
+     * outgrown, are retired and released after a grace period, once every
+     * read which might still see them has finished.
+     */
+    class TIDE_API PropertyTable
+    {
+    public:
+        PropertyTable();
+        ~PropertyTable();
+
+        /**
+         * Return the value of a property or a NULL reference if
+         * this table does not contain it.
+         */
+        ValueRef Get(const char* name);
+        ValueRef Get(const Atom* atom);
+        bool Has(const char* name);
+        void Set(const char* name, ValueRef value);
+        void Set(const Atom* atom, ValueRef value);
+        void Unset(const char* name);
+        void GetNames(StringList& names);
+
+    private:
+        struct Slot
+        {
+            const Atom* volatile atom;
+            Value* volatile value;
+        };
+
+        struct Table
+        {
+            size_t capacity;
+            size_t used;
+            Slot* slots;
+        };
+
+        Table* volatile table;
+        volatile unsigned int localAtoms;
+        Poco::FastMutex writeMutex;
+        std::vector<Value*> retiredValues;
+        std::vector<Table*> retiredTables;
+        std::vector<const Atom*> retiredAtoms;
+
+        static Table* NewTable(size_t capacity);
+        static void DeleteTable(Table* table);
+        static Slot* FindSlot(Table* table, const Atom* atom);
+        static Slot* FindSlot(Table* table, const char* name, unsigned int hash);
+        static ValueRef ValueOf(Slot* slot);
+        void Replace(Slot* slot, ValueRef value);
+        void Insert(const Atom* atom, ValueRef value);
+        void Grow();
+        void Retire(Value* value);
+        void Reclaim();
+
+        DISALLOW_EVIL_CONSTRUCTORS(PropertyTable);
+    };
+}
+
+#endif
@@ -0,0 +1,188 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "../tide.h"
+#include "../atomic.h"
+#include <algorithm>
+#include <cctype>
+#include <set>
+
+namespace tide
+{
+    static std::string AccessorKey(std::string name)
+    {
+        // Accessor names are compared case-insensitively.
+        std::transform(name.begin(), name.end(), name.begin(), tolower);
+        return name;
+    }
+
+    Prototype::Prototype(const Prototype* parent) :
+        parent(parent)
+    {
+    }
+
+    Prototype::~Prototype()
+    {
+        for (MemberMap::iterator i = members.begin(); i != members.end(); i++)
+            delete i->second.binder;
+    }
+
+    /*static*/
+    const Prototype* Prototype::GetOnce(const Prototype* volatile* slot,
+        Prototype* (*create)())
+    {
+        void* volatile* pointer = (void* volatile*) slot;
+        const Prototype* prototype = static_cast<const Prototype*>(
+            Atomic::LoadPointer(pointer));
+        if (prototype)
+            return prototype;
+
+        Prototype* created = create();
+        if (Atomic::CompareAndSwapPointer(pointer, 0, created))
+            return created;
+
+        delete created;
+        return static_cast<const Prototype*>(Atomic::LoadPointer(pointer));
+    }
+
+    void Prototype::AddMember(const char* name, ValueRef value, Binder* binder)
+    {
+        const Atom* atom = Atom::Intern(name);
+        MemberMap::iterator i = members.find(atom);
+        if (i == members.end())
+        {
+            this->names.push_back(atom);
+        }
+        else
+        {
+            delete i->second.binder;
+        }
+
+        Member& member = members[atom];
+        member.value = value;
+        member.binder = binder;
+    }
+
+    void Prototype::Set(const char* name, ValueRef value)
+    {
+        this->AddMember(name, value, 0);
+    }
+
+    void Prototype::AddMethod(const char* name, Binder* binder)
+    {
+        this->AddMember(name, 0, binder);
+
+        std::string methodName(name);
+        if (methodName.find("set") == 0)
+            setters[AccessorKey(methodName.substr(3))] = Atom::Intern(name);
+        else if (methodName.find("get") == 0)
+            getters[AccessorKey(methodName.substr(3))] = Atom::Intern(name);
+        else if (methodName.find("is") == 0)
+            getters[AccessorKey(methodName.substr(2))] = Atom::Intern(name);
+    }
+
+    const Prototype::Member* Prototype::Find(const Atom* atom) const
+    {
+        for (const Prototype* prototype = this; prototype; prototype = prototype->parent)
+        {
+            MemberMap::const_iterator i = prototype->members.find(atom);
+            if (i != prototype->members.end())
+                return &i->second;
+        }
+        return 0;
+    }
+
+    ValueRef Prototype::Get(StaticBoundObject* object, const Atom* atom, bool& bound) const
+    {
+        bound = false;
+        const Member* member = this->Find(atom);
+        if (!member)
+            return 0;
+
+        if (!member->binder)
+            return member->value;
+
+        bound = true;
+        return Value::NewMethod(member->binder->Bind(object, atom));
+    }
+
+    bool Prototype::Has(const Atom* atom) const
+    {
+        return this->Find(atom) != 0;
+    }
+
+    void Prototype::GetNames(StringList& names) const
+    {
+        // Members of a parent which are redefined by a child are only listed once.
+        std::set<const Atom*> seen;
+        for (const Prototype* prototype = this; prototype; prototype = prototype->parent)
+        {
+            for (size_t i = 0; i < prototype->names.size(); i++)
+            {
+                if (seen.insert(prototype->names[i]).second)
+                    names.push_back(new std::string(prototype->names[i]->Name()));
+            }
+        }
+    }
+
+    const Atom* Prototype::FindAccessor(const char* name, const AccessorNames& accessors)
+    {
+        AccessorNames::const_iterator i = accessors.find(AccessorKey(name));
+        if (i == accessors.end())
+            return 0;
+        return i->second;
+    }
+
+    const Atom* Prototype::FindGetter(const char* name) const
+    {
+        for (const Prototype* prototype = this; prototype; prototype = prototype->parent)
+        {
+            const Atom* getter = FindAccessor(name, prototype->getters);
+            if (getter)
+                return getter;
+        }
+        return 0;
+    }
+
+    const Atom* Prototype::FindSetter(const char* name) const
+    {
+        for (const Prototype* prototype = this; prototype; prototype = prototype->parent)
+        {
+            const Atom* setter = FindAccessor(name, prototype->setters);
+            if (setter)
+                return setter;
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,173 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _PROTOTYPE_H_
+#define _PROTOTYPE_H_
+
+#include <map>
+#include <string>
+
+namespace tide
+{
+    /**
+     * The methods and constants shared by every instance of a bound class.
+     * StaticBoundObject::Get falls back to an object's prototype for names
+     * the object does not define itself, so that creating an instance does
+     * not have to allocate a bound method and a table entry for every member
+     * of its class. A method is only bound to an instance the first time
+     * that instance looks it up. An instance may shadow a member by setting
+     * a property of the same name, but cannot remove it.
+     *
+     * A prototype is fully populated before GetOnce publishes it, and is
+     * never modified afterwards, so lookups do not lock. Prototypes are
+     * expected to live for the lifetime of the process, like Atoms.
+     * \code
+     * static Prototype* CreatePrototype()
+     * {
+     *   Prototype* prototype = new Prototype();
+     *   prototype->SetMethod("add", &MyObject::Add);
+     *   prototype->Set("VERSION", Value::NewInt(2));
+     *   return prototype;
+     * }
+     *
+     * static const Prototype* volatile prototype = 0;
+     * const Prototype* MyObject::GetPrototype()
+     * {
+     *   return Prototype::GetOnce(&prototype, &CreatePrototype);
+     * }
+     *
+     * MyObject::MyObject() : StaticBoundObject("MyObject", GetPrototype()) {}
+     * \endcode
+     */
+    class TIDE_API Prototype
+    {
+    public:
+        Prototype(const Prototype* parent = 0);
+        ~Prototype();
+
+        /**
+         * Return the prototype stored in slot, creating it first if slot is
+         * still NULL. Function-local statics are not initialized thread-safely
+         * by every compiler we build with, and the first instances of a class
+         * may be made on several threads at once. When two threads race, one
+         * prototype wins and the other is deleted before anyone sees it.
+         */
+        static const Prototype* GetOnce(const Prototype* volatile* slot,
+            Prototype* (*create)());
+
+        /**
+         * Add a constant. The value is shared by all instances, so
+         * it should never be modified.
+         */
+        void Set(const char* name, ValueRef value);
+
+        /**
+         * Add a method. T must be the class of the objects using this
+         * prototype, or one of their base classes.
+         */
+        template <typename T>
+        void SetMethod(const char* name, void (T::*method)(const ValueList&, ValueRef))
+        {
+            this->AddMethod(name, new MethodBinder<T>(method));
+        }
+
+        /**
+         * Return the member with the given name, or a NULL reference if
+         * neither this prototype nor its parents define it. Methods are
+         * bound to the given object, in which case bound is set to true.
+         */
+        ValueRef Get(StaticBoundObject* object, const Atom* atom, bool& bound) const;
+        bool Has(const Atom* atom) const;
+        void GetNames(StringList& names) const;
+
+        /**
+         * Return the name of the method implementing the getter or setter
+         * for a property, following the same case-insensitive "getX",
+         * "isX" and "setX" conventions as Accessor, or NULL if there is none.
+         */
+        const Atom* FindGetter(const char* name) const;
+        const Atom* FindSetter(const char* name) const;
+
+    private:
+        class Binder
+        {
+        public:
+            virtual ~Binder() {}
+            virtual TiMethodRef Bind(StaticBoundObject* object, const Atom* atom) const = 0;
+        };
+
+        template <typename T>
+        class MethodBinder : public Binder
+        {
+        public:
+            typedef void (T::*Method)(const ValueList&, ValueRef);
+            MethodBinder(Method method) : method(method) {}
+
+            TiMethodRef Bind(StaticBoundObject* object, const Atom* atom) const
+            {
+                // Named like the methods StaticBoundObject::SetMethod creates.
+                return new StaticBoundMethod(
+                    NewCallback<T, const ValueList&, ValueRef>(static_cast<T*>(object), method),
+                    object, atom);
+            }
+
+        private:
+            Method method;
+        };
+
+        struct Member
+        {
+            ValueRef value;
+            Binder* binder;
+        };
+
+        typedef std::map<const Atom*, Member> MemberMap;
+        typedef std::map<std::string, const Atom*> AccessorNames;
+
+        const Prototype* parent;
+        MemberMap members;
+        std::vector<const Atom*> names;
+        AccessorNames getters;
+        AccessorNames setters;
+
+        void AddMember(const char* name, ValueRef value, Binder* binder);
+        void AddMethod(const char* name, Binder* binder);
+        const Member* Find(const Atom* atom) const;
+        static const Atom* FindAccessor(const char* name, const AccessorNames& accessors);
+
+        DISALLOW_EVIL_CONSTRUCTORS(Prototype);
+    };
+}
+
+#endif
@@ -0,0 +1,112 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _SMALL_VALUE_LIST_H_
+#define _SMALL_VALUE_LIST_H_
+
+#include <vector>
+#include <stdexcept>
+
+namespace tide
+{
+    /**
+     * A list of values which keeps its first few entries inline, so that
+     * building the argument list for a typical method call does not touch
+     * the heap. Longer lists spill over into a vector.
+     */
+    class TIDE_API SmallValueList
+    {
+    public:
+        static const size_t INLINE_CAPACITY = 6;
+
+        SmallValueList() : count(0) {}
+
+        SmallValueList(const SmallValueList& other) : count(0)
+        {
+            for (size_t i = 0; i < other.count; i++)
+                this->push_back(other[i]);
+        }
+
+        SmallValueList& operator=(const SmallValueList& other)
+        {
+            if (this != &other)
+            {
+                this->clear();
+                for (size_t i = 0; i < other.count; i++)
+                    this->push_back(other[i]);
+            }
+            return *this;
+        }
+
+        void push_back(ValueRef value)
+        {
+            if (count < INLINE_CAPACITY)
+                inlineValues[count] = value;
+            else
+                overflow.push_back(value);
+            count++;
+        }
+
+        void clear()
+        {
+            for (size_t i = 0; i < count && i < INLINE_CAPACITY; i++)
+                inlineValues[i] = 0;
+            overflow.clear();
+            count = 0;
+        }
+
+        size_t size() const { return count; }
+
+        const ValueRef& operator[](size_t index) const
+        {
+            if (index < INLINE_CAPACITY)
+                return inlineValues[index];
+            return overflow[index - INLINE_CAPACITY];
+        }
+
+        const ValueRef& at(size_t index) const
+        {
+            if (index >= count)
+                throw std::out_of_range("SmallValueList::at");
+            return (*this)[index];
+        }
+
+    private:
+        ValueRef inlineValues[INLINE_CAPACITY];
+        std::vector<ValueRef> overflow;
+        size_t count;
+    };
+}
+
+#endif
@@ -50,6 +50,15 @@ namespace tide
     {
     }
 
+    SnapshotList::SnapshotList() :
+        StaticBoundList("SnapshotList")
+    {
+    }
+
+    SnapshotList::~SnapshotList()
+    {
+    }
+
     void StaticBoundList::Append(ValueRef value)
     {
         std::string name = TiList::IntToChars(this->length);
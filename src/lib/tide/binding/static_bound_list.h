@@ -103,6 +103,19 @@ namespace tide
     private:
         DISALLOW_EVIL_CONSTRUCTORS(StaticBoundList);
     };
+
+    /**
+     * A list which is handed to scripts as a copy in their own array type,
+     * rather than wrapped. Reading a copied array does not call back into
+     * native code, but later changes to the list are not seen by scripts,
+     * so only use it for results which are built once.
+     */
+    class TIDE_API SnapshotList : public StaticBoundList
+    {
+    public:
+        SnapshotList();
+        virtual ~SnapshotList();
+    };
 }
 
 #endif
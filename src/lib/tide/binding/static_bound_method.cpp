@@ -33,11 +33,20 @@
 **/
 
 #include "../tide.h"
+#include "../atomic.h"
 
 namespace tide
 {
     StaticBoundMethod::StaticBoundMethod(MethodCallback* callback, const char *type)
-        : TiMethod(type), callback(callback)
+        : TiMethod(type), callback(callback), owner(0), name(0), profilePath(0)
+    {
+        this->object = new StaticBoundObject();
+    }
+
+    StaticBoundMethod::StaticBoundMethod(MethodCallback* callback, TiObject* owner,
+        const Atom* name)
+        : TiMethod("StaticBoundMethod"), callback(callback), owner(owner), name(name),
+        profilePath(0)
     {
         this->object = new StaticBoundObject();
     }
@@ -48,6 +57,9 @@ namespace tide
 
     ValueRef StaticBoundMethod::Call(const ValueList& args)
     {
+        Profiler::Scope scope(Profiler::CALL, Profiler::IsEnabled() ?
+            this->GetProfilePath() : 0);
+
         ValueRef tv = Value::NewUndefined();
         if (this->callback)
         {
@@ -56,6 +68,28 @@ namespace tide
         return tv;
     }
 
+    const Atom* StaticBoundMethod::GetProfilePath()
+    {
+        // Two threads may both build the path, but they intern the same atom.
+        const Atom* path = static_cast<const Atom*>(
+            Atomic::LoadPointer((void* volatile*) &this->profilePath));
+        if (path)
+            return path;
+
+        if (this->owner && this->name)
+        {
+            std::string type(this->owner->GetType() + "." + this->name->Name());
+            path = Atom::Intern(type.c_str());
+        }
+        else
+        {
+            path = Atom::Intern(this->GetType().c_str());
+        }
+
+        Atomic::StorePointer((void* volatile*) &this->profilePath, (void*) path);
+        return path;
+    }
+
     void StaticBoundMethod::Set(const char *name, ValueRef value)
     {
         this->object->Set(name, value);
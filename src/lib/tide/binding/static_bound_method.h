@@ -43,6 +43,14 @@ namespace tide
     public:
 
         StaticBoundMethod(MethodCallback* callback, const char *type = "StaticBoundMethod");
+
+        /**
+         * A method which belongs to owner under the given name. It shows
+         * up in profiles as "<owner type>.<name>", e.g. "Filesystem.getFile",
+         * but that path is only built once the method is called while the
+         * profiler is running.
+         */
+        StaticBoundMethod(MethodCallback* callback, TiObject* owner, const Atom* name);
         virtual ~StaticBoundMethod();
 
         /**
@@ -91,6 +99,12 @@ namespace tide
         AutoPtr<StaticBoundObject> object;
         std::map<std::string, ValueRef > properties;
 
+        const Atom* GetProfilePath();
+
+        TiObject* owner;
+        const Atom* name;
+        const Atom* volatile profilePath;
+
     private:
         DISALLOW_EVIL_CONSTRUCTORS(StaticBoundMethod);
     };
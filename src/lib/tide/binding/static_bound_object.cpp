@@ -34,11 +34,13 @@
 
 #include "../tide.h"
 #include <cstring>
+#include <set>
 
 namespace tide
 {
-    StaticBoundObject::StaticBoundObject(const char* type)
-        : TiObject(type)
+    StaticBoundObject::StaticBoundObject(const char* type, const Prototype* prototype)
+        : TiObject(type),
+        prototype(prototype)
     {
     }
 
@@ -48,46 +50,72 @@ namespace tide
 
     bool StaticBoundObject::HasProperty(const char* name)
     {
-        return properties.find(name) != properties.end();
+        // Names which were never interned can still be set from script,
+        // but the prototype only has interned ones.
+        const Atom* atom = Atom::Find(name);
+        if (!atom)
+            return properties.Has(name);
+        if (!properties.Get(atom).isNull())
+            return true;
+        return this->prototype && this->prototype->Has(atom);
     }
     
     ValueRef StaticBoundObject::Get(const char* name)
     {
-        Poco::Mutex::ScopedLock lock(mutex);
-        std::map<std::string, ValueRef>::iterator iter = 
-            properties.find(std::string(name));
+        const Atom* atom = Atom::Find(name);
+        if (!atom)
+        {
+            ValueRef value(properties.Get(name));
+            return value.isNull() ? Value::Undefined : value;
+        }
 
-        if (iter == properties.end())
+        ValueRef value(properties.Get(atom));
+        if (value.isNull() && this->prototype)
+        {
+            bool bound;
+            value = this->prototype->Get(this, atom, bound);
+
+            // Keep methods once they are bound, so that later lookups
+            // return the same method without binding it again.
+            if (bound)
+                properties.Set(atom, value);
+        }
+
+        if (value.isNull())
             return Value::Undefined;
-        return iter->second;
+        return value;
     }
 
     void StaticBoundObject::Set(const char* name, ValueRef value)
     {
-        Poco::Mutex::ScopedLock lock(mutex);
-        this->properties[std::string(name)] = value;
+        properties.Set(name, value);
     }
 
     void StaticBoundObject::Unset(const char* name)
     {
-        Poco::Mutex::ScopedLock lock(mutex);
-        std::map<std::string, ValueRef>::iterator iter = 
-            properties.find(std::string(name));
-
-        if (this->properties.end() == iter)
-            return;
-        this->properties.erase(iter);
+        properties.Unset(name);
     }
 
     SharedStringList StaticBoundObject::GetPropertyNames()
     {
         SharedStringList list(new StringList());
-        Poco::Mutex::ScopedLock lock(mutex);
-        std::map<std::string, ValueRef>::iterator iter = properties.begin();
+        properties.GetNames(*list);
+        if (!this->prototype)
+            return list;
+
+        // Merge in the prototype's members, keeping the names sorted.
+        std::set<std::string> names;
+        for (size_t i = 0; i < list->size(); i++)
+            names.insert(*list->at(i));
 
-        while (iter != properties.end())
-            list->push_back(new std::string((iter++)->first));
+        StringList prototypeNames;
+        this->prototype->GetNames(prototypeNames);
+        for (size_t i = 0; i < prototypeNames.size(); i++)
+            names.insert(*prototypeNames[i]);
 
+        list->clear();
+        for (std::set<std::string>::iterator i = names.begin(); i != names.end(); i++)
+            list->push_back(new std::string(*i));
         return list;
     }
 }
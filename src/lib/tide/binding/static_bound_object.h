@@ -66,11 +66,16 @@ namespace tide
      * alert(myObject.description); // "my object"
      * alert(myObject.add(10, 15)); // 25
      * \endcode
+     *
+     * Classes with many instances should put their methods and constants in
+     * a shared Prototype instead, so that each instance only stores the
+     * properties which are actually its own.
      */
     class TIDE_API StaticBoundObject : public TiObject
     {
     public:
-        StaticBoundObject(const char* type = "StaticBoundObject");
+        StaticBoundObject(const char* type = "StaticBoundObject",
+            const Prototype* prototype = 0);
         virtual ~StaticBoundObject();
 
         virtual bool HasProperty(const char* name);
@@ -86,13 +91,17 @@ namespace tide
         template <typename T>
         void SetMethod(const char* name, void (T::*method)(const ValueList&, ValueRef))
         {
+            // Name the method after its owner, so that it shows up as
+            // "Filesystem.getFile" in profiles.
             this->Set(name, Value::NewMethod(new StaticBoundMethod(
-                NewCallback<T, const ValueList&, ValueRef>(static_cast<T*>(this), method))));
+                NewCallback<T, const ValueList&, ValueRef>(static_cast<T*>(this), method),
+                this, Atom::Intern(name))));
         }
 
 
     protected:
-        std::map<std::string, ValueRef> properties;
+        PropertyTable properties;
+        const Prototype* prototype;
         Poco::Mutex mutex;
 
     private:
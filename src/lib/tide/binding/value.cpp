@@ -35,9 +35,125 @@
 #include "../tide.h"
 #include <sstream>
 #include <cstring>
+#include <new>
+
+#ifdef OS_WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 namespace tide
 {
+    // Freed Values are kept on a per-thread singly-linked list, threaded
+    // through the freed memory itself. A thread's cache is released when
+    // the thread exits.
+    struct ValueCache
+    {
+        void* head;
+        size_t count;
+    };
+
+    static const size_t MAX_CACHED_VALUES = 512;
+
+    static void DestroyValueCache(void* data)
+    {
+        ValueCache* cache = static_cast<ValueCache*>(data);
+        while (cache->head)
+        {
+            void* next = *static_cast<void**>(cache->head);
+            ::operator delete(cache->head);
+            cache->head = next;
+        }
+        delete cache;
+    }
+
+#ifdef OS_WIN32
+    static void WINAPI DestroyValueCacheCallback(void* data)
+    {
+        if (data)
+            DestroyValueCache(data);
+    }
+
+    // Fiber-local storage is used because, unlike TlsAlloc, it
+    // runs a destructor when the thread exits.
+    static DWORD GetValueCacheKey()
+    {
+        static DWORD key = FlsAlloc(&DestroyValueCacheCallback);
+        return key;
+    }
+
+    static ValueCache* GetValueCache()
+    {
+        DWORD valueCacheKey = GetValueCacheKey();
+        ValueCache* cache = static_cast<ValueCache*>(FlsGetValue(valueCacheKey));
+        if (!cache)
+        {
+            cache = new ValueCache();
+            cache->head = 0;
+            cache->count = 0;
+            FlsSetValue(valueCacheKey, cache);
+        }
+        return cache;
+    }
+#else
+    static pthread_key_t valueCacheKey;
+    static pthread_once_t valueCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+    static void CreateValueCacheKey()
+    {
+        pthread_key_create(&valueCacheKey, &DestroyValueCache);
+    }
+
+    static ValueCache* GetValueCache()
+    {
+        pthread_once(&valueCacheKeyOnce, &CreateValueCacheKey);
+        ValueCache* cache = static_cast<ValueCache*>(pthread_getspecific(valueCacheKey));
+        if (!cache)
+        {
+            cache = new ValueCache();
+            cache->head = 0;
+            cache->count = 0;
+            pthread_setspecific(valueCacheKey, cache);
+        }
+        return cache;
+    }
+#endif
+
+    void* Value::operator new(size_t size)
+    {
+        if (size != sizeof(Value))
+            return ::operator new(size);
+
+        ValueCache* cache = GetValueCache();
+        if (!cache->head)
+            return ::operator new(size);
+
+        void* pointer = cache->head;
+        cache->head = *static_cast<void**>(pointer);
+        cache->count--;
+        return pointer;
+    }
+
+    void Value::operator delete(void* pointer, size_t size)
+    {
+        if (!pointer)
+            return;
+
+        // Values may be released on a different thread than the one which
+        // created them, in which case the memory simply migrates caches.
+        ValueCache* cache = size == sizeof(Value) ? GetValueCache() : 0;
+        if (!cache || cache->count >= MAX_CACHED_VALUES)
+        {
+            ::operator delete(pointer);
+            return;
+        }
+
+        *static_cast<void**>(pointer) = cache->head;
+        cache->head = pointer;
+        cache->count++;
+    }
+
     void Value::reset()
     {
         if (this->IsString() && this->stringValue)
@@ -136,6 +252,13 @@ namespace tide
         return v;
     }
 
+    ValueRef Value::NewString(const char* value, size_t length)
+    {
+        ValueRef v(new Value());
+        v->SetString(value, length);
+        return v;
+    }
+
     ValueRef Value::NewList(TiListRef value)
     {
         ValueRef v(new Value());
@@ -256,6 +379,15 @@ namespace tide
         this->SetString(value.get()->c_str());
     }
 
+    void Value::SetString(const char* value, size_t length)
+    {
+        reset();
+        this->stringValue = (char*) malloc(length + 1);
+        memcpy(this->stringValue, value, length);
+        this->stringValue[length] = '\0';
+        type = STRING;
+    }
+
     void Value::SetList(TiListRef value)
     {
         reset();
@@ -407,28 +539,4 @@ namespace tide
         else
             return unknownString;
     }
-
-    void Value::Unwrap(ValueRef value)
-    {
-        if (!Host::GetInstance()->ProfilingEnabled())
-        {
-            return;
-        }
-
-        if (value->IsMethod())
-        {
-            TiMethodRef method = TiMethod::Unwrap(value->ToMethod());
-            value->SetMethod(method);
-        }
-        else if (value->IsList())
-        {
-            TiListRef list = TiList::Unwrap(value->ToList());
-            value->SetList(list);
-        }
-        else if (value->IsObject())
-        {
-            TiObjectRef obj = TiObject::Unwrap(value->ToObject());
-            value->SetObject(obj);
-        }
-    }
 }
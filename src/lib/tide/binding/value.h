@@ -110,6 +110,14 @@ namespace tide
          */
         static ValueRef NewString(SharedString value);
 
+        /**
+         * Construct a new \link #Value::Type::STRING string\endlink value
+         * from a buffer which is not necessarily NUL-terminated.
+         * @param value The start of the string data
+         * @param length The number of bytes to copy
+         */
+        static ValueRef NewString(const char* value, size_t length);
+
         /**
          * Construct a new \link #Value::Type::LIST list\endlink value.
          * @param value The list value
@@ -285,6 +293,14 @@ namespace tide
          */
         void SetString(SharedString value);
 
+        /**
+         * Change the internal value of this Value to an \link #Value::Type::STRING string\endlink
+         * copied from a buffer which is not necessarily NUL-terminated
+         * @param value the start of the string data
+         * @param length the number of bytes to copy
+         */
+        void SetString(const char* value, size_t length);
+
         /**
          * Change the internal value of this Value to an \link #Value::Type::LIST list\endlink
          * @param value the list value
@@ -314,9 +330,12 @@ namespace tide
         void SetUndefined();
 
         /**
-         * Replace a value wth an unwrapped value
+         * Values are created and destroyed on every call between JavaScript
+         * and native code, so their memory comes from a small per-thread
+         * cache instead of going through the heap each time.
          */
-        static void Unwrap(ValueRef value);
+        static void* operator new(size_t size);
+        static void operator delete(void* pointer, size_t size);
 
     private:
         Type type;
@@ -45,9 +45,9 @@ using namespace TideUtils;
 
 #include "tide.h"
 #include "thread_manager.h"
+#include "thread_pool.h"
 #include <Poco/DirectoryIterator.h>
 #include <Poco/File.h>
-#include <Poco/FileStream.h>
 #include <Poco/Path.h>
 #include <Poco/Environment.h>
 #include <Poco/AutoPtr.h>
@@ -126,10 +126,11 @@ namespace tide
         waitForDebugger(false),
         autoScan(false),
         profile(false),
-        profileStream(0),
         consoleLogging(true),
         fileLogging(true),
-        logger(0)
+        logger(0),
+        threadPool(0),
+        jobBudget(16000)
     {
         hostInstance = this;
 
@@ -150,6 +151,11 @@ namespace tide
         this->SetupLogging();
         this->SetupProfiling();
 
+        // Shared pool for AsyncJobs and other background work. This is never
+        // joined on shutdown, because a pooled job may be blocked waiting on
+        // RunOnMainThread and the main loop is gone by then.
+        this->threadPool = new ThreadPool(2, 32, 60, 4096);
+
         // Call into the platform-specific initialization.
         this->Initialize(argc, argv);
     }
@@ -231,13 +237,9 @@ namespace tide
     {
         if (this->profile)
         {
-            // In the case of profiling, we wrap our top level global object
-            // to use the profiled bound object which will profile all methods
-            // going through this object and it's attached children
-            this->profileStream = new Poco::FileOutputStream(this->profilePath);
-            ProfiledBoundObject::SetStream(this->profileStream);
-            GlobalObject::TurnOnProfiling();
-
+            // Calls and property accesses are recorded into per-thread
+            // buffers and written out as a trace when the host stops.
+            Profiler::Start();
             logger->Info("Starting Profiler. Output going to %s", this->profilePath.c_str());
         }
     }
@@ -247,10 +249,16 @@ namespace tide
         if (this->profile)
         {
             logger->Info("Stopping Profiler");
-            ProfiledBoundObject::SetStream(0);
-            profileStream->flush();
-            profileStream->close();
-            profileStream = 0;
+            Profiler::Stop();
+            try
+            {
+                Profiler::WriteTrace(this->profilePath);
+            }
+            catch (ValueException& e)
+            {
+                logger->Error("Could not write profile: %s",
+                    e.ToString().c_str());
+            }
             this->profile = false;
         }
     }
@@ -729,7 +737,7 @@ namespace tide
     ValueRef Host::RunOnMainThread(TiMethodRef method, TiObjectRef thisObject,
         const ValueList& args, bool waitForCompletion)
     {
-        MainThreadJob* job = new MainThreadJob(method, thisObject,
+        MainThreadJob* job = this->jobQueue.AcquireJob(method, thisObject,
             args, waitForCompletion);
         if (this->IsMainThread() && waitForCompletion)
         {
@@ -737,12 +745,10 @@ namespace tide
         }
         else
         {
-            Poco::ScopedLock<Poco::Mutex> s(jobQueueMutex);
-            this->mainThreadJobs.push_back(job); // Enqueue job
+            this->jobQueue.Push(job);
+            this->SignalNewMainThreadJob();
         }
 
-        this->SignalNewMainThreadJob();
-
         if (!waitForCompletion)
         {
             return Value::Undefined; // Handler will cleanup
@@ -755,7 +761,7 @@ namespace tide
 
             ValueRef result(job->GetResult());
             ValueException exception(job->GetException());
-            delete job;
+            this->jobQueue.ReleaseJob(job);
 
             if (!result.isNull())
                 return result;
@@ -764,33 +770,31 @@ namespace tide
         }
     }
 
-    void Host::RunMainThreadJobs()
+    void Host::RunOnMainThreadCoalesced(const std::string& key, TiMethodRef method,
+        TiObjectRef thisObject, const ValueList& args)
     {
-        // Prevent other threads trying to queue while we clear the queue.
-        // But don't block the invocation task while we actually execute
-        // the jobs -- one of these jobs may try to add something to the
-        // job queue -- deadlock-o-rama
-        std::vector<MainThreadJob*> jobs;
-        {
-            Poco::ScopedLock<Poco::Mutex> s(jobQueueMutex);
-            jobs = this->mainThreadJobs;
-            this->mainThreadJobs.clear();
-        }
+        // Only signal for new jobs, an updated job is already on its way.
+        if (this->jobQueue.PushCoalesced(key, method, thisObject, args))
+            this->SignalNewMainThreadJob();
+    }
 
-        for (size_t i = 0; i < jobs.size(); i++)
-        {
-            MainThreadJob* job = jobs[i];
+    void Host::SetMainThreadJobBudget(int milliseconds)
+    {
+        this->jobBudget = milliseconds * 1000;
+    }
 
-            // Job might be freed soon after Execute(), so get this value now.
-            bool asynchronous = !job->ShouldWaitForCompletion();
-            job->Execute();
+    int Host::GetMainThreadJobBudget()
+    {
+        return this->jobBudget / 1000;
+    }
 
-            if (asynchronous)
-            {
-                job->PrintException();
-                delete job;
-            }
-        }
+    void Host::RunMainThreadJobs()
+    {
+        // Jobs are popped one at a time, so a job which spins a nested
+        // event loop and re-enters this method simply continues draining
+        // the same queue. If the budget runs out, ask for another turn.
+        if (this->jobQueue.Run(this->jobBudget))
+            this->SignalNewMainThreadJob();
     }
 
     ValueRef RunOnMainThread(TiMethodRef method, const ValueList& args,
@@ -802,7 +806,13 @@ namespace tide
     ValueRef RunOnMainThread(TiMethodRef method, TiObjectRef thisObject,
         const ValueList& args, bool waitForCompletion)
     {
-        return hostInstance->RunOnMainThread(method, args, waitForCompletion);
+        return hostInstance->RunOnMainThread(method, thisObject, args, waitForCompletion);
+    }
+
+    void RunOnMainThreadCoalesced(const std::string& key, TiMethodRef method,
+        TiObjectRef thisObject, const ValueList& args)
+    {
+        hostInstance->RunOnMainThreadCoalesced(key, method, thisObject, args);
     }
 
     bool IsMainThread()
@@ -44,6 +44,7 @@ using namespace TideUtils;
 namespace tide
 {
     class Module;
+    class ThreadPool;
     typedef std::vector<SharedPtr<Module> > ModuleList;
 
     /**
@@ -58,9 +59,9 @@ namespace tide
 
         inline SharedApplication GetApplication() { return this->application; }
         inline bool DebugModeEnabled() { return this->debug; }
-        inline bool ProfilingEnabled() { return this->profile; }
         inline Poco::Timestamp::TimeDiff GetElapsedTime() { return timeStarted.elapsed(); }
         inline TiObjectRef GetGlobalObject() { return GlobalObject::GetInstance(); }
+        inline ThreadPool* GetThreadPool() { return this->threadPool; }
         /**
          * Get the host singleton.
          */
@@ -96,6 +97,26 @@ namespace tide
         ValueRef RunOnMainThread(TiMethodRef method, TiObjectRef thisObject,
             const ValueList& args, bool waitForCompletion=true);
 
+        /*
+         * Asynchronously invoke a method on the UI thread, replacing any job
+         * with the same coalescing key which is still waiting to run. Use this
+         * for notifications where only the latest state matters.
+         * @param key coalescing key, e.g. the event name plus the target address
+         * @param method method to execute on the main thread
+         * @param args method arguments
+         */
+        void RunOnMainThreadCoalesced(const std::string& key, TiMethodRef method,
+            TiObjectRef thisObject, const ValueList& args);
+
+        /**
+         * Set the longest time (in milliseconds) RunMainThreadJobs may spend
+         * before yielding back to the event loop.
+         */
+        void SetMainThreadJobBudget(int milliseconds);
+        int GetMainThreadJobBudget();
+
+        MainThreadJobQueue& GetMainThreadJobQueue() { return this->jobQueue; }
+
         /**
          * Add a module provider to the host
          */
@@ -172,13 +193,13 @@ namespace tide
         bool profile;
         std::string profilePath;
         std::string logFilePath;
-        Poco::FileOutputStream* profileStream;
         bool consoleLogging;
         bool fileLogging;
         Logger* logger;
+        ThreadPool* threadPool;
         Poco::Timestamp timeStarted;
-        Poco::Mutex jobQueueMutex;
-        std::vector<MainThreadJob*> mainThreadJobs;
+        MainThreadJobQueue jobQueue;
+        Poco::Timestamp::TimeDiff jobBudget;
         std::vector<std::string> invalidModuleFiles;
 
         ModuleProvider* FindModuleProvider(std::string& filename);
@@ -210,6 +231,8 @@ namespace tide
         bool waitForCompletion=true);
     TIDE_API ValueRef RunOnMainThread(TiMethodRef method, TiObjectRef thisObject,
         const ValueList& args, bool waitForCompletion=true);
+    TIDE_API void RunOnMainThreadCoalesced(const std::string& key, TiMethodRef method,
+        TiObjectRef thisObject, const ValueList& args);
     TIDE_API bool IsMainThread();
 }
 
@@ -39,6 +39,7 @@ using namespace TideUtils;
 
 #include "javascript_module.h"
 
+#include <JavaScriptCore/JSWeakObjectMapRefPrivate.h>
 #include <Poco/FileStream.h>
 #include <Poco/Mutex.h>
 
@@ -73,6 +74,36 @@ namespace JSUtil
     static void FinalizeCallback(JSObjectRef);
     static JSValueRef ToStringCallback(JSContextRef, JSObjectRef, JSObjectRef, size_t, const JSValueRef[], JSValueRef*);
     static JSValueRef EqualsCallback(JSContextRef, JSObjectRef, JSObjectRef, size_t, const JSValueRef[], JSValueRef*);
+    static JSValueRef BytesToArrayCallback(JSContextRef, JSObjectRef, JSObjectRef, size_t, const JSValueRef[], JSValueRef*);
+    static JSValueRef SnapshotListToJSArray(TiListRef, JSContextRef);
+
+    // Native values get one wrapper per global object, so that a value which
+    // crosses into JavaScript twice is === to itself and property accesses
+    // do not make a new JavaScript object each time. The wrappers are kept
+    // in JavaScriptCore weak maps, which stop returning a wrapper as soon as
+    // the collector finds it dead, even if its finalizer has not run yet.
+    // The maps belong to the global object and are destroyed with it.
+    // One more map holds the functions behind special properties.
+    enum WrapperType
+    {
+        OBJECT_WRAPPER,
+        METHOD_WRAPPER,
+        LIST_WRAPPER,
+        SPECIAL_FUNCTIONS,
+        WRAPPER_TYPES
+    };
+    struct WrapperMaps
+    {
+        JSWeakObjectMapRef maps[WRAPPER_TYPES];
+    };
+    static std::map<JSObjectRef, WrapperMaps> wrapperMaps;
+    static Poco::FastMutex wrapperMapsMutex;
+
+    // Names of the special properties, created once so that property probes
+    // can compare them without converting the probed name first.
+    static JSStringRef lengthName = NULL;
+    static JSStringRef toStringName = NULL;
+    static JSStringRef equalsName = NULL;
 
     // Private functions
     static void AddSpecialPropertyNames(ValueRef, SharedStringList, bool);
@@ -225,6 +256,10 @@ namespace JSUtil
                 // this object is actually a pure JS array
                 jsValue = tiList->GetJSObject();
             }
+            else if (!list.cast<SnapshotList>().isNull())
+            {
+                jsValue = SnapshotListToJSArray(list, jsContext);
+            }
             else
             {
                 // this is a TiList that needs to be proxied
@@ -248,6 +283,76 @@ namespace JSUtil
 
     }
 
+    static void WrapperMapDestroyed(JSWeakObjectMapRef map, void* globalObject)
+    {
+        Poco::FastMutex::ScopedLock lock(wrapperMapsMutex);
+        std::map<JSObjectRef, WrapperMaps>::iterator i =
+            wrapperMaps.find(static_cast<JSObjectRef>(globalObject));
+        if (i == wrapperMaps.end())
+            return;
+
+        for (int type = 0; type < WRAPPER_TYPES; type++)
+        {
+            if (i->second.maps[type] == map)
+            {
+                wrapperMaps.erase(i);
+                return;
+            }
+        }
+    }
+
+    static JSWeakObjectMapRef GetWrapperMap(JSContextRef jsContext, int type)
+    {
+        JSObjectRef globalObject = JSContextGetGlobalObject(jsContext);
+        {
+            Poco::FastMutex::ScopedLock lock(wrapperMapsMutex);
+            std::map<JSObjectRef, WrapperMaps>::iterator i = wrapperMaps.find(globalObject);
+            if (i != wrapperMaps.end())
+                return i->second.maps[type];
+        }
+
+        // Creating the maps may collect garbage and destroy the maps
+        // of another global object, which takes the lock itself.
+        WrapperMaps maps;
+        for (int i = 0; i < WRAPPER_TYPES; i++)
+            maps.maps[i] = JSWeakObjectMapCreate(jsContext, globalObject, WrapperMapDestroyed);
+
+        Poco::FastMutex::ScopedLock lock(wrapperMapsMutex);
+        wrapperMaps[globalObject] = maps;
+        return maps.maps[type];
+    }
+
+    static JSObjectRef MakeWrapper(JSClassRef jsClass, ValueRef value,
+        JSContextRef jsContext, bool& created)
+    {
+        int type = value->IsMethod() ? METHOD_WRAPPER :
+            (value->IsList() ? LIST_WRAPPER : OBJECT_WRAPPER);
+        TiObject* object = value->ToObject().get();
+
+        JSWeakObjectMapRef map = GetWrapperMap(jsContext, type);
+        JSObjectRef jsObject = JSWeakObjectMapGet(jsContext, map, object);
+        if (jsObject)
+        {
+            created = false;
+            return jsObject;
+        }
+
+        // The wrapper gets its own Value, so that it keeps pointing
+        // at this object even if the original is reused.
+        ValueRef wrappedValue;
+        if (type == METHOD_WRAPPER)
+            wrappedValue = Value::NewMethod(value->ToMethod());
+        else if (type == LIST_WRAPPER)
+            wrappedValue = Value::NewList(value->ToList());
+        else
+            wrappedValue = Value::NewObject(value->ToObject());
+        jsObject = JSObjectMake(jsContext, jsClass, new ValueRef(wrappedValue));
+
+        JSWeakObjectMapSet(jsContext, map, object, jsObject);
+        created = true;
+        return jsObject;
+    }
+
     JSValueRef TiObjectToJSValue(ValueRef objectValue, JSContextRef jsContext)
     {
         if (KJSKObjectClass == NULL)
@@ -261,7 +366,9 @@ namespace JSUtil
             jsClassDefinition.setProperty = SetPropertyCallback;
             KJSKObjectClass = JSClassCreate(&jsClassDefinition);
         }
-        return JSObjectMake(jsContext, KJSKObjectClass, new ValueRef(objectValue));
+
+        bool created;
+        return MakeWrapper(KJSKObjectClass, objectValue, jsContext, created);
     }
 
     JSValueRef TiMethodToJSValue(ValueRef methodValue, JSContextRef jsContext)
@@ -278,9 +385,14 @@ namespace JSUtil
             jsClassDefinition.callAsFunction = CallAsFunctionCallback;
             KJSKMethodClass = JSClassCreate(&jsClassDefinition);
         }
-        JSObjectRef jsobject = JSObjectMake(jsContext, KJSKMethodClass, new ValueRef(methodValue));
-        JSValueRef functionPrototype = GetFunctionPrototype(jsContext, NULL);
-        JSObjectSetPrototype(jsContext, jsobject, functionPrototype);
+
+        bool created;
+        JSObjectRef jsobject = MakeWrapper(KJSKMethodClass, methodValue, jsContext, created);
+        if (created)
+        {
+            JSValueRef functionPrototype = GetFunctionPrototype(jsContext, NULL);
+            JSObjectSetPrototype(jsContext, jsobject, functionPrototype);
+        }
         return jsobject;
     }
 
@@ -299,15 +411,28 @@ namespace JSUtil
             KJSKListClass = JSClassCreate(&jsClassDefinition);
         }
 
-        JSObjectRef jsobject = JSObjectMake(jsContext, KJSKListClass, new ValueRef(listValue));
-        JSValueRef arrayPrototype = GetArrayPrototype(jsContext, NULL);
-        JSObjectSetPrototype(jsContext, jsobject, arrayPrototype);
+        bool created;
+        JSObjectRef jsobject = MakeWrapper(KJSKListClass, listValue, jsContext, created);
+        if (created)
+        {
+            JSValueRef arrayPrototype = GetArrayPrototype(jsContext, NULL);
+            JSObjectSetPrototype(jsContext, jsobject, arrayPrototype);
+        }
         return jsobject;
     }
 
     std::string ToChars(JSStringRef jsString)
     {
+        // Most strings which come through here are property names, which
+        // fit on the stack.
+        char buffer[256];
         size_t size = JSStringGetMaximumUTF8CStringSize(jsString);
+        if (size <= sizeof(buffer))
+        {
+            JSStringGetUTF8CString(jsString, buffer, size);
+            return std::string(buffer);
+        }
+
         char* cstring = (char*) malloc(size);
         JSStringGetUTF8CString(jsString, cstring, size);
         std::string string(cstring);
@@ -369,20 +494,22 @@ namespace JSUtil
         if (value == NULL)
             return false;
 
-        // Convert the name to a std::string.
-        TiObjectRef object = (*value)->ToObject();
-        std::string name(ToChars(jsProperty));
-
         // Special properties always take precedence. This is important
         // because even though the Array and Function prototypes have 
         // methods like toString -- we always want our special properties
-        // to override those.
-        SharedStringList specialProperties(new StringList());
-        AddSpecialPropertyNames(*value, specialProperties, true);
-        for (size_t i = 0; i < specialProperties->size(); i++)
+        // to override those. These are the names AddSpecialPropertyNames
+        // adds when showInvisible is true.
+        if (!lengthName)
+        {
+            lengthName = JSStringCreateWithUTF8CString("length");
+            toStringName = JSStringCreateWithUTF8CString("toString");
+            equalsName = JSStringCreateWithUTF8CString("equals");
+        }
+        if (JSStringIsEqual(jsProperty, toStringName) ||
+            JSStringIsEqual(jsProperty, equalsName) ||
+            ((*value)->IsList() && JSStringIsEqual(jsProperty, lengthName)))
         {
-            if (name == *specialProperties->at(i))
-                return true;
+            return true;
         }
 
         // If the JavaScript prototype for Lists (Array) or Methods (Function) has
@@ -395,9 +522,20 @@ namespace JSUtil
             return false;
         }
 
+        TiObjectRef object = (*value)->ToObject();
+        std::string name(ToChars(jsProperty));
         return object->HasProperty(name.c_str());
     }
 
+    static const Atom* GetProfilePath(TiObjectRef object, const std::string& name)
+    {
+        if (!Profiler::IsEnabled())
+            return 0;
+
+        std::string path(object->GetType() + "." + name);
+        return Atom::Intern(path.c_str());
+    }
+
     static JSValueRef GetPropertyCallback(JSContextRef jsContext, 
         JSObjectRef jsObject, JSStringRef jsProperty, JSValueRef* jsException)
     {
@@ -411,7 +549,11 @@ namespace JSUtil
         JSValueRef jsValue = NULL;
         try
         {
-            ValueRef kvalue = object->Get(name.c_str());
+            ValueRef kvalue;
+            {
+                Profiler::Scope scope(Profiler::GET, GetProfilePath(object, name));
+                kvalue = object->Get(name.c_str());
+            }
             jsValue = GetSpecialProperty(*value, name.c_str(), jsContext, kvalue);
         }
         catch (ValueException& exception)
@@ -452,6 +594,8 @@ namespace JSUtil
             // you do something like set the "length" property
             if (!DoSpecialSetBehavior(*value, propertyName.c_str(), newValue))
             {
+                Profiler::Scope scope(Profiler::SET,
+                    GetProfilePath(object, propertyName));
                 object->Set(propertyName.c_str(), newValue);
             }
             success = true;
@@ -489,7 +633,6 @@ namespace JSUtil
         for (size_t i = 0; i < argCount; i++)
         {
             ValueRef argVal = ToTiValue(jsArgs[i], jsContext, jsThis);
-            Value::Unwrap(argVal);
             args.push_back(argVal);
         }
 
@@ -555,6 +698,24 @@ namespace JSUtil
         }
     }
 
+    // The functions behind toString, equals and toArray are made once per
+    // global object and shared by every wrapper, keyed by their callback.
+    static JSValueRef GetSpecialFunction(JSContextRef jsContext, const char* name,
+        JSObjectCallAsFunctionCallback callback)
+    {
+        JSWeakObjectMapRef map = GetWrapperMap(jsContext, SPECIAL_FUNCTIONS);
+        void* key = reinterpret_cast<void*>(callback);
+        JSObjectRef function = JSWeakObjectMapGet(jsContext, map, key);
+        if (!function)
+        {
+            JSStringRef s = JSStringCreateWithUTF8CString(name);
+            function = JSObjectMakeFunctionWithCallback(jsContext, s, callback);
+            JSStringRelease(s);
+            JSWeakObjectMapSet(jsContext, map, key, function);
+        }
+        return function;
+    }
+
     static JSValueRef GetSpecialProperty(ValueRef value, const char* name, 
         JSContextRef jsContext, ValueRef objValue)
     {
@@ -574,22 +735,18 @@ namespace JSUtil
         if (!objValue->IsMethod())
         {
             if (!strcmp(name, "toString"))
-            {
-                JSStringRef s = JSStringCreateWithUTF8CString("toString");
-                JSValueRef toString = JSObjectMakeFunctionWithCallback(
-                    jsContext, s, &ToStringCallback);
-                JSStringRelease(s);
-                return toString;
-            }
+                return GetSpecialFunction(jsContext, "toString", &ToStringCallback);
 
             if (!strcmp(name, "equals"))
-            {
-                JSStringRef s = JSStringCreateWithUTF8CString("equals");
-                JSValueRef equals = JSObjectMakeFunctionWithCallback(
-                    jsContext, s, &EqualsCallback);
-                JSStringRelease(s);
-                return equals;
-            }
+                return GetSpecialFunction(jsContext, "equals", &EqualsCallback);
+        }
+
+        // Bytes.toArray builds the JavaScript array straight from the
+        // buffer, instead of going through a list of Values.
+        if (objValue->IsMethod() && !strcmp(name, "toArray") &&
+            !value->ToObject().cast<Bytes>().isNull())
+        {
+            return GetSpecialFunction(jsContext, "toArray", &BytesToArrayCallback);
         }
 
         // Otherwise this is just a normal JS value
@@ -649,6 +806,60 @@ namespace JSUtil
         return JSValueMakeBoolean(jsContext, (*value)->Equals(*otherValue));
     }
 
+    static JSValueRef BytesToArrayCallback(JSContextRef jsContext,
+        JSObjectRef jsFunction, JSObjectRef jsThis, size_t argCount,
+        const JSValueRef args[], JSValueRef* exception)
+    {
+        ValueRef* value = static_cast<ValueRef*>(JSObjectGetPrivate(jsThis));
+        BytesRef bytes(value ? (*value)->ToObject().cast<Bytes>() : BytesRef(0));
+        if (bytes.isNull())
+            return JSValueMakeUndefined(jsContext);
+
+        // Like Bytes::_ToArray, refuse what cannot be an index rather
+        // than casting NaN or a negative number to size_t.
+        size_t size = bytes->Length();
+        double arguments[2] = { 0, (double) size };
+        for (size_t i = 0; i < argCount && i < 2; i++)
+        {
+            if (!JSValueIsNumber(jsContext, args[i]))
+                continue;
+
+            arguments[i] = JSValueToNumber(jsContext, args[i], NULL);
+            if (!(arguments[i] >= 0))
+            {
+                *exception = ToJSValue(Value::NewString(
+                    "toArray start and length must not be negative"), jsContext);
+                return JSValueMakeUndefined(jsContext);
+            }
+        }
+
+        size_t start = arguments[0] < size ? (size_t) arguments[0] : size;
+        size_t length = arguments[1] < size - start ?
+            (size_t) arguments[1] : size - start;
+
+        const unsigned char* data = reinterpret_cast<unsigned char*>(bytes->Pointer());
+        std::vector<JSValueRef> values(length);
+        for (size_t i = 0; i < length; i++)
+            values[i] = JSValueMakeNumber(jsContext, data[start + i]);
+
+        return JSObjectMakeArray(jsContext, length, length ? &values[0] : NULL, exception);
+    }
+
+    static JSValueRef SnapshotListToJSArray(TiListRef list, JSContextRef jsContext)
+    {
+        // Fill the array in place instead of collecting the elements first:
+        // the array is reachable from the stack, so the garbage collector
+        // cannot free elements which were already converted.
+        JSObjectRef array = JSObjectMakeArray(jsContext, 0, NULL, NULL);
+        unsigned int length = list->Size();
+        for (unsigned int i = 0; i < length; i++)
+        {
+            JSObjectSetPropertyAtIndex(jsContext, array, i,
+                ToJSValue(list->At(i), jsContext), NULL);
+        }
+        return array;
+    }
+
     static void GetPropertyNamesCallback(JSContextRef jsContext,
         JSObjectRef jsObject, JSPropertyNameAccumulatorRef jsProperties)
     {
@@ -695,6 +906,14 @@ namespace JSUtil
     void UnregisterGlobalContext(JSGlobalContextRef jsContext)
     {
         JSObjectRef globalObject(JSContextGetGlobalObject(jsContext));
+
+        // A new context could be given the same global object address, so
+        // forget the wrapper maps of this one now rather than at collection.
+        {
+            Poco::FastMutex::ScopedLock lock(wrapperMapsMutex);
+            wrapperMaps.erase(globalObject);
+        }
+
         Poco::Mutex::ScopedLock lock(jsContextMapMutex);
         std::map<JSObjectRef, JSGlobalContextRef>::iterator i = jsContextMap.find(globalObject);
         if (i != jsContextMap.end())
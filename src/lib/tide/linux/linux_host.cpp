@@ -38,6 +38,7 @@
 using namespace TideUtils;
 
 #include "../tide.h"
+#include "../atomic.h"
 
 #include <dlfcn.h>
 #include <gcrypt.h>
@@ -54,12 +55,23 @@ namespace tide
 {
     static pthread_t mainThread = 0;
 
+    static volatile unsigned int jobCallbackPending = 0;
+
     static gboolean MainThreadJobCallback(gpointer data)
     {
         static_cast<Host*>(data)->RunMainThreadJobs();
         return TRUE;
     }
 
+    static gboolean MainThreadJobIdleCallback(gpointer data)
+    {
+        // Clear the flag first, so that jobs queued while we are
+        // running schedule another callback.
+        Atomic::Store(&jobCallbackPending, 0);
+        static_cast<Host*>(data)->RunMainThreadJobs();
+        return FALSE;
+    }
+
     void Host::Initialize(int argc, const char *argv[])
     {
         gtk_init(&argc, (char***) &argv);
@@ -96,6 +108,10 @@ namespace tide
 
     void Host::SignalNewMainThreadJob()
     {
+        // Wake up the GTK main loop right away instead of waiting for the
+        // polling timeout. Only one idle callback is ever pending at a time.
+        if (Atomic::CompareAndSwap(&jobCallbackPending, 0, 1))
+            g_idle_add(&MainThreadJobIdleCallback, this);
     }
 
     void Host::ExitImpl(int exitCode)
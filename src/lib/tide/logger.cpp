@@ -46,9 +46,26 @@ using namespace TideUtils;
 #include <Poco/PatternFormatter.h>
 #include <Poco/Path.h>
 #include <Poco/File.h>
+#include <Poco/Event.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(OS_WIN32)
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define LOGGER_MAX_ENTRY_SIZE 2048
 
+// The number of messages which may wait for the writer thread. When the
+// queue is full, messages are dropped or their threads wait, depending
+// on the overflow policy.
+#define LOGGER_QUEUE_SIZE 4096
+
 using Poco::PatternFormatter;
 using Poco::Path;
 using Poco::File;
@@ -56,8 +73,416 @@ using Poco::File;
 namespace tide
 {
     std::map<std::string, Logger*> Logger::loggers;
-    char Logger::buffer[LOGGER_MAX_ENTRY_SIZE];
     Poco::Mutex Logger::mutex;
+    static volatile Logger::OverflowPolicy overflowPolicy = Logger::DROP_WHEN_FULL;
+
+    /**
+     * Moves messages from the threads which log them to the root logger's
+     * outputs. Producers claim a slot in a bounded lock-free ring, using the
+     * same scheme as MainThreadJobQueue, and a single writer thread formats
+     * and writes them in batches. Only the writer thread touches the
+     * console, the log file and the callbacks.
+     */
+    class LogWriter : public Poco::Runnable
+    {
+    public:
+        LogWriter(RootLogger* root, unsigned int capacity);
+        ~LogWriter();
+
+        void Start();
+        void Stop();
+        void Push(const std::string& source, Logger::Level level,
+            const std::string& text, bool wait);
+        void Flush();
+        void WritePendingForCrash();
+        unsigned int GetDroppedCount() { return Atomic::Load(&this->droppedTotal); }
+        void run();
+
+    private:
+        struct Cell
+        {
+            volatile unsigned int sequence;
+            Logger::Level level;
+            Poco::Timestamp time;
+            std::string source;
+            std::string text;
+        };
+
+        bool TryPush(const std::string& source, Logger::Level level,
+            const std::string& text);
+        bool IsEmpty();
+        void Drain();
+        bool LockConsumer(int attempts);
+        void UnlockConsumer();
+
+        RootLogger* root;
+        Cell* cells;
+        unsigned int mask;
+        volatile unsigned int enqueuePosition;
+        volatile unsigned int dequeuePosition;
+        volatile unsigned int dropped;
+        volatile unsigned int droppedTotal;
+        volatile unsigned int consumerBusy;
+        volatile unsigned int writerSleeping;
+        volatile bool running;
+        Poco::Event messagesAvailable;
+        Poco::Event messagesWritten;
+        Poco::Thread thread;
+        std::vector<std::pair<Logger::Level, std::string> > lines;
+    };
+
+    LogWriter::LogWriter(RootLogger* root, unsigned int capacity) :
+        root(root),
+        enqueuePosition(0),
+        dequeuePosition(0),
+        dropped(0),
+        droppedTotal(0),
+        consumerBusy(0),
+        writerSleeping(0),
+        running(false)
+    {
+        // The ring indexes with a mask, so round up to a power of two.
+        unsigned int size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        this->cells = new Cell[size];
+        this->mask = size - 1;
+        for (unsigned int i = 0; i < size; i++)
+        {
+            this->cells[i].sequence = i;
+        }
+    }
+
+    LogWriter::~LogWriter()
+    {
+        this->Stop();
+        delete [] this->cells;
+    }
+
+    void LogWriter::Start()
+    {
+        this->running = true;
+        this->thread.setName("Logger");
+        this->thread.start(*this);
+    }
+
+    void LogWriter::Stop()
+    {
+        if (!this->running)
+            return;
+
+        this->running = false;
+        this->messagesAvailable.set();
+        this->thread.join();
+    }
+
+    bool LogWriter::TryPush(const std::string& source, Logger::Level level,
+        const std::string& text)
+    {
+        Cell* cell;
+        unsigned int position = Atomic::Load(&this->enqueuePosition);
+        while (true)
+        {
+            cell = &this->cells[position & this->mask];
+            unsigned int sequence = Atomic::Load(&cell->sequence);
+            int difference = (int) (sequence - position);
+
+            if (difference == 0)
+            {
+                if (Atomic::CompareAndSwap(&this->enqueuePosition, position, position + 1))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false; // The ring is full.
+            }
+
+            position = Atomic::Load(&this->enqueuePosition);
+        }
+
+        cell->level = level;
+        cell->time.update();
+        cell->source = source;
+        cell->text = text;
+        Atomic::Store(&cell->sequence, position + 1);
+        return true;
+    }
+
+    void LogWriter::Push(const std::string& source, Logger::Level level,
+        const std::string& text, bool wait)
+    {
+        // Only the writer thread drains the ring, so a logger callback
+        // that logs on it could never see room appear. Drop instead.
+        if (Poco::Thread::current() == &this->thread)
+            wait = false;
+
+        while (!this->TryPush(source, level, text))
+        {
+            if (!wait || !this->running)
+            {
+                unsigned int count;
+                do
+                {
+                    count = Atomic::Load(&this->dropped);
+                }
+                while (!Atomic::CompareAndSwap(&this->dropped, count, count + 1));
+                do
+                {
+                    count = Atomic::Load(&this->droppedTotal);
+                }
+                while (!Atomic::CompareAndSwap(&this->droppedTotal, count, count + 1));
+                return;
+            }
+
+            // Give the writer a chance to make some room.
+            this->messagesAvailable.set();
+            Poco::Thread::sleep(1);
+        }
+
+        // Only pay for waking the writer when it is actually asleep. It
+        // re-checks the ring after announcing that, so no wakeup is lost.
+        if (Atomic::Load(&this->writerSleeping))
+            this->messagesAvailable.set();
+    }
+
+    bool LogWriter::IsEmpty()
+    {
+        unsigned int position = Atomic::Load(&this->dequeuePosition);
+        Cell* cell = &this->cells[position & this->mask];
+        return (int) (Atomic::Load(&cell->sequence) - (position + 1)) < 0;
+    }
+
+    bool LogWriter::LockConsumer(int attempts)
+    {
+        while (!Atomic::CompareAndSwap(&this->consumerBusy, 0, 1))
+        {
+            if (--attempts <= 0)
+                return false;
+            Poco::Thread::sleep(1);
+        }
+        return true;
+    }
+
+    void LogWriter::UnlockConsumer()
+    {
+        Atomic::Store(&this->consumerBusy, 0);
+    }
+
+    void LogWriter::Drain()
+    {
+        // Must be called with the consumer lock held.
+        this->lines.clear();
+        while (!this->IsEmpty())
+        {
+            unsigned int position = this->dequeuePosition;
+            Cell* cell = &this->cells[position & this->mask];
+
+            // Take the text out of the cell, so that the ring does not
+            // hold on to the memory of messages which were written.
+            std::string text;
+            text.swap(cell->text);
+            Poco::Message message(cell->source, text,
+                (Poco::Message::Priority) cell->level);
+            message.setTime(cell->time);
+            Logger::Level level = cell->level;
+
+            Atomic::Store(&cell->sequence, position + this->mask + 1);
+            Atomic::Store(&this->dequeuePosition, position + 1);
+
+            this->lines.push_back(std::make_pair(level, std::string()));
+            this->root->formatter->format(message, this->lines.back().second);
+        }
+
+        unsigned int droppedCount;
+        do
+        {
+            droppedCount = Atomic::Load(&this->dropped);
+        }
+        while (droppedCount && !Atomic::CompareAndSwap(&this->dropped, droppedCount, 0));
+
+        if (droppedCount)
+        {
+            char text[128];
+            snprintf(text, sizeof(text),
+                "%u log messages were dropped because the log queue was full",
+                droppedCount);
+            Poco::Message message(GLOBAL_NAMESPACE, text, Poco::Message::PRIO_WARNING);
+            this->lines.push_back(std::make_pair(Logger::LWARN, std::string()));
+            this->root->formatter->format(message, this->lines.back().second);
+        }
+
+        if (!this->lines.empty())
+            this->root->Write(this->lines);
+    }
+
+    void LogWriter::run()
+    {
+        while (this->running)
+        {
+            if (this->LockConsumer(1000))
+            {
+                this->Drain();
+                this->UnlockConsumer();
+            }
+            this->messagesWritten.set();
+
+            Atomic::Store(&this->writerSleeping, 1);
+            if (this->running && this->IsEmpty())
+                this->messagesAvailable.tryWait(1000);
+            Atomic::Store(&this->writerSleeping, 0);
+        }
+
+        // Write whatever was logged while we were shutting down.
+        if (this->LockConsumer(1000))
+        {
+            this->Drain();
+            this->UnlockConsumer();
+        }
+        this->messagesWritten.set();
+    }
+
+    void LogWriter::Flush()
+    {
+        // Logging from a logger callback and then flushing would
+        // wait on ourselves, and everything is written soon anyway.
+        if (Poco::Thread::current() == &this->thread)
+            return;
+
+        unsigned int target = Atomic::Load(&this->enqueuePosition);
+        while ((int) (Atomic::Load(&this->dequeuePosition) - target) < 0)
+        {
+            if (!this->running)
+            {
+                if (this->LockConsumer(1000))
+                {
+                    this->Drain();
+                    this->UnlockConsumer();
+                }
+                return;
+            }
+
+            this->messagesAvailable.set();
+            this->messagesWritten.tryWait(10);
+        }
+    }
+
+    // Raw descriptors for the crash path, opened up front because nothing
+    // may be opened, allocated or locked once the process has crashed.
+#if defined(OS_WIN32)
+    static HANDLE crashLogFile = INVALID_HANDLE_VALUE;
+    static HANDLE crashConsole = INVALID_HANDLE_VALUE;
+
+    static void WriteForCrash(HANDLE handle, const char* data, size_t size)
+    {
+        DWORD written;
+        if (handle != INVALID_HANDLE_VALUE && size)
+            WriteFile(handle, data, (DWORD) size, &written, 0);
+    }
+#else
+    static int crashLogFile = -1;
+    static int crashConsole = -1;
+
+    static void WriteForCrash(int descriptor, const char* data, size_t size)
+    {
+        if (descriptor >= 0 && size)
+            write(descriptor, data, size);
+    }
+#endif
+
+    static void WriteForCrash(const char* data, size_t size)
+    {
+        WriteForCrash(crashLogFile, data, size);
+        WriteForCrash(crashConsole, data, size);
+    }
+
+    void LogWriter::WritePendingForCrash()
+    {
+        // This runs in a signal handler, possibly on the writer thread
+        // itself, so it only reads the messages still waiting in the ring
+        // and hands their bytes straight to the operating system. Nothing
+        // is formatted, and the ring is left as it is.
+        unsigned int position = Atomic::Load(&this->dequeuePosition);
+        unsigned int end = Atomic::Load(&this->enqueuePosition);
+        for (; position != end; position++)
+        {
+            Cell* cell = &this->cells[position & this->mask];
+            if (Atomic::Load(&cell->sequence) != position + 1)
+                break;
+
+            WriteForCrash("[", 1);
+            WriteForCrash(cell->source.data(), cell->source.size());
+            WriteForCrash("] ", 2);
+            WriteForCrash(cell->text.data(), cell->text.size());
+            WriteForCrash("\n", 1);
+        }
+    }
+
+    static void WriteLogForCrash()
+    {
+        RootLogger* root = RootLogger::instance;
+        if (root)
+            root->WritePendingForCrash();
+    }
+
+#if defined(OS_WIN32)
+    static LPTOP_LEVEL_EXCEPTION_FILTER previousExceptionFilter = 0;
+
+    static LONG WINAPI CrashExceptionFilter(EXCEPTION_POINTERS* exception)
+    {
+        WriteLogForCrash();
+        if (previousExceptionFilter)
+            return previousExceptionFilter(exception);
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+#else
+    static const int crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+    static const int crashSignalCount = sizeof(crashSignals) / sizeof(int);
+    static struct sigaction previousCrashActions[crashSignalCount];
+
+    static void CrashSignalHandler(int signal)
+    {
+        WriteLogForCrash();
+
+        // Put back whatever handled this signal before us and let it run.
+        for (int i = 0; i < crashSignalCount; i++)
+        {
+            if (crashSignals[i] == signal)
+                sigaction(signal, &previousCrashActions[i], 0);
+        }
+        raise(signal);
+    }
+#endif
+
+    static void FlushLogAtExit()
+    {
+        RootLogger* root = RootLogger::instance;
+        if (root)
+            root->Flush();
+    }
+
+    static void InstallLogFlushHooks()
+    {
+        static bool installed = false;
+        if (installed)
+            return;
+        installed = true;
+
+        atexit(&FlushLogAtExit);
+
+#if defined(OS_WIN32)
+        previousExceptionFilter = SetUnhandledExceptionFilter(&CrashExceptionFilter);
+#else
+        for (int i = 0; i < crashSignalCount; i++)
+        {
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_handler = &CrashSignalHandler;
+            sigemptyset(&action.sa_mask);
+            sigaction(crashSignals[i], &action, &previousCrashActions[i]);
+        }
+#endif
+    }
 
     /*static*/
     Logger* Logger::Get(std::string name)
@@ -76,6 +501,7 @@ namespace tide
     /*static*/
     void Logger::Shutdown()
     {
+        Poco::Mutex::ScopedLock lock(mutex);
         std::map<std::string, Logger*>::iterator i = loggers.begin();
         while (i != loggers.end())
         {
@@ -99,9 +525,33 @@ namespace tide
         rootLogger->AddLoggerCallback(callback);
     }
 
+    /*static*/
+    void Logger::SetOverflowPolicy(OverflowPolicy policy)
+    {
+        overflowPolicy = policy;
+    }
+
+    /*static*/
+    unsigned int Logger::GetDroppedCount()
+    {
+        RootLogger* root = RootLogger::instance;
+        if (!root)
+            return 0;
+        return root->GetDroppedCount();
+    }
+
+    /*static*/
+    void Logger::Flush()
+    {
+        RootLogger* root = RootLogger::instance;
+        if (root)
+            root->Flush();
+    }
+
     /*static*/
     Logger* Logger::GetImpl(std::string name)
     {
+        Poco::Mutex::ScopedLock lock(mutex);
         if (loggers.find(name) == loggers.end())
         {
             loggers[name] = new Logger(name);
@@ -247,17 +697,20 @@ namespace tide
     {
         // This check only happens at the entry logger and never in it's
         // parents. This is so a child logger can have a more permissive level.
-        if ((Level) m.getPriority() <= this->level)
+        RootLogger* root = RootLogger::instance;
+        if ((Level) m.getPriority() <= this->level && root)
         {
-            RootLogger* root = RootLogger::instance;
             root->LogImpl(m);
         }
     }
 
     void Logger::Log(Level level, std::string& message)
     {
-        Poco::Message m(this->name, message, (Poco::Message::Priority) level);
-        this->Log(m);
+        RootLogger* root = RootLogger::instance;
+        if (level <= this->level && root)
+        {
+            root->LogImpl(this->name, level, message);
+        }
     }
 
     void Logger::Log(Level level, const char* format, va_list args)
@@ -274,13 +727,12 @@ namespace tide
     /*static*/
     std::string Logger::Format(const char* format, va_list args)
     {
-        // Protect the buffer
-        Poco::Mutex::ScopedLock lock(mutex);
-
-        vsnprintf(Logger::buffer, LOGGER_MAX_ENTRY_SIZE - 1, format, args);
-        Logger::buffer[LOGGER_MAX_ENTRY_SIZE - 1] = '\0';
-        std::string text = buffer;
-        return text;
+        // Each thread formats into its own stack buffer, so
+        // logging threads never wait on each other here.
+        char buffer[LOGGER_MAX_ENTRY_SIZE];
+        vsnprintf(buffer, LOGGER_MAX_ENTRY_SIZE - 1, format, args);
+        buffer[LOGGER_MAX_ENTRY_SIZE - 1] = '\0';
+        return std::string(buffer);
     }
 
     void Logger::Log(Level level, const char* format, ...)
@@ -449,6 +901,7 @@ namespace tide
     RootLogger* RootLogger::instance = NULL;
     RootLogger::RootLogger(bool consoleLogging, std::string logFilePath, Level level) :
         Logger(GLOBAL_NAMESPACE, level),
+        writer(0),
         consoleLogging(consoleLogging),
         fileLogging(!logFilePath.empty())
     {
@@ -475,42 +928,114 @@ namespace tide
             {
                 this->fileLogging = false;
             }
+#ifdef OS_WIN32
+            else
+            {
+                crashLogFile = CreateFileW(UTF8ToWide(logFilePath).c_str(),
+                    FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+            }
+#else
+            else
+            {
+                crashLogFile = open(logFilePath.c_str(), O_WRONLY | O_APPEND);
+            }
+#endif
+        }
+
+        if (consoleLogging)
+        {
+#ifdef OS_WIN32
+            crashConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+#else
+            crashConsole = STDOUT_FILENO;
+#endif
         }
+
+        this->writer = new LogWriter(this, LOGGER_QUEUE_SIZE);
+        this->writer->Start();
+        InstallLogFlushHooks();
     }
 
     RootLogger::~RootLogger()
     {
+        // Stopping the writer writes out everything still queued.
+        RootLogger::instance = NULL;
+        delete this->writer;
+        this->writer = 0;
+
         if (fileLogging)
         {
             this->logFile.close();
         }
+
+#ifdef OS_WIN32
+        if (crashLogFile != INVALID_HANDLE_VALUE)
+            CloseHandle(crashLogFile);
+        crashLogFile = crashConsole = INVALID_HANDLE_VALUE;
+#else
+        if (crashLogFile >= 0)
+            close(crashLogFile);
+        crashLogFile = crashConsole = -1;
+#endif
     }
 
     void RootLogger::LogImpl(Poco::Message& m)
+    {
+        std::string text(m.getText());
+        this->LogImpl(m.getSource(), (Level) m.getPriority(), text);
+    }
+
+    void RootLogger::LogImpl(const std::string& source, Level level, std::string& text)
+    {
+        // Errors are never dropped, since they are the
+        // messages most likely to explain what went wrong.
+        bool wait = level <= LERROR || overflowPolicy == BLOCK_WHEN_FULL;
+        this->writer->Push(source, level, text, wait);
+    }
+
+    void RootLogger::Write(std::vector<std::pair<Level, std::string> >& lines)
     {
         Poco::Mutex::ScopedLock lock(mutex);
-        Level level = (Level) m.getPriority();
-        std::string line;
-        this->formatter->format(m, line);
 
         if (fileLogging)
         {
-            this->logFile << line << std::endl;
+            for (size_t i = 0; i < lines.size(); i++)
+                this->logFile << lines[i].second << '\n';
             this->logFile.flush();
         }
 
         if (consoleLogging)
         {
-            printf("%s\n", line.c_str());
+            for (size_t i = 0; i < lines.size(); i++)
+                printf("%s\n", lines[i].second.c_str());
             fflush(stdout);
         }
 
-        for (size_t i = 0; i < callbacks.size(); i++)
+        for (size_t i = 0; i < lines.size(); i++)
         {
-            callbacks[i](level, line);
+            for (size_t j = 0; j < callbacks.size(); j++)
+            {
+                callbacks[j](lines[i].first, lines[i].second);
+            }
         }
     }
 
+    void RootLogger::Flush()
+    {
+        this->writer->Flush();
+    }
+
+    void RootLogger::WritePendingForCrash()
+    {
+        this->writer->WritePendingForCrash();
+    }
+
+    unsigned int RootLogger::GetDroppedCount()
+    {
+        return this->writer->GetDroppedCount();
+    }
+
     void RootLogger::AddLoggerCallback(LoggerCallback callback)
     {
         Poco::Mutex::ScopedLock lock(mutex);
@@ -39,10 +39,12 @@
 #include <cstdarg>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 namespace tide
 {
     class RootLogger;
+    class LogWriter;
     class TIDE_API Logger
     {
         public:
@@ -59,12 +61,31 @@ namespace tide
         } Level;
         typedef void (*LoggerCallback)(Level, std::string&);
 
+        /**
+         * What to do with a message when the queue of messages waiting for
+         * the writer thread is full. Errors and anything more severe always
+         * wait for room, regardless of the policy.
+         */
+        typedef enum
+        {
+            DROP_WHEN_FULL,
+            BLOCK_WHEN_FULL
+        } OverflowPolicy;
+
         static Logger* Get(std::string name);
         static Logger* GetRootLogger();
         static void Initialize(bool, std::string, Level);
         static void Shutdown();
         static Level GetLevel(std::string& level);
         static void AddLoggerCallback(LoggerCallback callback);
+        static void SetOverflowPolicy(OverflowPolicy policy);
+        static unsigned int GetDroppedCount();
+
+        /**
+         * Block until every message logged so far has been written
+         * to the console, the log file and the logger callbacks.
+         */
+        static void Flush();
 
         Logger() {};
         virtual ~Logger() {};
@@ -122,7 +143,6 @@ namespace tide
         std::string name;
         Level level;
         static Poco::Mutex mutex;
-        static char buffer[];
 
         static Logger* GetImpl(std::string name);
         static std::map<std::string, Logger*> loggers;
@@ -135,9 +155,21 @@ namespace tide
         ~RootLogger();
         static RootLogger* instance;
         virtual void LogImpl(Poco::Message& m);
+        void LogImpl(const std::string& source, Level level, std::string& text);
         void AddLoggerCallback(LoggerCallback callback);
+        void Flush();
+        void WritePendingForCrash();
+        unsigned int GetDroppedCount();
+
+        /**
+         * Write a batch of formatted lines. This is only called by
+         * the writer thread, or by Flush once the writer has stopped.
+         */
+        void Write(std::vector<std::pair<Level, std::string> >& lines);
 
         protected:
+        friend class LogWriter;
+        LogWriter* writer;
         bool consoleLogging;
         bool fileLogging;
         Poco::PatternFormatter* formatter;
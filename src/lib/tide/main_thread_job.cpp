@@ -38,6 +38,14 @@
 namespace tide
 {
 
+    MainThreadJob::MainThreadJob() :
+        waitForCompletion(false),
+        returnValue(NULL),
+        exception(ValueException(NULL)),
+        semaphore(0, 1)
+    {
+    }
+
     MainThreadJob::MainThreadJob(TiMethodRef method, TiObjectRef thisObject,
         const ValueList& args, bool waitForCompletion) :
         method(method),
@@ -54,6 +62,30 @@ namespace tide
         // which meets this condition.
     }
 
+    void MainThreadJob::Reset(TiMethodRef method, TiObjectRef thisObject,
+        const ValueList& args, bool waitForCompletion)
+    {
+        // A finished job always leaves the semaphore back at 0, because
+        // the waiting thread consumed the set() from Execute().
+        this->method = method;
+        this->thisObject = thisObject;
+        this->args = args;
+        this->waitForCompletion = waitForCompletion;
+        this->returnValue = NULL;
+        this->exception = ValueException(NULL);
+        this->coalescingKey.clear();
+        this->queuedTime.update();
+    }
+
+    void MainThreadJob::Clear()
+    {
+        this->method = NULL;
+        this->thisObject = NULL;
+        this->args = ValueList();
+        this->returnValue = NULL;
+        this->exception = ValueException(NULL);
+    }
+
     void MainThreadJob::Wait()
     {
         if (this->waitForCompletion)
@@ -36,14 +36,29 @@
 #define _MAIN_THREAD_JOB_H
 
 #include <Poco/Semaphore.h>
+#include <Poco/Timestamp.h>
 
 namespace tide
 {
     class TIDE_API MainThreadJob
     {
     public:
+        MainThreadJob();
         MainThreadJob(TiMethodRef method, TiObjectRef thisObject,
             const ValueList& args, bool waitForCompletion);
+
+        /**
+         * Prepare a pooled job for another run.
+         */
+        void Reset(TiMethodRef method, TiObjectRef thisObject,
+            const ValueList& args, bool waitForCompletion);
+
+        /**
+         * Drop all references held by this job, so that a pooled job
+         * does not keep the objects of its last run alive.
+         */
+        void Clear();
+
         void Lock();
         void Wait();
         void Execute();
@@ -52,14 +67,22 @@ namespace tide
         bool ShouldWaitForCompletion();
         void PrintException();
 
+        const std::string& GetCoalescingKey() { return this->coalescingKey; }
+        void SetCoalescingKey(const std::string& key) { this->coalescingKey = key; }
+        const Poco::Timestamp& GetQueuedTime() { return this->queuedTime; }
+
     private:
         TiMethodRef method;
         TiObjectRef thisObject;
-        const ValueList args;
+        ValueList args;
         bool waitForCompletion;
         ValueRef returnValue;
         ValueException exception;
         Poco::Semaphore semaphore;
+        std::string coalescingKey;
+        Poco::Timestamp queuedTime;
+
+        DISALLOW_EVIL_CONSTRUCTORS(MainThreadJob);
     };
 }
 
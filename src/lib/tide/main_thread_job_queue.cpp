@@ -0,0 +1,322 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "tide.h"
+#include <limits>
+
+namespace tide
+{
+    static const unsigned int MAX_FREE_JOBS = 256;
+
+    // Upper bounds of the histogram buckets, the last bucket is open-ended.
+    static const Poco::Timestamp::TimeDiff latencyBounds[] =
+    {
+        100, 250, 1000, 4000, 16000, 50000, 100000, 250000, 1000000
+    };
+    static const int depthBounds[] =
+    {
+        1, 2, 4, 8, 16, 64, 256, 1024, 4096
+    };
+
+    template <typename T>
+    static int FindBucket(const T* bounds, T value)
+    {
+        int bucket = 0;
+        while (bucket < MainThreadJobQueue::HISTOGRAM_BUCKETS - 1 && value > bounds[bucket])
+            bucket++;
+        return bucket;
+    }
+
+    MainThreadJobQueue::MainThreadJobQueue(unsigned int capacity) :
+        enqueuePosition(0),
+        dequeuePosition(0),
+        overflowing(false),
+        depth(0),
+        maxDepth(0),
+        executed(0),
+        coalesced(0),
+        budgetExceeded(0)
+    {
+        // The ring indexes with a mask, so round up to a power of two.
+        unsigned int size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        this->cells = new Cell[size];
+        this->mask = size - 1;
+        for (unsigned int i = 0; i < size; i++)
+        {
+            this->cells[i].sequence = i;
+            this->cells[i].job = 0;
+        }
+
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        {
+            this->latencyHistogram[i] = 0;
+            this->depthHistogram[i] = 0;
+        }
+    }
+
+    MainThreadJobQueue::~MainThreadJobQueue()
+    {
+        delete [] this->cells;
+
+        std::vector<MainThreadJob*>::iterator i = this->freeJobs.begin();
+        while (i != this->freeJobs.end())
+        {
+            delete *i++;
+        }
+    }
+
+    MainThreadJob* MainThreadJobQueue::AcquireJob(TiMethodRef method,
+        TiObjectRef thisObject, const ValueList& args, bool waitForCompletion)
+    {
+        MainThreadJob* job = 0;
+        {
+            Poco::FastMutex::ScopedLock lock(this->freeJobsMutex);
+            if (!this->freeJobs.empty())
+            {
+                job = this->freeJobs.back();
+                this->freeJobs.pop_back();
+            }
+        }
+
+        if (!job)
+            job = new MainThreadJob();
+
+        job->Reset(method, thisObject, args, waitForCompletion);
+        return job;
+    }
+
+    void MainThreadJobQueue::ReleaseJob(MainThreadJob* job)
+    {
+        job->Clear();
+
+        {
+            Poco::FastMutex::ScopedLock lock(this->freeJobsMutex);
+            if (this->freeJobs.size() < MAX_FREE_JOBS)
+            {
+                this->freeJobs.push_back(job);
+                return;
+            }
+        }
+
+        delete job;
+    }
+
+    void MainThreadJobQueue::Push(MainThreadJob* job)
+    {
+        this->depth++;
+
+        // Once we have spilled into the overflow queue, every producer must
+        // keep using it until the main thread drains it, otherwise jobs from
+        // the same thread could overtake each other.
+        if (!this->overflowing && this->TryPush(job))
+            return;
+
+        Poco::FastMutex::ScopedLock lock(this->overflowMutex);
+        this->overflow.push_back(job);
+        this->overflowing = true;
+    }
+
+    bool MainThreadJobQueue::PushCoalesced(const std::string& key,
+        TiMethodRef method, TiObjectRef thisObject, const ValueList& args)
+    {
+        Poco::FastMutex::ScopedLock lock(this->coalescedJobsMutex);
+
+        std::map<std::string, MainThreadJob*>::iterator i =
+            this->coalescedJobs.find(key);
+        if (i != this->coalescedJobs.end())
+        {
+            // The main thread removes the key before it runs a job,
+            // so this job cannot be executing right now.
+            i->second->Reset(method, thisObject, args, false);
+            i->second->SetCoalescingKey(key);
+            this->coalesced++;
+            return false;
+        }
+
+        MainThreadJob* job = this->AcquireJob(method, thisObject, args, false);
+        job->SetCoalescingKey(key);
+        this->coalescedJobs[key] = job;
+        this->Push(job);
+        return true;
+    }
+
+    bool MainThreadJobQueue::TryPush(MainThreadJob* job)
+    {
+        Cell* cell;
+        unsigned int position = Atomic::Load(&this->enqueuePosition);
+        while (true)
+        {
+            cell = &this->cells[position & this->mask];
+            unsigned int sequence = Atomic::Load(&cell->sequence);
+            int difference = (int) (sequence - position);
+
+            if (difference == 0)
+            {
+                if (Atomic::CompareAndSwap(&this->enqueuePosition, position, position + 1))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false; // The ring is full.
+            }
+
+            position = Atomic::Load(&this->enqueuePosition);
+        }
+
+        cell->job = job;
+        Atomic::Store(&cell->sequence, position + 1);
+        return true;
+    }
+
+    MainThreadJob* MainThreadJobQueue::Pop()
+    {
+        Cell* cell = &this->cells[this->dequeuePosition & this->mask];
+        unsigned int sequence = Atomic::Load(&cell->sequence);
+        if ((int) (sequence - (this->dequeuePosition + 1)) == 0)
+        {
+            MainThreadJob* job = cell->job;
+            cell->job = 0;
+            Atomic::Store(&cell->sequence, this->dequeuePosition + this->mask + 1);
+            this->dequeuePosition++;
+            this->depth--;
+            return job;
+        }
+
+        // The ring is empty, so everything in the overflow
+        // queue was pushed after what we have run so far.
+        if (!this->overflowing)
+            return 0;
+
+        Poco::FastMutex::ScopedLock lock(this->overflowMutex);
+        if (this->overflow.empty())
+        {
+            this->overflowing = false;
+            return 0;
+        }
+
+        MainThreadJob* job = this->overflow.front();
+        this->overflow.pop_front();
+        if (this->overflow.empty())
+            this->overflowing = false;
+
+        this->depth--;
+        return job;
+    }
+
+    bool MainThreadJobQueue::IsEmpty()
+    {
+        return this->depth.value() <= 0;
+    }
+
+    bool MainThreadJobQueue::Run(Poco::Timestamp::TimeDiff budgetMicros)
+    {
+        int currentDepth = this->depth.value();
+        if (currentDepth <= 0)
+            return false;
+
+        if (currentDepth > this->maxDepth)
+            this->maxDepth = currentDepth;
+        this->depthHistogram[FindBucket(depthBounds, currentDepth)]++;
+
+        Poco::Timestamp started;
+        MainThreadJob* job;
+        while ((job = this->Pop()))
+        {
+            if (!job->GetCoalescingKey().empty())
+            {
+                Poco::FastMutex::ScopedLock lock(this->coalescedJobsMutex);
+                this->coalescedJobs.erase(job->GetCoalescingKey());
+            }
+
+            Poco::Timestamp::TimeDiff latency = job->GetQueuedTime().elapsed();
+            this->latencyHistogram[FindBucket(latencyBounds, latency)]++;
+            this->executed++;
+
+            // Job might be freed soon after Execute(), so get this value now.
+            bool asynchronous = !job->ShouldWaitForCompletion();
+            job->Execute();
+
+            if (asynchronous)
+            {
+                job->PrintException();
+                this->ReleaseJob(job);
+            }
+
+            // Leave the rest for the next turn of the event loop, so that
+            // a flood of jobs does not starve input and painting.
+            if (started.isElapsed(budgetMicros) && !this->IsEmpty())
+            {
+                this->budgetExceeded++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    TiObjectRef MainThreadJobQueue::GetStatsObject()
+    {
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetInt("depth", this->depth.value());
+        stats->SetInt("maxDepth", this->maxDepth);
+        stats->SetDouble("executed", (double) this->executed);
+        stats->SetDouble("coalesced", (double) this->coalesced.value());
+        stats->SetDouble("budgetExceeded", (double) this->budgetExceeded);
+
+        TiListRef latency(new StaticBoundList());
+        TiListRef depths(new StaticBoundList());
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        {
+            bool last = i == HISTOGRAM_BUCKETS - 1;
+
+            TiObjectRef latencyBucket(new StaticBoundObject());
+            latencyBucket->SetDouble("max", last ?
+                std::numeric_limits<double>::infinity() : latencyBounds[i] / 1000.0);
+            latencyBucket->SetDouble("count", (double) this->latencyHistogram[i]);
+            latency->Append(Value::NewObject(latencyBucket));
+
+            TiObjectRef depthBucket(new StaticBoundObject());
+            depthBucket->SetDouble("max", last ?
+                std::numeric_limits<double>::infinity() : depthBounds[i]);
+            depthBucket->SetDouble("count", (double) this->depthHistogram[i]);
+            depths->Append(Value::NewObject(depthBucket));
+        }
+        stats->SetList("latency", latency);
+        stats->SetList("depth", depths);
+        return stats;
+    }
+}
@@ -0,0 +1,146 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _MAIN_THREAD_JOB_QUEUE_H
+#define _MAIN_THREAD_JOB_QUEUE_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Mutex.h>
+
+#include "atomic.h"
+
+namespace tide
+{
+    /**
+     * The queue of jobs waiting to run on the main thread. Any thread may
+     * push jobs, but only the main thread pops them. Jobs travel through a
+     * bounded lock-free ring; when the ring is full they spill into a locked
+     * overflow queue, which keeps ordering intact because producers keep
+     * using the overflow until the main thread has drained it.
+     *
+     * Job objects are recycled through a free list so that posting a job
+     * does not need to allocate a new object and semaphore every time.
+     */
+    class TIDE_API MainThreadJobQueue
+    {
+    public:
+        static const int HISTOGRAM_BUCKETS = 10;
+
+        MainThreadJobQueue(unsigned int capacity = 4096);
+        ~MainThreadJobQueue();
+
+        /**
+         * Get a job object from the pool and prepare it for a run.
+         */
+        MainThreadJob* AcquireJob(TiMethodRef method, TiObjectRef thisObject,
+            const ValueList& args, bool waitForCompletion);
+
+        /**
+         * Return a finished job to the pool.
+         */
+        void ReleaseJob(MainThreadJob* job);
+
+        /**
+         * Queue a job. Safe to call from any thread.
+         */
+        void Push(MainThreadJob* job);
+
+        /**
+         * Queue an asynchronous job with a coalescing key. If a job with the
+         * same key is still waiting in the queue, its method and arguments
+         * are replaced instead of queueing another job. Returns true if a new
+         * job was queued and false if an existing job was updated.
+         */
+        bool PushCoalesced(const std::string& key, TiMethodRef method,
+            TiObjectRef thisObject, const ValueList& args);
+
+        /**
+         * Run queued jobs until the queue is empty or budgetMicros have
+         * passed. At least one job is always run. Must be called on the
+         * main thread. Returns true if jobs are still waiting.
+         */
+        bool Run(Poco::Timestamp::TimeDiff budgetMicros);
+
+        bool IsEmpty();
+        int Size() { return this->depth.value(); }
+
+        /**
+         * Get queue depth and latency histograms as a bound object.
+         */
+        TiObjectRef GetStatsObject();
+
+    private:
+        struct Cell
+        {
+            volatile unsigned int sequence;
+            MainThreadJob* job;
+        };
+
+        bool TryPush(MainThreadJob* job);
+        MainThreadJob* Pop();
+
+        Cell* cells;
+        unsigned int mask;
+        volatile unsigned int enqueuePosition;
+        unsigned int dequeuePosition;
+
+        std::deque<MainThreadJob*> overflow;
+        volatile bool overflowing;
+        Poco::FastMutex overflowMutex;
+
+        std::vector<MainThreadJob*> freeJobs;
+        Poco::FastMutex freeJobsMutex;
+
+        std::map<std::string, MainThreadJob*> coalescedJobs;
+        Poco::FastMutex coalescedJobsMutex;
+
+        // Statistics are only touched on the main thread, except
+        // for the depth which producers also update.
+        Poco::AtomicCounter depth;
+        int maxDepth;
+        Poco::UInt64 executed;
+        Poco::AtomicCounter coalesced;
+        Poco::UInt64 budgetExceeded;
+        Poco::UInt64 latencyHistogram[HISTOGRAM_BUCKETS];
+        Poco::UInt64 depthHistogram[HISTOGRAM_BUCKETS];
+
+        DISALLOW_EVIL_CONSTRUCTORS(MainThreadJobQueue);
+    };
+}
+
+#endif
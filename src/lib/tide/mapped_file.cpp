@@ -0,0 +1,164 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "mapped_file.h"
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+#else
+#include <tideutils/posix/posix_utils.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#endif
+
+namespace tide
+{
+    MappedFile::MappedFile(const std::string& path) :
+        path(path),
+        data(0),
+        size(0)
+    {
+#ifdef OS_WIN32
+        this->mapping = NULL;
+        this->handle = CreateFileW(UTF8ToWide(path).c_str(), GENERIC_READ,
+            FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (this->handle == INVALID_HANDLE_VALUE)
+            throw ValueException::FromFormat("Could not open %s", path.c_str());
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(this->handle, &fileSize))
+        {
+            CloseHandle(this->handle);
+            throw ValueException::FromFormat("Could not get the size of %s", path.c_str());
+        }
+        this->size = fileSize.QuadPart;
+
+        // Windows refuses to map an empty file.
+        if (this->size == 0)
+            return;
+
+        if ((Poco::UInt64) (SIZE_T) this->size != this->size)
+        {
+            CloseHandle(this->handle);
+            throw ValueException::FromFormat("%s is too large to map", path.c_str());
+        }
+
+        this->mapping = CreateFileMappingW(this->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (this->mapping)
+        {
+            this->data = static_cast<const unsigned char*>(
+                MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!this->data)
+        {
+            if (this->mapping)
+                CloseHandle(this->mapping);
+            CloseHandle(this->handle);
+            throw ValueException::FromFormat("Could not map %s", path.c_str());
+        }
+#else
+        int descriptor = open(UTF8ToSystem(path).c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            throw ValueException::FromFormat("Could not open %s: %s",
+                path.c_str(), strerror(errno));
+        }
+
+        struct stat info;
+        if (fstat(descriptor, &info) != 0)
+        {
+            int error = errno;
+            close(descriptor);
+            throw ValueException::FromFormat("Could not get the size of %s: %s",
+                path.c_str(), strerror(error));
+        }
+        this->size = info.st_size;
+
+        // POSIX does not allow mapping zero bytes.
+        if (this->size == 0)
+        {
+            close(descriptor);
+            return;
+        }
+
+        if ((Poco::UInt64) (size_t) this->size != this->size)
+        {
+            close(descriptor);
+            throw ValueException::FromFormat("%s is too large to map", path.c_str());
+        }
+
+        // The mapping keeps its own reference to the file,
+        // so the descriptor isn't needed past this point.
+        void* address = mmap(0, (size_t) this->size, PROT_READ, MAP_SHARED, descriptor, 0);
+        int error = errno;
+        close(descriptor);
+        if (address == MAP_FAILED)
+        {
+            throw ValueException::FromFormat("Could not map %s: %s",
+                path.c_str(), strerror(error));
+        }
+        this->data = static_cast<const unsigned char*>(address);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifdef OS_WIN32
+        if (this->data)
+            UnmapViewOfFile(this->data);
+        if (this->mapping)
+            CloseHandle(this->mapping);
+        CloseHandle(this->handle);
+#else
+        if (this->data)
+            munmap(const_cast<unsigned char*>(this->data), (size_t) this->size);
+#endif
+    }
+
+    void MappedFile::WillNeed()
+    {
+#if !defined(OS_WIN32) && defined(MADV_WILLNEED)
+        if (this->data)
+        {
+            madvise(const_cast<unsigned char*>(this->data),
+                (size_t) this->size, MADV_WILLNEED);
+        }
+#endif
+    }
+}
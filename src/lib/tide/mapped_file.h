@@ -32,60 +32,56 @@
 * limitations under the License.
 **/
 
-#ifndef _PROFILED_BOUND_METHOD_H_
-#define _PROFILED_BOUND_METHOD_H_
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "tide.h"
+#include <Poco/Types.h>
+
+#ifdef OS_WIN32
+#include <windows.h>
+#endif
 
 namespace tide
 {
     /**
-     * The ProfiledBoundMethod is a wrapped TiMethod that does profiling
+     * A read-only view of a whole file mapped into memory. Pages are only
+     * read from disk when they are touched, and separate threads can read
+     * separate parts of the file without any locking or copying.
      */
-    class ProfiledBoundMethod : public ProfiledBoundObject, public TiMethod
+    class TIDE_API MappedFile
     {
     public:
-        ProfiledBoundMethod(TiMethodRef delegate, std::string& parentType);
-        virtual ~ProfiledBoundMethod();
-
-        // @see TiMethod::Call
-        virtual ValueRef Call(const ValueList& args);
-        // @see TiMethod::Set
-        virtual void Set(const char *name, ValueRef value);
-        // @see TiMethod::Get
-        virtual ValueRef Get(const char *name);
-        // @see TiMethod::GetPropertyNames
-        virtual SharedStringList GetPropertyNames();
-        // @see TiObject::GetType
-        virtual std::string& GetType();
-
-        bool HasProperty(const char* name);
-
         /**
-         * @return the delegate of this profiled bound method
+         * Map a file, throwing a ValueException on failure.
+         * @param path The UTF-8 path of the file
          */
-        TiMethodRef GetDelegate() { return method; }
-        virtual void duplicate()
-        {
-            ++count;
-        }
+        MappedFile(const std::string& path);
+        ~MappedFile();
 
-        virtual void release()
-        {
-            int value = --count;
-            if (value <= 0) {
-                delete this;
-            }
-        }
+        /**
+         * Tell the operating system that the whole file will be needed
+         * soon, so that it can start reading it in the background.
+         */
+        void WillNeed();
 
-        virtual int referenceCount() const
-        {
-            return count.value();
-        }
+        /**
+         * @return the start of the mapping, or NULL for an empty file
+         */
+        const unsigned char* GetData() const { return data; }
+        Poco::UInt64 GetSize() const { return size; }
+        const std::string& GetPath() const { return path; }
 
     private:
-        TiMethodRef method;
-        std::string fullType;
-        Poco::AtomicCounter count;
+        std::string path;
+        const unsigned char* data;
+        Poco::UInt64 size;
+#ifdef OS_WIN32
+        HANDLE handle;
+        HANDLE mapping;
+#endif
 
+        DISALLOW_EVIL_CONSTRUCTORS(MappedFile);
     };
 }
 
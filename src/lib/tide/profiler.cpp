@@ -0,0 +1,573 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* Copyright (c) 2012 Mital Vora
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "tide.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <Poco/Thread.h>
+
+#if !defined(OS_WIN32)
+#include <pthread.h>
+#endif
+
+// Events are stored in chunks, which are allocated as a thread needs them
+// and reused after the profile is cleared. A thread stops recording raw
+// events once it has filled MAX_CHUNKS_PER_THREAD chunks, but keeps
+// updating its statistics.
+#define EVENTS_PER_CHUNK 4096
+#define MAX_CHUNKS_PER_THREAD 64
+
+// The number of distinct path and event type pairs each thread can keep
+// statistics for. This must be a power of two.
+#define STATS_SLOTS 1024
+
+// The number of buffers of exited threads whose events are kept for the
+// trace. Past this, new threads take over the oldest of them.
+#define MAX_RETIRED_BUFFERS 16
+
+namespace tide
+{
+    // Upper bounds of the latency histogram buckets in microseconds,
+    // the last bucket is open-ended.
+    static const Poco::Timestamp::TimeDiff latencyBounds[] =
+    {
+        10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000
+    };
+
+    static const char* eventTypeNames[] = { "call", "get", "set" };
+
+    struct TraceEvent
+    {
+        const Atom* path;
+        Profiler::EventType type;
+        Poco::Timestamp::TimeVal start;
+        Poco::Timestamp::TimeDiff duration;
+    };
+
+    struct TraceChunk
+    {
+        TraceEvent events[EVENTS_PER_CHUNK];
+        volatile unsigned int used;
+        void* volatile next;
+    };
+
+    struct PathStats
+    {
+        const Atom* volatile path;
+        Profiler::EventType type;
+        Poco::UInt64 count;
+        Poco::Timestamp::TimeDiff totalTime;
+        Poco::Timestamp::TimeDiff maxTime;
+        Poco::UInt64 histogram[Profiler::HISTOGRAM_BUCKETS];
+    };
+
+    // Everything a thread has recorded. Only the owning thread writes to
+    // its buffer; readers publish nothing and tolerate seeing a partially
+    // updated statistic, which is fine for profiling data. When a thread
+    // exits its buffer is retired and later handed to a new thread, so it
+    // is never freed while a reader may be looking at it.
+    struct ThreadBuffer
+    {
+        long threadId;
+        char threadName[64];
+        volatile unsigned int generation;
+        TraceChunk* head;
+        TraceChunk* tail;
+        unsigned int chunkCount;
+        Poco::UInt64 dropped;
+        PathStats stats[STATS_SLOTS];
+    };
+
+    volatile bool Profiler::enabled = false;
+    static volatile unsigned int generation = 1;
+    static Poco::Timestamp::TimeVal startTime = 0;
+
+    static Poco::FastMutex& BuffersMutex()
+    {
+        static Poco::FastMutex mutex;
+        return mutex;
+    }
+
+    static std::vector<ThreadBuffer*>& Buffers()
+    {
+        static std::vector<ThreadBuffer*> buffers;
+        return buffers;
+    }
+
+    // Buffers of exited threads, oldest first.
+    static std::vector<ThreadBuffer*>& RetiredBuffers()
+    {
+        static std::vector<ThreadBuffer*> buffers;
+        return buffers;
+    }
+
+    static ThreadBuffer* TakeRetiredBuffer()
+    {
+        // Must be called with the buffers mutex held. A buffer which
+        // recorded nothing since the last clear can be reused right away,
+        // since its events are no longer part of the profile.
+        std::vector<ThreadBuffer*>& retired = RetiredBuffers();
+        unsigned int currentGeneration = Atomic::Load(&generation);
+        for (size_t i = 0; i < retired.size(); i++)
+        {
+            ThreadBuffer* buffer = retired[i];
+            if (buffer->generation != currentGeneration)
+            {
+                retired.erase(retired.begin() + i);
+                return buffer;
+            }
+        }
+
+        if (retired.size() < MAX_RETIRED_BUFFERS)
+            return 0;
+
+        ThreadBuffer* buffer = retired.front();
+        retired.erase(retired.begin());
+        return buffer;
+    }
+
+    static ThreadBuffer* CreateThreadBuffer()
+    {
+        Poco::FastMutex::ScopedLock lock(BuffersMutex());
+        ThreadBuffer* buffer = TakeRetiredBuffer();
+        if (!buffer)
+        {
+            buffer = new ThreadBuffer();
+            buffer->head = buffer->tail = 0;
+            buffer->chunkCount = 0;
+            Buffers().push_back(buffer);
+        }
+
+        // Hide the buffer from readers until this thread records into it,
+        // which resets whatever the last thread left behind.
+        Atomic::Store(&buffer->generation, 0);
+
+        std::string threadName;
+        Poco::Thread* thread = Poco::Thread::current();
+        if (thread)
+            threadName = thread->getName();
+        else if (Host::GetInstance() && Host::GetInstance()->IsMainThread())
+            threadName = "Main Thread";
+
+        buffer->threadId = Poco::Thread::currentTid();
+        strncpy(buffer->threadName, threadName.c_str(), sizeof(buffer->threadName) - 1);
+        buffer->threadName[sizeof(buffer->threadName) - 1] = '\0';
+        return buffer;
+    }
+
+    static void RetireThreadBuffer(void* data)
+    {
+        Poco::FastMutex::ScopedLock lock(BuffersMutex());
+        RetiredBuffers().push_back(static_cast<ThreadBuffer*>(data));
+    }
+
+#if defined(OS_WIN32)
+    static void WINAPI RetireThreadBufferCallback(void* data)
+    {
+        if (data)
+            RetireThreadBuffer(data);
+    }
+
+    // Fiber-local storage is used because, unlike TlsAlloc, it
+    // runs a destructor when the thread exits.
+    static DWORD GetThreadBufferKey()
+    {
+        static DWORD key = FlsAlloc(&RetireThreadBufferCallback);
+        return key;
+    }
+
+    static ThreadBuffer* GetThreadBuffer()
+    {
+        DWORD key = GetThreadBufferKey();
+        ThreadBuffer* buffer = static_cast<ThreadBuffer*>(FlsGetValue(key));
+        if (!buffer)
+        {
+            buffer = CreateThreadBuffer();
+            FlsSetValue(key, buffer);
+        }
+        return buffer;
+    }
+#else
+    static pthread_key_t threadBufferKey;
+    static pthread_once_t threadBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+    static void CreateThreadBufferKey()
+    {
+        pthread_key_create(&threadBufferKey, &RetireThreadBuffer);
+    }
+
+    static ThreadBuffer* GetThreadBuffer()
+    {
+        pthread_once(&threadBufferKeyOnce, &CreateThreadBufferKey);
+        ThreadBuffer* buffer = static_cast<ThreadBuffer*>(pthread_getspecific(threadBufferKey));
+        if (!buffer)
+        {
+            buffer = CreateThreadBuffer();
+            pthread_setspecific(threadBufferKey, buffer);
+        }
+        return buffer;
+    }
+#endif
+
+    static void ResetThreadBuffer(ThreadBuffer* buffer, unsigned int currentGeneration)
+    {
+        // Chunks are kept for reuse, since a reader may still be walking them.
+        for (TraceChunk* chunk = buffer->head; chunk;
+            chunk = static_cast<TraceChunk*>(chunk->next))
+        {
+            Atomic::Store(&chunk->used, 0);
+        }
+        buffer->tail = buffer->head;
+        buffer->dropped = 0;
+
+        for (int i = 0; i < STATS_SLOTS; i++)
+        {
+            PathStats& stats = buffer->stats[i];
+            stats.path = 0;
+            stats.count = 0;
+            stats.totalTime = 0;
+            stats.maxTime = 0;
+            for (int j = 0; j < Profiler::HISTOGRAM_BUCKETS; j++)
+                stats.histogram[j] = 0;
+        }
+
+        Atomic::Store(&buffer->generation, currentGeneration);
+    }
+
+    static void RecordEvent(ThreadBuffer* buffer, const TraceEvent& event)
+    {
+        TraceChunk* chunk = buffer->tail;
+        if (!chunk || chunk->used == EVENTS_PER_CHUNK)
+        {
+            TraceChunk* next = chunk ? static_cast<TraceChunk*>(chunk->next) : buffer->head;
+            if (!next)
+            {
+                if (buffer->chunkCount == MAX_CHUNKS_PER_THREAD)
+                {
+                    buffer->dropped++;
+                    return;
+                }
+
+                next = new TraceChunk();
+                next->used = 0;
+                next->next = 0;
+                buffer->chunkCount++;
+                if (chunk)
+                    Atomic::StorePointer(&chunk->next, next);
+                else
+                    buffer->head = next;
+            }
+            buffer->tail = chunk = next;
+        }
+
+        chunk->events[chunk->used] = event;
+        Atomic::Store(&chunk->used, chunk->used + 1);
+    }
+
+    static void RecordStats(ThreadBuffer* buffer, const TraceEvent& event)
+    {
+        unsigned int index = (event.path->HashCode() * 3 + event.type) & (STATS_SLOTS - 1);
+        for (int probe = 0; probe < STATS_SLOTS; probe++)
+        {
+            PathStats& stats = buffer->stats[(index + probe) & (STATS_SLOTS - 1)];
+            if (!stats.path)
+            {
+                stats.type = event.type;
+                Atomic::StorePointer((void* volatile*) &stats.path, (void*) event.path);
+            }
+            else if (stats.path != event.path || stats.type != event.type)
+            {
+                continue;
+            }
+
+            stats.count++;
+            stats.totalTime += event.duration;
+            if (event.duration > stats.maxTime)
+                stats.maxTime = event.duration;
+
+            int bucket = 0;
+            while (bucket < Profiler::HISTOGRAM_BUCKETS - 1 && event.duration > latencyBounds[bucket])
+                bucket++;
+            stats.histogram[bucket]++;
+            return;
+        }
+    }
+
+    /*static*/
+    void Profiler::Start(bool clear)
+    {
+        if (clear)
+            Clear();
+        if (!startTime)
+            startTime = Now();
+        enabled = true;
+    }
+
+    /*static*/
+    void Profiler::Stop()
+    {
+        enabled = false;
+    }
+
+    /*static*/
+    void Profiler::Clear()
+    {
+        // Each thread notices the new generation the next time it records
+        // something and resets its own buffer, so that no buffer is ever
+        // written by two threads.
+        unsigned int current;
+        do
+        {
+            current = Atomic::Load(&generation);
+        }
+        while (!Atomic::CompareAndSwap(&generation, current, current + 1));
+        startTime = Now();
+    }
+
+    /*static*/
+    Poco::Timestamp::TimeVal Profiler::Now()
+    {
+        return Poco::Timestamp().epochMicroseconds();
+    }
+
+    /*static*/
+    void Profiler::Record(EventType type, const Atom* path,
+        Poco::Timestamp::TimeVal start, Poco::Timestamp::TimeDiff duration)
+    {
+        if (!enabled)
+            return;
+
+        ThreadBuffer* buffer = GetThreadBuffer();
+        unsigned int currentGeneration = Atomic::Load(&generation);
+        if (buffer->generation != currentGeneration)
+            ResetThreadBuffer(buffer, currentGeneration);
+
+        TraceEvent event;
+        event.path = path;
+        event.type = type;
+        event.start = start;
+        event.duration = duration;
+        RecordEvent(buffer, event);
+        RecordStats(buffer, event);
+    }
+
+    struct AggregateStats
+    {
+        AggregateStats() : count(0), totalTime(0), maxTime(0)
+        {
+            for (int i = 0; i < Profiler::HISTOGRAM_BUCKETS; i++)
+                histogram[i] = 0;
+        }
+
+        std::string path;
+        Profiler::EventType type;
+        Poco::UInt64 count;
+        Poco::Timestamp::TimeDiff totalTime;
+        Poco::Timestamp::TimeDiff maxTime;
+        Poco::UInt64 histogram[Profiler::HISTOGRAM_BUCKETS];
+    };
+
+    static bool CompareTotalTime(const AggregateStats* a, const AggregateStats* b)
+    {
+        return a->totalTime > b->totalTime;
+    }
+
+    // Copy the list of buffers, so that threads which start
+    // recording while we read don't have to wait for us.
+    static std::vector<ThreadBuffer*> CurrentBuffers()
+    {
+        std::vector<ThreadBuffer*> buffers;
+        unsigned int currentGeneration = Atomic::Load(&generation);
+
+        Poco::FastMutex::ScopedLock lock(BuffersMutex());
+        for (size_t i = 0; i < Buffers().size(); i++)
+        {
+            if (Atomic::Load(&Buffers()[i]->generation) == currentGeneration)
+                buffers.push_back(Buffers()[i]);
+        }
+        return buffers;
+    }
+
+    /*static*/
+    TiObjectRef Profiler::GetStatsObject()
+    {
+        std::map<std::pair<const Atom*, int>, AggregateStats> aggregated;
+        Poco::UInt64 events = 0;
+        Poco::UInt64 dropped = 0;
+
+        std::vector<ThreadBuffer*> buffers(CurrentBuffers());
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            ThreadBuffer* buffer = buffers[i];
+            dropped += buffer->dropped;
+            for (int j = 0; j < STATS_SLOTS; j++)
+            {
+                PathStats& stats = buffer->stats[j];
+                const Atom* path = static_cast<const Atom*>(
+                    Atomic::LoadPointer((void* volatile*) &stats.path));
+                if (!path)
+                    continue;
+
+                AggregateStats& total = aggregated[std::make_pair(path, (int) stats.type)];
+                total.path = path->Name();
+                total.type = stats.type;
+                total.count += stats.count;
+                total.totalTime += stats.totalTime;
+                total.maxTime = std::max(total.maxTime, stats.maxTime);
+                for (int k = 0; k < HISTOGRAM_BUCKETS; k++)
+                    total.histogram[k] += stats.histogram[k];
+                events += stats.count;
+            }
+        }
+
+        std::vector<AggregateStats*> sorted;
+        std::map<std::pair<const Atom*, int>, AggregateStats>::iterator iter = aggregated.begin();
+        for (; iter != aggregated.end(); iter++)
+            sorted.push_back(&iter->second);
+        std::sort(sorted.begin(), sorted.end(), &CompareTotalTime);
+
+        TiListRef paths(new StaticBoundList());
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            AggregateStats* total = sorted[i];
+            TiObjectRef entry(new StaticBoundObject());
+            entry->SetString("path", total->path);
+            entry->SetString("type", eventTypeNames[total->type]);
+            entry->SetDouble("count", (double) total->count);
+            entry->SetDouble("totalTime", total->totalTime / 1000.0);
+            entry->SetDouble("averageTime", total->totalTime / 1000.0 / total->count);
+            entry->SetDouble("maxTime", total->maxTime / 1000.0);
+
+            TiListRef histogram(new StaticBoundList());
+            for (int j = 0; j < HISTOGRAM_BUCKETS; j++)
+            {
+                bool last = j == HISTOGRAM_BUCKETS - 1;
+
+                TiObjectRef bucket(new StaticBoundObject());
+                bucket->SetDouble("max", last ?
+                    std::numeric_limits<double>::infinity() : latencyBounds[j] / 1000.0);
+                bucket->SetDouble("count", (double) total->histogram[j]);
+                histogram->Append(Value::NewObject(bucket));
+            }
+            entry->SetList("histogram", histogram);
+            paths->Append(Value::NewObject(entry));
+        }
+
+        TiObjectRef result(new StaticBoundObject());
+        result->SetBool("enabled", enabled);
+        result->SetDouble("events", (double) events);
+        result->SetDouble("droppedEvents", (double) dropped);
+        result->SetList("paths", paths);
+        return result;
+    }
+
+    static void WriteJSONString(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            char c = text[i];
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if ((unsigned char) c < 0x20)
+                out << ' ';
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    /*static*/
+    void Profiler::WriteTrace(std::ostream& out)
+    {
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        std::vector<ThreadBuffer*> buffers(CurrentBuffers());
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            ThreadBuffer* buffer = buffers[i];
+            if (buffer->threadName[0])
+            {
+                out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                    << buffer->threadId << ",\"args\":{\"name\":";
+                WriteJSONString(out, buffer->threadName);
+                out << "}}";
+                first = false;
+            }
+
+            for (TraceChunk* chunk = buffer->head; chunk;
+                chunk = static_cast<TraceChunk*>(Atomic::LoadPointer(&chunk->next)))
+            {
+                unsigned int used = Atomic::Load(&chunk->used);
+                for (unsigned int j = 0; j < used; j++)
+                {
+                    TraceEvent& event = chunk->events[j];
+                    out << (first ? "" : ",") << "\n{\"name\":";
+                    WriteJSONString(out, event.path->Name());
+                    out << ",\"cat\":\"" << eventTypeNames[event.type]
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                        << ",\"ts\":" << (event.start - startTime)
+                        << ",\"dur\":" << event.duration << "}";
+                    first = false;
+                }
+
+                // The rest of the chain is left over from before a clear.
+                if (used < EVENTS_PER_CHUNK)
+                    break;
+            }
+        }
+
+        out << "\n]}\n";
+    }
+
+    /*static*/
+    void Profiler::WriteTrace(const std::string& path)
+    {
+#if defined(OS_WIN32)
+        std::ofstream out(UTF8ToWide(path).c_str(), std::ios::out | std::ios::trunc);
+#else
+        std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+#endif
+        if (!out.is_open())
+            throw ValueException::FromFormat("Could not open profile output file: %s",
+                path.c_str());
+
+        WriteTrace(out);
+    }
+}
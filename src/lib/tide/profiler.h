@@ -0,0 +1,130 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _TIDE_PROFILER_H_
+#define _TIDE_PROFILER_H_
+
+#include <iosfwd>
+#include <Poco/Timestamp.h>
+
+namespace tide
+{
+    /**
+     * A low-overhead profiler for calls into the Tide API. Every thread
+     * records events into its own buffer, which no other thread writes,
+     * so recording never takes a lock. Call counts and latency histograms
+     * are kept per API path next to the raw events, and the events can be
+     * exported as Chrome trace-event JSON (chrome://tracing).
+     *
+     * The profiler is off by default and costs a single flag check while
+     * off. It can be started with --profile or at any time from script.
+     */
+    class TIDE_API Profiler
+    {
+    public:
+        enum EventType
+        {
+            CALL = 0,
+            GET = 1,
+            SET = 2
+        };
+
+        static const int HISTOGRAM_BUCKETS = 10;
+
+        static bool IsEnabled() { return enabled; }
+
+        /**
+         * Start recording. Unless clear is false, anything recorded
+         * by an earlier run is discarded.
+         */
+        static void Start(bool clear = true);
+        static void Stop();
+        static void Clear();
+
+        /**
+         * Microseconds on the profiler's clock.
+         */
+        static Poco::Timestamp::TimeVal Now();
+
+        /**
+         * Record an event for path which started at start (see Now)
+         * and lasted duration microseconds.
+         */
+        static void Record(EventType type, const Atom* path,
+            Poco::Timestamp::TimeVal start, Poco::Timestamp::TimeDiff duration);
+
+        /**
+         * Get the aggregated counts and latency histograms for every
+         * path which has been recorded, as a bound object.
+         */
+        static TiObjectRef GetStatsObject();
+
+        /**
+         * Write every recorded event as Chrome trace-event JSON.
+         */
+        static void WriteTrace(std::ostream& out);
+        static void WriteTrace(const std::string& path);
+
+        /**
+         * Times the enclosing scope. Pass a NULL path to skip recording,
+         * which is what callers do while the profiler is off.
+         */
+        class Scope
+        {
+        public:
+            Scope(EventType type, const Atom* path) :
+                type(type),
+                path(path),
+                start(path ? Now() : 0)
+            {
+            }
+
+            ~Scope()
+            {
+                if (path)
+                    Record(type, path, start, Now() - start);
+            }
+
+        private:
+            EventType type;
+            const Atom* path;
+            Poco::Timestamp::TimeVal start;
+        };
+
+    private:
+        static volatile bool enabled;
+    };
+}
+
+#endif
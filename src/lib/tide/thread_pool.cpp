@@ -5,9 +5,15 @@
  */
 
 #include "thread_pool.h"
+#include "atomic.h"
+#include <algorithm>
+#include <Poco/ThreadLocal.h>
 
 namespace tide
 {
+    // The worker running on the current thread, if any.
+    static Poco::ThreadLocal<PooledThread*> currentThread;
+
     /**
         ThreadPool
     */
@@ -16,101 +22,160 @@ namespace tide
         minCapacity(minCapacity),
         maxCapacity(maxCapacity),
         idleSeconds(idleSeconds),
-        queueMax(queueMax)
+        queueMax(queueMax),
+        stopping(0),
+        pending(0),
+        rejected(0)
     {
+        retiredStats.threads = retiredStats.idle = retiredStats.queued = 0;
+        retiredStats.executed = retiredStats.stolen = 0;
+        retiredStats.rejected = retiredStats.reaped = 0;
+        retiredStats.totalWait = retiredStats.maxWait = 0;
+
         // Spawn initial threads
         for (int c = 0; c < minCapacity; c++)
         {
-            PooledThread* thread = new PooledThread(this);
-            this->threads.push_back(thread);
-            thread->start();
+            this->spawnThread();
         }
     }
 
     ThreadPool::~ThreadPool()
     {
-        // Wait for all threads to complete
-        this->pauseAll();
+        PooledThreadList all;
+        {
+            Poco::ScopedRWLock lock(this->threadsLock, true);
+            Atomic::Store(&this->stopping, 1);
+            all = this->threads;
+            all.insert(all.end(), this->retired.begin(), this->retired.end());
+            this->threads.clear();
+            this->retired.clear();
+        }
 
-        // Free all threads
-        PooledThreadList::iterator i = this->threads.begin();
-        while (i != this->threads.end())
+        // Wake everyone up so they notice we are stopping, then wait
+        // for all threads to complete and free them.
+        for (size_t i = 0; i < all.size(); i++)
         {
-            PooledThread* thread = *i++;
-            delete thread;
+            all[i]->wakeup.set();
+        }
+        for (size_t i = 0; i < all.size(); i++)
+        {
+            all[i]->join();
+            delete all[i];
         }
     }
 
     bool ThreadPool::start(SharedRunnable target, bool queue)
     {
-        PooledThread* thread = this->getIdleThread();
-        if (!thread)
+        PoolJob job(target);
+        if (!queue && this->availableThreads() == 0 && !this->canSpawnThread())
+        {
+            return false;
+        }
+
+        // Jobs spawned from one of our own workers go onto its own deque,
+        // where they will either be run by the worker or stolen by a sibling.
+        PooledThread* worker = this->currentWorker();
+        if (worker)
         {
-            // If no threads are available, queue the job for later
-            // if the caller allows it.
-            if (queue)
+            worker->pushLocal(job);
+            this->wakeIdleThread();
+            return true;
+        }
+
+        {
+            Poco::FastMutex::ScopedLock lock(this->injectedMutex);
+            if (this->queueMax >= 0 && (int) this->injected.size() >= this->queueMax)
             {
-                this->addJob(target);
-                return true;
+                this->rejected++;
+                return false;
             }
-
-            return false;
+            this->injected.push_back(job);
+            this->pending++;
         }
 
-        thread->assignJob(target);
+        this->wakeIdleThread();
         return true;
     }
 
     void ThreadPool::pauseAll()
     {
-        Poco::Mutex::ScopedLock lock(this->threadsMutex);
-
-        PooledThreadList::iterator i = this->threads.begin();
-        while (i != this->threads.end())
+        // The pool can only become quiet when a worker goes idle, and
+        // markIdle signals under quietMutex, so no wakeup is lost.
+        Poco::FastMutex::ScopedLock lock(this->quietMutex);
+        while (this->hasPendingJobs() || this->availableThreads() < this->totalThreads())
         {
-            PooledThread* thread = *i++;
-            if (!thread->idle())
-            {
-                thread->pause(true);
-            }
-        }    
+            this->quiet.wait(this->quietMutex);
+        }
     }
 
     int ThreadPool::availableThreads()
     {
-        Poco::Mutex::ScopedLock lock(this->threadsMutex);
-
-        int count = 0;
-        PooledThreadList::iterator i = this->threads.begin();
-        while (i != this->threads.end())
-        {
-            PooledThread* thread = *i++;
-            if (thread->idle()) count++;
-        }
-
-        return count;
+        Poco::FastMutex::ScopedLock lock(this->idleMutex);
+        return this->idleThreads.size();
     }
 
     int ThreadPool::totalThreads()
     {
+        Poco::ScopedRWLock lock(this->threadsLock, false);
         return this->threads.size();
     }
 
     void ThreadPool::collect()
     {
-        Poco::Mutex::ScopedLock lock(this->threadsMutex);
+        PooledThreadList dead;
+        {
+            Poco::ScopedRWLock lock(this->threadsLock, true);
+            dead.swap(this->retired);
+        }
+
+        for (size_t i = 0; i < dead.size(); i++)
+        {
+            dead[i]->join();
+            delete dead[i];
+        }
+    }
+
+    ThreadPoolStats ThreadPool::GetStats()
+    {
+        Poco::ScopedRWLock lock(this->threadsLock, false);
+
+        ThreadPoolStats stats(this->retiredStats);
+        stats.threads = this->threads.size();
+        stats.idle = this->availableThreads();
+        stats.queued = this->pending.value();
+        stats.rejected = this->rejected.value();
 
         PooledThreadList::iterator i = this->threads.begin();
         while (i != this->threads.end())
         {
-            PooledThread* thread = *i;
-            if (thread->idleTime() > this->idleSeconds)
-            {
-                thread->shutdown();
-                this->threads.erase(i);
-            }
-            i++;
+            PooledThread* thread = *i++;
+            stats.executed += thread->executed;
+            stats.stolen += thread->stolen;
+            stats.totalWait += thread->totalWait;
+            stats.maxWait = std::max(stats.maxWait, thread->maxWait);
         }
+
+        return stats;
+    }
+
+    TiObjectRef ThreadPool::GetStatsObject()
+    {
+        ThreadPoolStats stats(this->GetStats());
+        double averageWait = stats.executed > 0 ?
+            (double) stats.totalWait / (double) stats.executed : 0.0;
+
+        TiObjectRef object(new StaticBoundObject());
+        object->SetInt("threads", stats.threads);
+        object->SetInt("idle", stats.idle);
+        object->SetInt("queued", stats.queued);
+        object->SetDouble("executed", (double) stats.executed);
+        object->SetDouble("stolen", (double) stats.stolen);
+        object->SetDouble("rejected", (double) stats.rejected);
+        object->SetDouble("reaped", (double) stats.reaped);
+        object->SetDouble("totalWaitTime", stats.totalWait / 1000.0);
+        object->SetDouble("averageWaitTime", averageWait / 1000.0);
+        object->SetDouble("maxWaitTime", stats.maxWait / 1000.0);
+        return object;
     }
 
     bool ThreadPool::canSpawnThread()
@@ -119,171 +184,269 @@ namespace tide
         return (threadCount < this->maxCapacity);
     }
 
-    PooledThread* ThreadPool::getIdleThread()
+    PooledThread* ThreadPool::currentWorker()
     {
-        Poco::Mutex::ScopedLock lock(this->threadsMutex);
+        PooledThread* thread = currentThread.get();
+        if (thread && thread->pool == this)
+            return thread;
+        return 0;
+    }
 
-        PooledThreadList::iterator i = this->threads.begin();
-        while (i != this->threads.end())
+    void ThreadPool::wakeIdleThread()
+    {
         {
-            PooledThread* thread = *i;
-            if (thread->idle())
+            // Prefer the most recently idled thread, its cache is still warm.
+            Poco::FastMutex::ScopedLock lock(this->idleMutex);
+            if (!this->idleThreads.empty())
             {
-                thread->reserve();
-                return thread;
+                PooledThread* thread = this->idleThreads.back();
+                this->idleThreads.pop_back();
+                thread->isIdle = false;
+                thread->wakeup.set();
+                return;
             }
-            i++;
         }
 
-        // If we do not find any idle threads, see if we can spawn one.
+        // Do not hold idleMutex here -- retire() takes the locks
+        // in the opposite order.
         if (this->canSpawnThread())
+            this->spawnThread();
+    }
+
+    void ThreadPool::spawnThread()
+    {
+        PooledThreadList dead;
         {
+            Poco::ScopedRWLock lock(this->threadsLock, true);
+            if (this->stopping || (int) this->threads.size() >= this->maxCapacity)
+                return;
+
             PooledThread* thread = new PooledThread(this);
             this->threads.push_back(thread);
             thread->start();
-            thread->reserve();
-            return thread;
+
+            // Opportunistically free any reaped threads.
+            dead.swap(this->retired);
         }
 
-        return 0;
+        for (size_t i = 0; i < dead.size(); i++)
+        {
+            dead[i]->join();
+            delete dead[i];
+        }
     }
 
-    SharedRunnable ThreadPool::getJob()
+    bool ThreadPool::findJob(PooledThread* thread, PoolJob& job)
     {
-        Poco::Mutex::ScopedLock lock(this->jobsMutex);
-        SharedRunnable job;
+        if (thread->popLocal(job))
+            return true;
 
-        if (!this->pendingJobs.empty())
         {
-            job = this->pendingJobs.back();
-            this->pendingJobs.pop();
+            Poco::FastMutex::ScopedLock lock(this->injectedMutex);
+            if (!this->injected.empty())
+            {
+                job = this->injected.front();
+                this->injected.pop_front();
+                this->pending--;
+                return true;
+            }
         }
-        
-        return job;
-    }
 
-    void ThreadPool::addJob(SharedRunnable job)
-    {
-        Poco::Mutex::ScopedLock lock(this->jobsMutex);
-        this->pendingJobs.push(job);
+        return this->stealJob(thread, job);
     }
 
-    /**
-        PooledThread
-    */
-
-    PooledThread::PooledThread(ThreadPool* pool) :
-        _state(DEAD),
-        sleeping(false),
-        pool(pool)
+    bool ThreadPool::stealJob(PooledThread* thread, PoolJob& job)
     {
+        Poco::ScopedRWLock lock(this->threadsLock, false);
+
+        // Start with the sibling after us so that thieves spread
+        // themselves over the victims instead of all hitting the first.
+        size_t count = this->threads.size();
+        size_t start = std::find(this->threads.begin(), this->threads.end(), thread)
+            - this->threads.begin();
+        for (size_t n = 1; n < count; n++)
+        {
+            PooledThread* victim = this->threads[(start + n) % count];
+            if (victim->stealFrom(job))
+            {
+                thread->stolen++;
+                return true;
+            }
+        }
+        return false;
     }
 
-    PooledThread::~PooledThread()
+    bool ThreadPool::hasPendingJobs()
     {
-        if (this->alive())
-            this->shutdown();
+        return this->pending.value() > 0;
     }
 
-    void PooledThread::start()
+    void ThreadPool::markIdle(PooledThread* thread)
     {
-        this->_state = IDLE;
-        Poco::Thread::start(*this);
+        {
+            Poco::FastMutex::ScopedLock lock(this->idleMutex);
+            if (thread->isIdle)
+                return;
+
+            thread->isIdle = true;
+            this->idleThreads.push_back(thread);
+        }
+
+        Poco::FastMutex::ScopedLock lock(this->quietMutex);
+        this->quiet.broadcast();
     }
 
-    inline void PooledThread::shutdown()
+    void ThreadPool::markBusy(PooledThread* thread)
     {
-        this->setState(POWERDOWN);
+        Poco::FastMutex::ScopedLock lock(this->idleMutex);
+        if (thread->isIdle)
+        {
+            thread->isIdle = false;
+            this->idleThreads.erase(std::remove(this->idleThreads.begin(),
+                this->idleThreads.end(), thread), this->idleThreads.end());
+        }
     }
 
-    void PooledThread::assignJob(SharedRunnable job)
+    bool ThreadPool::retire(PooledThread* thread)
     {
-        this->job = job;
-        this->resume();
+        Poco::ScopedRWLock lock(this->threadsLock, true);
+        if (this->stopping)
+            return true;
+
+        // A job may have been queued just as our idle timeout expired.
+        if ((int) this->threads.size() <= this->minCapacity || this->hasPendingJobs())
+            return false;
+
+        this->markBusy(thread);
+        this->threads.erase(std::remove(this->threads.begin(),
+            this->threads.end(), thread), this->threads.end());
+        this->retired.push_back(thread);
+
+        this->retiredStats.executed += thread->executed;
+        this->retiredStats.stolen += thread->stolen;
+        this->retiredStats.totalWait += thread->totalWait;
+        this->retiredStats.maxWait = std::max(this->retiredStats.maxWait, thread->maxWait);
+        this->retiredStats.reaped++;
+        return true;
     }
 
-    void PooledThread::resume()
+    /**
+        PooledThread
+    */
+
+    PooledThread::PooledThread(ThreadPool* pool) :
+        pool(pool),
+        isIdle(false),
+        executed(0),
+        stolen(0),
+        totalWait(0),
+        maxWait(0)
     {
-        this->setState(WORKING);
-        this->wakeup.set();
     }
 
-    inline void PooledThread::pause(bool wait)
+    PooledThread::~PooledThread()
     {
-        this->setState(PAUSING);
-        if (wait)
-            this->sleeping.wait();
     }
 
-    inline void PooledThread::reserve()
+    void PooledThread::start()
     {
-        this->setState(RESERVED);
+        this->setName("ThreadPool worker");
+        Poco::Thread::start(*this);
     }
 
-    int PooledThread::idleTime()
+    void PooledThread::pushLocal(PoolJob& job)
     {
-        if (!this->idle())
-            return 0;
-        return time(NULL) - this->idleStartTime;
+        Poco::FastMutex::ScopedLock lock(this->localMutex);
+        this->local.push_back(job);
+        this->pool->pending++;
     }
 
-    PooledThread::State PooledThread::state()
+    bool PooledThread::popLocal(PoolJob& job)
     {
-        Poco::Mutex::ScopedLock lock(this->stateMutex);
-        return this->_state;
+        Poco::FastMutex::ScopedLock lock(this->localMutex);
+        if (this->local.empty())
+            return false;
+
+        job = this->local.back();
+        this->local.pop_back();
+        this->pool->pending--;
+        return true;
     }
 
-    void PooledThread::setState(PooledThread::State state)
+    bool PooledThread::stealFrom(PoolJob& job)
     {
-        Poco::Mutex::ScopedLock lock(this->stateMutex);
-        this->_state = state;
+        // Never wait on a busy victim, there are others to try.
+        if (!this->localMutex.tryLock())
+            return false;
+
+        bool found = !this->local.empty();
+        if (found)
+        {
+            job = this->local.front();
+            this->local.pop_front();
+            this->pool->pending--;
+        }
+
+        this->localMutex.unlock();
+        return found;
     }
 
-    void PooledThread::work()
+    void PooledThread::execute(PoolJob& job)
     {
-        if (!this->job.isNull())
+        Poco::Timestamp::TimeDiff wait = job.queuedAt.elapsed();
+        this->totalWait += wait;
+        if (wait > this->maxWait)
+            this->maxWait = wait;
+
+        try
         {
-            this->job->run();
-            this->job = 0;
+            job.runnable->run();
         }
-        else
+        catch (ValueException& e)
         {
-            // If there is no assigned job, fetch one from pool.
-            this->job = this->pool->getJob();
-            if (this->job.isNull())
-            {
-                // No queued jobs in pool, so sleep.
-                this->pause();
-            }
+            Logger::Get("ThreadPool")->Error("Uncaught exception in pooled job: %s",
+                e.ToString().c_str());
         }
+        catch (std::exception& e)
+        {
+            Logger::Get("ThreadPool")->Error("Uncaught exception in pooled job: %s",
+                e.what());
+        }
+
+        job.runnable = 0;
+        this->executed++;
     }
 
     void PooledThread::run()
     {
-        bool alive = true;
+        long idleMillis = this->pool->idleSeconds * 1000;
+        currentThread.get() = this;
 
-        while (alive)
+        while (!Atomic::Load(&this->pool->stopping))
         {
-            switch (this->state())
+            PoolJob job;
+            if (this->pool->findJob(this, job))
             {
-                case WORKING:
-                    this->work();                  // Work on some jobs...
-                    break;
-                case POWERDOWN:
-                    this->setState(DEAD);          // Mark us as a dead thread
-                    alive = false;
-                    break;
-                case PAUSING:
-                    time(&this->idleStartTime);    // Start idle time stopwatch
-                    this->setState(IDLE);          // Enter idle state
-                    this->sleeping.set();          // Let everyone know we are napping
-                    this->wakeup.wait();           // Zzzzz
-                    this->sleeping.reset();        // Reset sleeping event since we are awake now
-                    break;
-                default:
-                    printf("THREAD POOL ERROR: invalid thread state!\n");
-                    return;
+                this->execute(job);
+                continue;
             }
+
+            // Advertise ourselves as idle and look once more, so that a job
+            // queued between the first look and now does not go unnoticed.
+            this->pool->markIdle(this);
+            if (this->pool->findJob(this, job))
+            {
+                this->pool->markBusy(this);
+                this->execute(job);
+                continue;
+            }
+
+            if (!this->wakeup.tryWait(idleMillis) && this->pool->retire(this))
+                return;
+
+            // Whether we were woken or kept alive after timing out, we
+            // are about to look for work, so stop advertising as idle.
+            this->pool->markBusy(this);
         }
     }
 }
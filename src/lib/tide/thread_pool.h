@@ -35,27 +35,67 @@
 #ifndef _THREAD_POOL_H_
 #define _THREAD_POOL_H_
 
-#include <ctime>
-
-#include <list>
-#include <queue>
+#include <deque>
+#include <vector>
 
 #include <Poco/SharedPtr.h>
 #include <Poco/Thread.h>
 #include <Poco/Runnable.h>
 #include <Poco/Mutex.h>
+#include <Poco/RWLock.h>
 #include <Poco/Event.h>
+#include <Poco/Condition.h>
+#include <Poco/AtomicCounter.h>
+#include <Poco/Timestamp.h>
 
 #include "tide.h"
 
 namespace tide
 {
     typedef Poco::SharedPtr<Poco::Runnable> SharedRunnable;
-    typedef std::queue<SharedRunnable> PoolJobQueue;
+
+    /**
+     * A unit of work waiting in one of the pool queues. The timestamp
+     * is used to account for the time a job spends waiting for a thread.
+     */
+    struct PoolJob
+    {
+        PoolJob() {}
+        PoolJob(SharedRunnable runnable) : runnable(runnable) {}
+
+        SharedRunnable runnable;
+        Poco::Timestamp queuedAt;
+    };
+    typedef std::deque<PoolJob> PoolJobQueue;
 
     class PooledThread;
-    typedef std::list<PooledThread*> PooledThreadList;
+    typedef std::vector<PooledThread*> PooledThreadList;
+
+    /**
+     * A snapshot of the counters kept by a ThreadPool.
+     */
+    struct ThreadPoolStats
+    {
+        int threads;       // Number of live worker threads
+        int idle;          // Number of workers currently waiting for work
+        int queued;        // Jobs waiting in the injection and local queues
+        Poco::UInt64 executed; // Jobs run to completion since startup
+        Poco::UInt64 stolen;   // Jobs taken from another worker's queue
+        Poco::UInt64 rejected; // Jobs refused because the queue was full
+        Poco::UInt64 reaped;   // Idle workers that have been shut down
+        Poco::Timestamp::TimeDiff totalWait; // Total queue wait (usec)
+        Poco::Timestamp::TimeDiff maxWait;   // Longest queue wait (usec)
+    };
 
+    /**
+     * A work-stealing thread pool. Jobs started from outside the pool go
+     * into a bounded injection queue, while jobs started from inside a
+     * worker go onto that worker's own deque. Workers pop their own deque
+     * from the back, then drain the injection queue and finally steal
+     * from the front of their siblings' deques. Workers which stay idle
+     * for longer than idleSeconds are shut down automatically as long as
+     * more than minCapacity threads are alive.
+     */
     class TIDE_API ThreadPool
     {
         friend class PooledThread;
@@ -65,17 +105,39 @@ namespace tide
             int minCapacity = 2,
             int maxCapacity = 10,
             int idleSeconds = 60,
-            int queueMax = -1
+            int queueMax = 1024
         );
         virtual ~ThreadPool();
 
+        /**
+         * Schedule a job on the pool. If queue is false, the job is only
+         * accepted when a thread can pick it up right away. Returns false
+         * when the job was not accepted.
+         */
         bool start(SharedRunnable target, bool queue = true);
+
+        /**
+         * Block until all queued jobs have finished and every
+         * worker is idle.
+         */
         void pauseAll();
 
         int availableThreads();
         int totalThreads();
+
+        /**
+         * Release the resources of workers which have been reaped.
+         */
         void collect();
 
+        ThreadPoolStats GetStats();
+
+        /**
+         * Get the counters of this pool as a bound object suitable
+         * for returning to scripts.
+         */
+        TiObjectRef GetStatsObject();
+
     protected:
         virtual bool canSpawnThread();
 
@@ -84,59 +146,69 @@ namespace tide
         int queueMax;
 
     private:
-        PooledThread* getIdleThread();
-
-        SharedRunnable getJob();
-        void addJob(SharedRunnable job);
+        PooledThread* currentWorker();
+        void wakeIdleThread();
+        void spawnThread();
+        bool findJob(PooledThread* thread, PoolJob& job);
+        bool stealJob(PooledThread* thread, PoolJob& job);
+        bool hasPendingJobs();
+        void markIdle(PooledThread* thread);
+        void markBusy(PooledThread* thread);
+        bool retire(PooledThread* thread);
+
+        // Read by the workers without holding any lock.
+        volatile unsigned int stopping;
 
         PooledThreadList threads;
-        Poco::Mutex threadsMutex;
+        PooledThreadList retired;
+        Poco::RWLock threadsLock;
+
+        PooledThreadList idleThreads;
+        Poco::FastMutex idleMutex;
+
+        // Signalled whenever a worker goes idle, for pauseAll.
+        Poco::Condition quiet;
+        Poco::FastMutex quietMutex;
 
-        PoolJobQueue pendingJobs;
-        Poco::Mutex jobsMutex;
+        PoolJobQueue injected;
+        Poco::FastMutex injectedMutex;
+        Poco::AtomicCounter pending;
+        Poco::AtomicCounter rejected;
+
+        // Counters of workers which have already been reaped.
+        ThreadPoolStats retiredStats;
     };
 
     class TIDE_API PooledThread : public Poco::Thread, public Poco::Runnable
     {
+        friend class ThreadPool;
+
     public:
         PooledThread(ThreadPool* pool);
         virtual ~PooledThread();
 
-        enum State {
-            IDLE,
-            PAUSING,
-            RESERVED,
-            WORKING,
-            POWERDOWN,
-            DEAD
-        };
-
         void start();
-        void shutdown();
-        void assignJob(SharedRunnable job);
-        void resume();
-        void pause(bool wait=false);
-        void reserve();
-
-        bool idle() { return state() == IDLE; }
-        bool working() { return state() == WORKING; }
-        bool alive() { return state() != DEAD; }
-
-        int idleTime();
-
+        bool idle() { return isIdle; }
         void run();
 
     private:
-        State state();
-        void setState(State state);
-        void work();
-
-        State _state;
-        Poco::Mutex stateMutex;
-        Poco::Event wakeup, sleeping;
-        SharedRunnable job;
+        void execute(PoolJob& job);
+        void pushLocal(PoolJob& job);
+        bool popLocal(PoolJob& job);
+        bool stealFrom(PoolJob& job);
+
         ThreadPool* pool;
-        time_t idleStartTime;
+        bool isIdle;
+        Poco::Event wakeup;
+
+        PoolJobQueue local;
+        Poco::FastMutex localMutex;
+
+        // Only ever written by the worker itself.
+        Poco::UInt64 executed;
+        Poco::UInt64 stolen;
+        Poco::Timestamp::TimeDiff totalWait;
+        Poco::Timestamp::TimeDiff maxWait;
     };
 }
 
@@ -69,11 +69,13 @@ namespace tide
 
     class StaticBoundObject;
     class StaticBoundMethod;
+    class Prototype;
     class StaticBoundList;
 
     class GlobalObject;
     class ScopeMethodDelegate;
     class Bytes;
+    class BytesChain;
     class VoidPtr;
     class ValueReleasePolicy;
     class Logger;
@@ -84,6 +86,7 @@ namespace tide
     typedef AutoPtr<TiMethod> TiMethodRef;
     typedef AutoPtr<TiList> TiListRef;
     typedef AutoPtr<Bytes> BytesRef;
+    typedef AutoPtr<BytesChain> BytesChainRef;
 
     typedef SharedPtr<std::string> SharedString;
     typedef std::vector<SharedString> StringList;
@@ -102,10 +105,12 @@ namespace tide
 #include "logger.h"
 
 #include "binding/binding.h"
+#include "profiler.h"
 #include "module_provider.h"
 #include "module.h"
 #include "async_job.h"
 #include "main_thread_job.h"
+#include "main_thread_job_queue.h"
 #include "script.h"
 
 #ifdef OS_OSX
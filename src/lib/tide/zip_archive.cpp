@@ -0,0 +1,1587 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "zip_archive.h"
+#include "thread_pool.h"
+
+#include <tideutils/platform_utils.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Mutex.h>
+#include <Poco/Event.h>
+#include <Poco/AtomicCounter.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Runnable.h>
+#include <Poco/Exception.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <set>
+#include <ctime>
+#include <cstring>
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+#else
+#include <tideutils/posix/posix_utils.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace tide
+{
+    static const Poco::UInt32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    static const Poco::UInt32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    static const Poco::UInt32 END_SIGNATURE = 0x06054b50;
+    static const Poco::UInt32 ZIP64_END_SIGNATURE = 0x06064b50;
+    static const Poco::UInt32 ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+    static const Poco::UInt16 ZIP64_EXTRA_ID = 0x0001;
+
+    static const size_t LOCAL_HEADER_SIZE = 30;
+    static const size_t CENTRAL_HEADER_SIZE = 46;
+    static const size_t END_SIZE = 22;
+    static const size_t ZIP64_END_SIZE = 56;
+    static const size_t ZIP64_LOCATOR_SIZE = 20;
+    static const Poco::UInt32 MAX_32 = 0xffffffff;
+    static const Poco::UInt16 MAX_16 = 0xffff;
+
+    static const Poco::UInt16 VERSION_DEFAULT = 20;
+    static const Poco::UInt16 VERSION_ZIP64 = 45;
+    static const Poco::UInt16 HOST_UNIX = 3;
+    static const Poco::UInt16 METHOD_STORED = 0;
+    static const Poco::UInt16 METHOD_DEFLATED = 8;
+    static const Poco::UInt16 FLAG_ENCRYPTED = 0x0001;
+    static const Poco::UInt16 FLAG_UTF8 = 0x0800;
+
+    // Unix entries keep their st_mode in the top half of the external
+    // attributes, while the bottom half holds the MS-DOS attributes.
+    static const Poco::UInt32 UNIX_TYPE_MASK = 0170000;
+    static const Poco::UInt32 UNIX_DIRECTORY = 0040000;
+    static const Poco::UInt32 UNIX_SYMLINK = 0120000;
+    static const Poco::UInt32 DOS_DIRECTORY = 0x10;
+
+    // zlib counts bytes in 32-bit integers, so larger buffers are
+    // handed to it a piece at a time.
+    static const size_t ZLIB_CHUNK = 1024 * 1024;
+    static const size_t IO_BUFFER_SIZE = 256 * 1024;
+
+    // Files larger than this are deflated straight into the archive by
+    // the writing thread instead of being held in memory until their turn.
+    static const Poco::UInt64 STREAMING_THRESHOLD = 8 * 1024 * 1024;
+    static const Poco::UInt64 MAX_BUFFERED = 64 * 1024 * 1024;
+
+    static inline Poco::UInt16 Read16(const unsigned char* p)
+    {
+        return (Poco::UInt16) (p[0] | (p[1] << 8));
+    }
+
+    static inline Poco::UInt32 Read32(const unsigned char* p)
+    {
+        return (Poco::UInt32) p[0] | ((Poco::UInt32) p[1] << 8) |
+            ((Poco::UInt32) p[2] << 16) | ((Poco::UInt32) p[3] << 24);
+    }
+
+    static inline Poco::UInt64 Read64(const unsigned char* p)
+    {
+        return (Poco::UInt64) Read32(p) | ((Poco::UInt64) Read32(p + 4) << 32);
+    }
+
+    static inline void Put16(std::string& out, Poco::UInt16 value)
+    {
+        out += (char) (value & 0xff);
+        out += (char) (value >> 8);
+    }
+
+    static inline void Put32(std::string& out, Poco::UInt32 value)
+    {
+        Put16(out, (Poco::UInt16) (value & 0xffff));
+        Put16(out, (Poco::UInt16) (value >> 16));
+    }
+
+    static inline void Put64(std::string& out, Poco::UInt64 value)
+    {
+        Put32(out, (Poco::UInt32) (value & MAX_32));
+        Put32(out, (Poco::UInt32) (value >> 32));
+    }
+
+    static Poco::UInt32 UpdateCRC(Poco::UInt32 crc, const unsigned char* data, Poco::UInt64 length)
+    {
+        while (length > 0)
+        {
+            uInt count = (uInt) std::min<Poco::UInt64>(length, ZLIB_CHUNK);
+            crc = (Poco::UInt32) crc32(crc, data, count);
+            data += count;
+            length -= count;
+        }
+        return crc;
+    }
+
+    static void ToDOSTime(time_t time, Poco::UInt16& dosTime, Poco::UInt16& dosDate)
+    {
+        struct tm local;
+#ifdef OS_WIN32
+        bool converted = localtime_s(&local, &time) == 0;
+#else
+        bool converted = localtime_r(&time, &local) != 0;
+#endif
+        // MS-DOS time starts in 1980.
+        if (!converted || local.tm_year < 80)
+        {
+            dosTime = 0;
+            dosDate = (1 << 5) | 1;
+            return;
+        }
+
+        dosTime = (Poco::UInt16) ((local.tm_hour << 11) |
+            (local.tm_min << 5) | (local.tm_sec / 2));
+        dosDate = (Poco::UInt16) (((local.tm_year - 80) << 9) |
+            ((local.tm_mon + 1) << 5) | local.tm_mday);
+    }
+
+    static time_t FromDOSTime(Poco::UInt16 dosTime, Poco::UInt16 dosDate)
+    {
+        struct tm local;
+        memset(&local, 0, sizeof(local));
+        local.tm_year = (dosDate >> 9) + 80;
+        local.tm_mon = ((dosDate >> 5) & 0xf) - 1;
+        local.tm_mday = dosDate & 0x1f;
+        local.tm_hour = dosTime >> 11;
+        local.tm_min = (dosTime >> 5) & 0x3f;
+        local.tm_sec = (dosTime & 0x1f) * 2;
+        local.tm_isdst = -1;
+        return mktime(&local);
+    }
+
+    /**
+     * Turn an entry name into a relative path which cannot
+     * point outside of the directory it is extracted to.
+     */
+    static std::string GetSafeName(const std::string& name)
+    {
+        std::string path(name);
+        std::replace(path.begin(), path.end(), '\\', '/');
+        if ((!path.empty() && path[0] == '/') || (path.size() > 1 && path[1] == ':'))
+        {
+            throw ValueException::FromFormat(
+                "Zip entry %s has an absolute path", name.c_str());
+        }
+
+        std::string safe;
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            size_t end = path.find('/', start);
+            if (end == std::string::npos)
+                end = path.size();
+
+            std::string component(path, start, end - start);
+            if (component == "..")
+            {
+                throw ValueException::FromFormat(
+                    "Zip entry %s points outside of the archive", name.c_str());
+            }
+            if (!component.empty() && component != ".")
+            {
+                if (!safe.empty())
+                    safe += '/';
+                safe += component;
+            }
+            start = end + 1;
+        }
+        return safe;
+    }
+
+    static void SetModifiedTime(const std::string& path, const ZipEntry& entry)
+    {
+        time_t modified = FromDOSTime(entry.modifiedTime, entry.modifiedDate);
+        if (modified != (time_t) -1)
+            Poco::File(path).setLastModified(Poco::Timestamp::fromEpochTime(modified));
+    }
+
+    /**
+     * Somewhere for the contents of an entry to go as they are inflated.
+     */
+    class EntrySink
+    {
+    public:
+        virtual ~EntrySink() {}
+        virtual void Write(const unsigned char* data, size_t length) = 0;
+    };
+
+    class StringSink : public EntrySink
+    {
+    public:
+        void Write(const unsigned char* data, size_t length)
+        {
+            this->data.append((const char*) data, length);
+        }
+
+        std::string data;
+    };
+
+    /**
+     * A file opened for writing through the native API, with a small
+     * buffer in front of it so that headers don't each cost a system call.
+     */
+    class OutputFile : public EntrySink
+    {
+    public:
+        OutputFile(const std::string& path, int permissions) :
+            path(path),
+            position(0)
+        {
+#ifdef OS_WIN32
+            this->handle = CreateFileW(UTF8ToWide(path).c_str(), GENERIC_WRITE,
+                0, NULL, CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (this->handle == INVALID_HANDLE_VALUE)
+                throw ValueException::FromFormat("Could not create %s", path.c_str());
+#else
+            mode_t mode = permissions ? (permissions & 0777) : 0666;
+            this->descriptor = open(UTF8ToSystem(path).c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC, mode);
+            if (this->descriptor < 0)
+            {
+                throw ValueException::FromFormat("Could not create %s: %s",
+                    path.c_str(), strerror(errno));
+            }
+#endif
+        }
+
+        ~OutputFile()
+        {
+#ifdef OS_WIN32
+            if (this->handle != INVALID_HANDLE_VALUE)
+                CloseHandle(this->handle);
+#else
+            if (this->descriptor >= 0)
+                close(this->descriptor);
+#endif
+        }
+
+        /**
+         * Reserve space for the whole file up front, so that the file system
+         * can lay it out in one piece instead of growing it a write at a time.
+         * Failing to do so is harmless, the writes will simply extend the file.
+         */
+        void Preallocate(Poco::UInt64 size)
+        {
+#if defined(OS_WIN32)
+            LARGE_INTEGER offset;
+            offset.QuadPart = size;
+            if (SetFilePointerEx(this->handle, offset, NULL, FILE_BEGIN))
+                SetEndOfFile(this->handle);
+            offset.QuadPart = 0;
+            SetFilePointerEx(this->handle, offset, NULL, FILE_BEGIN);
+#elif defined(OS_OSX)
+            fstore_t store;
+            memset(&store, 0, sizeof(store));
+            store.fst_flags = F_ALLOCATECONTIG;
+            store.fst_posmode = F_PEOFPOSMODE;
+            store.fst_length = size;
+            if (fcntl(this->descriptor, F_PREALLOCATE, &store) == -1)
+            {
+                store.fst_flags = F_ALLOCATEALL;
+                fcntl(this->descriptor, F_PREALLOCATE, &store);
+            }
+#elif defined(OS_LINUX)
+            // Unlike posix_fallocate, this fails instead of falling back
+            // to writing zeros when the file system can't preallocate.
+            fallocate(this->descriptor, 0, 0, size);
+#endif
+        }
+
+        void Write(const unsigned char* data, size_t length)
+        {
+            if (this->buffer.size() + length <= IO_BUFFER_SIZE)
+            {
+                this->buffer.append((const char*) data, length);
+            }
+            else
+            {
+                this->Flush();
+                this->WriteFully(data, length);
+            }
+            this->position += length;
+        }
+
+        void Write(const std::string& data)
+        {
+            this->Write((const unsigned char*) data.data(), data.size());
+        }
+
+        /**
+         * Overwrite data which has already been written, such as a header
+         * which could only be filled in once the data after it was known.
+         */
+        void Rewrite(Poco::UInt64 offset, const std::string& data)
+        {
+            this->Flush();
+            this->Seek(offset);
+            this->WriteFully((const unsigned char*) data.data(), data.size());
+            this->Seek(this->position);
+        }
+
+        void Close()
+        {
+            this->Flush();
+#ifdef OS_WIN32
+            HANDLE handle = this->handle;
+            this->handle = INVALID_HANDLE_VALUE;
+            if (!CloseHandle(handle))
+                throw ValueException::FromFormat("Could not write %s", path.c_str());
+#else
+            int descriptor = this->descriptor;
+            this->descriptor = -1;
+            if (close(descriptor) != 0)
+            {
+                throw ValueException::FromFormat("Could not write %s: %s",
+                    path.c_str(), strerror(errno));
+            }
+#endif
+        }
+
+        Poco::UInt64 GetPosition() const { return position; }
+
+    private:
+        std::string path;
+        std::string buffer;
+        Poco::UInt64 position;
+#ifdef OS_WIN32
+        HANDLE handle;
+#else
+        int descriptor;
+#endif
+
+        void Flush()
+        {
+            if (this->buffer.empty())
+                return;
+            this->WriteFully((const unsigned char*) this->buffer.data(),
+                this->buffer.size());
+            this->buffer.clear();
+        }
+
+        void Seek(Poco::UInt64 offset)
+        {
+#ifdef OS_WIN32
+            LARGE_INTEGER distance;
+            distance.QuadPart = offset;
+            if (!SetFilePointerEx(this->handle, distance, NULL, FILE_BEGIN))
+                throw ValueException::FromFormat("Could not seek in %s", path.c_str());
+#else
+            if (lseek(this->descriptor, (off_t) offset, SEEK_SET) == (off_t) -1)
+            {
+                throw ValueException::FromFormat("Could not seek in %s: %s",
+                    path.c_str(), strerror(errno));
+            }
+#endif
+        }
+
+        void WriteFully(const unsigned char* data, size_t length)
+        {
+            while (length > 0)
+            {
+#ifdef OS_WIN32
+                DWORD count = 0;
+                DWORD chunk = (DWORD) std::min<size_t>(length, 0x40000000);
+                if (!WriteFile(this->handle, data, chunk, &count, NULL))
+                    throw ValueException::FromFormat("Could not write %s", path.c_str());
+#else
+                ssize_t count = write(this->descriptor, data, length);
+                if (count < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw ValueException::FromFormat("Could not write %s: %s",
+                        path.c_str(), strerror(errno));
+                }
+#endif
+                data += count;
+                length -= count;
+            }
+        }
+
+        DISALLOW_EVIL_CONSTRUCTORS(OutputFile);
+    };
+
+    /**
+     * A raw inflate stream which is reset between entries, so that
+     * each thread only sets up zlib's window once.
+     */
+    class Inflater
+    {
+    public:
+        Inflater() : buffer(IO_BUFFER_SIZE)
+        {
+            memset(&this->stream, 0, sizeof(this->stream));
+            if (inflateInit2(&this->stream, -MAX_WBITS) != Z_OK)
+                throw ValueException::FromString("Could not initialize zlib");
+        }
+
+        ~Inflater()
+        {
+            inflateEnd(&this->stream);
+        }
+
+        /**
+         * Decompress an entry into a sink, checking its size and CRC.
+         */
+        void Inflate(const ZipEntry& entry, const unsigned char* data, EntrySink& sink)
+        {
+            Poco::UInt32 crc = 0;
+            Poco::UInt64 total = 0;
+
+            if (entry.method == METHOD_STORED)
+            {
+                if (entry.compressedSize != entry.size)
+                {
+                    throw ValueException::FromFormat(
+                        "Zip entry %s has a bad size", entry.name.c_str());
+                }
+                crc = UpdateCRC(crc, data, entry.size);
+                sink.Write(data, (size_t) entry.size);
+                total = entry.size;
+            }
+            else
+            {
+                inflateReset(&this->stream);
+                const unsigned char* input = data;
+                Poco::UInt64 remaining = entry.compressedSize;
+                int status = Z_OK;
+                while (status != Z_STREAM_END)
+                {
+                    if (this->stream.avail_in == 0 && remaining > 0)
+                    {
+                        uInt count = (uInt) std::min<Poco::UInt64>(remaining, ZLIB_CHUNK);
+                        this->stream.next_in = const_cast<Bytef*>(input);
+                        this->stream.avail_in = count;
+                        input += count;
+                        remaining -= count;
+                    }
+
+                    this->stream.next_out = &this->buffer[0];
+                    this->stream.avail_out = (uInt) this->buffer.size();
+                    status = inflate(&this->stream, Z_NO_FLUSH);
+                    if (status != Z_OK && status != Z_STREAM_END)
+                    {
+                        throw ValueException::FromFormat(
+                            "Zip entry %s is corrupt", entry.name.c_str());
+                    }
+
+                    size_t count = this->buffer.size() - this->stream.avail_out;
+                    total += count;
+                    if (total > entry.size)
+                    {
+                        throw ValueException::FromFormat(
+                            "Zip entry %s is larger than expected", entry.name.c_str());
+                    }
+                    crc = (Poco::UInt32) crc32(crc, &this->buffer[0], (uInt) count);
+                    sink.Write(&this->buffer[0], count);
+                }
+                this->stream.avail_in = 0;
+            }
+
+            if (total != entry.size || crc != entry.crc)
+            {
+                throw ValueException::FromFormat(
+                    "Zip entry %s failed its CRC check", entry.name.c_str());
+            }
+        }
+
+    private:
+        z_stream stream;
+        std::vector<unsigned char> buffer;
+
+        DISALLOW_EVIL_CONSTRUCTORS(Inflater);
+    };
+
+    /**
+     * A raw deflate stream, reset between entries like the Inflater.
+     */
+    class Deflater
+    {
+    public:
+        Deflater()
+        {
+            memset(&this->stream, 0, sizeof(this->stream));
+            if (deflateInit2(&this->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                throw ValueException::FromString("Could not initialize zlib");
+            }
+        }
+
+        ~Deflater()
+        {
+            deflateEnd(&this->stream);
+        }
+
+        /**
+         * Compress a buffer which fits in memory in one go.
+         */
+        void Deflate(const unsigned char* data, size_t length, std::string& out)
+        {
+            deflateReset(&this->stream);
+            out.resize(deflateBound(&this->stream, (uLong) length));
+            this->stream.next_in = const_cast<Bytef*>(data);
+            this->stream.avail_in = (uInt) length;
+            this->stream.next_out = (Bytef*) &out[0];
+            this->stream.avail_out = (uInt) out.size();
+            if (deflate(&this->stream, Z_FINISH) != Z_STREAM_END)
+                throw ValueException::FromString("Could not compress zip entry");
+            out.resize(this->stream.total_out);
+        }
+
+        /**
+         * Compress a buffer of any size into a file, a chunk at a time.
+         * @return the number of compressed bytes written
+         */
+        Poco::UInt64 Deflate(const unsigned char* data, Poco::UInt64 length,
+            Poco::UInt32& crc, OutputFile& output)
+        {
+            deflateReset(&this->stream);
+            std::vector<unsigned char> buffer(IO_BUFFER_SIZE);
+            Poco::UInt64 written = 0;
+            int status = Z_OK;
+            while (status != Z_STREAM_END)
+            {
+                if (this->stream.avail_in == 0 && length > 0)
+                {
+                    // Take the CRC while the chunk is still in the cache.
+                    uInt count = (uInt) std::min<Poco::UInt64>(length, ZLIB_CHUNK);
+                    crc = (Poco::UInt32) crc32(crc, data, count);
+                    this->stream.next_in = const_cast<Bytef*>(data);
+                    this->stream.avail_in = count;
+                    data += count;
+                    length -= count;
+                }
+
+                this->stream.next_out = &buffer[0];
+                this->stream.avail_out = (uInt) buffer.size();
+                status = deflate(&this->stream, length > 0 ? Z_NO_FLUSH : Z_FINISH);
+                if (status != Z_OK && status != Z_STREAM_END)
+                    throw ValueException::FromString("Could not compress zip entry");
+
+                size_t count = buffer.size() - this->stream.avail_out;
+                output.Write(&buffer[0], count);
+                written += count;
+            }
+            return written;
+        }
+
+    private:
+        z_stream stream;
+
+        DISALLOW_EVIL_CONSTRUCTORS(Deflater);
+    };
+
+    /**
+     * Work shared between the thread which started an operation and any
+     * helpers it could borrow from the host thread pool. The caller always
+     * works too, so nothing depends on a helper ever being scheduled, and
+     * helpers which only start once the work has been joined do nothing.
+     */
+    class ParallelWork
+    {
+    public:
+        ParallelWork() :
+            active(0),
+            closed(false),
+            failed(false),
+            cancelled(false)
+        {}
+        virtual ~ParallelWork() {}
+
+        /**
+         * Do work on a helper thread until there is nothing left.
+         */
+        virtual void Help() = 0;
+
+        bool Enter()
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->closed)
+                return false;
+            this->active++;
+            return true;
+        }
+
+        void Leave()
+        {
+            {
+                Poco::FastMutex::ScopedLock lock(this->mutex);
+                this->active--;
+            }
+            this->left.set();
+        }
+
+        /**
+         * Wait for every helper which has started to finish, and throw
+         * the first error any of the threads ran into.
+         */
+        void Join()
+        {
+            while (true)
+            {
+                {
+                    Poco::FastMutex::ScopedLock lock(this->mutex);
+                    this->closed = true;
+                    if (this->active == 0)
+                        break;
+                }
+                this->left.wait();
+            }
+
+            if (this->failed)
+                throw ValueException::FromString(this->error);
+        }
+
+        void Fail(const std::string& message)
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (!this->failed)
+                this->error = message;
+            this->failed = true;
+        }
+
+        bool Stopped() const { return failed || cancelled; }
+        bool Cancelled() const { return cancelled; }
+
+        /**
+         * Pass progress to the listener, remembering if it asks to stop.
+         */
+        void Report(ZipProgressListener* listener, size_t finished, size_t total)
+        {
+            if (listener && !listener->OnProgress(finished, total))
+                this->cancelled = true;
+        }
+
+    protected:
+        Poco::FastMutex mutex;
+
+    private:
+        Poco::Event left;
+        int active;
+        bool closed;
+        volatile bool failed;
+        volatile bool cancelled;
+        std::string error;
+    };
+    typedef Poco::SharedPtr<ParallelWork> ParallelWorkRef;
+
+    class ParallelWorkRunnable : public Poco::Runnable
+    {
+    public:
+        ParallelWorkRunnable(ParallelWorkRef work) : work(work) {}
+
+        void run()
+        {
+            if (this->work->Enter())
+            {
+                this->work->Help();
+                this->work->Leave();
+            }
+        }
+
+    private:
+        ParallelWorkRef work;
+    };
+
+#define ZIP_CATCH(work) \
+    catch (ValueException& e) { (work)->Fail(e.ToString()); } \
+    catch (Poco::Exception& e) { (work)->Fail(e.displayText()); } \
+    catch (std::exception& e) { (work)->Fail(e.what()); }
+
+    /**
+     * Ask the host thread pool for enough helpers to keep every processor
+     * busy. Only idle threads (or new ones) are taken, so a busy pool
+     * just means the calling thread does more of the work itself.
+     * @return the number of helpers which were started
+     */
+    static int StartHelpers(ParallelWorkRef work, size_t jobs)
+    {
+        Host* host = Host::GetInstance();
+        if (!host || !host->GetThreadPool())
+            return 0;
+
+        size_t wanted = std::min<size_t>(
+            std::max(PlatformUtils::GetProcessorCount(), 1), jobs);
+        int started = 0;
+        for (size_t i = 1; i < wanted; i++)
+        {
+            SharedRunnable runnable(new ParallelWorkRunnable(work));
+            if (!host->GetThreadPool()->start(runnable, false))
+                break;
+            started++;
+        }
+        return started;
+    }
+
+    ZipEntry::ZipEntry() :
+        versionMadeBy(0),
+        flags(0),
+        method(0),
+        modifiedTime(0),
+        modifiedDate(0),
+        crc(0),
+        externalAttributes(0),
+        compressedSize(0),
+        size(0),
+        localHeaderOffset(0)
+    {
+    }
+
+    static inline bool IsUnixEntry(const ZipEntry& entry)
+    {
+        return (entry.versionMadeBy >> 8) == HOST_UNIX;
+    }
+
+    bool ZipEntry::IsDirectory() const
+    {
+        if (!this->name.empty() && this->name[this->name.size() - 1] == '/')
+            return true;
+        if (IsUnixEntry(*this))
+            return ((this->externalAttributes >> 16) & UNIX_TYPE_MASK) == UNIX_DIRECTORY;
+        return (this->externalAttributes & DOS_DIRECTORY) != 0;
+    }
+
+    bool ZipEntry::IsSymlink() const
+    {
+        return IsUnixEntry(*this) &&
+            ((this->externalAttributes >> 16) & UNIX_TYPE_MASK) == UNIX_SYMLINK;
+    }
+
+    int ZipEntry::GetPermissions() const
+    {
+        if (!IsUnixEntry(*this))
+            return 0;
+        return (this->externalAttributes >> 16) & 07777;
+    }
+
+    ZipReader::ZipReader(const std::string& path) :
+        file(path)
+    {
+        this->ReadCentralDirectory();
+    }
+
+    void ZipReader::ReadCentralDirectory()
+    {
+        const unsigned char* data = this->file.GetData();
+        Poco::UInt64 size = this->file.GetSize();
+        const char* path = this->file.GetPath().c_str();
+
+        // The end record sits after the central directory, followed
+        // only by an archive comment of at most 64k.
+        const unsigned char* end = 0;
+        if (size >= END_SIZE)
+        {
+            Poco::UInt64 last = size - END_SIZE;
+            Poco::UInt64 first = last > MAX_16 ? last - MAX_16 : 0;
+            for (Poco::UInt64 offset = last + 1; offset-- > first;)
+            {
+                if (Read32(data + offset) == END_SIGNATURE)
+                {
+                    end = data + offset;
+                    break;
+                }
+            }
+        }
+        if (!end)
+            throw ValueException::FromFormat("%s is not a zip file", path);
+
+        if (Read16(end + 4) != 0 || Read16(end + 6) != 0)
+            throw ValueException::FromFormat("%s spans several disks", path);
+
+        Poco::UInt64 count = Read16(end + 10);
+        Poco::UInt64 directorySize = Read32(end + 12);
+        Poco::UInt64 directoryOffset = Read32(end + 16);
+
+        Poco::UInt64 endOffset = end - data;
+        if ((count == MAX_16 || directorySize == MAX_32 || directoryOffset == MAX_32) &&
+            endOffset >= ZIP64_LOCATOR_SIZE &&
+            Read32(end - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR_SIGNATURE)
+        {
+            Poco::UInt64 zip64Offset = Read64(end - ZIP64_LOCATOR_SIZE + 8);
+            if (zip64Offset > size || size - zip64Offset < ZIP64_END_SIZE ||
+                Read32(data + zip64Offset) != ZIP64_END_SIGNATURE)
+            {
+                throw ValueException::FromFormat("%s has a corrupt zip64 record", path);
+            }
+            const unsigned char* zip64End = data + zip64Offset;
+            count = Read64(zip64End + 32);
+            directorySize = Read64(zip64End + 40);
+            directoryOffset = Read64(zip64End + 48);
+        }
+
+        if (directoryOffset > size || size - directoryOffset < directorySize)
+            throw ValueException::FromFormat("%s is truncated", path);
+
+        const unsigned char* p = data + directoryOffset;
+        const unsigned char* directoryEnd = p + directorySize;
+        this->entries.reserve((size_t) std::min(count, directorySize / CENTRAL_HEADER_SIZE));
+        for (Poco::UInt64 i = 0; i < count; i++)
+        {
+            if ((size_t) (directoryEnd - p) < CENTRAL_HEADER_SIZE ||
+                Read32(p) != CENTRAL_HEADER_SIGNATURE)
+            {
+                throw ValueException::FromFormat("%s has a corrupt central directory", path);
+            }
+
+            size_t nameLength = Read16(p + 28);
+            size_t extraLength = Read16(p + 30);
+            size_t commentLength = Read16(p + 32);
+            size_t headerLength = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+            if ((size_t) (directoryEnd - p) < headerLength)
+                throw ValueException::FromFormat("%s has a corrupt central directory", path);
+
+            ZipEntry entry;
+            entry.versionMadeBy = Read16(p + 4);
+            entry.flags = Read16(p + 8);
+            entry.method = Read16(p + 10);
+            entry.modifiedTime = Read16(p + 12);
+            entry.modifiedDate = Read16(p + 14);
+            entry.crc = Read32(p + 16);
+            entry.compressedSize = Read32(p + 20);
+            entry.size = Read32(p + 24);
+            entry.externalAttributes = Read32(p + 38);
+            entry.localHeaderOffset = Read32(p + 42);
+            entry.name.assign((const char*) p + CENTRAL_HEADER_SIZE, nameLength);
+
+            // Values which don't fit in the header are in the zip64 extra
+            // field, in a fixed order but only when the header is saturated.
+            const unsigned char* extra = p + CENTRAL_HEADER_SIZE + nameLength;
+            const unsigned char* extraEnd = extra + extraLength;
+            while (extraEnd - extra >= 4)
+            {
+                Poco::UInt16 id = Read16(extra);
+                size_t length = Read16(extra + 2);
+                const unsigned char* field = extra + 4;
+                if ((size_t) (extraEnd - field) < length)
+                    break;
+
+                if (id == ZIP64_EXTRA_ID)
+                {
+                    const unsigned char* fieldEnd = field + length;
+                    if (entry.size == MAX_32 && fieldEnd - field >= 8)
+                    {
+                        entry.size = Read64(field);
+                        field += 8;
+                    }
+                    if (entry.compressedSize == MAX_32 && fieldEnd - field >= 8)
+                    {
+                        entry.compressedSize = Read64(field);
+                        field += 8;
+                    }
+                    if (entry.localHeaderOffset == MAX_32 && fieldEnd - field >= 8)
+                    {
+                        entry.localHeaderOffset = Read64(field);
+                    }
+                    break;
+                }
+                extra = field + length;
+            }
+
+            this->entries.push_back(entry);
+            p += headerLength;
+        }
+    }
+
+    const unsigned char* ZipReader::GetEntryData(const ZipEntry& entry)
+    {
+        const unsigned char* data = this->file.GetData();
+        Poco::UInt64 size = this->file.GetSize();
+
+        Poco::UInt64 offset = entry.localHeaderOffset;
+        if (offset > size || size - offset < LOCAL_HEADER_SIZE ||
+            Read32(data + offset) != LOCAL_HEADER_SIGNATURE)
+        {
+            throw ValueException::FromFormat(
+                "Zip entry %s has a corrupt header", entry.name.c_str());
+        }
+
+        // The local header's name and extra field can differ from those
+        // in the central directory, so its own lengths are the ones to use.
+        const unsigned char* header = data + offset;
+        offset += LOCAL_HEADER_SIZE + Read16(header + 26) + Read16(header + 28);
+        if (offset > size || size - offset < entry.compressedSize)
+        {
+            throw ValueException::FromFormat(
+                "Zip entry %s is truncated", entry.name.c_str());
+        }
+        return data + offset;
+    }
+
+    /**
+     * Extracts the regular files of an archive, each thread taking the
+     * next file from a shared counter.
+     */
+    class ExtractWork : public ParallelWork
+    {
+    public:
+        ExtractWork(ZipReader& reader, size_t finished, size_t total) :
+            reader(reader),
+            total(total),
+            next(0),
+            finished((int) finished)
+        {}
+
+        void Help()
+        {
+            this->Run(0);
+        }
+
+        void Run(ZipProgressListener* listener)
+        {
+            try
+            {
+                Inflater inflater;
+                while (!this->Stopped())
+                {
+                    size_t index = (size_t) (this->next++);
+                    if (index >= this->files.size())
+                        break;
+
+                    const ZipEntry& entry = *this->files[index];
+                    const std::string& path = this->paths[index];
+                    const unsigned char* data = this->reader.GetEntryData(entry);
+                    {
+                        OutputFile output(path, entry.GetPermissions());
+                        if (entry.size > IO_BUFFER_SIZE)
+                            output.Preallocate(entry.size);
+                        inflater.Inflate(entry, data, output);
+                        output.Close();
+                    }
+                    SetModifiedTime(path, entry);
+
+                    size_t finished = (size_t) (++this->finished);
+                    this->Report(listener, finished, this->total);
+                }
+            }
+            ZIP_CATCH(this)
+        }
+
+        size_t GetFinished() { return (size_t) this->finished.value(); }
+
+        std::vector<const ZipEntry*> files;
+        std::vector<std::string> paths;
+
+    private:
+        ZipReader& reader;
+        size_t total;
+        Poco::AtomicCounter next;
+        Poco::AtomicCounter finished;
+    };
+
+    static bool LargerEntry(const std::pair<Poco::UInt64, size_t>& a,
+        const std::pair<Poco::UInt64, size_t>& b)
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    }
+
+    bool ZipReader::ExtractAll(const std::string& directory, ZipProgressListener* listener)
+    {
+        std::string root(directory);
+        if (!root.empty() && root[root.size() - 1] != '/' && root[root.size() - 1] != '\\')
+            root += '/';
+        Poco::File(root.empty() ? std::string(".") : root).createDirectories();
+
+        // Directories are all created up front, so that threads
+        // extracting files never race each other to create them.
+        std::set<std::string> directories;
+        std::vector<std::pair<Poco::UInt64, size_t> > files;
+        std::vector<size_t> links;
+        size_t skipped = 0;
+        for (size_t i = 0; i < this->entries.size(); i++)
+        {
+            const ZipEntry& entry = this->entries[i];
+            std::string name(GetSafeName(entry.name));
+            if (name.empty() || entry.IsDirectory())
+            {
+                if (!name.empty())
+                    directories.insert(name);
+                skipped++;
+                continue;
+            }
+
+            if (entry.flags & FLAG_ENCRYPTED)
+            {
+                throw ValueException::FromFormat(
+                    "Zip entry %s is encrypted", entry.name.c_str());
+            }
+            if (entry.method != METHOD_STORED && entry.method != METHOD_DEFLATED)
+            {
+                throw ValueException::FromFormat(
+                    "Zip entry %s uses unsupported compression method %d",
+                    entry.name.c_str(), entry.method);
+            }
+
+            size_t slash = name.rfind('/');
+            if (slash != std::string::npos)
+                directories.insert(name.substr(0, slash));
+
+            if (entry.IsSymlink())
+                links.push_back(i);
+            else
+                files.push_back(std::make_pair(entry.compressedSize, i));
+        }
+
+        for (std::set<std::string>::iterator i = directories.begin();
+            i != directories.end(); i++)
+        {
+            Poco::File(root + *i).createDirectories();
+        }
+
+        // Starting with the largest entries keeps one big file
+        // from leaving a single thread busy at the very end.
+        std::sort(files.begin(), files.end(), LargerEntry);
+
+        ExtractWork* extract = new ExtractWork(*this, skipped, this->entries.size());
+        ParallelWorkRef work(extract);
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            const ZipEntry& entry = this->entries[files[i].second];
+            extract->files.push_back(&entry);
+            extract->paths.push_back(root + GetSafeName(entry.name));
+        }
+
+        StartHelpers(work, files.size());
+        extract->Run(listener);
+        work->Join();
+        if (work->Cancelled())
+            return false;
+
+        // Links go last, so that no file is ever written through one.
+        size_t finished = extract->GetFinished();
+        Inflater inflater;
+        for (size_t i = 0; i < links.size(); i++)
+        {
+            const ZipEntry& entry = this->entries[links[i]];
+            std::string path(root + GetSafeName(entry.name));
+            StringSink target;
+            inflater.Inflate(entry, this->GetEntryData(entry), target);
+
+#ifdef OS_WIN32
+            // Without symbolic links, keep the target as the file's contents.
+            OutputFile output(path, 0);
+            output.Write(target.data);
+            output.Close();
+#else
+            std::string systemPath(UTF8ToSystem(path));
+            unlink(systemPath.c_str());
+            if (symlink(target.data.c_str(), systemPath.c_str()) != 0)
+            {
+                throw ValueException::FromFormat("Could not create link %s: %s",
+                    path.c_str(), strerror(errno));
+            }
+#endif
+
+            work->Report(listener, ++finished, this->entries.size());
+            if (work->Cancelled())
+                return false;
+        }
+
+        if (listener)
+            listener->OnProgress(this->entries.size(), this->entries.size());
+        return true;
+    }
+
+    ZipWriter::ZipWriter(const std::string& path) :
+        path(path)
+    {
+    }
+
+    void ZipWriter::AddDirectory(const std::string& directory)
+    {
+        this->AddDirectory(directory, std::string());
+    }
+
+    void ZipWriter::AddDirectory(const std::string& directory, const std::string& prefix)
+    {
+        // Sorting makes archives of the same tree come out identical.
+        std::vector<std::string> names;
+        Poco::File(directory).list(names);
+        std::sort(names.begin(), names.end());
+
+        Poco::Path base(directory);
+        base.makeDirectory();
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            Poco::Path path(base, names[i]);
+            Poco::File file(path);
+
+            Source source;
+            source.path = path.toString();
+            source.name = prefix + names[i];
+            source.directory = false;
+            source.symlink = false;
+            source.size = 0;
+
+            if (file.isLink())
+            {
+                source.symlink = true;
+                this->sources.push_back(source);
+            }
+            else if (file.isDirectory())
+            {
+                source.name += '/';
+                source.directory = true;
+                this->sources.push_back(source);
+                this->AddDirectory(source.path, source.name);
+            }
+            else
+            {
+                source.size = file.getSize();
+                this->sources.push_back(source);
+            }
+        }
+    }
+
+    void ZipWriter::AddFile(const std::string& path, const std::string& name)
+    {
+        Source source;
+        source.path = path;
+        source.name = name;
+        source.directory = false;
+        source.symlink = false;
+        source.size = Poco::File(path).getSize();
+        this->sources.push_back(source);
+    }
+
+    /**
+     * Fill in the parts of an entry which come from the file system.
+     */
+    static void ReadAttributes(const ZipWriter::Source& source, ZipEntry& entry)
+    {
+        entry.name = source.name;
+        entry.flags = FLAG_UTF8;
+
+#ifdef OS_WIN32
+        entry.versionMadeBy = VERSION_DEFAULT;
+        time_t modified = Poco::File(source.path).getLastModified().epochTime();
+        if (source.directory)
+            entry.externalAttributes = DOS_DIRECTORY;
+#else
+        entry.versionMadeBy = (HOST_UNIX << 8) | VERSION_DEFAULT;
+        struct stat info;
+        if (lstat(UTF8ToSystem(source.path).c_str(), &info) != 0)
+        {
+            throw ValueException::FromFormat("Could not read %s: %s",
+                source.path.c_str(), strerror(errno));
+        }
+        time_t modified = info.st_mtime;
+        entry.externalAttributes = (Poco::UInt32) info.st_mode << 16;
+        if (source.directory)
+            entry.externalAttributes |= DOS_DIRECTORY;
+#endif
+
+        ToDOSTime(modified, entry.modifiedTime, entry.modifiedDate);
+    }
+
+    static std::string LocalHeader(const ZipEntry& entry, bool zip64)
+    {
+        std::string header;
+        header.reserve(LOCAL_HEADER_SIZE + entry.name.size() + 20);
+        Put32(header, LOCAL_HEADER_SIGNATURE);
+        Put16(header, zip64 ? VERSION_ZIP64 : VERSION_DEFAULT);
+        Put16(header, entry.flags);
+        Put16(header, entry.method);
+        Put16(header, entry.modifiedTime);
+        Put16(header, entry.modifiedDate);
+        Put32(header, entry.crc);
+        Put32(header, zip64 ? MAX_32 : (Poco::UInt32) entry.compressedSize);
+        Put32(header, zip64 ? MAX_32 : (Poco::UInt32) entry.size);
+        Put16(header, (Poco::UInt16) entry.name.size());
+        Put16(header, zip64 ? 20 : 0);
+        header += entry.name;
+        if (zip64)
+        {
+            Put16(header, ZIP64_EXTRA_ID);
+            Put16(header, 16);
+            Put64(header, entry.size);
+            Put64(header, entry.compressedSize);
+        }
+        return header;
+    }
+
+    static std::string CentralHeader(const ZipEntry& entry)
+    {
+        std::string extra;
+        if (entry.size >= MAX_32)
+            Put64(extra, entry.size);
+        if (entry.compressedSize >= MAX_32)
+            Put64(extra, entry.compressedSize);
+        if (entry.localHeaderOffset >= MAX_32)
+            Put64(extra, entry.localHeaderOffset);
+
+        std::string header;
+        header.reserve(CENTRAL_HEADER_SIZE + entry.name.size() + 28);
+        Put32(header, CENTRAL_HEADER_SIGNATURE);
+        Put16(header, entry.versionMadeBy);
+        Put16(header, extra.empty() ? VERSION_DEFAULT : VERSION_ZIP64);
+        Put16(header, entry.flags);
+        Put16(header, entry.method);
+        Put16(header, entry.modifiedTime);
+        Put16(header, entry.modifiedDate);
+        Put32(header, entry.crc);
+        Put32(header, (Poco::UInt32) std::min<Poco::UInt64>(entry.compressedSize, MAX_32));
+        Put32(header, (Poco::UInt32) std::min<Poco::UInt64>(entry.size, MAX_32));
+        Put16(header, (Poco::UInt16) entry.name.size());
+        Put16(header, (Poco::UInt16) (extra.empty() ? 0 : extra.size() + 4));
+        Put16(header, 0); // comment length
+        Put16(header, 0); // disk number
+        Put16(header, 0); // internal attributes
+        Put32(header, entry.externalAttributes);
+        Put32(header, (Poco::UInt32) std::min<Poco::UInt64>(entry.localHeaderOffset, MAX_32));
+        header += entry.name;
+        if (!extra.empty())
+        {
+            Put16(header, ZIP64_EXTRA_ID);
+            Put16(header, (Poco::UInt16) extra.size());
+            header += extra;
+        }
+        return header;
+    }
+
+    static std::string EndRecords(Poco::UInt64 count, Poco::UInt64 directoryOffset,
+        Poco::UInt64 directorySize)
+    {
+        std::string records;
+        bool zip64 = count >= MAX_16 || directoryOffset >= MAX_32 || directorySize >= MAX_32;
+        if (zip64)
+        {
+            Poco::UInt64 zip64Offset = directoryOffset + directorySize;
+            Put32(records, ZIP64_END_SIGNATURE);
+            Put64(records, ZIP64_END_SIZE - 12);
+            Put16(records, (HOST_UNIX << 8) | VERSION_ZIP64);
+            Put16(records, VERSION_ZIP64);
+            Put32(records, 0); // this disk
+            Put32(records, 0); // disk with the central directory
+            Put64(records, count);
+            Put64(records, count);
+            Put64(records, directorySize);
+            Put64(records, directoryOffset);
+
+            Put32(records, ZIP64_LOCATOR_SIGNATURE);
+            Put32(records, 0);
+            Put64(records, zip64Offset);
+            Put32(records, 1); // total disks
+        }
+
+        Put32(records, END_SIGNATURE);
+        Put16(records, 0);
+        Put16(records, 0);
+        Put16(records, (Poco::UInt16) std::min<Poco::UInt64>(count, MAX_16));
+        Put16(records, (Poco::UInt16) std::min<Poco::UInt64>(count, MAX_16));
+        Put32(records, (Poco::UInt32) std::min<Poco::UInt64>(directorySize, MAX_32));
+        Put32(records, (Poco::UInt32) std::min<Poco::UInt64>(directoryOffset, MAX_32));
+        Put16(records, 0); // comment length
+        return records;
+    }
+
+    /**
+     * Compresses entries ahead of the thread writing the archive. Only a
+     * window of entries past the last one written may be claimed, which
+     * bounds how much compressed data waits in memory.
+     */
+    class CompressWork : public ParallelWork
+    {
+    public:
+        enum State { QUEUED, CLAIMED, READY, STREAM };
+
+        struct Slot
+        {
+            Slot() : state(QUEUED) {}
+
+            ZipEntry entry;
+            std::string data;
+            int state;
+        };
+
+        CompressWork(const std::vector<ZipWriter::Source>& sources) :
+            sources(sources),
+            slots(sources.size()),
+            window(16),
+            next(0),
+            written(0),
+            buffered(0)
+        {}
+
+        void SetThreads(int threads)
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            this->window = std::max(16, threads * 4);
+        }
+
+        void Help()
+        {
+            try
+            {
+                Deflater deflater;
+                while (!this->Stopped())
+                {
+                    bool finished;
+                    size_t index = this->Claim(finished);
+                    if (finished)
+                        break;
+
+                    if (index == this->slots.size())
+                        this->windowMoved.tryWait(50);
+                    else
+                        this->Prepare(index, deflater);
+                }
+            }
+            ZIP_CATCH(this)
+        }
+
+        /**
+         * Write every entry in order, compressing entries whenever
+         * the next one to write isn't ready yet.
+         */
+        void Run(OutputFile& output, ZipProgressListener* listener)
+        {
+            try
+            {
+                Deflater deflater;
+                std::vector<ZipEntry> entries;
+                entries.reserve(this->slots.size());
+
+                for (size_t current = 0; current < this->slots.size();)
+                {
+                    if (this->Stopped())
+                        return;
+
+                    int state;
+                    {
+                        Poco::FastMutex::ScopedLock lock(this->mutex);
+                        state = this->slots[current].state;
+                    }
+
+                    if (state == READY || state == STREAM)
+                    {
+                        Slot& slot = this->slots[current];
+                        this->WriteEntry(output, current, state == STREAM, deflater);
+                        entries.push_back(slot.entry);
+                        std::string().swap(slot.data);
+
+                        {
+                            Poco::FastMutex::ScopedLock lock(this->mutex);
+                            this->buffered -= this->GetCost(current);
+                            this->written = ++current;
+                        }
+                        this->windowMoved.set();
+                        this->Report(listener, current, this->slots.size());
+                        continue;
+                    }
+
+                    bool finished;
+                    size_t index = this->Claim(finished);
+                    if (index < this->slots.size())
+                        this->Prepare(index, deflater);
+                    else
+                        this->ready.tryWait(50);
+                }
+
+                Poco::UInt64 directoryOffset = output.GetPosition();
+                for (size_t i = 0; i < entries.size(); i++)
+                    output.Write(CentralHeader(entries[i]));
+                Poco::UInt64 directorySize = output.GetPosition() - directoryOffset;
+                output.Write(EndRecords(entries.size(), directoryOffset, directorySize));
+                output.Close();
+            }
+            ZIP_CATCH(this)
+        }
+
+    private:
+        const std::vector<ZipWriter::Source>& sources;
+        std::vector<Slot> slots;
+        size_t window;
+        size_t next;
+        size_t written;
+        Poco::UInt64 buffered;
+        Poco::Event ready;
+        Poco::Event windowMoved;
+
+        Poco::UInt64 GetCost(size_t index)
+        {
+            Poco::UInt64 size = this->sources[index].size;
+            return size > STREAMING_THRESHOLD ? 0 : size;
+        }
+
+        /**
+         * Take the next entry to compress.
+         * @return the index of the entry, or the number of entries when
+         * nothing can be claimed right now
+         */
+        size_t Claim(bool& finished)
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            finished = this->next >= this->slots.size();
+            if (finished)
+                return this->slots.size();
+
+            // The entry right after the last one written is always allowed,
+            // however big it is, so that the writer can make progress.
+            Poco::UInt64 cost = this->GetCost(this->next);
+            if (this->next != this->written &&
+                (this->next - this->written >= this->window ||
+                this->buffered + cost > MAX_BUFFERED))
+            {
+                return this->slots.size();
+            }
+
+            this->buffered += cost;
+            this->slots[this->next].state = CLAIMED;
+            return this->next++;
+        }
+
+        void Prepare(size_t index, Deflater& deflater)
+        {
+            const ZipWriter::Source& source = this->sources[index];
+            Slot& slot = this->slots[index];
+            ZipEntry& entry = slot.entry;
+            ReadAttributes(source, entry);
+
+            int state = READY;
+            if (source.directory)
+            {
+                entry.method = METHOD_STORED;
+            }
+            else if (source.symlink)
+            {
+#ifndef OS_WIN32
+                std::vector<char> target(4096);
+                ssize_t length = readlink(UTF8ToSystem(source.path).c_str(),
+                    &target[0], target.size());
+                if (length < 0)
+                {
+                    throw ValueException::FromFormat("Could not read link %s: %s",
+                        source.path.c_str(), strerror(errno));
+                }
+                slot.data.assign(&target[0], length);
+#endif
+                entry.method = METHOD_STORED;
+                entry.size = entry.compressedSize = slot.data.size();
+                entry.crc = UpdateCRC(0, (const unsigned char*) slot.data.data(), slot.data.size());
+            }
+            else if (this->GetCost(index) == 0 && source.size > 0)
+            {
+                // Too big to hold in memory, the writer will stream it.
+                state = STREAM;
+            }
+            else
+            {
+                MappedFile input(source.path);
+                const unsigned char* data = input.GetData();
+                size_t size = (size_t) input.GetSize();
+
+                entry.size = size;
+                entry.crc = UpdateCRC(0, data, size);
+                entry.method = METHOD_DEFLATED;
+                deflater.Deflate(data, size, slot.data);
+
+                // Data which doesn't compress, like images, is stored as is.
+                if (slot.data.size() >= size)
+                {
+                    entry.method = METHOD_STORED;
+                    slot.data.assign((const char*) data, size);
+                }
+                entry.compressedSize = slot.data.size();
+            }
+
+            {
+                Poco::FastMutex::ScopedLock lock(this->mutex);
+                slot.state = state;
+            }
+            this->ready.set();
+        }
+
+        void WriteEntry(OutputFile& output, size_t index, bool stream, Deflater& deflater)
+        {
+            Slot& slot = this->slots[index];
+            ZipEntry& entry = slot.entry;
+            entry.localHeaderOffset = output.GetPosition();
+            if (!stream)
+            {
+                output.Write(LocalHeader(entry, false));
+                output.Write(slot.data);
+                return;
+            }
+
+            // The sizes and CRC are only known once the data has been
+            // written, so the local header is written again afterwards.
+            MappedFile input(this->sources[index].path);
+            entry.method = METHOD_DEFLATED;
+            entry.size = input.GetSize();
+            bool zip64 = entry.size + entry.size / 100 + 1024 >= MAX_32;
+            output.Write(LocalHeader(entry, zip64));
+            entry.compressedSize = deflater.Deflate(input.GetData(),
+                input.GetSize(), entry.crc, output);
+            output.Rewrite(entry.localHeaderOffset, LocalHeader(entry, zip64));
+        }
+    };
+
+    bool ZipWriter::Write(ZipProgressListener* listener)
+    {
+        Poco::File(Poco::Path(this->path).parent()).createDirectories();
+
+        CompressWork* compress = new CompressWork(this->sources);
+        ParallelWorkRef work(compress);
+        {
+            OutputFile output(this->path, 0);
+            compress->SetThreads(StartHelpers(work, this->sources.size()) + 1);
+            compress->Run(output, listener);
+        }
+
+        try
+        {
+            work->Join();
+        }
+        catch (...)
+        {
+            Poco::File(this->path).remove();
+            throw;
+        }
+
+        if (work->Cancelled())
+        {
+            Poco::File(this->path).remove();
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,182 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _ZIP_ARCHIVE_H_
+#define _ZIP_ARCHIVE_H_
+
+#include "tide.h"
+#include "mapped_file.h"
+#include <Poco/Types.h>
+
+namespace tide
+{
+    /**
+     * One entry of a zip file's central directory.
+     */
+    struct TIDE_API ZipEntry
+    {
+        ZipEntry();
+
+        bool IsDirectory() const;
+        bool IsSymlink() const;
+
+        /**
+         * @return the Unix permission bits of this entry, or 0
+         * when the archive was not created on a Unix system
+         */
+        int GetPermissions() const;
+
+        std::string name;
+        Poco::UInt16 versionMadeBy;
+        Poco::UInt16 flags;
+        Poco::UInt16 method;
+        Poco::UInt16 modifiedTime;
+        Poco::UInt16 modifiedDate;
+        Poco::UInt32 crc;
+        Poco::UInt32 externalAttributes;
+        Poco::UInt64 compressedSize;
+        Poco::UInt64 size;
+        Poco::UInt64 localHeaderOffset;
+    };
+
+    /**
+     * Receives progress from a ZipReader or ZipWriter. It is always called
+     * on the thread which started the operation, never on a helper thread.
+     */
+    class TIDE_API ZipProgressListener
+    {
+    public:
+        virtual ~ZipProgressListener() {}
+
+        /**
+         * @param finished The number of entries which are done
+         * @param total The number of entries in the operation
+         * @return false to cancel the operation
+         */
+        virtual bool OnProgress(size_t finished, size_t total) = 0;
+    };
+
+    /**
+     * Reads a zip file through a memory mapping. Entries are inflated
+     * straight out of the mapping and into preallocated output files,
+     * several at a time on the host thread pool.
+     */
+    class TIDE_API ZipReader
+    {
+    public:
+        /**
+         * Open a zip file and read its central directory, throwing a
+         * ValueException when the file is not a usable zip file.
+         * @param path The UTF-8 path of the zip file
+         */
+        ZipReader(const std::string& path);
+
+        const std::vector<ZipEntry>& GetEntries() const { return entries; }
+
+        /**
+         * Extract every entry below a directory, which is created if
+         * necessary. Throws a ValueException on the first failure.
+         * @return false if the listener cancelled the extraction
+         */
+        bool ExtractAll(const std::string& directory,
+            ZipProgressListener* listener = 0);
+
+        /**
+         * Find the data of an entry and check that it lies within the file.
+         */
+        const unsigned char* GetEntryData(const ZipEntry& entry);
+
+    private:
+        MappedFile file;
+        std::vector<ZipEntry> entries;
+
+        void ReadCentralDirectory();
+
+        DISALLOW_EVIL_CONSTRUCTORS(ZipReader);
+    };
+
+    /**
+     * Writes a zip file. Entries are deflated into memory several at a
+     * time on the host thread pool and written out in order by the calling
+     * thread, so that the archive is the same no matter how many threads
+     * did the work. Large files are deflated straight into the archive.
+     */
+    class TIDE_API ZipWriter
+    {
+    public:
+        /**
+         * @param path The UTF-8 path of the zip file to create
+         */
+        ZipWriter(const std::string& path);
+
+        /**
+         * Queue the contents of a directory, recursively. Entry names are
+         * relative to the directory, which is the root of the archive.
+         */
+        void AddDirectory(const std::string& directory);
+
+        /**
+         * Queue a single file.
+         * @param path The UTF-8 path of the file
+         * @param name The name of the entry in the archive
+         */
+        void AddFile(const std::string& path, const std::string& name);
+
+        /**
+         * Compress the queued entries and write the archive, throwing a
+         * ValueException on the first failure.
+         * @return false if the listener cancelled writing the archive
+         */
+        bool Write(ZipProgressListener* listener = 0);
+
+        struct Source
+        {
+            std::string path;
+            std::string name;
+            bool directory;
+            bool symlink;
+            Poco::UInt64 size;
+        };
+
+    private:
+        std::string path;
+        std::vector<Source> sources;
+
+        void AddDirectory(const std::string& directory, const std::string& prefix);
+
+        DISALLOW_EVIL_CONSTRUCTORS(ZipWriter);
+    };
+}
+
+#endif
@@ -0,0 +1,483 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "base64.h"
+#include "cpu_features.h"
+
+#ifdef CODEC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace ti
+{
+namespace Base64
+{
+    static const char STANDARD_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static const char URL_SAFE_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    // Decoding table entries which are not sextet values.
+    static const signed char INVALID = -1;
+    static const signed char WHITESPACE = -2;
+    static const signed char PADDING = -3;
+
+    static signed char standardTable[256];
+    static signed char urlSafeTable[256];
+
+    static void BuildTable(signed char* table, const char* alphabet)
+    {
+        for (int i = 0; i < 256; i++)
+            table[i] = INVALID;
+        for (int i = 0; i < 64; i++)
+            table[(unsigned char) alphabet[i]] = (signed char) i;
+        table[(unsigned char) ' '] = WHITESPACE;
+        table[(unsigned char) '\t'] = WHITESPACE;
+        table[(unsigned char) '\r'] = WHITESPACE;
+        table[(unsigned char) '\n'] = WHITESPACE;
+        table[(unsigned char) '='] = PADDING;
+    }
+
+    static bool BuildTables()
+    {
+        BuildTable(standardTable, STANDARD_ALPHABET);
+        BuildTable(urlSafeTable, URL_SAFE_ALPHABET);
+        return true;
+    }
+
+    static bool tablesBuilt = BuildTables();
+
+    static void EncodeScalar(const unsigned char* in, size_t groups,
+        char* out, const char* alphabet)
+    {
+        while (groups-- > 0)
+        {
+            unsigned int value = (in[0] << 16) | (in[1] << 8) | in[2];
+            out[0] = alphabet[(value >> 18) & 63];
+            out[1] = alphabet[(value >> 12) & 63];
+            out[2] = alphabet[(value >> 6) & 63];
+            out[3] = alphabet[value & 63];
+            in += 3;
+            out += 4;
+        }
+    }
+
+#ifdef CODEC_X86_SIMD
+    // The SIMD kernels follow Wojciech Muła and Daniel Lemire, "Faster
+    // Base64 Encoding and Decoding using AVX2 Instructions" (2018).
+    // Each 128-bit lane turns 12 bytes into 16 sextet indices, and a
+    // 16-entry shuffle table maps each index range onto its character
+    // offset in a single step.
+
+    template <bool urlSafe>
+    CODEC_TARGET("ssse3")
+    static inline __m128i EncodeLaneSSSE3(__m128i in)
+    {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t1, t3);
+
+        __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+        __m128i offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            (urlSafe ? '-' : '+') - 62, (urlSafe ? '_' : '/') - 63,
+            'A', 0, 0);
+        return _mm_add_epi8(_mm_shuffle_epi8(offsets, reduced), indices);
+    }
+
+    template <bool urlSafe>
+    CODEC_TARGET("ssse3")
+    static size_t EncodeSSSE3(const unsigned char* in, size_t length, char* out)
+    {
+        // Each step reads 16 bytes but only uses 12 of them.
+        size_t done = 0;
+        while (length - done >= 16)
+        {
+            __m128i chars = EncodeLaneSSSE3<urlSafe>(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+            done += 12;
+            out += 16;
+        }
+        return done;
+    }
+
+    template <bool urlSafe>
+    CODEC_TARGET("avx2")
+    static size_t EncodeAVX2(const unsigned char* in, size_t length, char* out)
+    {
+        size_t done = 0;
+        while (length - done >= 28)
+        {
+            __m256i input = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done + 12)), 1);
+
+            input = _mm256_shuffle_epi8(input, _mm256_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            __m256i t0 = _mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00));
+            __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+            __m256i t2 = _mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0));
+            __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+            __m256i indices = _mm256_or_si256(t1, t3);
+
+            __m256i reduced = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+            reduced = _mm256_or_si256(reduced,
+                _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            __m256i offsets = _mm256_setr_epi8(
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                (urlSafe ? '-' : '+') - 62, (urlSafe ? '_' : '/') - 63,
+                'A', 0, 0,
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                (urlSafe ? '-' : '+') - 62, (urlSafe ? '_' : '/') - 63,
+                'A', 0, 0);
+            __m256i chars = _mm256_add_epi8(
+                _mm256_shuffle_epi8(offsets, reduced), indices);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+            done += 24;
+            out += 32;
+        }
+        return done;
+    }
+
+    // Translate 16 characters to sextets, or return false if any of them
+    // is not in the alphabet (including whitespace and padding), so the
+    // caller can let the scalar loop deal with that block.
+    template <bool urlSafe>
+    CODEC_TARGET("ssse3")
+    static inline bool TranslateSSSE3(__m128i& chars)
+    {
+        if (urlSafe)
+        {
+            // Map '-' and '_' onto '+' and '/' so the standard tables
+            // apply, after making sure those two weren't there already.
+            __m128i standard = _mm_or_si128(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('+')),
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('/')));
+            if (_mm_movemask_epi8(standard))
+                return false;
+            chars = _mm_add_epi8(chars, _mm_and_si128(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('-')),
+                _mm_set1_epi8('+' - '-')));
+            chars = _mm_add_epi8(chars, _mm_and_si128(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')),
+                _mm_set1_epi8('/' - '_')));
+        }
+
+        const __m128i lowTable = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i highTable = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i rollTable = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask = _mm_set1_epi8(0x2f);
+
+        __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), mask);
+        __m128i lowNibbles = _mm_and_si128(chars, mask);
+        __m128i high = _mm_shuffle_epi8(highTable, highNibbles);
+        __m128i low = _mm_shuffle_epi8(lowTable, lowNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(low, high),
+            _mm_setzero_si128())))
+        {
+            return false;
+        }
+
+        __m128i slash = _mm_cmpeq_epi8(chars, mask);
+        __m128i roll = _mm_shuffle_epi8(rollTable,
+            _mm_add_epi8(slash, highNibbles));
+        chars = _mm_add_epi8(chars, roll);
+        return true;
+    }
+
+    // Pack 16 sextets into the low 12 bytes of the register.
+    CODEC_TARGET("ssse3")
+    static inline __m128i PackSSSE3(__m128i sextets)
+    {
+        __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+        __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(words, _mm_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    template <bool urlSafe>
+    CODEC_TARGET("ssse3")
+    static size_t DecodeSSSE3(const unsigned char* in, size_t length,
+        unsigned char* out, size_t& written)
+    {
+        // Every block stores 16 bytes to keep 12, so stop while the
+        // output is guaranteed to have room for the extra 4.
+        size_t done = 0;
+        written = 0;
+        while (length - done >= 24)
+        {
+            __m128i chars = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(in + done));
+            if (!TranslateSSSE3<urlSafe>(chars))
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written),
+                PackSSSE3(chars));
+            done += 16;
+            written += 12;
+        }
+        return done;
+    }
+
+    template <bool urlSafe>
+    CODEC_TARGET("avx2")
+    static size_t DecodeAVX2(const unsigned char* in, size_t length,
+        unsigned char* out, size_t& written)
+    {
+        size_t done = 0;
+        written = 0;
+        while (length - done >= 48)
+        {
+            __m256i chars = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(in + done));
+
+            if (urlSafe)
+            {
+                __m256i standard = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+')),
+                    _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/')));
+                if (_mm256_movemask_epi8(standard))
+                    break;
+                chars = _mm256_add_epi8(chars, _mm256_and_si256(
+                    _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('-')),
+                    _mm256_set1_epi8('+' - '-')));
+                chars = _mm256_add_epi8(chars, _mm256_and_si256(
+                    _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_')),
+                    _mm256_set1_epi8('/' - '_')));
+            }
+
+            const __m256i lowTable = _mm256_setr_epi8(
+                0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+            const __m256i highTable = _mm256_setr_epi8(
+                0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m256i rollTable = _mm256_setr_epi8(
+                0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i mask = _mm256_set1_epi8(0x2f);
+
+            __m256i highNibbles = _mm256_and_si256(
+                _mm256_srli_epi32(chars, 4), mask);
+            __m256i lowNibbles = _mm256_and_si256(chars, mask);
+            __m256i high = _mm256_shuffle_epi8(highTable, highNibbles);
+            __m256i low = _mm256_shuffle_epi8(lowTable, lowNibbles);
+            if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(
+                _mm256_and_si256(low, high), _mm256_setzero_si256())))
+            {
+                break;
+            }
+
+            __m256i slash = _mm256_cmpeq_epi8(chars, mask);
+            __m256i roll = _mm256_shuffle_epi8(rollTable,
+                _mm256_add_epi8(slash, highNibbles));
+            chars = _mm256_add_epi8(chars, roll);
+
+            __m256i pairs = _mm256_maddubs_epi16(chars,
+                _mm256_set1_epi32(0x01400140));
+            __m256i words = _mm256_madd_epi16(pairs,
+                _mm256_set1_epi32(0x00011000));
+            words = _mm256_shuffle_epi8(words, _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            // Close the gap between the two lanes' 12 bytes.
+            words = _mm256_permutevar8x32_epi32(words,
+                _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + written), words);
+            done += 32;
+            written += 24;
+        }
+        return done;
+    }
+#endif
+
+    size_t EncodedLength(size_t length, bool padding)
+    {
+        if (padding)
+            return (length + 2) / 3 * 4;
+        return length / 3 * 4 + (length % 3 == 0 ? 0 : length % 3 + 1);
+    }
+
+    void Encode(const char* data, size_t length, char* out,
+        bool urlSafe, bool padding)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        const char* alphabet = urlSafe ? URL_SAFE_ALPHABET : STANDARD_ALPHABET;
+
+        size_t done = 0;
+#ifdef CODEC_X86_SIMD
+        CPUFeatures::SIMDLevel level = CPUFeatures::GetSIMDLevel();
+        if (level >= CPUFeatures::AVX2)
+        {
+            done = urlSafe ? EncodeAVX2<true>(in, length, out)
+                : EncodeAVX2<false>(in, length, out);
+        }
+        if (level >= CPUFeatures::SSSE3)
+        {
+            char* next = out + done / 3 * 4;
+            done += urlSafe ? EncodeSSSE3<true>(in + done, length - done, next)
+                : EncodeSSSE3<false>(in + done, length - done, next);
+        }
+#endif
+
+        size_t groups = (length - done) / 3;
+        EncodeScalar(in + done, groups, out + done / 3 * 4, alphabet);
+        done += groups * 3;
+        out += done / 3 * 4;
+
+        size_t remaining = length - done;
+        if (remaining == 0)
+            return;
+
+        unsigned int value = in[done] << 16;
+        if (remaining == 2)
+            value |= in[done + 1] << 8;
+        *out++ = alphabet[(value >> 18) & 63];
+        *out++ = alphabet[(value >> 12) & 63];
+        if (remaining == 2)
+            *out++ = alphabet[(value >> 6) & 63];
+        else if (padding)
+            *out++ = '=';
+        if (padding)
+            *out++ = '=';
+    }
+
+    size_t DecodedMaxLength(size_t length)
+    {
+        return (length + 3) / 4 * 3;
+    }
+
+    bool Decode(const char* data, size_t length, char* outData,
+        size_t& outLength, bool urlSafe)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = in + length;
+        unsigned char* out = reinterpret_cast<unsigned char*>(outData);
+        const signed char* table = urlSafe ? urlSafeTable : standardTable;
+
+#ifdef CODEC_X86_SIMD
+        CPUFeatures::SIMDLevel level = CPUFeatures::GetSIMDLevel();
+#endif
+
+        unsigned int value = 0;
+        int count = 0;
+        while (in < end)
+        {
+#ifdef CODEC_X86_SIMD
+            size_t written;
+            if (level >= CPUFeatures::AVX2)
+            {
+                in += urlSafe ? DecodeAVX2<true>(in, end - in, out, written)
+                    : DecodeAVX2<false>(in, end - in, out, written);
+                out += written;
+            }
+            if (level >= CPUFeatures::SSSE3)
+            {
+                in += urlSafe ? DecodeSSSE3<true>(in, end - in, out, written)
+                    : DecodeSSSE3<false>(in, end - in, out, written);
+                out += written;
+            }
+#endif
+
+            // Handle at least the block the kernels stopped at (it may hold
+            // whitespace) and finish the quantum, so they can pick up again.
+            const unsigned char* stop = in + 16;
+            while (in < end && (in < stop || count != 0))
+            {
+                signed char sextet = table[*in++];
+                if (sextet >= 0)
+                {
+                    value = (value << 6) | sextet;
+                    if (++count == 4)
+                    {
+                        out[0] = (unsigned char) (value >> 16);
+                        out[1] = (unsigned char) (value >> 8);
+                        out[2] = (unsigned char) value;
+                        out += 3;
+                        value = 0;
+                        count = 0;
+                    }
+                }
+                else if (sextet == PADDING)
+                {
+                    // Only more padding and whitespace may follow.
+                    for (; in < end; in++)
+                    {
+                        if (table[*in] != PADDING && table[*in] != WHITESPACE)
+                            return false;
+                    }
+                    break;
+                }
+                else if (sextet != WHITESPACE)
+                {
+                    return false;
+                }
+            }
+        }
+
+        // A final partial quantum holds one or two bytes.
+        if (count == 1)
+            return false;
+        if (count >= 2)
+            *out++ = (unsigned char) (value >> (count == 2 ? 4 : 10));
+        if (count == 3)
+            *out++ = (unsigned char) (value >> 2);
+
+        outLength = out - reinterpret_cast<unsigned char*>(outData);
+        return true;
+    }
+}
+}
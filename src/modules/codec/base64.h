@@ -0,0 +1,79 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _BASE64_H_
+#define _BASE64_H_
+
+#include <cstddef>
+
+namespace ti
+{
+    /**
+     * Base64 (RFC 4648) over plain buffers. Both directions use SSSE3 or
+     * AVX2 kernels when the processor has them and a table-driven loop
+     * otherwise. The URL-safe alphabet uses '-' and '_' for 62 and 63.
+     */
+    namespace Base64
+    {
+        /**
+         * @return the number of characters Encode writes for the given
+         * number of input bytes
+         */
+        size_t EncodedLength(size_t length, bool padding);
+
+        /**
+         * Encode data without line breaks. The output must have room for
+         * EncodedLength(length, padding) characters; it is not terminated.
+         */
+        void Encode(const char* data, size_t length, char* out,
+            bool urlSafe, bool padding);
+
+        /**
+         * @return the most bytes Decode can produce from the given number
+         * of characters
+         */
+        size_t DecodedMaxLength(size_t length);
+
+        /**
+         * Decode text, skipping whitespace. Padding is optional.
+         * @param out Room for DecodedMaxLength(length) bytes
+         * @param outLength Set to the number of bytes written
+         * @return false if the text is not valid base64
+         */
+        bool Decode(const char* data, size_t length, char* out,
+            size_t& outLength, bool urlSafe);
+    }
+}
+
+#endif
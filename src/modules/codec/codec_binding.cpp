@@ -38,46 +38,27 @@
 #include <tideutils/posix/posix_utils.h>
 #endif
 #include <tide/tide.h>
+#include <tide/zip_archive.h>
 #include "codec_binding.h"
+#include "base64.h"
+#include "digest_binding.h"
+#include "hex_binary.h"
+#include "sequential_file.h"
+#include "sha2_engine.h"
 
 #include <sstream>
 
-#include <Poco/Zip/Zip.h>
-#include <Poco/Zip/Compress.h>
-#include <Poco/Zip/Decompress.h>
-#include <Poco/Base64Encoder.h>
-#include <Poco/Base64Decoder.h>
 #include <Poco/DigestEngine.h>
 #include <Poco/MD2Engine.h>
 #include <Poco/MD4Engine.h>
 #include <Poco/MD5Engine.h>
 #include <Poco/SHA1Engine.h>
 #include <Poco/HMACEngine.h>
-#include <Poco/HexBinaryEncoder.h>
-#include <Poco/HexBinaryDecoder.h>
 #include <Poco/Checksum.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
 
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/archive/iterators/insert_linebreaks.hpp>
-#include <boost/archive/iterators/remove_whitespace.hpp>
-
-using namespace boost::archive::iterators;
-using namespace std;
-
-typedef transform_width< binary_from_base64<remove_whitespace<string::const_iterator> >, 8, 6 > it_binary_t;
-typedef insert_linebreaks<base64_from_binary<transform_width<string::const_iterator,6,8> >, 72 > it_base64_t;
-
-
-#define CODEC_MD2       1
-#define CODEC_MD4       2
-#define CODEC_MD5       3
-#define CODEC_SHA1      4
-#define CODEC_CRC32     1
-#define CODEC_ADLER32   2
+#include <cstring>
 
 namespace ti
 {
@@ -88,20 +69,22 @@ namespace ti
         /**
          * @tiapi(method=True,name=Codec.encodeBase64,since=0.7) encode a string or Bytes into base64
          * @tiarg(for=Codec.encodeBase64,name=data,type=String|Bytes) data to encode
+         * @tiarg(for=Codec.encodeBase64,name=options,type=Object,optional=True) urlSafe (use '-' and '_', default false), padding (default true, or false when urlSafe), lineLength (default 72, or 0 when urlSafe; 0 for no line breaks) and asBytes (return Bytes instead of a String)
          * @tiresult(for=Codec.encodeBase64,type=string) returns base64 encoded string
          */
         this->SetMethod("encodeBase64", &CodecBinding::EncodeBase64);
 
         /**
          * @tiapi(method=True,name=Codec.decodeBase64,since=0.7) decode a string from base64
-         * @tiarg(for=Codec.decodeBase64,name=data,type=String) data to decode
+         * @tiarg(for=Codec.decodeBase64,name=data,type=String|Bytes) data to decode
+         * @tiarg(for=Codec.decodeBase64,name=options,type=Object,optional=True) urlSafe (expect '-' and '_', default false) and asBytes (return Bytes instead of a String)
          * @tiresult(for=Codec.decodeBase64,type=string) returns base64 decoded string
          */
         this->SetMethod("decodeBase64", &CodecBinding::DecodeBase64);
 
         /**
          * @tiapi(method=True,name=Codec.digestToHex,since=0.7) encode a string or Bytes using a digest algorithm
-         * @tiarg(for=Codec.digestToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1
+         * @tiarg(for=Codec.digestToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1, SHA256, SHA512
          * @tiarg(for=Codec.digestToHex,name=data,type=String|Bytes) data to encode
          * @tiresult(for=Codec.digestToHex,type=string) returns encoded string
          */
@@ -109,7 +92,7 @@ namespace ti
 
         /**
          * @tiapi(method=True,name=Codec.digestHMACToHex,since=0.7) digest a encoded string in HMAC
-         * @tiarg(for=Codec.digestHMACToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1
+         * @tiarg(for=Codec.digestHMACToHex,name=type,type=int) encoding type: currently supports MD2, MD4, MD5, SHA1, SHA256, SHA512
          * @tiarg(for=Codec.digestHMACToHex,name=data,type=String) data to encode
          * @tiarg(for=Codec.digestHMACToHex,name=data,type=String) key to us for HMAC
          * @tiresult(for=Codec.digestHMACToHex,type=string) returns base64 decoded string
@@ -119,13 +102,15 @@ namespace ti
         /**
          * @tiapi(method=True,name=Codec.encodeHexBinary,since=0.7) encode a string or Bytes into hex binary
          * @tiarg(for=Codec.encodeHexBinary,name=data,type=String|Bytes) data to encode
+         * @tiarg(for=Codec.encodeHexBinary,name=options,type=Object,optional=True) lineLength (default 72; 0 for no line breaks) and asBytes (return Bytes instead of a String)
          * @tiresult(for=Codec.encodeHexBinary,type=string) returns hex binary encoded string
          */
         this->SetMethod("encodeHexBinary", &CodecBinding::EncodeHexBinary);
 
         /**
          * @tiapi(method=True,name=Codec.decodeHexBinary,since=0.7) decode a string from hex binary
-         * @tiarg(for=Codec.decodeHexBinary,name=data,type=String) data to decode
+         * @tiarg(for=Codec.decodeHexBinary,name=data,type=String|Bytes) data to decode
+         * @tiarg(for=Codec.decodeHexBinary,name=options,type=Object,optional=True) asBytes (return Bytes instead of a String)
          * @tiresult(for=Codec.decodeHexBinary,type=string) returns unencoded hex binary string
          */
         this->SetMethod("decodeHexBinary", &CodecBinding::DecodeHexBinary);
@@ -133,20 +118,59 @@ namespace ti
         /**
          * @tiapi(method=True,name=Codec.checksum,since=0.7) compute checksum
          * @tiarg(for=Codec.checksum,name=data,type=String) data to checksum (as string)
-         * @tiarg(for=Codec.checksum,name=type,type=int,optional=True) checksum type: currently supports CRC32 (default) and ADLER32
+         * @tiarg(for=Codec.checksum,name=type,type=int,optional=True) checksum type: currently supports CRC32 (default), ADLER32 and CRC32C
          * @tiresult(for=Codec.checksum,type=int) return checksum value
          */
         this->SetMethod("checksum", &CodecBinding::Checksum);
+
+        /**
+         * @tiapi(method=True,name=Codec.createDigest,since=1.3.2)
+         * @tiapi Create a digest which can be fed data a piece at a time,
+         * @tiapi for input which is too large to pass to digestToHex at once.
+         * @tiarg[Number, type] Digest type: MD2, MD4, MD5, SHA1, SHA256 or SHA512
+         * @tiresult[Codec.Digest] A new digest object.
+         */
+        this->SetMethod("createDigest", &CodecBinding::CreateDigest);
+
+        /**
+         * @tiapi(method=True,name=Codec.createChecksum,since=1.3.2)
+         * @tiapi Create a checksum which can be fed data a piece at a time.
+         * @tiarg[Number, type, optional=True] Checksum type: CRC32 (default), ADLER32 or CRC32C
+         * @tiresult[Codec.Checksum] A new checksum object.
+         */
+        this->SetMethod("createChecksum", &CodecBinding::CreateChecksum);
+
+        /**
+         * @tiapi(method=True,name=Codec.digestFile,since=1.3.2)
+         * @tiapi Asynchronously digest the contents of a file. The file is
+         * @tiapi read in large chunks on a background thread, so it never
+         * @tiapi has to fit in memory.
+         * @tiarg[Number, type] Digest type: MD2, MD4, MD5, SHA1, SHA256 or SHA512
+         * @tiarg[Filesystem.File|String, file] The file to digest
+         * @tiarg[Function, onComplete, optional=True] A function which receives the digest as hex: function onComplete(digest) {}
+         * @tiresult[AsyncJob] The job which is reading the file.
+         */
+        this->SetMethod("digestFile", &CodecBinding::DigestFile);
         
         /**
          * @tiapi(method=True,name=Codec.createZip,since=0.7) Asynchronously write the contents of a directory to a zip file
          * All files will be recursively added from the directory, and the directory will be considered the logical "root" of the zip.
          * @tiarg[Filesystem.File|String, directory] A directory root to write to the zip stream
          * @tiarg[Filesystem.File|String, zipFile] The destination zip file
+         * Entries are compressed on several threads at once, and the job's progress is updated as each one is written.
          * @tiarg[Function, onComplete] A function callback that receives the zip file when writing is finished: function onComplete(destFile) {}
+         * @tiresult[AsyncJob] The job which is writing the zip file.
          */
         this->SetMethod("createZip", &CodecBinding::CreateZip);
 
+        /**
+         * @tiapi(method=True,name=Codec.extractZip,since=0.7) Asynchronously extract the contents of a zip file into a directory
+         * Entries are extracted on several threads at once, and the job's progress is updated as each one is written.
+         * @tiarg[Filesystem.File|String, zipFile] The zip file to extract
+         * @tiarg[Filesystem.File|String, directory] The destination directory, which is created if it doesn't exist
+         * @tiarg[Function, onComplete] A function callback that receives the directory when extraction is finished: function onComplete(destDir) {}
+         * @tiresult[AsyncJob] The job which is extracting the zip file.
+         */
         this->SetMethod("extractZip", &CodecBinding::ExtractZip);
         
         /**
@@ -165,6 +189,14 @@ namespace ti
          * @tiapi(property=True,name=Codec.SHA1,since=0.7) SHA1 property
          */
         this->SetInt("SHA1", CODEC_SHA1);
+        /**
+         * @tiapi(property=True,name=Codec.SHA256,since=1.3.2) SHA256 property
+         */
+        this->SetInt("SHA256", CODEC_SHA256);
+        /**
+         * @tiapi(property=True,name=Codec.SHA512,since=1.3.2) SHA512 property
+         */
+        this->SetInt("SHA512", CODEC_SHA512);
         /**
          * @tiapi(property=True,name=Codec.CRC32,since=0.7) CRC32 property
          */
@@ -173,114 +205,172 @@ namespace ti
          * @tiapi(property=True,name=Codec.ADLER32,since=0.7) ADLER32 property
          */
         this->SetInt("ADLER32", CODEC_ADLER32);
+        /**
+         * @tiapi(property=True,name=Codec.CRC32C,since=1.3.2) CRC32C property
+         */
+        this->SetInt("CRC32C", CODEC_CRC32C);
     }
     
     CodecBinding::~CodecBinding()
     {
     }
     
-    static std::string& GetStringFromValue(ValueRef value)
+    // The contents of a String or Bytes argument, without copying them.
+    // Any other object is treated as empty.
+    static void GetData(ValueRef value, const char*& data, size_t& length)
     {
-        static std::string data;
+        data = "";
+        length = 0;
         if (value->IsString())
         {
             data = value->ToString();
+            length = strlen(data);
         }
-        else
+        else if (value->IsObject())
         {
-            AutoPtr<Bytes> bytes(value->ToObject().cast<Bytes>());
-            if (!bytes.isNull())
-            {
-                data = std::string(bytes->Pointer(), bytes->Length());
-            }
-            else
+            BytesRef bytes(value->ToObject().cast<Bytes>());
+            if (!bytes.isNull() && bytes->Length() > 0)
             {
-                data = "";
+                data = bytes->Pointer();
+                length = bytes->Length();
             }
         }
-        return data;
     }
-    
-    void CodecBinding::EncodeBase64(const ValueList& args, ValueRef result)
+
+    static TiObjectRef GetOptions(const ValueList& args, size_t index)
     {
-        args.VerifyException("encodeBase64", "s|o");
-        
-        std::string s = GetStringFromValue(args.at(0));
+        if (args.size() > index && args.at(index)->IsObject())
+            return args.GetObject(index);
+        return 0;
+    }
+
+    static size_t WrappedLength(size_t length, size_t lineLength)
+    {
+        if (lineLength == 0 || length == 0)
+            return length;
+        return length + (length - 1) / lineLength;
+    }
 
-        // Encode
-        unsigned int writePaddChars = (3-s.length()%3)%3;
-        string base64(it_base64_t(s.begin()),it_base64_t(s.end()));
-        base64.append(writePaddChars,'=');
-	result->SetString(base64);
+    // Break text into lines of lineLength characters, in place. The buffer
+    // must have room for WrappedLength(length, lineLength) characters.
+    static size_t WrapLines(char* text, size_t length, size_t lineLength)
+    {
+        size_t wrappedLength = WrappedLength(length, lineLength);
+        if (wrappedLength == length)
+            return length;
+
+        // Work backwards so that no line is overwritten before it moves.
+        size_t breaks = wrappedLength - length;
+        size_t lastLine = length - breaks * lineLength;
+        char* source = text + length - lastLine;
+        char* destination = text + wrappedLength - lastLine;
+        memmove(destination, source, lastLine);
+        while (breaks-- > 0)
+        {
+            *--destination = '\n';
+            source -= lineLength;
+            destination -= lineLength;
+            memmove(destination, source, lineLength);
+        }
+        return wrappedLength;
+    }
+
+    // Return the first length bytes of a buffer which was allocated for
+    // the worst case, as Bytes or as a String.
+    static void SetResult(ValueRef result, BytesRef buffer, size_t length,
+        bool asBytes)
+    {
+        if (asBytes)
+        {
+            if (length != buffer->Length())
+                buffer = new Bytes(buffer, 0, length);
+            result->SetObject(buffer);
+        }
+        else if (length == 0)
+        {
+            result->SetString("");
+        }
+        else
+        {
+            result->SetString(buffer->Pointer(), length);
+        }
+    }
+
+    void CodecBinding::EncodeBase64(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("encodeBase64", "s|o ?o");
+
+        const char* data;
+        size_t length;
+        GetData(args.at(0), data, length);
+
+        // Stay compatible with the MIME-style output this has always
+        // produced, unless asked for the URL-safe form.
+        TiObjectRef options(GetOptions(args, 1));
+        bool urlSafe = !options.isNull() && options->GetBool("urlSafe");
+        bool padding = options.isNull() || options->GetBool("padding", !urlSafe);
+        int lineLength = options.isNull() ? 72 : options->GetInt("lineLength", urlSafe ? 0 : 72);
+        bool asBytes = !options.isNull() && options->GetBool("asBytes");
+        if (lineLength < 0)
+            lineLength = 0;
+
+        size_t encodedLength = Base64::EncodedLength(length, padding);
+        BytesRef encoded(new Bytes(WrappedLength(encodedLength, lineLength)));
+        Base64::Encode(data, length, encoded->Pointer(), urlSafe, padding);
+        SetResult(result, encoded,
+            WrapLines(encoded->Pointer(), encodedLength, lineLength), asBytes);
     }
 
     void CodecBinding::DecodeBase64(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("decodeBase64", "s");
+        args.VerifyException("decodeBase64", "s|o ?o");
+
+        const char* data;
+        size_t length;
+        GetData(args.at(0), data, length);
 
-        std::string base64 = args.at(0)->ToString();
+        TiObjectRef options(GetOptions(args, 1));
+        bool urlSafe = !options.isNull() && options->GetBool("urlSafe");
+        bool asBytes = !options.isNull() && options->GetBool("asBytes");
 
-        // Decode
-        unsigned int paddChars = std::count(base64.begin(), base64.end(), '=');
-        std::replace(base64.begin(),base64.end(),'=','A'); // replace '=' by base64 encoding of '\0'
-        std::string decoded(it_binary_t(base64.begin()), it_binary_t(base64.end())); // decode
-        decoded.erase(decoded.end()-paddChars, decoded.end());  // erase padding '\0' characters
-        result->SetString(decoded);
+        BytesRef decoded(new Bytes(Base64::DecodedMaxLength(length)));
+        size_t decodedLength = 0;
+        if (!Base64::Decode(data, length, decoded->Pointer(), decodedLength, urlSafe))
+            throw ValueException::FromString("Invalid base64 data");
+        SetResult(result, decoded, decodedLength, asBytes);
     }
 
-    void CodecBinding::DigestToHex(const ValueList& args, ValueRef result)
+    /*static*/
+    Poco::DigestEngine* CodecBinding::CreateDigestEngine(int type)
     {
-        args.VerifyException("digestToHex", "i s|o");
-        
-        int type = args.at(0)->ToInt();
-        
-        Poco::DigestEngine *engine = NULL;
-        
         switch(type)
         {
             case CODEC_MD2:
-            {
-                engine = new Poco::MD2Engine(); 
-                break;
-            }
+                return new Poco::MD2Engine();
             case CODEC_MD4:
-            {
-                engine = new Poco::MD4Engine(); 
-                break;
-            }
+                return new Poco::MD4Engine();
             case CODEC_MD5:
-            {
-                engine = new Poco::MD5Engine(); 
-                break;
-            }
+                return new Poco::MD5Engine();
             case CODEC_SHA1:
-            {
-                engine = new Poco::SHA1Engine(); 
-                break;
-            }
+                return new Poco::SHA1Engine();
+            case CODEC_SHA256:
+                return new SHA256Engine();
+            case CODEC_SHA512:
+                return new SHA512Engine();
             default:
-            {
-                std::ostringstream msg("Unsupported encoding type: ");
-                msg << type;
-                throw ValueException::FromString(msg.str());
-            }
+                throw ValueException::FromFormat("Unsupported encoding type: %i", type);
         }
+    }
+
+    void CodecBinding::DigestToHex(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("digestToHex", "i s|o");
         
-        if (args.at(1)->IsString())
-        {
-            engine->update(args.GetString(1));
-        }
-        else
-        {
-            AutoPtr<Bytes> bytes(args.GetObject(1).cast<Bytes>());
-            if (!bytes.isNull())
-            {
-                engine->update(bytes->Pointer(), bytes->Length());
-            }
-        }
+        Poco::SharedPtr<Poco::DigestEngine> engine(
+            CreateDigestEngine(args.at(0)->ToInt()));
+        DigestBinding::Update(*engine, args.at(1));
         std::string data = Poco::DigestEngine::digestToHex(engine->digest()); 
         result->SetString(data);
-        delete engine;
     }
 
     void CodecBinding::DigestHMACToHex(const ValueList& args, ValueRef result)
@@ -325,6 +415,22 @@ namespace ti
                 result->SetString(data);
                 break;
             }
+            case CODEC_SHA256:
+            {
+                Poco::HMACEngine<SHA256Engine> engine(key);
+                engine.update(encoded);
+                std::string data = Poco::DigestEngine::digestToHex(engine.digest());
+                result->SetString(data);
+                break;
+            }
+            case CODEC_SHA512:
+            {
+                Poco::HMACEngine<SHA512Engine> engine(key);
+                engine.update(encoded);
+                std::string data = Poco::DigestEngine::digestToHex(engine.digest());
+                result->SetString(data);
+                break;
+            }
             default:
             {
                 std::ostringstream msg("Unsupported encoding type: ");
@@ -336,27 +442,40 @@ namespace ti
 
     void CodecBinding::EncodeHexBinary(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("encodeHexBinary", "s|o");
-        
-        std::stringstream str;
-        Poco::HexBinaryEncoder encoder(str);
-        encoder << GetStringFromValue(args.at(0));
-        encoder.close();
-        std::string encoded = str.str();
-        result->SetString(encoded);
+        args.VerifyException("encodeHexBinary", "s|o ?o");
+
+        const char* data;
+        size_t length;
+        GetData(args.at(0), data, length);
+
+        TiObjectRef options(GetOptions(args, 1));
+        int lineLength = options.isNull() ? 72 : options->GetInt("lineLength", 72);
+        bool asBytes = !options.isNull() && options->GetBool("asBytes");
+        if (lineLength < 0)
+            lineLength = 0;
+
+        BytesRef encoded(new Bytes(WrappedLength(length * 2, lineLength)));
+        HexBinary::Encode(data, length, encoded->Pointer());
+        SetResult(result, encoded,
+            WrapLines(encoded->Pointer(), length * 2, lineLength), asBytes);
     }
 
     void CodecBinding::DecodeHexBinary(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("decodeHexBinary", "s");
-        
-        std::string encoded = args.at(0)->ToString();
-        std::stringstream str;
-        str << encoded;
-        Poco::HexBinaryDecoder decoder(str);
-        std::string decoded;
-        decoder >> decoded;
-        result->SetString(decoded);
+        args.VerifyException("decodeHexBinary", "s|o ?o");
+
+        const char* data;
+        size_t length;
+        GetData(args.at(0), data, length);
+
+        TiObjectRef options(GetOptions(args, 1));
+        bool asBytes = !options.isNull() && options->GetBool("asBytes");
+
+        BytesRef decoded(new Bytes(length / 2));
+        size_t decodedLength = 0;
+        if (!HexBinary::Decode(data, length, decoded->Pointer(), decodedLength))
+            throw ValueException::FromString("Invalid hex binary data");
+        SetResult(result, decoded, decodedLength, asBytes);
     }
 
     void CodecBinding::Checksum(const ValueList& args, ValueRef result)
@@ -370,53 +489,24 @@ namespace ti
             type = args.at(1)->ToInt();
         }
         
-        Poco::Checksum *checksum = NULL;
-        
-        switch(type)
-        {
-            case CODEC_CRC32:
-            {
-                checksum = new Poco::Checksum(Poco::Checksum::TYPE_CRC32);
-                break;
-            }
-            case CODEC_ADLER32:
-            {
-                checksum = new Poco::Checksum(Poco::Checksum::TYPE_ADLER32);
-                break;
-            }
-            default:
-            {
-                std::ostringstream msg("Unsupported type: ");
-                msg << type;
-                throw ValueException::FromString(msg.str());
-            }
-        }
-
-        if (args.at(0)->IsString())
-        {
-            std::string encoded = args.at(0)->ToString();
-            const char *data = encoded.c_str();
-            checksum->update(data,encoded.size());
-            result->SetInt(checksum->checksum());
-        }
-        else if (args.at(0)->IsObject())
-        {
-            BytesRef bytes = args.at(0)->ToObject().cast<Bytes>();
-            if (bytes.isNull())
-            {
-                delete checksum;
-                throw ValueException::FromString("unsupported data type passed as argument 1");
-            }
-            checksum->update(bytes->Pointer(),bytes->Length());
-            result->SetInt(checksum->checksum());
-        }
-        else
+        ChecksumEngine checksum(type);
+        if (!checksum.Update(args.at(0)))
         {
-            delete checksum;
             throw ValueException::FromString("unsupported data type passed as argument 1");
         }
-        
-        delete checksum;
+        result->SetInt(checksum.GetValue());
+    }
+
+    void CodecBinding::CreateDigest(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createDigest", "i");
+        result->SetObject(new DigestBinding(CreateDigestEngine(args.GetInt(0))));
+    }
+
+    void CodecBinding::CreateChecksum(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createChecksum", "?i");
+        result->SetObject(new ChecksumBinding(args.GetInt(0, CODEC_CRC32)));
     }
     
     static std::string GetPathFromValue(ValueRef value)
@@ -482,7 +572,7 @@ namespace ti
         {
             throw ValueException::FromString("Error: Zip file name in extractZip is empty");
         }
-        if (zipFile.size() <= 0)
+        if (directory.size() <= 0)
         {
             throw ValueException::FromString("Error: Destination directory name in extractZip is empty");
         }
@@ -504,6 +594,66 @@ namespace ti
         result->SetObject(extractJob);
     }
 
+    void CodecBinding::DigestFile(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("digestFile", "i s|o ?m");
+
+        // Check the type here, so that a bad one is reported to the caller
+        // instead of being lost on the job's thread.
+        int type = args.GetInt(0);
+        delete CreateDigestEngine(type);
+
+        std::string file = GetPathFromValue(args.at(1));
+        if (file.empty())
+        {
+            throw ValueException::FromString("Error: File name in digestFile is empty");
+        }
+
+        TiMethodRef digestAsyncMethod = new FunctionPtrMethod(&CodecBinding::DigestFileAsync);
+        ValueList digestArgs;
+        digestArgs.push_back(Value::NewInt(type));
+        digestArgs.push_back(Value::NewString(file));
+
+        AutoPtr<AsyncJob> digestJob = new AsyncJob(digestAsyncMethod);
+        digestArgs.push_back(Value::NewObject(digestJob));
+        if (args.size() > 2 && args.at(2)->IsMethod())
+        {
+            digestArgs.push_back(args.at(2));
+        }
+
+        digestJob->SetArguments(digestArgs);
+        digestJob->RunAsynchronously();
+        result->SetObject(digestJob);
+    }
+
+    /**
+     * Passes zip progress on to the job doing the work. The job's progress
+     * follows every entry, but callbacks go to the main thread at most
+     * once for each percent.
+     */
+    class ZipJobListener : public ZipProgressListener
+    {
+    public:
+        ZipJobListener(AsyncJob* job) :
+            job(job),
+            reported(0.0)
+        {}
+
+        bool OnProgress(size_t finished, size_t total)
+        {
+            double progress = total > 0 ? (double) finished / (double) total : 1.0;
+            bool callbacks = progress - reported >= 0.01 || finished == total;
+            job->SetProgress(progress, callbacks);
+            if (callbacks)
+                reported = progress;
+            return !job->IsCancelled();
+        }
+
+    private:
+        AsyncJob* job;
+        double reported;
+    };
+
     /*static*/
     ValueRef CodecBinding::CreateZipAsync(const ValueList& args)
     {
@@ -516,25 +666,25 @@ namespace ti
             callback = args.GetMethod(3);
         }
         
-        Poco::Path path(directory);
-        path.makeDirectory();
-        
-        std::ofstream stream(UTF8ToSystem(zipFile).c_str(),
-            std::ios::binary | std::ios::trunc);
-        Poco::Zip::Compress compressor(stream, true);
+        ZipJobListener listener(job.get());
         try
         {
-            compressor.addRecursive(path);
+            ZipWriter writer(zipFile);
+            writer.AddDirectory(directory);
+            if (!writer.Write(&listener))
+                return Value::Undefined;
         }
-        catch (std::exception& e)
+        catch (ValueException& e)
         {
-            Logger::Get("Codec")->Error("exception compressing: %s", e.what());
-            throw ValueException::FromFormat("Exception during zip: %s", e.what());
+            Logger::Get("Codec")->Error("exception compressing: %s", e.ToString().c_str());
+            throw ValueException::FromFormat("Exception during zip: %s", e.ToString().c_str());
         }
-        
-        compressor.close();
-        stream.close();
-        
+        catch (Poco::Exception& e)
+        {
+            Logger::Get("Codec")->Error("exception compressing: %s", e.displayText().c_str());
+            throw ValueException::FromFormat("Exception during zip: %s", e.displayText().c_str());
+        }
+
         if (!callback.isNull())
         {
             ValueList args;
@@ -557,19 +707,23 @@ namespace ti
             callback = args.GetMethod(3);
         }
 
-        std::ifstream stream(UTF8ToSystem(zipFile).c_str(), std::ios::binary);
-        Poco::Zip::Decompress decompressor(stream, directory);
+        ZipJobListener listener(job.get());
         try
         {
-            decompressor.decompressAllFiles();
+            ZipReader reader(zipFile);
+            if (!reader.ExtractAll(directory, &listener))
+                return Value::Undefined;
         }
-        catch (std::exception& e)
+        catch (ValueException& e)
         {
-            Logger::Get("Codec")->Error("exception decompressing: %s", e.what());
-            throw ValueException::FromFormat("Exception during extraction: %s", e.what());
+            Logger::Get("Codec")->Error("exception decompressing: %s", e.ToString().c_str());
+            throw ValueException::FromFormat("Exception during extraction: %s", e.ToString().c_str());
+        }
+        catch (Poco::Exception& e)
+        {
+            Logger::Get("Codec")->Error("exception decompressing: %s", e.displayText().c_str());
+            throw ValueException::FromFormat("Exception during extraction: %s", e.displayText().c_str());
         }
-
-        stream.close();
 
         if (!callback.isNull())
         {
@@ -580,4 +734,55 @@ namespace ti
 
         return Value::Undefined;
     }
+
+    /*static*/
+    ValueRef CodecBinding::DigestFileAsync(const ValueList& args)
+    {
+        int type = args.GetInt(0);
+        std::string file = args.GetString(1);
+        AutoPtr<AsyncJob> job = args.GetObject(2).cast<AsyncJob>();
+        TiMethodRef callback = 0;
+        if (args.size() > 3)
+        {
+            callback = args.GetMethod(3);
+        }
+
+        Poco::SharedPtr<Poco::DigestEngine> engine(CreateDigestEngine(type));
+        SequentialFile input(file);
+        Poco::UInt64 size = input.GetSize();
+        Poco::UInt64 total = 0;
+        double reported = 0.0;
+
+        size_t count;
+        while ((count = input.Read()) > 0)
+        {
+            if (job->IsCancelled())
+                return Value::Undefined;
+
+            engine->update(input.GetBuffer(), (unsigned) count);
+            total += count;
+
+            // Each progress report is a trip to the main thread, so only
+            // send one for every percent of the file.
+            if (size > 0)
+            {
+                double progress = (double) total / (double) size;
+                if (progress - reported >= 0.01)
+                {
+                    job->SetProgress(progress, true);
+                    reported = progress;
+                }
+            }
+        }
+
+        std::string digest = Poco::DigestEngine::digestToHex(engine->digest());
+        if (!callback.isNull())
+        {
+            ValueList args;
+            args.push_back(Value::NewString(digest));
+            RunOnMainThread(callback, args, false);
+        }
+
+        return Value::NewString(digest);
+    }
 }
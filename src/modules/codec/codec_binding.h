@@ -36,7 +36,17 @@
 #define _CODEC_BINDING_H_
 
 #include <tide/tide.h>
+#include <Poco/DigestEngine.h>
 
+#define CODEC_MD2       1
+#define CODEC_MD4       2
+#define CODEC_MD5       3
+#define CODEC_SHA1      4
+#define CODEC_SHA256    5
+#define CODEC_SHA512    6
+#define CODEC_CRC32     1
+#define CODEC_ADLER32   2
+#define CODEC_CRC32C    3
 
 namespace ti
 {
@@ -44,6 +54,13 @@ namespace ti
     {
     public:
         CodecBinding(TiObjectRef);
+
+        /**
+         * Create a new engine for one of the CODEC_ digest types, throwing
+         * a ValueException for an unknown type. The caller owns the engine.
+         */
+        static Poco::DigestEngine* CreateDigestEngine(int type);
+
     protected:
         virtual ~CodecBinding();
     private:
@@ -56,11 +73,15 @@ namespace ti
         void EncodeHexBinary(const ValueList& args, ValueRef result);
         void DecodeHexBinary(const ValueList& args, ValueRef result);
         void Checksum(const ValueList& args, ValueRef result);
+        void CreateDigest(const ValueList& args, ValueRef result);
+        void CreateChecksum(const ValueList& args, ValueRef result);
+        void DigestFile(const ValueList& args, ValueRef result);
         void CreateZip(const ValueList& args, ValueRef result);
         void ExtractZip(const ValueList& args, ValueRef result);
         
         static ValueRef CreateZipAsync(const ValueList& args);
         static ValueRef ExtractZipAsync(const ValueList& args);
+        static ValueRef DigestFileAsync(const ValueList& args);
     };
 }
 
@@ -0,0 +1,120 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "cpu_features.h"
+
+#ifdef CODEC_X86_SIMD
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace ti
+{
+namespace CPUFeatures
+{
+#ifdef CODEC_X86_SIMD
+    static void CPUID(unsigned int leaf, unsigned int registers[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(reinterpret_cast<int*>(registers), leaf, 0);
+#else
+        __cpuid_count(leaf, 0, registers[0], registers[1],
+            registers[2], registers[3]);
+#endif
+    }
+
+    // AVX2 also needs the operating system to save the YMM registers
+    // when switching threads, which XGETBV reports.
+    static bool OSSavesYMM()
+    {
+#if defined(_MSC_VER)
+        return (_xgetbv(0) & 6) == 6;
+#else
+        unsigned int eax, edx;
+        __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" // xgetbv
+            : "=a" (eax), "=d" (edx) : "c" (0));
+        return (eax & 6) == 6;
+#endif
+    }
+
+    static SIMDLevel DetectSIMDLevel()
+    {
+        unsigned int registers[4];
+        CPUID(0, registers);
+        unsigned int maximumLeaf = registers[0];
+        if (maximumLeaf < 1)
+            return SCALAR;
+
+        CPUID(1, registers);
+        unsigned int ecx = registers[2];
+        if (!(ecx & (1 << 9)))
+            return SCALAR;
+        if (!(ecx & (1 << 20)))
+            return SSSE3;
+
+        bool hasAVX = (ecx & (1 << 27)) && (ecx & (1 << 28)) && OSSavesYMM();
+        if (!hasAVX || maximumLeaf < 7)
+            return SSE42;
+
+        CPUID(7, registers);
+        if (!(registers[1] & (1 << 5)))
+            return SSE42;
+        return AVX2;
+    }
+#else
+    static SIMDLevel DetectSIMDLevel()
+    {
+        return SCALAR;
+    }
+#endif
+
+    // Detect while the module loads, so that no thread ever sees a
+    // half-initialized value.
+    static const SIMDLevel detectedLevel = DetectSIMDLevel();
+    static volatile SIMDLevel currentLevel = detectedLevel;
+
+    SIMDLevel GetSIMDLevel()
+    {
+        return currentLevel;
+    }
+
+    void LimitSIMDLevel(SIMDLevel level)
+    {
+        currentLevel = level < detectedLevel ? level : detectedLevel;
+    }
+}
+}
@@ -0,0 +1,80 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _CPU_FEATURES_H_
+#define _CPU_FEATURES_H_
+
+// CODEC_X86_SIMD is defined when the compiler can build SSE and AVX2
+// kernels which are only called after checking the processor at runtime.
+// CODEC_TARGET marks such a kernel, so that the rest of the module is
+// still compiled for the baseline instruction set.
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#if defined(_MSC_VER) && _MSC_VER >= 1800
+#define CODEC_X86_SIMD 1
+#define CODEC_TARGET(instructions)
+#elif defined(__clang__) || (defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define CODEC_X86_SIMD 1
+#define CODEC_TARGET(instructions) __attribute__((target(instructions)))
+#endif
+#endif
+
+namespace ti
+{
+    namespace CPUFeatures
+    {
+        enum SIMDLevel
+        {
+            SCALAR = 0,
+            SSSE3 = 1,
+            SSE42 = 2,
+            AVX2 = 3
+        };
+
+        /**
+         * @return the best instruction set the codec kernels may use on
+         * this processor, never more than the last LimitSIMDLevel call.
+         */
+        SIMDLevel GetSIMDLevel();
+
+        /**
+         * Stop the kernels from using instructions beyond the given level.
+         * This is meant for tests and benchmarks, which want to compare
+         * the implementations on one machine.
+         */
+        void LimitSIMDLevel(SIMDLevel level);
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "crc32c.h"
+#include "cpu_features.h"
+#include <cstring>
+
+#ifdef CODEC_X86_SIMD
+#include <nmmintrin.h>
+#endif
+
+namespace ti
+{
+namespace CRC32C
+{
+    // The reflected Castagnoli polynomial.
+    static const Poco::UInt32 POLYNOMIAL = 0x82f63b78;
+
+    // table[0] is the usual byte-at-a-time table and table[k] advances a
+    // byte through k more zero bytes, which lets the software path fold
+    // eight bytes per step.
+    static Poco::UInt32 table[8][256];
+
+    static bool BuildTable()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            Poco::UInt32 crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (POLYNOMIAL & (0 - (crc & 1)));
+            table[0][i] = crc;
+        }
+
+        for (int i = 0; i < 256; i++)
+        {
+            for (int k = 1; k < 8; k++)
+            {
+                Poco::UInt32 crc = table[k - 1][i];
+                table[k][i] = (crc >> 8) ^ table[0][crc & 0xff];
+            }
+        }
+        return true;
+    }
+
+    // Build the tables while the module loads, before any thread can
+    // race to use them.
+    static bool tableBuilt = BuildTable();
+
+    static inline bool IsLittleEndian()
+    {
+        const Poco::UInt32 one = 1;
+        return *reinterpret_cast<const unsigned char*>(&one) == 1;
+    }
+
+    Poco::UInt32 UpdateSoftware(Poco::UInt32 crc, const void* data, size_t length)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        crc = ~crc;
+
+        if (IsLittleEndian())
+        {
+            while (length >= 8)
+            {
+                Poco::UInt32 low, high;
+                memcpy(&low, p, 4);
+                memcpy(&high, p + 4, 4);
+                low ^= crc;
+                crc = table[7][low & 0xff]
+                    ^ table[6][(low >> 8) & 0xff]
+                    ^ table[5][(low >> 16) & 0xff]
+                    ^ table[4][low >> 24]
+                    ^ table[3][high & 0xff]
+                    ^ table[2][(high >> 8) & 0xff]
+                    ^ table[1][(high >> 16) & 0xff]
+                    ^ table[0][high >> 24];
+                p += 8;
+                length -= 8;
+            }
+        }
+
+        while (length-- > 0)
+            crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xff];
+
+        return ~crc;
+    }
+
+#ifdef CODEC_X86_SIMD
+    CODEC_TARGET("sse4.2")
+    static Poco::UInt32 UpdateHardware(Poco::UInt32 crc, const void* data, size_t length)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        crc = ~crc;
+
+        // Consume single bytes until the rest of the data is aligned.
+        while (length > 0 && (reinterpret_cast<size_t>(p) & 7) != 0)
+        {
+            crc = _mm_crc32_u8(crc, *p++);
+            length--;
+        }
+
+#if defined(__x86_64__) || defined(_M_X64)
+        Poco::UInt64 crc64 = crc;
+        while (length >= 8)
+        {
+            crc64 = _mm_crc32_u64(crc64,
+                *reinterpret_cast<const Poco::UInt64*>(p));
+            p += 8;
+            length -= 8;
+        }
+        crc = (Poco::UInt32) crc64;
+#endif
+
+        while (length >= 4)
+        {
+            crc = _mm_crc32_u32(crc, *reinterpret_cast<const Poco::UInt32*>(p));
+            p += 4;
+            length -= 4;
+        }
+
+        while (length-- > 0)
+            crc = _mm_crc32_u8(crc, *p++);
+
+        return ~crc;
+    }
+
+    Poco::UInt32 Update(Poco::UInt32 crc, const void* data, size_t length)
+    {
+        if (IsHardwareAccelerated())
+            return UpdateHardware(crc, data, length);
+        return UpdateSoftware(crc, data, length);
+    }
+
+    bool IsHardwareAccelerated()
+    {
+        return CPUFeatures::GetSIMDLevel() >= CPUFeatures::SSE42;
+    }
+#else
+    Poco::UInt32 Update(Poco::UInt32 crc, const void* data, size_t length)
+    {
+        return UpdateSoftware(crc, data, length);
+    }
+
+    bool IsHardwareAccelerated()
+    {
+        return false;
+    }
+#endif
+}
+}
@@ -32,52 +32,38 @@
 * limitations under the License.
 **/
 
-#include "../tide.h"
-#include <cstdio>
-#include <cstring>
-#include <iostream>
-#include <sstream>
-#include <Poco/Stopwatch.h>
-#include <Poco/ScopedLock.h>
+#ifndef _CRC32C_H_
+#define _CRC32C_H_
 
-namespace tide
-{
-    ProfiledGlobalObject::ProfiledGlobalObject(TiObjectRef global) :
-        profiledObject(new ProfiledBoundObject(global))
-    {
-    }
-
-    ProfiledGlobalObject::~ProfiledGlobalObject()
-    {
-    }
+#include <Poco/Types.h>
+#include <cstddef>
 
-    void ProfiledGlobalObject::Set(const char* name, ValueRef value)
-    {
-        profiledObject->Set(name, value);
-    }
-
-    ValueRef ProfiledGlobalObject::Get(const char* name)
-    {
-        return profiledObject->Get(name);
-    }
-
-    SharedStringList ProfiledGlobalObject::GetPropertyNames()
-    {
-        return profiledObject->GetPropertyNames();
-    }
-
-    SharedString ProfiledGlobalObject::DisplayString(int levels)
+namespace ti
+{
+    /**
+     * CRC-32C (the Castagnoli polynomial used by iSCSI, ext4 and most
+     * storage formats). On x86 processors with SSE 4.2 this uses the
+     * CRC32 instruction, otherwise a slicing-by-8 table implementation.
+     */
+    namespace CRC32C
     {
-        return profiledObject->DisplayString(levels);
-    }
+        /**
+         * Continue a checksum with more data, zlib-style: pass 0 for the
+         * first call and the previous result for each call after that.
+         */
+        Poco::UInt32 Update(Poco::UInt32 crc, const void* data, size_t length);
 
-    bool ProfiledGlobalObject::HasProperty(const char* name)
-    {
-        return profiledObject->HasProperty(name);
-    }
+        /**
+         * The table-driven implementation, regardless of what the
+         * processor supports. Exposed for testing and benchmarks.
+         */
+        Poco::UInt32 UpdateSoftware(Poco::UInt32 crc, const void* data, size_t length);
 
-    bool ProfiledGlobalObject::Equals(TiObjectRef other)
-    {
-        return profiledObject->Equals(other);
+        /**
+         * @return true if Update uses the processor's CRC32 instruction
+         */
+        bool IsHardwareAccelerated();
     }
 }
+
+#endif
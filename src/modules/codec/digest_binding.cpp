@@ -0,0 +1,257 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "digest_binding.h"
+#include "codec_binding.h"
+#include "crc32c.h"
+
+namespace ti
+{
+    // Poco's update() takes an unsigned length, so hand it very large
+    // buffers a piece at a time.
+    static const size_t MAX_UPDATE_LENGTH = 1 << 30;
+
+    template <typename Engine>
+    static bool UpdateFromValue(Engine& engine, ValueRef data)
+    {
+        if (data->IsString())
+        {
+            const char* string = data->ToString();
+            engine.Update(string, strlen(string));
+            return true;
+        }
+
+        BytesRef bytes(0);
+        if (data->IsObject())
+            bytes = data->ToObject().cast<Bytes>();
+        if (bytes.isNull())
+            return false;
+
+        std::vector<BytesRef> segments;
+        bytes->GetSegments(segments);
+        for (size_t i = 0; i < segments.size(); i++)
+        {
+            const char* pointer = segments[i]->Pointer();
+            size_t length = segments[i]->Length();
+            while (length > 0)
+            {
+                size_t count = std::min(length, MAX_UPDATE_LENGTH);
+                engine.Update(pointer, count);
+                pointer += count;
+                length -= count;
+            }
+        }
+        return true;
+    }
+
+    // Adapts a Poco::DigestEngine to UpdateFromValue.
+    class DigestEngineSink
+    {
+    public:
+        DigestEngineSink(Poco::DigestEngine& engine) : engine(engine) {}
+        void Update(const char* data, size_t length)
+        {
+            engine.update(data, (unsigned) length);
+        }
+
+    private:
+        Poco::DigestEngine& engine;
+    };
+
+    DigestBinding::DigestBinding(Poco::DigestEngine* engine) :
+        StaticBoundObject("Codec.Digest"),
+        engine(engine)
+    {
+        /**
+         * @tiapi(method=True,name=Codec.Digest.update,since=1.3.2)
+         * @tiapi Add more data to the digest.
+         * @tiarg[String|Bytes, data] The data to add.
+         */
+        this->SetMethod("update", &DigestBinding::_Update);
+
+        /**
+         * @tiapi(method=True,name=Codec.Digest.digest,since=1.3.2)
+         * @tiapi Finish the digest and reset it, so the object can be
+         * @tiapi used again for a new message.
+         * @tiresult[String] The digest of all the data added since it was created or last reset, as hex.
+         */
+        this->SetMethod("digest", &DigestBinding::_Digest);
+
+        /**
+         * @tiapi(method=True,name=Codec.Digest.reset,since=1.3.2)
+         * @tiapi Discard any data added so far.
+         */
+        this->SetMethod("reset", &DigestBinding::_Reset);
+    }
+
+    DigestBinding::~DigestBinding()
+    {
+        delete this->engine;
+    }
+
+    /*static*/
+    bool DigestBinding::Update(Poco::DigestEngine& engine, ValueRef data)
+    {
+        DigestEngineSink sink(engine);
+        return UpdateFromValue(sink, data);
+    }
+
+    void DigestBinding::_Update(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("update", "s|o");
+        if (!Update(*this->engine, args.at(0)))
+            throw ValueException::FromString("Codec.Digest.update expects a String or Bytes");
+    }
+
+    void DigestBinding::_Digest(const ValueList& args, ValueRef result)
+    {
+        std::string hex(Poco::DigestEngine::digestToHex(this->engine->digest()));
+        result->SetString(hex);
+    }
+
+    void DigestBinding::_Reset(const ValueList& args, ValueRef result)
+    {
+        this->engine->reset();
+    }
+
+    ChecksumEngine::ChecksumEngine(int type) :
+        type(type),
+        checksum(0),
+        crc32c(0)
+    {
+        this->Reset();
+    }
+
+    ChecksumEngine::~ChecksumEngine()
+    {
+        delete this->checksum;
+    }
+
+    void ChecksumEngine::Reset()
+    {
+        delete this->checksum;
+        this->checksum = 0;
+        this->crc32c = 0;
+
+        switch (this->type)
+        {
+            case CODEC_CRC32:
+                this->checksum = new Poco::Checksum(Poco::Checksum::TYPE_CRC32);
+                break;
+            case CODEC_ADLER32:
+                this->checksum = new Poco::Checksum(Poco::Checksum::TYPE_ADLER32);
+                break;
+            case CODEC_CRC32C:
+                break;
+            default:
+                throw ValueException::FromFormat("Unsupported type: %i", this->type);
+        }
+    }
+
+    void ChecksumEngine::Update(const char* data, size_t length)
+    {
+        if (this->type == CODEC_CRC32C)
+        {
+            this->crc32c = CRC32C::Update(this->crc32c, data, length);
+            return;
+        }
+
+        while (length > 0)
+        {
+            size_t count = std::min(length, MAX_UPDATE_LENGTH);
+            this->checksum->update(data, (unsigned int) count);
+            data += count;
+            length -= count;
+        }
+    }
+
+    bool ChecksumEngine::Update(ValueRef data)
+    {
+        return UpdateFromValue(*this, data);
+    }
+
+    Poco::UInt32 ChecksumEngine::GetValue() const
+    {
+        if (this->type == CODEC_CRC32C)
+            return this->crc32c;
+        return this->checksum->checksum();
+    }
+
+    ChecksumBinding::ChecksumBinding(int type) :
+        StaticBoundObject("Codec.Checksum"),
+        engine(type)
+    {
+        /**
+         * @tiapi(method=True,name=Codec.Checksum.update,since=1.3.2)
+         * @tiapi Add more data to the checksum.
+         * @tiarg[String|Bytes, data] The data to add.
+         */
+        this->SetMethod("update", &ChecksumBinding::_Update);
+
+        /**
+         * @tiapi(method=True,name=Codec.Checksum.getValue,since=1.3.2)
+         * @tiapi Get the checksum of the data added so far. Unlike
+         * @tiapi Codec.checksum, the value is never negative.
+         * @tiresult[Number] The checksum as an unsigned 32-bit number.
+         */
+        this->SetMethod("getValue", &ChecksumBinding::_GetValue);
+
+        /**
+         * @tiapi(method=True,name=Codec.Checksum.reset,since=1.3.2)
+         * @tiapi Discard any data added so far.
+         */
+        this->SetMethod("reset", &ChecksumBinding::_Reset);
+    }
+
+    ChecksumBinding::~ChecksumBinding()
+    {
+    }
+
+    void ChecksumBinding::_Update(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("update", "s|o");
+        if (!this->engine.Update(args.at(0)))
+            throw ValueException::FromString("Codec.Checksum.update expects a String or Bytes");
+    }
+
+    void ChecksumBinding::_GetValue(const ValueList& args, ValueRef result)
+    {
+        result->SetDouble(this->engine.GetValue());
+    }
+
+    void ChecksumBinding::_Reset(const ValueList& args, ValueRef result)
+    {
+        this->engine.Reset();
+    }
+}
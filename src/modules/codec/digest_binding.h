@@ -0,0 +1,115 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _DIGEST_BINDING_H_
+#define _DIGEST_BINDING_H_
+
+#include <tide/tide.h>
+#include <Poco/DigestEngine.h>
+#include <Poco/Checksum.h>
+
+namespace ti
+{
+    /**
+     * A message digest which is computed a piece at a time, so that
+     * large inputs never have to be held in memory all at once.
+     */
+    class DigestBinding : public StaticBoundObject
+    {
+    public:
+        DigestBinding(Poco::DigestEngine* engine);
+
+        /**
+         * Feed a String or Bytes value to an engine. Bytes made of several
+         * segments are read in place instead of being flattened first.
+         * @return false if the value is neither a String nor a Bytes
+         */
+        static bool Update(Poco::DigestEngine& engine, ValueRef data);
+
+    protected:
+        virtual ~DigestBinding();
+
+    private:
+        Poco::DigestEngine* engine;
+
+        void _Update(const ValueList& args, ValueRef result);
+        void _Digest(const ValueList& args, ValueRef result);
+        void _Reset(const ValueList& args, ValueRef result);
+
+        DISALLOW_EVIL_CONSTRUCTORS(DigestBinding);
+    };
+
+    /**
+     * Computes one of the Codec checksum types (CRC32, ADLER32 or CRC32C)
+     * incrementally.
+     */
+    class ChecksumEngine
+    {
+    public:
+        ChecksumEngine(int type);
+        ~ChecksumEngine();
+
+        void Update(const char* data, size_t length);
+        bool Update(ValueRef data);
+        Poco::UInt32 GetValue() const;
+        void Reset();
+
+    private:
+        int type;
+        Poco::Checksum* checksum;
+        Poco::UInt32 crc32c;
+
+        DISALLOW_EVIL_CONSTRUCTORS(ChecksumEngine);
+    };
+
+    class ChecksumBinding : public StaticBoundObject
+    {
+    public:
+        ChecksumBinding(int type);
+
+    protected:
+        virtual ~ChecksumBinding();
+
+    private:
+        ChecksumEngine engine;
+
+        void _Update(const ValueList& args, ValueRef result);
+        void _GetValue(const ValueList& args, ValueRef result);
+        void _Reset(const ValueList& args, ValueRef result);
+
+        DISALLOW_EVIL_CONSTRUCTORS(ChecksumBinding);
+    };
+}
+
+#endif
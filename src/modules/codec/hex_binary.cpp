@@ -0,0 +1,303 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "hex_binary.h"
+#include "cpu_features.h"
+
+#ifdef CODEC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace ti
+{
+namespace HexBinary
+{
+    static const char DIGITS[] = "0123456789abcdef";
+
+    // Decoding table entries which are not digit values.
+    static const signed char INVALID = -1;
+    static const signed char WHITESPACE = -2;
+
+    static signed char table[256];
+
+    static bool BuildTable()
+    {
+        for (int i = 0; i < 256; i++)
+            table[i] = INVALID;
+        for (int i = 0; i < 10; i++)
+            table['0' + i] = (signed char) i;
+        for (int i = 0; i < 6; i++)
+        {
+            table['a' + i] = (signed char) (10 + i);
+            table['A' + i] = (signed char) (10 + i);
+        }
+        table[(unsigned char) ' '] = WHITESPACE;
+        table[(unsigned char) '\t'] = WHITESPACE;
+        table[(unsigned char) '\r'] = WHITESPACE;
+        table[(unsigned char) '\n'] = WHITESPACE;
+        return true;
+    }
+
+    static bool tableBuilt = BuildTable();
+
+#ifdef CODEC_X86_SIMD
+    CODEC_TARGET("ssse3")
+    static size_t EncodeSSSE3(const unsigned char* in, size_t length, char* out)
+    {
+        const __m128i digits = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(DIGITS));
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+
+        size_t done = 0;
+        for (; length - done >= 16; done += 16, out += 32)
+        {
+            __m128i bytes = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(in + done));
+            __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+            __m128i low = _mm_and_si128(bytes, nibble);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                _mm_shuffle_epi8(digits, _mm_unpacklo_epi8(high, low)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                _mm_shuffle_epi8(digits, _mm_unpackhi_epi8(high, low)));
+        }
+        return done;
+    }
+
+    CODEC_TARGET("avx2")
+    static size_t EncodeAVX2(const unsigned char* in, size_t length, char* out)
+    {
+        const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(DIGITS)));
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+        size_t done = 0;
+        for (; length - done >= 32; done += 32, out += 64)
+        {
+            __m256i bytes = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(in + done));
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+            __m256i low = _mm256_and_si256(bytes, nibble);
+
+            // Unpacking works within each lane, so these hold input bytes
+            // 0-7 and 16-23, then 8-15 and 24-31.
+            __m256i first = _mm256_shuffle_epi8(digits,
+                _mm256_unpacklo_epi8(high, low));
+            __m256i second = _mm256_shuffle_epi8(digits,
+                _mm256_unpackhi_epi8(high, low));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                _mm256_permute2x128_si256(first, second, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32),
+                _mm256_permute2x128_si256(first, second, 0x31));
+        }
+        return done;
+    }
+
+    // Turn 16 hex digits into their values, or return false if any of
+    // them is something else.
+    CODEC_TARGET("ssse3")
+    static inline bool TranslateSSSE3(__m128i& chars)
+    {
+        __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+        __m128i isDigit = _mm_and_si128(
+            _mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)),
+            _mm_cmpgt_epi8(_mm_set1_epi8(10), digit));
+        __m128i letter = _mm_sub_epi8(
+            _mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        __m128i isLetter = _mm_and_si128(
+            _mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)),
+            _mm_cmpgt_epi8(_mm_set1_epi8(6), letter));
+        if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xffff)
+            return false;
+
+        chars = _mm_or_si128(_mm_and_si128(isDigit, digit),
+            _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+        return true;
+    }
+
+    CODEC_TARGET("ssse3")
+    static size_t DecodeSSSE3(const unsigned char* in, size_t length,
+        unsigned char* out, size_t& written)
+    {
+        // Combine each pair of digits as high * 16 + low.
+        const __m128i weights = _mm_set1_epi16(0x0110);
+
+        size_t done = 0;
+        written = 0;
+        while (length - done >= 32)
+        {
+            __m128i first = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(in + done));
+            __m128i second = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(in + done + 16));
+            if (!TranslateSSSE3(first) || !TranslateSSSE3(second))
+                break;
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written),
+                _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                _mm_maddubs_epi16(second, weights)));
+            done += 32;
+            written += 16;
+        }
+        return done;
+    }
+
+    CODEC_TARGET("avx2")
+    static inline bool TranslateAVX2(__m256i& chars)
+    {
+        __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+        __m256i isDigit = _mm256_and_si256(
+            _mm256_cmpgt_epi8(digit, _mm256_set1_epi8(-1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(10), digit));
+        __m256i letter = _mm256_sub_epi8(
+            _mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+            _mm256_set1_epi8('a'));
+        __m256i isLetter = _mm256_and_si256(
+            _mm256_cmpgt_epi8(letter, _mm256_set1_epi8(-1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(6), letter));
+        if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter)) != -1)
+            return false;
+
+        chars = _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+            _mm256_and_si256(isLetter,
+            _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+        return true;
+    }
+
+    CODEC_TARGET("avx2")
+    static size_t DecodeAVX2(const unsigned char* in, size_t length,
+        unsigned char* out, size_t& written)
+    {
+        const __m256i weights = _mm256_set1_epi16(0x0110);
+
+        size_t done = 0;
+        written = 0;
+        while (length - done >= 64)
+        {
+            __m256i first = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(in + done));
+            __m256i second = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(in + done + 32));
+            if (!TranslateAVX2(first) || !TranslateAVX2(second))
+                break;
+
+            // Packing also works within each lane, so put the four
+            // quarters back in order afterwards.
+            __m256i bytes = _mm256_packus_epi16(
+                _mm256_maddubs_epi16(first, weights),
+                _mm256_maddubs_epi16(second, weights));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + written),
+                _mm256_permute4x64_epi64(bytes, 0xd8));
+            done += 64;
+            written += 32;
+        }
+        return done;
+    }
+#endif
+
+    void Encode(const char* data, size_t length, char* out)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+
+        size_t done = 0;
+#ifdef CODEC_X86_SIMD
+        CPUFeatures::SIMDLevel level = CPUFeatures::GetSIMDLevel();
+        if (level >= CPUFeatures::AVX2)
+            done = EncodeAVX2(in, length, out);
+        if (level >= CPUFeatures::SSSE3)
+            done += EncodeSSSE3(in + done, length - done, out + done * 2);
+#endif
+
+        for (out += done * 2; done < length; done++)
+        {
+            *out++ = DIGITS[in[done] >> 4];
+            *out++ = DIGITS[in[done] & 0x0f];
+        }
+    }
+
+    bool Decode(const char* data, size_t length, char* outData,
+        size_t& outLength)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = in + length;
+        unsigned char* out = reinterpret_cast<unsigned char*>(outData);
+
+#ifdef CODEC_X86_SIMD
+        CPUFeatures::SIMDLevel level = CPUFeatures::GetSIMDLevel();
+#endif
+
+        unsigned int high = 0;
+        bool haveHigh = false;
+        while (in < end)
+        {
+#ifdef CODEC_X86_SIMD
+            size_t written;
+            if (level >= CPUFeatures::AVX2)
+            {
+                in += DecodeAVX2(in, end - in, out, written);
+                out += written;
+            }
+            if (level >= CPUFeatures::SSSE3)
+            {
+                in += DecodeSSSE3(in, end - in, out, written);
+                out += written;
+            }
+#endif
+
+            // Handle at least the block the kernels stopped at and finish
+            // the current pair, so they can pick up again.
+            const unsigned char* stop = in + 32;
+            while (in < end && (in < stop || haveHigh))
+            {
+                signed char value = table[*in++];
+                if (value == WHITESPACE)
+                    continue;
+                if (value < 0)
+                    return false;
+
+                if (haveHigh)
+                    *out++ = (unsigned char) ((high << 4) | value);
+                else
+                    high = value;
+                haveHigh = !haveHigh;
+            }
+        }
+
+        if (haveHigh)
+            return false;
+
+        outLength = out - reinterpret_cast<unsigned char*>(outData);
+        return true;
+    }
+}
+}
@@ -32,27 +32,34 @@
 * limitations under the License.
 **/
 
-#ifndef _PROFILED_GLOBAL_OBJECT_H_
-#define _PROFILED_GLOBAL_OBJECT_H_
+#ifndef _HEX_BINARY_H_
+#define _HEX_BINARY_H_
 
-namespace tide
+#include <cstddef>
+
+namespace ti
 {
-    class TIDE_API ProfiledGlobalObject : public GlobalObject
+    /**
+     * Lowercase hexadecimal encoding over plain buffers, with SSSE3 and
+     * AVX2 kernels chosen at runtime like Base64's.
+     */
+    namespace HexBinary
     {
-    public:
-        ProfiledGlobalObject(TiObjectRef delegate);
-        virtual ~ProfiledGlobalObject();
-
-        virtual void Set(const char *name, ValueRef value);
-        virtual ValueRef Get(const char *name);
-        virtual SharedStringList GetPropertyNames();
-        virtual SharedString DisplayString(int levels=3);
-        virtual bool Equals(TiObjectRef other);
-        bool HasProperty(const char* name);
+        /**
+         * Encode data without line breaks. The output must have room for
+         * 2 * length characters; it is not terminated.
+         */
+        void Encode(const char* data, size_t length, char* out);
 
-    protected:
-        AutoPtr<ProfiledBoundObject> profiledObject;
-    };
+        /**
+         * Decode upper or lowercase hex digits, skipping whitespace.
+         * @param out Room for length / 2 bytes
+         * @param outLength Set to the number of bytes written
+         * @return false on any other character or an odd number of digits
+         */
+        bool Decode(const char* data, size_t length, char* out,
+            size_t& outLength);
+    }
 }
 
 #endif
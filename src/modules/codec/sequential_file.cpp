@@ -0,0 +1,167 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+#include <malloc.h>
+#else
+#include <tideutils/posix/posix_utils.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+#include "sequential_file.h"
+
+namespace ti
+{
+    // Aligning to a page keeps every read a whole number of pages, which
+    // lets the kernel copy straight out of its page cache.
+    static const size_t BUFFER_ALIGNMENT = 4096;
+
+    static char* AllocateAligned(size_t size)
+    {
+#ifdef OS_WIN32
+        return static_cast<char*>(_aligned_malloc(size, BUFFER_ALIGNMENT));
+#else
+        void* memory = 0;
+        if (posix_memalign(&memory, BUFFER_ALIGNMENT, size) != 0)
+            return 0;
+        return static_cast<char*>(memory);
+#endif
+    }
+
+    static void FreeAligned(char* memory)
+    {
+#ifdef OS_WIN32
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    SequentialFile::SequentialFile(const std::string& path, size_t bufferSize) :
+        path(path),
+        buffer(0),
+        bufferSize(bufferSize),
+        size(0)
+    {
+#ifdef OS_WIN32
+        this->handle = CreateFileW(UTF8ToWide(path).c_str(), GENERIC_READ,
+            FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (this->handle == INVALID_HANDLE_VALUE)
+            throw ValueException::FromFormat("Could not open %s", path.c_str());
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(this->handle, &fileSize))
+            this->size = fileSize.QuadPart;
+#else
+        this->descriptor = open(UTF8ToSystem(path).c_str(), O_RDONLY);
+        if (this->descriptor < 0)
+        {
+            throw ValueException::FromFormat("Could not open %s: %s",
+                path.c_str(), strerror(errno));
+        }
+
+        struct stat info;
+        if (fstat(this->descriptor, &info) == 0)
+            this->size = info.st_size;
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(this->descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+        fcntl(this->descriptor, F_RDAHEAD, 1);
+#endif
+#endif
+
+        this->buffer = AllocateAligned(bufferSize);
+        if (!this->buffer)
+        {
+#ifdef OS_WIN32
+            CloseHandle(this->handle);
+#else
+            close(this->descriptor);
+#endif
+            throw ValueException::FromString("Could not allocate a read buffer");
+        }
+    }
+
+    SequentialFile::~SequentialFile()
+    {
+#ifdef OS_WIN32
+        CloseHandle(this->handle);
+#else
+        close(this->descriptor);
+#endif
+        FreeAligned(this->buffer);
+    }
+
+    size_t SequentialFile::Read()
+    {
+        // Fill the whole buffer when we can, so callers see as few
+        // (and as large) chunks as possible.
+        size_t total = 0;
+        while (total < this->bufferSize)
+        {
+#ifdef OS_WIN32
+            DWORD count = 0;
+            if (!ReadFile(this->handle, this->buffer + total,
+                (DWORD) (this->bufferSize - total), &count, NULL))
+            {
+                throw ValueException::FromFormat("Could not read %s",
+                    this->path.c_str());
+            }
+#else
+            ssize_t count = read(this->descriptor, this->buffer + total,
+                this->bufferSize - total);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw ValueException::FromFormat("Could not read %s: %s",
+                    this->path.c_str(), strerror(errno));
+            }
+#endif
+            if (count == 0)
+                break;
+            total += count;
+        }
+        return total;
+    }
+}
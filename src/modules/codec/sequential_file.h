@@ -0,0 +1,91 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _SEQUENTIAL_FILE_H_
+#define _SEQUENTIAL_FILE_H_
+
+#include <tide/tide.h>
+#include <Poco/Types.h>
+
+#ifdef OS_WIN32
+#include <windows.h>
+#endif
+
+namespace ti
+{
+    /**
+     * Reads a file from start to finish in large chunks, straight into a
+     * page-aligned buffer and bypassing the C++ stream layer. The
+     * operating system is told the access is sequential so that it
+     * can read ahead aggressively.
+     */
+    class SequentialFile
+    {
+    public:
+        static const size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+        /**
+         * Open a file for reading, throwing a ValueException on failure.
+         * @param path The UTF-8 path of the file
+         * @param bufferSize The most data returned by one Read()
+         */
+        SequentialFile(const std::string& path,
+            size_t bufferSize = DEFAULT_BUFFER_SIZE);
+        ~SequentialFile();
+
+        /**
+         * Read the next chunk of the file into the buffer.
+         * @return the number of bytes read, or 0 at the end of the file
+         */
+        size_t Read();
+
+        const char* GetBuffer() const { return buffer; }
+        Poco::UInt64 GetSize() const { return size; }
+
+    private:
+        std::string path;
+        char* buffer;
+        size_t bufferSize;
+        Poco::UInt64 size;
+#ifdef OS_WIN32
+        HANDLE handle;
+#else
+        int descriptor;
+#endif
+
+        DISALLOW_EVIL_CONSTRUCTORS(SequentialFile);
+    };
+}
+
+#endif
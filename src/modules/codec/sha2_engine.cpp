@@ -0,0 +1,374 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "sha2_engine.h"
+#include <cstring>
+
+#if defined(_MSC_VER)
+#define U64(x) x##ui64
+#else
+#define U64(x) x##ULL
+#endif
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+namespace ti
+{
+    static const Poco::UInt32 SHA256_K[64] =
+    {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+        0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+        0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+        0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+        0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    static const Poco::UInt64 SHA512_K[80] =
+    {
+        U64(0x428a2f98d728ae22), U64(0x7137449123ef65cd),
+        U64(0xb5c0fbcfec4d3b2f), U64(0xe9b5dba58189dbbc),
+        U64(0x3956c25bf348b538), U64(0x59f111f1b605d019),
+        U64(0x923f82a4af194f9b), U64(0xab1c5ed5da6d8118),
+        U64(0xd807aa98a3030242), U64(0x12835b0145706fbe),
+        U64(0x243185be4ee4b28c), U64(0x550c7dc3d5ffb4e2),
+        U64(0x72be5d74f27b896f), U64(0x80deb1fe3b1696b1),
+        U64(0x9bdc06a725c71235), U64(0xc19bf174cf692694),
+        U64(0xe49b69c19ef14ad2), U64(0xefbe4786384f25e3),
+        U64(0x0fc19dc68b8cd5b5), U64(0x240ca1cc77ac9c65),
+        U64(0x2de92c6f592b0275), U64(0x4a7484aa6ea6e483),
+        U64(0x5cb0a9dcbd41fbd4), U64(0x76f988da831153b5),
+        U64(0x983e5152ee66dfab), U64(0xa831c66d2db43210),
+        U64(0xb00327c898fb213f), U64(0xbf597fc7beef0ee4),
+        U64(0xc6e00bf33da88fc2), U64(0xd5a79147930aa725),
+        U64(0x06ca6351e003826f), U64(0x142929670a0e6e70),
+        U64(0x27b70a8546d22ffc), U64(0x2e1b21385c26c926),
+        U64(0x4d2c6dfc5ac42aed), U64(0x53380d139d95b3df),
+        U64(0x650a73548baf63de), U64(0x766a0abb3c77b2a8),
+        U64(0x81c2c92e47edaee6), U64(0x92722c851482353b),
+        U64(0xa2bfe8a14cf10364), U64(0xa81a664bbc423001),
+        U64(0xc24b8b70d0f89791), U64(0xc76c51a30654be30),
+        U64(0xd192e819d6ef5218), U64(0xd69906245565a910),
+        U64(0xf40e35855771202a), U64(0x106aa07032bbd1b8),
+        U64(0x19a4c116b8d2d0c8), U64(0x1e376c085141ab53),
+        U64(0x2748774cdf8eeb99), U64(0x34b0bcb5e19b48a8),
+        U64(0x391c0cb3c5c95a63), U64(0x4ed8aa4ae3418acb),
+        U64(0x5b9cca4f7763e373), U64(0x682e6ff3d6b2b8a3),
+        U64(0x748f82ee5defb2fc), U64(0x78a5636f43172f60),
+        U64(0x84c87814a1f0ab72), U64(0x8cc702081a6439ec),
+        U64(0x90befffa23631e28), U64(0xa4506cebde82bde9),
+        U64(0xbef9a3f7b2c67915), U64(0xc67178f2e372532b),
+        U64(0xca273eceea26619c), U64(0xd186b8c721c0c207),
+        U64(0xeada7dd6cde0eb1e), U64(0xf57d4f7fee6ed178),
+        U64(0x06f067aa72176fba), U64(0x0a637dc5a2c898a6),
+        U64(0x113f9804bef90dae), U64(0x1b710b35131c471b),
+        U64(0x28db77f523047d84), U64(0x32caab7b40c72493),
+        U64(0x3c9ebe0a15c9bebc), U64(0x431d67c49c100d4c),
+        U64(0x4cc5d4becb3e42b6), U64(0x597f299cfc657e2a),
+        U64(0x5fcb6fab3ad6faec), U64(0x6c44198c4a475817)
+    };
+
+    static inline Poco::UInt32 ReadUInt32(const unsigned char* p)
+    {
+        return ((Poco::UInt32) p[0] << 24) | ((Poco::UInt32) p[1] << 16)
+            | ((Poco::UInt32) p[2] << 8) | (Poco::UInt32) p[3];
+    }
+
+    static inline Poco::UInt64 ReadUInt64(const unsigned char* p)
+    {
+        return ((Poco::UInt64) ReadUInt32(p) << 32) | ReadUInt32(p + 4);
+    }
+
+    static inline void WriteUInt32(unsigned char* p, Poco::UInt32 value)
+    {
+        p[0] = (unsigned char) (value >> 24);
+        p[1] = (unsigned char) (value >> 16);
+        p[2] = (unsigned char) (value >> 8);
+        p[3] = (unsigned char) value;
+    }
+
+    static inline void WriteUInt64(unsigned char* p, Poco::UInt64 value)
+    {
+        WriteUInt32(p, (Poco::UInt32) (value >> 32));
+        WriteUInt32(p + 4, (Poco::UInt32) value);
+    }
+
+    // Both algorithms buffer partial blocks the same way, so share the
+    // code which feeds whole blocks to Transform.
+    template <typename Engine>
+    void FeedBlocks(Engine* engine, const unsigned char* data, unsigned length)
+    {
+        unsigned char* buffer = engine->buffer;
+        unsigned& bufferLength = engine->bufferLength;
+        const unsigned blockSize = Engine::BLOCK_SIZE;
+
+        if (bufferLength > 0)
+        {
+            unsigned count = blockSize - bufferLength;
+            if (count > length)
+                count = length;
+            memcpy(buffer + bufferLength, data, count);
+            bufferLength += count;
+            data += count;
+            length -= count;
+
+            if (bufferLength < blockSize)
+                return;
+            engine->Transform(buffer);
+            bufferLength = 0;
+        }
+
+        // Hash whole blocks straight out of the caller's memory.
+        while (length >= blockSize)
+        {
+            engine->Transform(data);
+            data += blockSize;
+            length -= blockSize;
+        }
+
+        if (length > 0)
+        {
+            memcpy(buffer, data, length);
+            bufferLength = length;
+        }
+    }
+
+    SHA256Engine::SHA256Engine() :
+        result(DIGEST_SIZE)
+    {
+        reset();
+    }
+
+    SHA256Engine::~SHA256Engine()
+    {
+        reset();
+    }
+
+    unsigned SHA256Engine::digestLength() const
+    {
+        return DIGEST_SIZE;
+    }
+
+    void SHA256Engine::reset()
+    {
+        state[0] = 0x6a09e667;
+        state[1] = 0xbb67ae85;
+        state[2] = 0x3c6ef372;
+        state[3] = 0xa54ff53a;
+        state[4] = 0x510e527f;
+        state[5] = 0x9b05688c;
+        state[6] = 0x1f83d9ab;
+        state[7] = 0x5be0cd19;
+        length = 0;
+        bufferLength = 0;
+        memset(buffer, 0, sizeof(buffer));
+    }
+
+    void SHA256Engine::updateImpl(const void* data, unsigned count)
+    {
+        length += count;
+        FeedBlocks(this, static_cast<const unsigned char*>(data), count);
+    }
+
+    void SHA256Engine::Transform(const unsigned char* block)
+    {
+        Poco::UInt32 w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = ReadUInt32(block + i * 4);
+        for (int i = 16; i < 64; i++)
+        {
+            Poco::UInt32 s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            Poco::UInt32 s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        Poco::UInt32 a = state[0], b = state[1], c = state[2], d = state[3];
+        Poco::UInt32 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++)
+        {
+            Poco::UInt32 S1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+            Poco::UInt32 ch = (e & f) ^ (~e & g);
+            Poco::UInt32 t1 = h + S1 + ch + SHA256_K[i] + w[i];
+            Poco::UInt32 S0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+            Poco::UInt32 maj = (a & b) ^ (a & c) ^ (b & c);
+            Poco::UInt32 t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    const Poco::DigestEngine::Digest& SHA256Engine::digest()
+    {
+        Poco::UInt64 bits = length * 8;
+
+        // Pad with a one bit, zeros and the big-endian bit length so that
+        // the message fills a whole number of blocks.
+        unsigned char padding[BLOCK_SIZE + 8];
+        unsigned padLength = (bufferLength < 56 ? 56 : 120) - bufferLength;
+        memset(padding, 0, sizeof(padding));
+        padding[0] = 0x80;
+        WriteUInt64(padding + padLength, bits);
+        FeedBlocks(this, padding, padLength + 8);
+
+        for (int i = 0; i < 8; i++)
+            WriteUInt32(&result[i * 4], state[i]);
+
+        reset();
+        return result;
+    }
+
+    SHA512Engine::SHA512Engine() :
+        result(DIGEST_SIZE)
+    {
+        reset();
+    }
+
+    SHA512Engine::~SHA512Engine()
+    {
+        reset();
+    }
+
+    unsigned SHA512Engine::digestLength() const
+    {
+        return DIGEST_SIZE;
+    }
+
+    void SHA512Engine::reset()
+    {
+        state[0] = U64(0x6a09e667f3bcc908);
+        state[1] = U64(0xbb67ae8584caa73b);
+        state[2] = U64(0x3c6ef372fe94f82b);
+        state[3] = U64(0xa54ff53a5f1d36f1);
+        state[4] = U64(0x510e527fade682d1);
+        state[5] = U64(0x9b05688c2b3e6c1f);
+        state[6] = U64(0x1f83d9abfb41bd6b);
+        state[7] = U64(0x5be0cd19137e2179);
+        length = 0;
+        bufferLength = 0;
+        memset(buffer, 0, sizeof(buffer));
+    }
+
+    void SHA512Engine::updateImpl(const void* data, unsigned count)
+    {
+        length += count;
+        FeedBlocks(this, static_cast<const unsigned char*>(data), count);
+    }
+
+    void SHA512Engine::Transform(const unsigned char* block)
+    {
+        Poco::UInt64 w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = ReadUInt64(block + i * 8);
+        for (int i = 16; i < 80; i++)
+        {
+            Poco::UInt64 s0 = ROTR64(w[i - 15], 1) ^ ROTR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+            Poco::UInt64 s1 = ROTR64(w[i - 2], 19) ^ ROTR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        Poco::UInt64 a = state[0], b = state[1], c = state[2], d = state[3];
+        Poco::UInt64 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 80; i++)
+        {
+            Poco::UInt64 S1 = ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41);
+            Poco::UInt64 ch = (e & f) ^ (~e & g);
+            Poco::UInt64 t1 = h + S1 + ch + SHA512_K[i] + w[i];
+            Poco::UInt64 S0 = ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39);
+            Poco::UInt64 maj = (a & b) ^ (a & c) ^ (b & c);
+            Poco::UInt64 t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    const Poco::DigestEngine::Digest& SHA512Engine::digest()
+    {
+        // The length field is 128 bits wide; its top half only holds
+        // the bits shifted out of the byte count.
+        unsigned char padding[BLOCK_SIZE + 16];
+        unsigned padLength = (bufferLength < 112 ? 112 : 240) - bufferLength;
+        memset(padding, 0, sizeof(padding));
+        padding[0] = 0x80;
+        WriteUInt64(padding + padLength, length >> 61);
+        WriteUInt64(padding + padLength + 8, length << 3);
+        FeedBlocks(this, padding, padLength + 16);
+
+        for (int i = 0; i < 8; i++)
+            WriteUInt64(&result[i * 8], state[i]);
+
+        reset();
+        return result;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _SHA2_ENGINE_H_
+#define _SHA2_ENGINE_H_
+
+#include <Poco/DigestEngine.h>
+#include <Poco/Types.h>
+
+namespace ti
+{
+    /**
+     * SHA-256 (FIPS 180-2) as a Poco DigestEngine, which the version
+     * of Poco we bundle does not provide. Like Poco's own engines,
+     * digest() returns the final value and resets the engine.
+     */
+    class SHA256Engine : public Poco::DigestEngine
+    {
+    public:
+        enum
+        {
+            BLOCK_SIZE = 64,
+            DIGEST_SIZE = 32
+        };
+
+        SHA256Engine();
+        virtual ~SHA256Engine();
+
+        unsigned digestLength() const;
+        void reset();
+        const Poco::DigestEngine::Digest& digest();
+
+    protected:
+        void updateImpl(const void* data, unsigned length);
+
+    private:
+        template <typename Engine>
+        friend void FeedBlocks(Engine*, const unsigned char*, unsigned);
+        void Transform(const unsigned char* block);
+
+        Poco::UInt32 state[8];
+        Poco::UInt64 length;
+        unsigned char buffer[BLOCK_SIZE];
+        unsigned bufferLength;
+        Poco::DigestEngine::Digest result;
+
+        SHA256Engine(const SHA256Engine&);
+        SHA256Engine& operator=(const SHA256Engine&);
+    };
+
+    /**
+     * SHA-512 (FIPS 180-2) as a Poco DigestEngine.
+     */
+    class SHA512Engine : public Poco::DigestEngine
+    {
+    public:
+        enum
+        {
+            BLOCK_SIZE = 128,
+            DIGEST_SIZE = 64
+        };
+
+        SHA512Engine();
+        virtual ~SHA512Engine();
+
+        unsigned digestLength() const;
+        void reset();
+        const Poco::DigestEngine::Digest& digest();
+
+    protected:
+        void updateImpl(const void* data, unsigned length);
+
+    private:
+        template <typename Engine>
+        friend void FeedBlocks(Engine*, const unsigned char*, unsigned);
+        void Transform(const unsigned char* block);
+
+        Poco::UInt64 state[8];
+        Poco::UInt64 length;
+        unsigned char buffer[BLOCK_SIZE];
+        unsigned bufferLength;
+        Poco::DigestEngine::Digest result;
+
+        SHA512Engine(const SHA512Engine&);
+        SHA512Engine& operator=(const SHA512Engine&);
+    };
+}
+
+#endif
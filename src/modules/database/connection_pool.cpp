@@ -0,0 +1,239 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include <tide/tide.h>
+#include "connection_pool.h"
+#include <Poco/File.h>
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+// Prepared statements kept per connection. Scripts tend to reuse a small
+// set of queries, so this is enough for them to be compiled only once.
+#define STATEMENT_CACHE_SIZE 64
+
+// Idle connections kept per database path.
+#define MAX_IDLE_CONNECTIONS 4
+
+// How long a connection waits for another one to finish writing.
+#define BUSY_TIMEOUT_MS 10000
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        static Logger* logger = Logger::Get("Database.ConnectionPool");
+        return logger;
+    }
+
+    static std::string ReadPragmaValue(TiObjectRef options, const char* name,
+        const std::string& defaultValue, const char** allowed)
+    {
+        std::string value(options->GetString(name, defaultValue));
+        std::transform(value.begin(), value.end(), value.begin(), ::toupper);
+        if (value.empty())
+            return value;
+
+        // These end up in the text of a PRAGMA statement, so only
+        // take the values sqlite knows.
+        for (int i = 0; allowed[i]; i++)
+        {
+            if (value == allowed[i])
+                return value;
+        }
+        throw ValueException::FromFormat("Invalid value for %s: %s",
+            name, value.c_str());
+    }
+
+    /*static*/
+    ConnectionSettings ConnectionSettings::Defaults()
+    {
+        ConnectionSettings settings;
+        settings.journalMode = "WAL";
+        settings.synchronous = "NORMAL";
+        return settings;
+    }
+
+    void ConnectionSettings::Read(TiObjectRef options)
+    {
+        static const char* journalModes[] =
+            { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF", 0 };
+        static const char* synchronousModes[] =
+            { "OFF", "NORMAL", "FULL", "EXTRA", 0 };
+
+        journalMode = ReadPragmaValue(options, "journalMode", journalMode, journalModes);
+        synchronous = ReadPragmaValue(options, "synchronous", synchronous, synchronousModes);
+        cacheSize = options->GetInt("cacheSize", cacheSize);
+    }
+
+    bool ConnectionSettings::operator==(const ConnectionSettings& other) const
+    {
+        return journalMode == other.journalMode &&
+            synchronous == other.synchronous &&
+            cacheSize == other.cacheSize;
+    }
+
+    Connection::Connection(const std::string& path) :
+        path(path),
+        db(0),
+        statements(0),
+        generation(0)
+    {
+        if (sqlite3_open(path.c_str(), &db) != SQLITE_OK)
+        {
+            std::string error(sqlite3_errmsg(db));
+            sqlite3_close(db);
+            throw ValueException::FromFormat("Could not open database %s: %s",
+                path.c_str(), error.c_str());
+        }
+
+        sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+        statements = new StatementCache(db, STATEMENT_CACHE_SIZE);
+    }
+
+    Connection::~Connection()
+    {
+        delete statements;
+        sqlite3_close(db);
+    }
+
+    void Connection::Configure(const ConnectionSettings& newSettings)
+    {
+        if (newSettings == settings)
+            return;
+
+        std::ostringstream pragmas;
+        if (!newSettings.journalMode.empty() &&
+            newSettings.journalMode != settings.journalMode)
+            pragmas << "PRAGMA journal_mode=" << newSettings.journalMode << ";";
+        if (!newSettings.synchronous.empty() &&
+            newSettings.synchronous != settings.synchronous)
+            pragmas << "PRAGMA synchronous=" << newSettings.synchronous << ";";
+        if (newSettings.cacheSize && newSettings.cacheSize != settings.cacheSize)
+            pragmas << "PRAGMA cache_size=" << newSettings.cacheSize << ";";
+
+        std::string sql(pragmas.str());
+        char* error = 0;
+        if (!sql.empty() && sqlite3_exec(db, sql.c_str(), 0, 0, &error) != SQLITE_OK)
+        {
+            // The database stays usable with sqlite's defaults.
+            GetLogger()->Warn("Could not configure %s: %s", path.c_str(),
+                error ? error : sqlite3_errmsg(db));
+            sqlite3_free(error);
+        }
+        settings = newSettings;
+    }
+
+    /*static*/
+    ConnectionPool* ConnectionPool::GetInstance()
+    {
+        static ConnectionPool* instance = new ConnectionPool();
+        return instance;
+    }
+
+    Connection* ConnectionPool::Acquire(const std::string& path,
+        const ConnectionSettings& settings)
+    {
+        Connection* connection = 0;
+        unsigned int generation;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            generation = generations[path];
+            std::vector<Connection*>& connections = idle[path];
+            if (!connections.empty())
+            {
+                connection = connections.back();
+                connections.pop_back();
+            }
+        }
+
+        if (!connection)
+        {
+            connection = new Connection(path);
+            connection->generation = generation;
+        }
+
+        connection->Configure(settings);
+        return connection;
+    }
+
+    void ConnectionPool::Release(Connection* connection)
+    {
+        if (!sqlite3_get_autocommit(connection->GetHandle()))
+        {
+            GetLogger()->Warn("Rolling back unfinished transaction on %s",
+                connection->GetPath().c_str());
+            sqlite3_exec(connection->GetHandle(), "ROLLBACK", 0, 0, 0);
+        }
+
+        {
+            // A connection which was busy when its database was
+            // removed still has the deleted file open.
+            Poco::FastMutex::ScopedLock lock(mutex);
+            std::vector<Connection*>& connections = idle[connection->GetPath()];
+            if (connection->generation == generations[connection->GetPath()] &&
+                connections.size() < MAX_IDLE_CONNECTIONS)
+            {
+                connections.push_back(connection);
+                return;
+            }
+        }
+        delete connection;
+    }
+
+    void ConnectionPool::Remove(const std::string& path)
+    {
+        std::vector<Connection*> connections;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            connections.swap(idle[path]);
+            idle.erase(path);
+            generations[path]++;
+        }
+
+        for (size_t i = 0; i < connections.size(); i++)
+            delete connections[i];
+
+        const char* suffixes[] = { "", "-wal", "-shm", "-journal", 0 };
+        for (int i = 0; suffixes[i]; i++)
+        {
+            Poco::File file(path + suffixes[i]);
+            if (file.exists() && file.canWrite())
+            {
+                GetLogger()->Debug("Removing database file: %s", file.path().c_str());
+                file.remove();
+            }
+        }
+    }
+}
@@ -0,0 +1,171 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _DATABASE_CONNECTION_POOL_H_
+#define _DATABASE_CONNECTION_POOL_H_
+
+#include <tide/tide.h>
+#include <map>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <sqlite3.h>
+#include "statement_cache.h"
+
+namespace ti
+{
+    /**
+     * The pragmas applied to a pooled connection. Empty or zero fields
+     * leave sqlite's (or the database file's) own setting alone.
+     */
+    struct ConnectionSettings
+    {
+        ConnectionSettings() : cacheSize(0) {}
+
+        /**
+         * The settings Database.openFile uses unless told otherwise.
+         * Database.open leaves WebKit's databases as they are. The defaults
+         * are WAL, so that readers and a writer on different
+         * connections do not block each other, and NORMAL synchronous,
+         * which is still safe against corruption in WAL mode.
+         */
+        static ConnectionSettings Defaults();
+
+        /**
+         * Read journalMode, synchronous and cacheSize from a script
+         * options object over these settings. Throws a ValueException
+         * for values sqlite does not accept.
+         */
+        void Read(TiObjectRef options);
+
+        bool operator==(const ConnectionSettings& other) const;
+
+        std::string journalMode;
+        std::string synchronous;
+        int cacheSize;
+    };
+
+    /**
+     * An open sqlite database and the prepared statements kept for it.
+     */
+    class Connection
+    {
+    public:
+        Connection(const std::string& path);
+        ~Connection();
+
+        sqlite3* GetHandle() { return db; }
+        StatementCache* GetStatements() { return statements; }
+        const std::string& GetPath() { return path; }
+
+        /**
+         * Apply the pragmas in settings which differ from the ones
+         * this connection was last configured with.
+         */
+        void Configure(const ConnectionSettings& settings);
+
+    private:
+        friend class ConnectionPool;
+
+        std::string path;
+        sqlite3* db;
+        StatementCache* statements;
+        ConnectionSettings settings;
+        unsigned int generation;
+    };
+
+    /**
+     * Keeps connections to each database path open after they are
+     * released, so that opening a database again, or running a query
+     * on another thread, skips opening the file and compiling statements.
+     */
+    class ConnectionPool
+    {
+    public:
+        static ConnectionPool* GetInstance();
+
+        /**
+         * Get a connection to path which only the caller uses until it
+         * is released. Throws a ValueException if it can not be opened.
+         */
+        Connection* Acquire(const std::string& path,
+            const ConnectionSettings& settings = ConnectionSettings());
+
+        /**
+         * Give a connection back to the pool. An unfinished transaction
+         * is rolled back, so the next user starts from a clean state.
+         */
+        void Release(Connection* connection);
+
+        /**
+         * Close the idle connections to path and delete the database
+         * file, along with the write-ahead log and shared memory files
+         * sqlite keeps next to it in WAL mode. Connections which are in
+         * use are closed when they are released.
+         */
+        void Remove(const std::string& path);
+
+    private:
+        ConnectionPool() {}
+
+        Poco::FastMutex mutex;
+        std::map<std::string, std::vector<Connection*> > idle;
+
+        // How many times each path has been removed. Connections opened
+        // before the latest removal are not pooled again.
+        std::map<std::string, unsigned int> generations;
+    };
+
+    /**
+     * A connection from the pool which is released when this goes out
+     * of scope.
+     */
+    class PooledConnection
+    {
+    public:
+        PooledConnection(const std::string& path,
+            const ConnectionSettings& settings = ConnectionSettings()) :
+            connection(ConnectionPool::GetInstance()->Acquire(path, settings)) {}
+        ~PooledConnection() { ConnectionPool::GetInstance()->Release(connection); }
+
+        Connection* operator->() { return connection; }
+        Connection* get() { return connection; }
+
+    private:
+        Connection* connection;
+
+        DISALLOW_EVIL_CONSTRUCTORS(PooledConnection);
+    };
+}
+
+#endif
@@ -37,22 +37,10 @@
 #include "resultset_binding.h"
 #include "webkit_databases.h"
 
-#include <Poco/Data/AbstractBinding.h>
-#include <Poco/Data/RecordSet.h>
-#include <Poco/Data/MetaColumn.h>
-#include <Poco/Data/Statement.h>
-#include <Poco/Data/SessionFactory.h>
-#include <Poco/Data/SQLite/Connector.h>
-#include <Poco/Data/SQLite/SQLiteException.h>
-
-#include <Poco/File.h>
-
-using Poco::Data::Session;
-using Poco::Data::Statement;
-using Poco::Data::RecordSet;
-using Poco::Data::use;
-using Poco::Data::into;
-using Poco::Data::now;
+#include <tide/thread_manager.h>
+#include <tide/thread_pool.h>
+#include <climits>
+#include <sstream>
 
 namespace ti
 {
@@ -62,103 +50,274 @@ namespace ti
         return logger;
     }
 
-    /**
-     * this is a class that manages Value to Data bindings
-     * and manages the memory that needs to be created during the
-     * lifecycle of the Statement and then frees the memory once
-     * this binding is destructed
-     */
-    class ValueBinding
+    static void BindValue(sqlite3* db, sqlite3_stmt* statement, int index, ValueRef arg)
     {
-    public:
-        void convert (Statement &select, ValueRef arg)
+        int rc;
+        if (arg->IsString())
         {
-            if (arg->IsString())
-            {
-                std::string *s = new std::string(arg->ToString()); 
-                select , use(*s);
-                strings.push_back(s);
-            }
-            else if (arg->IsInt())
-            {
-                int *i = new int(arg->ToInt());
-                select , use(*i);
-                ints.push_back(i);
-            }
-            else if (arg->IsDouble())
+            rc = sqlite3_bind_text(statement, index, arg->ToString(), -1,
+                SQLITE_TRANSIENT);
+        }
+        else if (arg->IsInt())
+        {
+            rc = sqlite3_bind_int(statement, index, arg->ToInt());
+        }
+        else if (arg->IsDouble())
+        {
+            rc = sqlite3_bind_double(statement, index, arg->ToDouble());
+        }
+        else if (arg->IsBool())
+        {
+            rc = sqlite3_bind_int(statement, index, arg->ToBool() ? 1 : 0);
+        }
+        else if (arg->IsNull() || arg->IsUndefined())
+        {
+            // Null has always been bound as the string "null", so that
+            // rows inserted with a null argument can be selected with one.
+            rc = sqlite3_bind_text(statement, index, "null", 4, SQLITE_STATIC);
+        }
+        else if (arg->IsObject() && !arg->ToObject().cast<Bytes>().isNull())
+        {
+            BytesRef bytes(arg->ToObject().cast<Bytes>());
+            rc = sqlite3_bind_blob(statement, index, bytes->Pointer(),
+                bytes->Length(), SQLITE_TRANSIENT);
+        }
+        else
+        {
+            throw ValueException::FromFormat("Unsupport type for argument: %s",
+                arg->GetType().c_str());
+        }
+
+        if (rc != SQLITE_OK)
+            throw ValueException::FromString(sqlite3_errmsg(db));
+    }
+
+    // Bind each value in turn. Lists are flattened, so arguments can be
+    // passed either as varargs or as an array.
+    static void BindValues(sqlite3* db, sqlite3_stmt* statement,
+        const ValueList& args, size_t start)
+    {
+        int index = 1;
+        for (size_t c = start; c < args.size(); c++)
+        {
+            ValueRef arg(args.at(c));
+            if (arg->IsList())
             {
-                double *d = new double(arg->ToDouble());
-                select , use(*d);
-                doubles.push_back(d);
+                TiListRef list(arg->ToList());
+                for (size_t a = 0; a < list->Size(); a++)
+                    BindValue(db, statement, index++, list->At(a));
             }
-            else if (arg->IsBool())
+            else
             {
-                bool *b = new bool(arg->ToBool());
-                select , use(*b);
-                bools.push_back(b);
+                BindValue(db, statement, index++, arg);
             }
-            else if (arg->IsNull() || arg->IsUndefined())
+        }
+    }
+
+    static void CopyValue(ValueRef arg, ValueList& copy)
+    {
+        if (arg->IsList() || arg->IsMethod() ||
+            (arg->IsObject() && arg->ToObject().cast<Bytes>().isNull()))
+        {
+            throw ValueException::FromFormat("Unsupport type for argument: %s",
+                arg->GetType().c_str());
+        }
+        copy.push_back(arg);
+    }
+
+    // Flatten args[start, end) as BindValues would and check their types,
+    // so that a worker thread can bind them without touching script objects.
+    static void CopyValues(const ValueList& args, size_t start, size_t end,
+        ValueList& copy)
+    {
+        for (size_t c = start; c < end; c++)
+        {
+            ValueRef arg(args.at(c));
+            if (arg->IsList())
             {
-                // in this case, we bind a null string (dequoted)
-                std::string *s = new std::string("null");
-                select , use(s);
-                strings.push_back(s);
+                TiListRef list(arg->ToList());
+                for (size_t a = 0; a < list->Size(); a++)
+                    CopyValue(list->At(a), copy);
             }
             else
             {
-                throw ValueException::FromFormat("Unsupport type for argument: %s",
-                    arg->GetType().c_str());
+                CopyValue(arg, copy);
             }
-        } 
-        ValueBinding() {}
-        ~ValueBinding()
+        }
+    }
+
+    static void StepToEnd(sqlite3* db, sqlite3_stmt* statement)
+    {
+        int rc;
+        while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {}
+
+        if (rc != SQLITE_DONE)
+            throw ValueException::FromString(sqlite3_errmsg(db));
+    }
+
+    static void ExecuteScript(sqlite3* db, const std::string& sql)
+    {
+        char* error = 0;
+        if (sqlite3_exec(db, sql.c_str(), 0, 0, &error) != SQLITE_OK)
         {
-            if (strings.size()>0)
+            std::string message(error ? error : sqlite3_errmsg(db));
+            sqlite3_free(error);
+            throw ValueException::FromString(message);
+        }
+    }
+
+    static ValueRef RowIdValue(sqlite3_int64 rowId)
+    {
+        if (rowId >= INT_MIN && rowId <= INT_MAX)
+            return Value::NewInt((int) rowId);
+        return Value::NewDouble((double) rowId);
+    }
+
+    // Run sql with the arguments in args from start on and read all of
+    // its rows. Anything after the first statement is run as a plain
+    // script. This is shared by execute and executeAsync, so it only uses
+    // the connection it is given.
+    static TiObjectRef ExecuteStatement(sqlite3* db, StatementCache* statements,
+        const std::string& sql, const ValueList& args, size_t start, int& rowsAffected)
+    {
+        size_t tailOffset;
+        sqlite3_stmt* statement = statements->Acquire(sql, &tailOffset);
+
+        TiObjectRef resultSet;
+        rowsAffected = 0;
+        if (statement)
+        {
+            try
             {
-                std::vector<std::string*>::iterator i = strings.begin();
-                while(i!=strings.end())
+                BindValues(db, statement, args, start);
+                if (sqlite3_column_count(statement) > 0)
                 {
-                    std::string *s = (*i);
-                    delete s;
-                    i++;
+                    AutoPtr<ResultSetBinding> rows(new ResultSetBinding(db, statement));
+                    rowsAffected = rows->GetRowCount();
+                    resultSet = rows;
                 }
-            }
-            if (ints.size()>0)
-            {
-                std::vector<int*>::iterator i = ints.begin();
-                while(i!=ints.end())
+                else
                 {
-                    int *s = (*i);
-                    delete s;
-                    i++;
+                    StepToEnd(db, statement);
+                    rowsAffected = sqlite3_changes(db);
                 }
             }
-            if (doubles.size()>0)
+            catch (ValueException&)
             {
-                std::vector<double*>::iterator i = doubles.begin();
-                while(i!=doubles.end())
-                {
-                    double *s = (*i);
-                    delete s;
-                    i++;
-                }
+                statements->Release(sql, statement);
+                throw;
+            }
+            statements->Release(sql, statement);
+        }
+
+        if (sql.find_first_not_of(" \t\r\n;", tailOffset) != std::string::npos)
+        {
+            ExecuteScript(db, sql.substr(tailOffset));
+            rowsAffected = sqlite3_changes(db);
+        }
+
+        if (resultSet.isNull())
+            resultSet = new ResultSetBinding();
+        return resultSet;
+    }
+
+    static ThreadPool* GetQueryThreadPool()
+    {
+        // Queries get threads of their own, so that a long one does
+        // not hold up the jobs on the host's shared pool.
+        static ThreadPool* pool = new ThreadPool(1, 4);
+        return pool;
+    }
+
+    // Runs on the main thread: update the database's counts and hand the
+    // result of an executeAsync call to its callback.
+    static ValueRef DeliverAsyncResult(const ValueList& args)
+    {
+        TiObjectRef database(args.GetObject(0));
+        TiMethodRef callback(args.GetMethod(1));
+        ValueRef resultSet(args.at(2));
+        ValueRef error(args.at(3));
+
+        if (error->IsUndefined())
+        {
+            database->Set("rowsAffected", args.at(4));
+            database->Set("lastInsertRowId", args.at(5));
+        }
+
+        ValueList callbackArgs;
+        callbackArgs.push_back(resultSet);
+        callbackArgs.push_back(error);
+        callback->Call(callbackArgs);
+        return Value::Undefined;
+    }
+
+    /**
+     * A statement run by executeAsync on one of the query threads, with
+     * a connection of its own from the pool.
+     */
+    class AsyncQuery : public Poco::Runnable
+    {
+    public:
+        AsyncQuery(DatabaseBinding* database, const std::string& path,
+            const ConnectionSettings& settings, const std::string& sql,
+            const ValueList& args, TiMethodRef callback) :
+            database(database, true),
+            path(path),
+            settings(settings),
+            sql(sql),
+            args(args),
+            callback(callback)
+        {
+        }
+
+        void run()
+        {
+            START_TIDE_THREAD;
+
+            ValueRef resultSet(Value::Null);
+            ValueRef error(Value::Undefined);
+            int rowsAffected = 0;
+            sqlite3_int64 lastInsertRowId = 0;
+            try
+            {
+                PooledConnection connection(path, settings);
+                resultSet = Value::NewObject(ExecuteStatement(connection->GetHandle(),
+                    connection->GetStatements(), sql, args, 0, rowsAffected));
+                lastInsertRowId = sqlite3_last_insert_rowid(connection->GetHandle());
             }
-            if (bools.size()>0)
+            catch (ValueException& e)
             {
-                std::vector<bool*>::iterator i = bools.begin();
-                while(i!=bools.end())
-                {
-                    bool *s = (*i);
-                    delete s;
-                    i++;
-                }
+                GetLogger()->Error("Exception executing: %s, Error was: %s", sql.c_str(),
+                    e.ToString().c_str());
+                error = Value::NewString(e.ToString());
             }
+
+            // The callback and database are handed over to the main thread
+            // along with the result, so that they are released there.
+            ValueList deliverArgs;
+            deliverArgs.push_back(Value::NewObject(database));
+            deliverArgs.push_back(Value::NewMethod(callback));
+            deliverArgs.push_back(resultSet);
+            deliverArgs.push_back(error);
+            deliverArgs.push_back(Value::NewInt(rowsAffected));
+            deliverArgs.push_back(RowIdValue(lastInsertRowId));
+            database = 0;
+            callback = 0;
+            args = ValueList();
+
+            RunOnMainThread(new FunctionPtrMethod(&DeliverAsyncResult),
+                deliverArgs, false);
+
+            END_TIDE_THREAD;
         }
+
     private:
-        std::vector<std::string*> strings;
-        std::vector<int*> ints;
-        std::vector<double*> doubles;
-        std::vector<bool*> bools;
+        AutoPtr<DatabaseBinding> database;
+        std::string path;
+        ConnectionSettings settings;
+        std::string sql;
+        ValueList args;
+        TiMethodRef callback;
     };
 
     static WebKitDatabases* GetWebKitDatabases()
@@ -167,12 +326,17 @@ namespace ti
         return databases;
     }
 
-    DatabaseBinding::DatabaseBinding(std::string& name, bool isWebKitDatabase) :
+    DatabaseBinding::DatabaseBinding(std::string& name, bool isWebKitDatabase,
+        const ConnectionSettings& settings) :
         AccessorObject("Database.DB"),
-        session(0),
+        connection(0),
+        db(0),
+        statements(0),
         name(name),
         path(name),
-        isWebKitDatabase(isWebKitDatabase)
+        isWebKitDatabase(isWebKitDatabase),
+        settings(settings),
+        savepointCount(0)
     {
         /**
          * @tiapi(method=True,name=Database.DB.execute,since=0.4) Executes an SQL query on the database.
@@ -181,6 +345,53 @@ namespace ti
          */
         this->SetMethod("execute", &DatabaseBinding::Execute);
 
+        /**
+         * @tiapi(method=True,name=Database.DB.query,since=1.3.2)
+         * @tiapi Execute a single SQL statement and return a cursor over its rows.
+         * @tiapi Unlike execute, rows are only read from the database as the
+         * @tiapi ResultSet moves to them, so large results do not have to fit in
+         * @tiapi memory. rowsAffected is not updated for queries which return rows.
+         * @tiarg[String, sql] The SQL statement to execute.
+         * @tiresult[Database.ResultSet] A ResultSet positioned on the first row.
+         */
+        this->SetMethod("query", &DatabaseBinding::Query);
+
+        /**
+         * @tiapi(method=True,name=Database.DB.executeAsync,since=1.3.2)
+         * @tiapi Execute an SQL query on a background thread and pass its
+         * @tiapi Database.ResultSet to a callback on the main thread. The query
+         * @tiapi runs on a connection of its own, so it does not see changes
+         * @tiapi made inside a transaction which is still open on this object.
+         * @tiarg[String, sql] The SQL query to execute.
+         * @tiarg[Function, callback] Called with the Database.ResultSet and
+         * @tiarg undefined when the query succeeds, or with null and an error
+         * @tiarg message when it fails. Any arguments between sql and callback
+         * @tiarg are bound to the query, as they are for execute.
+         */
+        this->SetMethod("executeAsync", &DatabaseBinding::ExecuteAsync);
+
+        /**
+         * @tiapi(method=True,name=Database.DB.executeMany,since=1.3.2)
+         * @tiapi Execute one SQL statement once for each set of arguments. Unless
+         * @tiapi a transaction is already open, all rows are executed inside a
+         * @tiapi single transaction which is rolled back if any of them fails.
+         * @tiarg[String, sql] The SQL statement to execute.
+         * @tiarg[Array, rows] An Array holding an Array of arguments (or a single
+         * @tiarg argument) for each execution.
+         */
+        this->SetMethod("executeMany", &DatabaseBinding::ExecuteMany);
+
+        /**
+         * @tiapi(method=True,name=Database.DB.transaction,since=1.3.2)
+         * @tiapi Call a function inside a transaction. The transaction is committed
+         * @tiapi when the function returns and rolled back if it throws. Transactions
+         * @tiapi may be nested, in which case the inner ones use savepoints.
+         * @tiarg[Function, callback] The function to call. It is passed this
+         * @tiarg Database.DB.
+         * @tiresult[Any] The value returned by callback.
+         */
+        this->SetMethod("transaction", &DatabaseBinding::Transaction);
+
         /**
          * @tiapi(method=True,name=Database.DB.close,since=0.4) Closes an open database
          */
@@ -211,87 +422,231 @@ namespace ti
         if (isWebKitDatabase)
             this->path = GetWebKitDatabases()->Path(name);
 
-        session = new Session("SQLite", path);
+        connection = ConnectionPool::GetInstance()->Acquire(path, settings);
+        db = connection->GetHandle();
+        statements = connection->GetStatements();
     }
 
     DatabaseBinding::~DatabaseBinding()
     {
-        if (session)
-            delete session;
+        this->Close();
+    }
+
+    void DatabaseBinding::CheckOpen(const char* methodName)
+    {
+        if (!db)
+            throw ValueException::FromFormat(
+                "Tried to call %s, but database was closed.", methodName);
+    }
+
+    void DatabaseBinding::UpdateCounts(int rowsAffected)
+    {
+        this->SetInt("rowsAffected", rowsAffected);
+        this->Set("lastInsertRowId", RowIdValue(sqlite3_last_insert_rowid(db)));
     }
 
     void DatabaseBinding::Execute(const ValueList& args, ValueRef result)
     {
         args.VerifyException("execute", "s");
-
-        if (!session)
-            throw ValueException::FromString("Tried to call execute, but database was closed.");
+        CheckOpen("execute");
 
         std::string sql(args.GetString(0));
         GetLogger()->Debug("Execute called with %s", sql.c_str());
-        
-        Statement select(*this->session);
-        
+
         try
         {
-            ValueBinding binding;
-            
-            select << sql;
-            
-            if (args.size()>1)
-            {
-                
-                for (size_t c=1;c<args.size();c++)
-                {
-                    ValueRef anarg = args.at(c);
-                    if (anarg->IsList())
-                    {
-                        TiListRef list = anarg->ToList();
-                        for (size_t a=0;a<list->Size();a++)
-                        {
-                            ValueRef arg = list->At(a);
-                            binding.convert(select,arg);
-                        }
-                    }
-                    else
-                    {
-                        binding.convert(select,anarg);
-                    }
-                }
-            }
-            Poco::UInt32 count = select.execute();
+            // execute() reports the number of rows up front,
+            // so all of them are read here.
+            int rowsAffected;
+            TiObjectRef resultSet(ExecuteStatement(db, statements, sql, args, 1,
+                rowsAffected));
 
-            GetLogger()->Debug("sql returned: %d rows for result",count);
+            GetLogger()->Debug("sql returned: %d rows for result", rowsAffected);
+            this->UpdateCounts(rowsAffected);
+            result->SetObject(resultSet);
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Exception executing: %s, Error was: %s", sql.c_str(),
+                e.ToString().c_str());
+            throw;
+        }
+    }
 
-            this->SetInt("rowsAffected",count);
+    void DatabaseBinding::Query(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("query", "s");
+        CheckOpen("query");
+
+        std::string sql(args.GetString(0));
+        GetLogger()->Debug("Query called with %s", sql.c_str());
 
-            // get the row insert id
-            Statement ss(*this->session);
-            ss << "select last_insert_rowid()", now;
-            RecordSet rr(ss);
-            Poco::DynamicAny value = rr.value(0);
-            int i;
-            value.convert(i);
-            this->SetInt("lastInsertRowId",i);
+        sqlite3_stmt* statement = 0;
+        try
+        {
+            size_t tailOffset;
+            statement = statements->Acquire(sql, &tailOffset);
+            if (!statement ||
+                sql.find_first_not_of(" \t\r\n;", tailOffset) != std::string::npos)
+            {
+                throw ValueException::FromString(
+                    "query requires exactly one SQL statement");
+            }
 
-            
-            if (count > 0)
+            BindValues(db, statement, args, 1);
+            if (sqlite3_column_count(statement) > 0)
             {
-                RecordSet rs(select);
-                TiObjectRef r = new ResultSetBinding(rs);
-                result->SetObject(r);
+                sqlite3_stmt* cursorStatement = statement;
+                statement = 0;
+                result->SetObject(new ResultSetBinding(this, sql, cursorStatement));
             }
             else
             {
-                TiObjectRef r = new ResultSetBinding();
-                result->SetObject(r);
+                StepToEnd(db, statement);
+                statements->Release(sql, statement);
+                statement = 0;
+                this->UpdateCounts(sqlite3_changes(db));
+                result->SetObject(new ResultSetBinding());
             }
         }
-        catch (Poco::Data::DataException &e)
+        catch (ValueException& e)
         {
+            statements->Release(sql, statement);
             GetLogger()->Error("Exception executing: %s, Error was: %s", sql.c_str(),
-                e.what());
-            throw ValueException::FromString(e.what());
+                e.ToString().c_str());
+            throw;
+        }
+    }
+
+    void DatabaseBinding::ExecuteAsync(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("executeAsync", "s");
+        CheckOpen("executeAsync");
+
+        if (args.size() < 2 || !args.at(args.size() - 1)->IsMethod())
+            throw ValueException::FromString("executeAsync requires a callback");
+
+        std::string sql(args.GetString(0));
+        GetLogger()->Debug("ExecuteAsync called with %s", sql.c_str());
+
+        ValueList queryArgs;
+        CopyValues(args, 1, args.size() - 1, queryArgs);
+
+        SharedRunnable query(new AsyncQuery(this, path, settings, sql, queryArgs,
+            args.at(args.size() - 1)->ToMethod()));
+        if (!GetQueryThreadPool()->start(query))
+        {
+            throw ValueException::FromString(
+                "Too many pending asynchronous queries, try again later");
+        }
+    }
+
+    void DatabaseBinding::ExecuteMany(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("executeMany", "s l");
+        CheckOpen("executeMany");
+
+        std::string sql(args.GetString(0));
+        TiListRef rows(args.GetList(1));
+        GetLogger()->Debug("ExecuteMany called with %s", sql.c_str());
+
+        // Committing once for all rows, instead of once per row, is what
+        // makes bulk inserts fast.
+        bool implicitTransaction = sqlite3_get_autocommit(db) != 0;
+        if (implicitTransaction)
+            ExecuteScript(db, "BEGIN");
+
+        sqlite3_stmt* statement = 0;
+        try
+        {
+            size_t tailOffset;
+            statement = statements->Acquire(sql, &tailOffset);
+            if (!statement)
+                throw ValueException::FromString("executeMany requires an SQL statement");
+
+            int rowsAffected = 0;
+            for (size_t i = 0; i < rows->Size(); i++)
+            {
+                ValueList rowArgs(rows->At(i));
+                BindValues(db, statement, rowArgs, 0);
+                StepToEnd(db, statement);
+                rowsAffected += sqlite3_changes(db);
+
+                sqlite3_reset(statement);
+                sqlite3_clear_bindings(statement);
+            }
+
+            statements->Release(sql, statement);
+            statement = 0;
+
+            if (implicitTransaction)
+                ExecuteScript(db, "COMMIT");
+
+            this->UpdateCounts(rowsAffected);
+        }
+        catch (ValueException& e)
+        {
+            statements->Release(sql, statement);
+            GetLogger()->Error("Exception executing: %s, Error was: %s", sql.c_str(),
+                e.ToString().c_str());
+
+            if (implicitTransaction && !sqlite3_get_autocommit(db))
+                sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+            throw;
+        }
+    }
+
+    void DatabaseBinding::Transaction(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("transaction", "m");
+        CheckOpen("transaction");
+
+        // The outermost transaction is a real one. Nested ones are savepoints,
+        // so that they can be rolled back without losing the outer work.
+        bool outermost = sqlite3_get_autocommit(db) != 0;
+        std::string savepoint;
+        if (outermost)
+        {
+            ExecuteScript(db, "BEGIN");
+        }
+        else
+        {
+            std::ostringstream savepointName;
+            savepointName << "tide_savepoint_" << ++savepointCount;
+            savepoint = savepointName.str();
+            ExecuteScript(db, "SAVEPOINT " + savepoint);
+        }
+
+        TiMethodRef callback(args.GetMethod(0));
+        try
+        {
+            ValueRef callbackResult(callback->Call(
+                ValueList(Value::NewObject(GetAutoPtr()))));
+
+            if (!db)
+                throw ValueException::FromString(
+                    "The database was closed during a transaction.");
+
+            ExecuteScript(db, outermost ? std::string("COMMIT") : "RELEASE " + savepoint);
+            result->SetValue(callbackResult);
+        }
+        catch (...)
+        {
+            // The transaction may already be gone, for instance if the
+            // callback committed it itself, so errors here are ignored.
+            if (db && !sqlite3_get_autocommit(db))
+            {
+                if (outermost)
+                {
+                    sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+                }
+                else
+                {
+                    std::string rollback("ROLLBACK TO " + savepoint + "; RELEASE " + savepoint);
+                    sqlite3_exec(db, rollback.c_str(), 0, 0, 0);
+                }
+            }
+            throw;
         }
     }
 
@@ -301,12 +656,39 @@ namespace ti
         this->Close();
     }
 
+    void DatabaseBinding::ReleaseStatement(const std::string& sql, sqlite3_stmt* statement)
+    {
+        if (statements)
+            statements->Release(sql, statement);
+        else
+            sqlite3_finalize(statement);
+    }
+
+    void DatabaseBinding::AddResultSet(ResultSetBinding* resultSet)
+    {
+        resultSets.insert(resultSet);
+    }
+
+    void DatabaseBinding::RemoveResultSet(ResultSetBinding* resultSet)
+    {
+        resultSets.erase(resultSet);
+    }
+
     void DatabaseBinding::Close()
     {
-        if (session)
+        if (db)
         {
-            delete session;
-            session = 0;
+            // Open cursors have to finish with their statements before
+            // the connection goes away. Detaching removes them from the set.
+            std::set<ResultSetBinding*> openResultSets(resultSets);
+            std::set<ResultSetBinding*>::iterator i = openResultSets.begin();
+            while (i != openResultSets.end())
+                (*i++)->Detach();
+
+            ConnectionPool::GetInstance()->Release(connection);
+            connection = 0;
+            statements = 0;
+            db = 0;
         }
     }
 
@@ -325,10 +707,7 @@ namespace ti
         }
         else
         {
-            GetLogger()->Debug("Removing database file: %s", path.c_str());
-            Poco::File file(path);
-            if (file.canWrite())
-                file.remove();
+            ConnectionPool::GetInstance()->Remove(path);
         }
     }
 }
@@ -37,29 +37,62 @@
 
 #include <tide/tide.h>
 #include "webkit_databases.h"
-#include <Poco/Data/Session.h>
-#include <Poco/Data/Statement.h>
+#include "connection_pool.h"
+#include <sqlite3.h>
+#include <set>
 
 namespace ti
 {
+    class ResultSetBinding;
+
     class DatabaseBinding : public AccessorObject
     {
     public:
-        DatabaseBinding(std::string& name, bool isWebKitDatabase);
+        DatabaseBinding(std::string& name, bool isWebKitDatabase,
+            const ConnectionSettings& settings);
+
+        sqlite3* GetHandle() { return db; }
+
+        /**
+         * Called by a ResultSet which is done with a statement from this
+         * database's cache.
+         */
+        void ReleaseStatement(const std::string& sql, sqlite3_stmt* statement);
+
+        /**
+         * Keep track of ResultSets which are still stepping a statement,
+         * so that they can give it back when the database is closed.
+         */
+        void AddResultSet(ResultSetBinding* resultSet);
+        void RemoveResultSet(ResultSetBinding* resultSet);
 
     protected:
         virtual ~DatabaseBinding();
         void Open(const ValueList& args, ValueRef result);
         void Execute(const ValueList& args, ValueRef result);
+        void Query(const ValueList& args, ValueRef result);
+        void ExecuteAsync(const ValueList& args, ValueRef result);
+        void ExecuteMany(const ValueList& args, ValueRef result);
+        void Transaction(const ValueList& args, ValueRef result);
         void Close(const ValueList& args, ValueRef result);
         void Remove(const ValueList& args, ValueRef result);
         void GetPath(const ValueList& args, ValueRef result);
         void Close();
 
-        Poco::Data::Session *session;
+        void CheckOpen(const char* methodName);
+        void UpdateCounts(int rowsAffected);
+
+        // The pooled connection this object uses until it is closed,
+        // and shortcuts to its handle and statement cache.
+        Connection* connection;
+        sqlite3* db;
+        StatementCache* statements;
+        std::set<ResultSetBinding*> resultSets;
         std::string name;
         std::string path;
         bool isWebKitDatabase;
+        ConnectionSettings settings;
+        int savepointCount;
     };
 }
 
@@ -36,9 +36,6 @@
 #include "database_module.h"
 #include "database_binding.h"
 
-#include <Poco/Data/SQLite/Connector.h>
-#include <Poco/Data/SQLite/SQLiteException.h>
-
 using namespace tide;
 using namespace ti;
 
@@ -46,15 +43,26 @@ namespace ti
 {
     TIDE_MODULE(DatabaseModule, STRING(MODULE_NAME), STRING(MODULE_VERSION));
 
-    void DatabaseModule::Initialize()
+    static ConnectionSettings GetSettings(const ValueList& args, size_t index,
+        const ConnectionSettings& defaults)
     {
-        Poco::Data::SQLite::Connector::registerConnector();
+        ConnectionSettings settings(defaults);
+        if (args.size() > index && args.at(index)->IsObject())
+            settings.Read(args.GetObject(index));
+        return settings;
+    }
 
+    void DatabaseModule::Initialize()
+    {
         /**
          * @tiapi Opens a WebKit database, given a database name. This database
          * @tiapi will be opened with the security origin of the application's
          * @tiapi app:// url.
          * @tiarg[String, name] The name of the database to open.
+         * @tiarg[Object, options, optional=True] Settings for the connection:
+         * @tiarg journalMode, synchronous and cacheSize, which are applied as
+         * @tiarg the sqlite pragmas of the same names. WebKit shares these
+         * @tiarg databases, so by default they are left as WebKit made them.
          * @tiresult[Database.DB] The new database object.
          */
         this->SetMethod("open", &DatabaseModule::Open);
@@ -64,6 +72,9 @@ namespace ti
          * @tiapi Opens a database, given a path to an sqlite file.
          * @tiarg[String, path] Path to an SQLite file to store the database
          * @tiarg in. If the file does not exist, it will be created.
+         * @tiarg[Object, options, optional=True] Settings for the connection,
+         * @tiarg as for Database.open. Here journalMode defaults to "WAL" and
+         * @tiarg synchronous to "NORMAL".
          * @tiresult[Database.DB] The new database object.
          */
         this->SetMethod("openFile", &DatabaseModule::OpenFile);
@@ -79,14 +90,15 @@ namespace ti
 
     void DatabaseModule::Open(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("open", "?s");
+        args.VerifyException("open", "?s ?o");
         std::string name(args.GetString(0, "unnamed"));
-        result->SetObject(new DatabaseBinding(name, true));
+        result->SetObject(new DatabaseBinding(name, true,
+            GetSettings(args, 1, ConnectionSettings())));
     }
 
     void DatabaseModule::OpenFile(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("openFile", "s|o");
+        args.VerifyException("openFile", "s|o ?o");
         std::string name;
         if (args.at(0)->IsString())
         {
@@ -108,6 +120,7 @@ namespace ti
             name = v->ToString();
         }
 
-        result->SetObject(new DatabaseBinding(name, false));
+        result->SetObject(new DatabaseBinding(name, false,
+            GetSettings(args, 1, ConnectionSettings::Defaults())));
     }
 }
@@ -34,25 +34,112 @@
 
 #include <tide/tide.h>
 #include "resultset_binding.h"
-#include <Poco/Data/MetaColumn.h>
-#include <Poco/DynamicAny.h>
-
-using Poco::Data::MetaColumn;
+#include "database_binding.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
 
 namespace ti
 {
+    // Poco's SQLite connector reported columns declared as BOOL or
+    // BOOLEAN as booleans, so keep doing that.
+    static bool IsBoolColumn(sqlite3_stmt* statement, int column)
+    {
+        const char* declared = sqlite3_column_decltype(statement, column);
+        if (!declared)
+            return false;
+
+        std::string type(declared);
+        std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+        return type == "BOOL" || type == "BOOLEAN";
+    }
+
+    static ValueRef ColumnToValue(sqlite3_stmt* statement, int column, bool isBool)
+    {
+        switch (sqlite3_column_type(statement, column))
+        {
+            case SQLITE_INTEGER:
+            {
+                sqlite3_int64 i = sqlite3_column_int64(statement, column);
+                if (isBool)
+                    return Value::NewBool(i != 0);
+                if (i >= INT_MIN && i <= INT_MAX)
+                    return Value::NewInt((int) i);
+                return Value::NewDouble((double) i);
+            }
+            case SQLITE_FLOAT:
+                return Value::NewDouble(sqlite3_column_double(statement, column));
+            case SQLITE_NULL:
+                return Value::Null;
+            default:
+            {
+                // Text and blobs are both handed to scripts as strings.
+                const char* data = (const char*) sqlite3_column_blob(statement, column);
+                int length = sqlite3_column_bytes(statement, column);
+                return Value::NewString(data ? data : "", length);
+            }
+        }
+    }
+
     ResultSetBinding::ResultSetBinding() :
         StaticBoundObject("Database.ResultSet"),
+        db(0),
+        statement(0),
+        rowCount(0),
+        closed(false),
         eof(true)
     {
         // no results result set
         Bind();
     }
-    ResultSetBinding::ResultSetBinding(Poco::Data::RecordSet &r) : StaticBoundObject("ResultSet"), eof(false)
+
+    ResultSetBinding::ResultSetBinding(DatabaseBinding* database,
+        const std::string& sql, sqlite3_stmt* statement) :
+        StaticBoundObject("Database.ResultSet"),
+        database(database, true),
+        sql(sql),
+        db(database->GetHandle()),
+        statement(statement),
+        rowCount(0),
+        closed(false),
+        eof(false)
+    {
+        ReadColumns();
+
+        // Step to the first row now, so that an error in the query is
+        // reported by the call which made it.
+        eof = !StepRow();
+        if (this->statement)
+            database->AddResultSet(this);
+
+        Bind();
+    }
+
+    ResultSetBinding::ResultSetBinding(sqlite3* db, sqlite3_stmt* statement) :
+        StaticBoundObject("Database.ResultSet"),
+        db(db),
+        statement(statement),
+        rowCount(0),
+        closed(false),
+        eof(false)
     {
-        rs = new Poco::Data::RecordSet(r);
+        ReadColumns();
+        ReadAll();
+        eof = rows.empty();
         Bind();
     }
+
+    void ResultSetBinding::ReadColumns()
+    {
+        int columnCount = sqlite3_column_count(statement);
+        for (int i = 0; i < columnCount; i++)
+        {
+            const char* name = sqlite3_column_name(statement, i);
+            columnNames.push_back(name ? name : "");
+            boolColumns.push_back(IsBoolColumn(statement, i));
+        }
+    }
+
     void ResultSetBinding::Bind()
     {
         /**
@@ -103,148 +190,227 @@ namespace ti
          * @tiresult(for=Database.ResultSet.fieldByName,type=Boolean|String|Number|Bytes) The content of the specified field in the current row
          */
         this->SetMethod("fieldByName",&ResultSetBinding::FieldByName);
+
+        /**
+         * @tiapi(method=True,name=Database.ResultSet.fetchAll,since=1.3.2)
+         * @tiapi Read rows, starting with the current one, and move past them.
+         * @tiarg[Number, maxRows, optional=True] The most rows to read. By default
+         * @tiarg all remaining rows are read.
+         * @tiresult[Array<Array>] An Array holding an Array of field values for
+         * @tiresult each row.
+         */
+        this->SetMethod("fetchAll",&ResultSetBinding::FetchAll);
+
+        /**
+         * @tiapi(method=True,name=Database.ResultSet.fetchColumns,since=1.3.2)
+         * @tiapi Read rows, starting with the current one, and move past them,
+         * @tiapi collecting the values of each field into its own Array.
+         * @tiarg[Number, maxRows, optional=True] The most rows to read. By default
+         * @tiarg all remaining rows are read.
+         * @tiresult[Object] An object mapping each field name to an Array of its values.
+         */
+        this->SetMethod("fetchColumns",&ResultSetBinding::FetchColumns);
     }
     ResultSetBinding::~ResultSetBinding()
     {
+        ReleaseStatement();
     }
-    void ResultSetBinding::IsValidRow(const ValueList& args, ValueRef result)
+
+    bool ResultSetBinding::StepRow()
     {
-        if (rs.isNull())
+        if (!statement)
+            return false;
+
+        int rc = sqlite3_step(statement);
+        if (rc == SQLITE_ROW)
         {
-            result->SetBool(false);
+            size_t columnCount = columnNames.size();
+            rows.push_back(Row());
+            Row& values = rows.back();
+            values.reserve(columnCount);
+            for (size_t i = 0; i < columnCount; i++)
+                values.push_back(ColumnToValue(statement, i, boolColumns[i]));
+
+            rowCount++;
+            return true;
         }
-        else
+
+        std::string error;
+        if (rc != SQLITE_DONE)
+            error = sqlite3_errmsg(db);
+
+        ReleaseStatement();
+        if (rc != SQLITE_DONE)
+            throw ValueException::FromString(error);
+        return false;
+    }
+
+    void ResultSetBinding::ReleaseStatement()
+    {
+        if (!statement)
+            return;
+
+        if (!database.isNull())
         {
-            result->SetBool(!eof);
+            database->RemoveResultSet(this);
+            database->ReleaseStatement(sql, statement);
         }
+        statement = 0;
+
+        // Finished cursors should not keep the database open.
+        database = 0;
+    }
+
+    void ResultSetBinding::ReadAll()
+    {
+        while (StepRow()) {}
+    }
+
+    void ResultSetBinding::Detach()
+    {
+        ReleaseStatement();
+    }
+
+    void ResultSetBinding::Advance()
+    {
+        if (closed || eof)
+            return;
+
+        // Like Poco's RecordSet used to, stay on the last row once there
+        // are no more, so that its fields can still be read.
+        if (rows.size() > 1 || StepRow())
+            rows.pop_front();
+        else
+            eof = true;
+    }
+
+    bool ResultSetBinding::HasRow()
+    {
+        return !closed && !rows.empty();
+    }
+
+    TiListRef ResultSetBinding::RowToList(Row& row)
+    {
+        TiListRef list(new SnapshotList());
+        for (size_t i = 0; i < row.size(); i++)
+            list->Append(row[i]);
+        return list;
     }
+
+    void ResultSetBinding::IsValidRow(const ValueList& args, ValueRef result)
+    {
+        result->SetBool(HasRow() && !eof);
+    }
+
     void ResultSetBinding::Next(const ValueList& args, ValueRef result)
     {
-        if (!rs.isNull() && !eof)
-        {
-            eof = (rs->moveNext() == false);
-        }
+        Advance();
     }
+
     void ResultSetBinding::Close(const ValueList& args, ValueRef result)
     {
-        if (!rs.isNull())
-        {
-            rs = NULL;
-        }
+        closed = true;
+        rows.clear();
+        ReleaseStatement();
     }
+
     void ResultSetBinding::RowCount(const ValueList& args, ValueRef result)
     {
-        if (rs.isNull())
-        {
-            result->SetInt(0);
-        }
-        else
-        {
-            result->SetInt(rs->rowCount());
-        }
+        // Counting the rows means reading all of them.
+        if (!closed)
+            ReadAll();
+        result->SetInt(closed ? 0 : rowCount);
     }
+
     void ResultSetBinding::FieldCount(const ValueList& args, ValueRef result)
     {
-        if (rs.isNull())
-        {
-            result->SetInt(0);
-        }
-        else
-        {
-            result->SetInt(rs->columnCount());
-        }
+        result->SetInt(HasRow() ? columnNames.size() : 0);
     }
+
     void ResultSetBinding::FieldName(const ValueList& args, ValueRef result)
     {
-        if (rs.isNull())
+        args.VerifyException("fieldName", "i");
+        int index = args.GetInt(0);
+        if (!HasRow() || index < 0 || index >= (int) columnNames.size())
         {
             result->SetNull();
         }
         else
         {
-            args.VerifyException("fieldName", "i");
-            const std::string &str = rs->columnName(args.at(0)->ToInt());
-            result->SetString(str.c_str());
+            result->SetString(columnNames[index]);
         }
     }
+
     void ResultSetBinding::Field(const ValueList& args, ValueRef result)
     {
-        if (rs.isNull())
-        {
-            result->SetNull();
-        }
-        else
-        {
-            args.VerifyException("field", "i");
-            TransformValue(args.at(0)->ToInt(),result);
-        }
+        args.VerifyException("field", "i");
+        TransformValue(args.GetInt(0), result);
     }
+
     void ResultSetBinding::FieldByName(const ValueList& args, ValueRef result)
     {
         result->SetNull();
-        if (!rs.isNull())
+        args.VerifyException("fieldByName", "s");
+        std::string name = args.GetString(0);
+        for (size_t i = 0; i < columnNames.size(); i++)
         {
-            args.VerifyException("fieldByName", "s");
-            std::string name = args.at(0)->ToString();
-            size_t count = rs->columnCount();
-            for (size_t i = 0; i<count; i++)
+            if (columnNames[i] == name)
             {
-                const std::string &str = rs->columnName(i);
-                if (str == name)
-                {
-                    TransformValue(i,result);
-                    break;
-                }
+                TransformValue(i, result);
+                break;
             }
         }
     }
-    void ResultSetBinding::TransformValue(size_t index, ValueRef result)
+
+    void ResultSetBinding::FetchAll(const ValueList& args, ValueRef result)
     {
-        MetaColumn::ColumnDataType type = rs->columnType(index);
-        Poco::DynamicAny value = rs->value(index);
-        
-        if (value.isEmpty())
-        {
-            result->SetNull();
-        }
-        else if (type == MetaColumn::FDT_STRING)
+        args.VerifyException("fetchAll", "?i");
+        int maxRows = args.GetInt(0, -1);
+
+        TiListRef list(new SnapshotList());
+        for (int count = 0; HasRow() && !eof && (maxRows < 0 || count < maxRows); count++)
         {
-            std::string str;
-            value.convert(str);
-            result->SetString(str);
+            list->Append(Value::NewList(RowToList(rows.front())));
+            Advance();
         }
-        else if (type == MetaColumn::FDT_BOOL)
+        result->SetList(list);
+    }
+
+    void ResultSetBinding::FetchColumns(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("fetchColumns", "?i");
+        int maxRows = args.GetInt(0, -1);
+
+        std::vector<TiListRef> columns;
+        for (size_t i = 0; i < columnNames.size(); i++)
+            columns.push_back(new SnapshotList());
+
+        for (int count = 0; HasRow() && !eof && (maxRows < 0 || count < maxRows); count++)
         {
-            bool v = false;
-            value.convert(v);
-            result->SetBool(v);
+            Row& row = rows.front();
+            for (size_t i = 0; i < row.size(); i++)
+                columns[i]->Append(row[i]);
+            Advance();
         }
-        else if (type == MetaColumn::FDT_FLOAT || type == MetaColumn::FDT_DOUBLE)
+
+        TiObjectRef object(new StaticBoundObject());
+        if (!closed)
         {
-            float f = 0;
-            value.convert(f);
-            result->SetDouble(f);
+            for (size_t i = 0; i < columnNames.size(); i++)
+                object->SetList(columnNames[i].c_str(), columns[i]);
         }
-        else if (type == MetaColumn::FDT_BLOB || type == MetaColumn::FDT_UNKNOWN)
+        result->SetObject(object);
+    }
+
+    void ResultSetBinding::TransformValue(size_t index, ValueRef result)
+    {
+        if (!HasRow() || index >= columnNames.size())
         {
-            std::string str;
-            value.convert(str);
-            result->SetString(str);
+            result->SetNull();
         }
         else
         {
-            // the rest of these are ints:
-            // FDT_INT8,
-            // FDT_UINT8,
-            // FDT_INT16,
-            // FDT_UINT16,
-            // FDT_INT32,
-            // FDT_UINT32,
-            // FDT_INT64,
-            // FDT_UINT64,
-            int i;
-            value.convert(i);
-            result->SetInt(i);
+            result->SetValue(rows.front()[index]);
         }
     }
 }
@@ -36,30 +36,79 @@
 #define _DATABASE_RESULTSET_BINDING_H_
 
 #include <tide/tide.h>
-#include <Poco/Data/RecordSet.h>
+#include <sqlite3.h>
+#include <deque>
+#include <vector>
 
 namespace ti
 {
+    class DatabaseBinding;
+
     /**
-     * Binding for the ResultSet (or in Poco SQLite the RecordSet)
-     *
+     * Binding for the ResultSet of a query. This is a forward-only cursor
+     * over a prepared statement: rows are stepped and converted to Values
+     * only when the script moves to them, unless ReadAll reads them ahead.
      */
     class ResultSetBinding : public StaticBoundObject
     {
     public:
         ResultSetBinding();
-        ResultSetBinding(Poco::Data::RecordSet& rs);
+
+        /**
+         * Take over statement, which database acquired for sql with its
+         * arguments already bound, and step to the first row. The statement
+         * goes back to database once all rows are read or the cursor is
+         * closed. Throws a ValueException if stepping fails.
+         */
+        ResultSetBinding(DatabaseBinding* database, const std::string& sql,
+            sqlite3_stmt* statement);
+
+        /**
+         * Read all rows of statement, which stays with the caller. This
+         * does not need a DatabaseBinding, so it works on any thread.
+         * Throws a ValueException if stepping fails.
+         */
+        ResultSetBinding(sqlite3* db, sqlite3_stmt* statement);
+
+        /**
+         * Step the statement to the end, keeping the remaining rows,
+         * and give the statement back.
+         */
+        void ReadAll();
+
+        /**
+         * Give the statement back before database is closed. Rows which
+         * were already read stay available.
+         */
+        void Detach();
+
+        size_t GetRowCount() { return rowCount; }
 
     protected:
         virtual ~ResultSetBinding();
 
     private:
-        SharedPtr<Poco::Data::RecordSet> rs;
+        typedef std::vector<ValueRef> Row;
+
+        AutoPtr<DatabaseBinding> database;
+        std::string sql;
+        sqlite3* db;
+        sqlite3_stmt* statement;
+        std::vector<std::string> columnNames;
+        std::vector<bool> boolColumns;
+        std::deque<Row> rows; // The current row and any read ahead of it.
+        size_t rowCount; // Rows stepped so far.
+        bool closed;
         bool eof;
-        
+
         void Bind();
+        void ReadColumns();
+        bool StepRow();
+        void ReleaseStatement();
+        void Advance();
+        bool HasRow();
         void TransformValue(size_t index, ValueRef result);
-        
+        TiListRef RowToList(Row& row);
 
         void IsValidRow(const ValueList& args, ValueRef result);
         void Next(const ValueList& args, ValueRef result);
@@ -69,6 +118,8 @@ namespace ti
         void FieldName(const ValueList& args, ValueRef result);
         void Field(const ValueList& args, ValueRef result);
         void FieldByName(const ValueList& args, ValueRef result);
+        void FetchAll(const ValueList& args, ValueRef result);
+        void FetchColumns(const ValueList& args, ValueRef result);
     };
 }
 
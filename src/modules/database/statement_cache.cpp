@@ -0,0 +1,114 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include <tide/tide.h>
+#include "statement_cache.h"
+#include <cstring>
+
+namespace ti
+{
+    StatementCache::StatementCache(sqlite3* db, size_t capacity) :
+        db(db),
+        capacity(capacity)
+    {
+    }
+
+    StatementCache::~StatementCache()
+    {
+        this->Clear();
+    }
+
+    sqlite3_stmt* StatementCache::Acquire(const std::string& sql, size_t* tailOffset)
+    {
+        sqlite3_stmt* statement = 0;
+        std::map<std::string, EntryList::iterator>::iterator i = index.find(sql);
+        if (i != index.end())
+        {
+            statement = i->second->second;
+            entries.erase(i->second);
+            index.erase(i);
+        }
+        else
+        {
+            int rc = sqlite3_prepare_v2(db, sql.c_str(), (int) sql.size() + 1,
+                &statement, 0);
+            if (rc != SQLITE_OK)
+            {
+                sqlite3_finalize(statement);
+                throw ValueException::FromString(sqlite3_errmsg(db));
+            }
+        }
+
+        // sqlite3_sql holds exactly the text that was compiled, so it
+        // also tells where the rest of a multi-statement string starts.
+        *tailOffset = statement ? strlen(sqlite3_sql(statement)) : sql.size();
+        return statement;
+    }
+
+    void StatementCache::Release(const std::string& sql, sqlite3_stmt* statement)
+    {
+        if (!statement)
+            return;
+
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+
+        // The same SQL may have been acquired twice at once. Keep only
+        // the copy that is already cached.
+        if (capacity == 0 || index.find(sql) != index.end())
+        {
+            sqlite3_finalize(statement);
+            return;
+        }
+
+        entries.push_front(Entry(sql, statement));
+        index[sql] = entries.begin();
+
+        if (entries.size() > capacity)
+        {
+            Entry& oldest = entries.back();
+            index.erase(oldest.first);
+            sqlite3_finalize(oldest.second);
+            entries.pop_back();
+        }
+    }
+
+    void StatementCache::Clear()
+    {
+        for (EntryList::iterator i = entries.begin(); i != entries.end(); i++)
+            sqlite3_finalize(i->second);
+        entries.clear();
+        index.clear();
+    }
+}
@@ -0,0 +1,89 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _DATABASE_STATEMENT_CACHE_H_
+#define _DATABASE_STATEMENT_CACHE_H_
+
+#include <list>
+#include <map>
+#include <string>
+#include <sqlite3.h>
+
+namespace ti
+{
+    /**
+     * A least-recently-used cache of prepared statements for one sqlite
+     * connection, keyed by their SQL text. A statement is taken out of the
+     * cache while it is in use, so two callers never share one; Release
+     * resets it and makes it available again.
+     */
+    class StatementCache
+    {
+    public:
+        StatementCache(sqlite3* db, size_t capacity);
+        ~StatementCache();
+
+        /**
+         * Get a prepared statement for the first SQL statement in sql,
+         * compiling it if it is not cached. On return tailOffset is the
+         * offset in sql of the text after the first statement. Returns NULL
+         * for SQL that holds no statement (only whitespace or comments) and
+         * throws a ValueException if it does not compile.
+         */
+        sqlite3_stmt* Acquire(const std::string& sql, size_t* tailOffset);
+
+        /**
+         * Reset a statement from Acquire and put it back in the cache,
+         * finalizing the least recently used one if the cache is full.
+         */
+        void Release(const std::string& sql, sqlite3_stmt* statement);
+
+        /**
+         * Finalize every cached statement. Statements that are currently
+         * acquired are not affected.
+         */
+        void Clear();
+
+    private:
+        typedef std::pair<std::string, sqlite3_stmt*> Entry;
+        typedef std::list<Entry> EntryList;
+
+        sqlite3* db;
+        size_t capacity;
+        EntryList entries; // Most recently used first.
+        std::map<std::string, EntryList::iterator> index;
+    };
+}
+
+#endif
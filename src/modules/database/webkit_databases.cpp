@@ -37,25 +37,10 @@
 using namespace TideUtils;
 
 #include <tide/tide.h>
-#include <Poco/File.h>
 #include "webkit_databases.h"
-
-#include <Poco/Data/AbstractBinding.h>
-#include <Poco/Data/RecordSet.h>
-#include <Poco/Data/MetaColumn.h>
-#include <Poco/Data/Statement.h>
-#include <Poco/Data/SessionFactory.h>
-#include <Poco/Data/SQLite/Connector.h>
-#include <Poco/Data/SQLite/SQLiteException.h>
-
-using Poco::Data::Session;
-using Poco::Data::Statement;
-using Poco::Data::RecordSet;
-using Poco::Data::use;
-using Poco::Data::into;
-using Poco::Data::now;
-
-//FIXME: add SessionPool
+#include "connection_pool.h"
+#include <Poco/Format.h>
+#include <cstdlib>
 
 namespace ti
 {
@@ -93,58 +78,93 @@ namespace ti
         return dataDirectory;
     }
 
+    // Run one statement on the tracker database, binding params as text.
+    // Returns whether it produced a row and, if so, stores its first
+    // column in firstValue.
+    static bool Query(Connection* connection, const std::string& sql,
+        const std::string* params, size_t paramCount, std::string* firstValue = 0)
+    {
+        StatementCache* statements = connection->GetStatements();
+        size_t tailOffset;
+        sqlite3_stmt* statement = statements->Acquire(sql, &tailOffset);
+        for (size_t i = 0; i < paramCount; i++)
+        {
+            sqlite3_bind_text(statement, i + 1, params[i].c_str(),
+                params[i].size(), SQLITE_TRANSIENT);
+        }
+
+        int rc = sqlite3_step(statement);
+        if (rc == SQLITE_ROW && firstValue)
+        {
+            const char* text = (const char*) sqlite3_column_text(statement, 0);
+            *firstValue = text ? text : "";
+        }
+
+        std::string error;
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+            error = sqlite3_errmsg(connection->GetHandle());
+        statements->Release(sql, statement);
+
+        if (!error.empty())
+            throw ValueException::FromString(error);
+        return rc == SQLITE_ROW;
+    }
+
+    static void ExecuteScript(Connection* connection, const char* sql)
+    {
+        char* error = 0;
+        if (sqlite3_exec(connection->GetHandle(), sql, 0, 0, &error) != SQLITE_OK)
+        {
+            std::string message(error ? error : "unknown error");
+            sqlite3_free(error);
+            throw ValueException::FromString(message);
+        }
+    }
+
     WebKitDatabases::WebKitDatabases() :
         origin(GetApplicationSecurityOrigin()),
         originPath(GetDataPath(origin)),
-        session(0)
+        trackerPath(FileUtils::Join(GetDataPath().c_str(), "Databases.db", NULL))
     {
-        std::string dbPath = FileUtils::Join(GetDataPath().c_str(), "Databases.db", NULL);
-        GetLogger()->Debug("DB Path = %s", dbPath.c_str());
-        this->session = new Session("SQLite", dbPath);
-
-        Statement select(*this->session);
-        GetLogger()->Debug("Creating table Origins");
-        select << "CREATE TABLE IF NOT EXISTS Origins (origin TEXT UNIQUE ON "
-            "CONFLICT REPLACE, quota INTEGER NOT NULL ON CONFLICT FAIL)", now;
-
-        Statement select2(*this->session);
-        GetLogger()->Debug("Creating table Databases");
-        select2 << "CREATE TABLE IF NOT EXISTS Databases (guid INTEGER PRIMARY KEY "
+        GetLogger()->Debug("DB Path = %s", trackerPath.c_str());
+
+        // WebKit reads this database itself, so its journal mode is left alone.
+        PooledConnection tracker(trackerPath);
+        GetLogger()->Debug("Creating tables Origins and Databases");
+        ExecuteScript(tracker.get(),
+            "CREATE TABLE IF NOT EXISTS Origins (origin TEXT UNIQUE ON "
+            "CONFLICT REPLACE, quota INTEGER NOT NULL ON CONFLICT FAIL);"
+            "CREATE TABLE IF NOT EXISTS Databases (guid INTEGER PRIMARY KEY "
             "AUTOINCREMENT, origin TEXT, name TEXT, displayName TEXT, estimatedSize "
-            "INTEGER, path TEXT)", now;
+            "INTEGER, path TEXT)");
     }
 
     WebKitDatabases::~WebKitDatabases()
     {
-        if (this->session)
-            delete session;
     }
 
     std::string WebKitDatabases::Create(std::string name)
     {
-        Statement select(*this->session);
-        Poco::UInt32 seq = 0;
-        select << "SELECT seq FROM sqlite_sequence WHERE name='Databases'", into(seq);
-        select.execute();
+        PooledConnection tracker(trackerPath);
 
-        ++seq;
+        std::string seqString;
+        Query(tracker.get(), "SELECT seq FROM sqlite_sequence WHERE name='Databases'",
+            0, 0, &seqString);
+        unsigned int seq = atoi(seqString.c_str()) + 1;
 
-        std::string filename = Poco::format("%016u.db", (unsigned int) seq);
+        std::string filename = Poco::format("%016u.db", seq);
         GetLogger()->Debug("Creating new db: %s", filename.c_str());
 
-        Statement select2(*this->session);
-        select2 << "INSERT INTO Databases (origin, name, path) VALUES (:origin,:name,:path)",
-             use(this->origin), use(name), use(filename);
-        select2.execute();
+        std::string databaseParams[] = { this->origin, name, filename };
+        Query(tracker.get(), "INSERT INTO Databases (origin, name, path) VALUES (?,?,?)",
+            databaseParams, 3);
 
-        Statement select5(*this->session);
-        select5 << "SELECT origin from Origins where origin = :origin", use(this->origin);
-        Poco::Int32 count = select5.execute();
-        if (count == 0)
+        if (!Query(tracker.get(), "SELECT origin from Origins where origin = ?",
+            &this->origin, 1))
         {
-            Statement select(*this->session);
-            select << "INSERT INTO Origins (origin,quota) values (:origin,1720462881547374560)",
-                use(this->origin), now;
+            Query(tracker.get(),
+                "INSERT INTO Origins (origin,quota) values (?,1720462881547374560)",
+                &this->origin, 1);
         }
 
         // Create the path for this application's origin, if necessary.
@@ -158,15 +178,13 @@ namespace ti
         GetLogger()->Debug("path to new database: %s", filePath.c_str());
 
         // Create the metadata table for WebKit
-        Session fileSession("SQLite", filePath);
-        Statement select3(fileSession);
-        select3 << "CREATE TABLE __WebKitDatabaseInfoTable__ (key TEXT NOT NULL "
+        PooledConnection file(filePath);
+        ExecuteScript(file.get(),
+            "CREATE TABLE __WebKitDatabaseInfoTable__ (key TEXT NOT NULL "
             "ON CONFLICT FAIL UNIQUE ON CONFLICT REPLACE,value TEXT NOT NULL ON "
-            "CONFLICT FAIL)", now;
-
-        Statement select4(fileSession);
-        select4 << "insert into __WebKitDatabaseInfoTable__ values "
-            "('WebKitDatabaseVersionKey','1.0')", now;
+            "CONFLICT FAIL);"
+            "insert into __WebKitDatabaseInfoTable__ values "
+            "('WebKitDatabaseVersionKey','1.0')");
 
         return filePath;
     }
@@ -176,13 +194,14 @@ namespace ti
         if (Exists(name))
         {
             std::string path = Path(name);
-            Statement select(*this->session);
-            select << "DELETE FROM Databases WHERE origin=:origin AND name=:name", 
-                use(this->origin), use(name), now;
-
-            Poco::File f(path);
-            f.remove(true);
+            {
+                PooledConnection tracker(trackerPath);
+                std::string params[] = { this->origin, name };
+                Query(tracker.get(), "DELETE FROM Databases WHERE origin=? AND name=?",
+                    params, 2);
+            }
 
+            ConnectionPool::GetInstance()->Remove(path);
             GetLogger()->Debug("deleted database file: %s", path.c_str());
         }
         else
@@ -197,39 +216,22 @@ namespace ti
         if (!Exists(name))
             return Create(name);
 
-        Statement select(*this->session);
-        try
+        PooledConnection tracker(trackerPath);
+        std::string params[] = { this->origin, name };
+        std::string path;
+        if (Query(tracker.get(), "SELECT path FROM Databases WHERE origin=? AND name=?",
+            params, 2, &path))
         {
-            std::string path;
-            select << "SELECT path FROM Databases WHERE origin=:origin AND name=:name",
-                 use(this->origin), use(name), into(path);
-            Poco::UInt32 count = select.execute();
-            if (count > 0)
-            {
-                return FileUtils::Join(this->originPath.c_str(), path.c_str(), NULL);
-            }
-        }
-        catch (Poco::Data::SQLite::InvalidSQLStatementException &se)
-        {
-            // NO DB
+            return FileUtils::Join(this->originPath.c_str(), path.c_str(), NULL);
         }
         return "";
     }
 
     bool WebKitDatabases::Exists(std::string name)
     {
-        Statement select(*this->session);
-        try
-        {
-            select << "SELECT guid FROM Databases WHERE origin=:origin AND name=:name",
-                use(this->origin), use(name);
-            Poco::UInt32 count = select.execute();
-            return count > 0;
-        }
-        catch (Poco::Data::SQLite::InvalidSQLStatementException &se)
-        {
-            // NO DB
-            return false;
-        }
+        PooledConnection tracker(trackerPath);
+        std::string params[] = { this->origin, name };
+        return Query(tracker.get(), "SELECT guid FROM Databases WHERE origin=? AND name=?",
+            params, 2);
     }
 }
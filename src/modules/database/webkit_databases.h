@@ -35,8 +35,7 @@
 #ifndef TI_DATABASES_H
 #define TI_DATABASES_H
 
-#include <Poco/Data/Session.h>
-#include <Poco/Data/Statement.h>
+#include <string>
 
 namespace ti
 {
@@ -72,7 +71,7 @@ namespace ti
     private:
         std::string origin;
         std::string originPath;
-        Poco::Data::Session* session;
+        std::string trackerPath;
     };
 }
 
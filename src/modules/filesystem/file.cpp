@@ -40,6 +40,8 @@ using namespace TideUtils;
 #include "file.h"
 #include "filesystem_utils.h"
 
+#include <tide/zip_archive.h>
+
 #include <Poco/File.h>
 #include <Poco/Path.h>
 #include <Poco/Exception.h>
@@ -760,7 +762,7 @@ namespace ti
 
     /**
      * Function: Unzip
-     *   unzip this file to destination
+     *   unzip this file to destination, extracting entries on several threads
      *
      * Parameters:
      *   dest - destination directory to unzip this file
@@ -788,7 +790,7 @@ namespace ti
             {
                 throw ValueException::FromString("destination must be a directory");
             }
-            FileUtils::Unzip(from_s,to_s);
+            ZipReader(from_s).ExtractAll(to_s);
             result->SetBool(true);
         }
         catch (Poco::FileNotFoundException&)
@@ -34,16 +34,79 @@
 **/
 
 #include "file_stream.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <sstream>
 #include <sys/stat.h>
 
 #include <Poco/LineEndingConverter.h>
+#include <tide/mapped_file.h>
+
+#ifdef OS_WIN32
+#include <tideutils/win/win32_utils.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 namespace ti {
+
+// Large enough that writing a file line by line only reaches
+// the operating system once every few thousand lines.
+static const size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+#ifdef OS_WIN32
+static const HANDLE NO_OUTPUT = INVALID_HANDLE_VALUE;
+#else
+static const int NO_OUTPUT = -1;
+#endif
+
+// The whole file, as mapped for MODE_MAPPED. Scripts never see this
+// object, only slices of it, which copy their data if written to and
+// keep the mapping alive after the stream is closed.
+class MappedFileBytes : public Bytes
+{
+public:
+    MappedFileBytes(const std::string& path) :
+        Bytes(),
+        file(path)
+    {
+        this->buffer = (char*) file.GetData();
+        this->size = (size_t) file.GetSize();
+    }
+
+    ~MappedFileBytes()
+    {
+        // The memory belongs to the mapping, so ~Bytes must not free it.
+        this->buffer = 0;
+        this->size = 0;
+    }
+
+private:
+    MappedFile file;
+};
+
+static std::string GetLastErrorString()
+{
+#ifdef OS_WIN32
+    char message[256];
+    DWORD length = FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM |
+        FORMAT_MESSAGE_IGNORE_INSERTS, NULL, GetLastError(), 0,
+        message, sizeof(message), NULL);
+    return std::string(message, length);
+#else
+    return strerror(errno);
+#endif
+}
+
 FileStream::FileStream(std::string filename) :
     Stream("Filesystem.FileStream"),
-    istream(0), ostream(0), stream(0)
+    istream(0),
+    mapped(0),
+    mappedPosition(0),
+    output(NO_OUTPUT)
 {
 #ifdef OS_OSX
     // in OSX, we need to expand ~ in paths to their absolute path value
@@ -65,17 +128,27 @@ FileStream::FileStream(std::string filename) :
     this->SetMethod("readLine", &FileStream::_ReadLine);
     this->SetMethod("writeLine", &FileStream::_WriteLine);
     this->SetMethod("ready", &FileStream::_Ready);
+    this->SetMethod("flush", &FileStream::_Flush);
+    this->SetMethod("sync", &FileStream::_Sync);
 
     // These should be depricated and no longer used.
     // All constants should be kept on Ti.Filesystem object.
     this->Set("MODE_READ", Value::NewInt(MODE_READ));
     this->Set("MODE_APPEND", Value::NewInt(MODE_APPEND));
     this->Set("MODE_WRITE", Value::NewInt(MODE_WRITE));
+    this->Set("MODE_MAPPED", Value::NewInt(MODE_MAPPED));
 }
 
 FileStream::~FileStream()
 {
-    this->Close();
+    try
+    {
+        this->Close();
+    }
+    catch (ValueException&)
+    {
+        // Close already logged the error and there is nobody to tell.
+    }
 }
 
 bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
@@ -83,45 +156,28 @@ bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
     // close the prev stream if needed
     this->Close();
 
-    try
+    if (mode == MODE_MAPPED)
+    {
+        this->mapped = new MappedFileBytes(this->filename);
+        this->mappedPosition = 0;
+        return true;
+    }
+
+    if (mode == MODE_APPEND || mode == MODE_WRITE)
     {
-        std::ios::openmode flags = (std::ios::openmode) 0;
-        bool output = false;
+        this->OpenOutput(mode == MODE_APPEND);
+        return true;
+    }
 
+    try
+    {
+        std::ios::openmode flags = std::ios::in;
         if (binary)
         {
             flags|=std::ios::binary;
         }
 
-        if (mode == MODE_APPEND)
-        {
-            flags|=std::ios::out|std::ios::app;
-            output = true;
-        }
-        else if (mode == MODE_WRITE)
-        {
-            flags |= std::ios::out|std::ios::trunc;
-            output = true;
-        }
-        else if (mode == MODE_READ)
-        {
-            flags |= std::ios::in;
-        }
-
-        if (output)
-        {
-            this->ostream = new Poco::FileOutputStream(this->filename,flags);
-            this->stream = this->ostream;
-#ifndef OS_WIN32
-            chmod(this->filename.c_str(),S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
-#endif      
-        }
-        else
-        {
-            this->istream = new Poco::FileInputStream(this->filename,flags);
-            this->stream = this->istream;
-        }
-
+        this->istream = new Poco::FileInputStream(this->filename,flags);
         return true;
     }
     catch (Poco::Exception& exc)
@@ -132,27 +188,66 @@ bool FileStream::Open(FileStreamMode mode, bool binary, bool append)
     }
 }
 
+void FileStream::OpenOutput(bool append)
+{
+#ifdef OS_WIN32
+    this->output = CreateFileW(::UTF8ToWide(this->filename).c_str(),
+        GENERIC_WRITE, FILE_SHARE_READ, NULL,
+        append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (this->output != NO_OUTPUT && append)
+    {
+        LARGE_INTEGER zero;
+        zero.QuadPart = 0;
+        SetFilePointerEx(this->output, zero, NULL, FILE_END);
+    }
+#else
+    int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    this->output = open(this->filename.c_str(), flags,
+        S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+    if (this->output != NO_OUTPUT)
+    {
+        chmod(this->filename.c_str(),S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+
+        // O_APPEND only moves to the end on each write, but tell()
+        // should already report the end of the file.
+        if (append)
+            lseek(this->output, 0, SEEK_END);
+    }
+#endif
+
+    if (this->output == NO_OUTPUT)
+    {
+        std::string error(GetLastErrorString());
+        Logger* logger = Logger::Get("Filesystem.FileStream");
+        logger->Error("Error in open. Exception: %s", error.c_str());
+        throw ValueException::FromFormat("Could not open %s: %s",
+            this->filename.c_str(), error.c_str());
+    }
+
+    this->writeBuffer.reserve(WRITE_BUFFER_SIZE);
+}
+
 bool FileStream::IsOpen() const
 {
-    return this->stream != NULL;
+    return this->istream || !this->mapped.isNull() || this->output != NO_OUTPUT;
 }
 
 void FileStream::Close()
 {
+    // Slices already handed out keep the mapping alive on their own.
+    this->mapped = 0;
+    this->mappedPosition = 0;
+
+    if (this->output != NO_OUTPUT)
+        this->CloseOutput();
+
     try
     {
-        if (this->stream)
+        if (this->istream)
         {
-            if (this->ostream)
-            {
-                this->ostream->flush();
-            }
-
-            this->stream->close();
-            delete this->stream;
-            this->stream = NULL;
+            this->istream->close();
+            delete this->istream;
             this->istream = NULL;
-            this->ostream = NULL;
         }
     }
     catch (Poco::Exception& exc)
@@ -163,50 +258,223 @@ void FileStream::Close()
     }
 }
 
-void FileStream::Seek(int offset, int direction)
+void FileStream::CloseOutput()
 {
-    if (this->istream)
-        this->istream->seekg(offset, (std::ios::seekdir)direction);
-    else if (this->ostream)
-        this->ostream->seekp(offset, (std::ios::seekdir)direction);
+    std::string error;
+    try
+    {
+        this->Flush();
+    }
+    catch (ValueException& e)
+    {
+        error = e.ToString();
+    }
+
+#ifdef OS_WIN32
+    CloseHandle(this->output);
+#else
+    close(this->output);
+#endif
+    this->output = NO_OUTPUT;
+    std::vector<char>().swap(this->writeBuffer);
+
+    if (!error.empty())
+    {
+        Logger* logger = Logger::Get("Filesystem.FileStream");
+        logger->Error("Error in close. Exception: %s", error.c_str());
+        throw ValueException::FromString(error);
+    }
+}
+
+void FileStream::Seek(Poco::Int64 offset, int direction)
+{
+    if (!this->mapped.isNull())
+    {
+        Poco::Int64 length = (Poco::Int64) this->mapped->Length();
+        Poco::Int64 base = 0;
+        if (direction == std::ios::cur)
+            base = (Poco::Int64) this->mappedPosition;
+        else if (direction == std::ios::end)
+            base = length;
+
+        Poco::Int64 position = base + offset;
+        if (position < 0)
+            position = 0;
+        this->mappedPosition = (size_t) std::min(position, length);
+    }
+    else if (this->istream)
+    {
+        this->istream->seekg((std::streamoff) offset,
+            (std::ios::seekdir) direction);
+    }
+    else if (this->output != NO_OUTPUT)
+    {
+        this->Flush();
+
+#ifdef OS_WIN32
+        DWORD method = FILE_BEGIN;
+        if (direction == std::ios::cur)
+            method = FILE_CURRENT;
+        else if (direction == std::ios::end)
+            method = FILE_END;
+
+        LARGE_INTEGER distance;
+        distance.QuadPart = offset;
+        if (!SetFilePointerEx(this->output, distance, NULL, method))
+#else
+        int whence = SEEK_SET;
+        if (direction == std::ios::cur)
+            whence = SEEK_CUR;
+        else if (direction == std::ios::end)
+            whence = SEEK_END;
+
+        // Without large file support off_t is only 32 bits wide.
+        if ((Poco::Int64) (off_t) offset != offset)
+            throw ValueException::FromFormat("Seek offset is too large for %s",
+                this->filename.c_str());
+
+        if (lseek(this->output, (off_t) offset, whence) < 0)
+#endif
+            throw ValueException::FromFormat("Could not seek in %s: %s",
+                this->filename.c_str(), GetLastErrorString().c_str());
+    }
     else
+    {
         throw ValueException::FromString("FileStream must be opened before seeking");
+    }
 }
 
-int FileStream::Tell()
+Poco::Int64 FileStream::Tell()
 {
-    if (this->istream)
-        return this->istream->tellg();
-    else if (this->ostream)
-        return this->ostream->tellp();
+    if (!this->mapped.isNull())
+        return (Poco::Int64) this->mappedPosition;
+    else if (this->istream)
+        return (Poco::Int64) (std::streamoff) this->istream->tellg();
+    else if (this->output != NO_OUTPUT)
+    {
+        // Buffered data has not reached the file yet, but it is
+        // still part of what has been written.
+#ifdef OS_WIN32
+        LARGE_INTEGER zero, position;
+        zero.QuadPart = 0;
+        if (!SetFilePointerEx(this->output, zero, &position, FILE_CURRENT))
+            position.QuadPart = -1;
+        long long offset = position.QuadPart;
+#else
+        off_t offset = lseek(this->output, 0, SEEK_CUR);
+#endif
+        if (offset < 0)
+            throw ValueException::FromFormat("Could not tell position in %s: %s",
+                this->filename.c_str(), GetLastErrorString().c_str());
+        return (Poco::Int64) offset + (Poco::Int64) this->writeBuffer.size();
+    }
 
     throw ValueException::FromString("FileStream must be opend before using tell");
 }
 
 void FileStream::Write(const char* buffer, size_t size)
 {
-    if(!this->ostream)
+    if (this->output == NO_OUTPUT)
         throw ValueException::FromString("FileStream must be opened for writing before calling write");
 
-    try {
-        this->ostream->write(buffer, size);
+    if (this->writeBuffer.size() + size > WRITE_BUFFER_SIZE)
+        this->Flush();
+
+    // Anything at least as big as the buffer would only be copied
+    // into it to be written out again straight away.
+    if (size >= WRITE_BUFFER_SIZE)
+        this->WriteOutput(buffer, size);
+    else
+        this->writeBuffer.insert(this->writeBuffer.end(), buffer, buffer + size);
+}
+
+void FileStream::WriteOutput(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+#ifdef OS_WIN32
+        DWORD chunk = (DWORD) std::min(size, (size_t) 0x40000000);
+        DWORD written = 0;
+        if (!WriteFile(this->output, data, chunk, &written, NULL))
+#else
+        ssize_t written = write(this->output, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0)
+#endif
+        {
+            std::string error(GetLastErrorString());
+            Logger* logger = Logger::Get("Filesystem.FileStream");
+            logger->Error("Error in write. Exception: %s", error.c_str());
+            throw ValueException::FromFormat("Could not write to %s: %s",
+                this->filename.c_str(), error.c_str());
+        }
+
+        data += written;
+        size -= written;
     }
-    catch (Poco::Exception& ex) {
-        Logger* logger = Logger::Get("Filesystem.FileStream");
-        logger->Error("Error in write. Exception: %s",ex.displayText().c_str());
-        throw ValueException::FromString(ex.displayText());
+}
+
+void FileStream::Flush()
+{
+    if (this->output == NO_OUTPUT)
+        throw ValueException::FromString("FileStream must be opened for writing before calling flush");
+
+    if (this->writeBuffer.empty())
+        return;
+
+    // Drop the buffered data even if writing it fails, so that
+    // a later flush or close does not write it a second time.
+    try
+    {
+        this->WriteOutput(&this->writeBuffer[0], this->writeBuffer.size());
     }
+    catch (ValueException&)
+    {
+        this->writeBuffer.clear();
+        throw;
+    }
+    this->writeBuffer.clear();
+}
+
+void FileStream::Sync()
+{
+    this->Flush();
+
+#ifdef OS_WIN32
+    bool synced = FlushFileBuffers(this->output) != 0;
+#elif defined(OS_OSX)
+    // fsync only hands the data to the drive, which may keep it in
+    // its own cache. F_FULLFSYNC is not supported by every filesystem.
+    bool synced = fcntl(this->output, F_FULLFSYNC) == 0 ||
+        fsync(this->output) == 0;
+#else
+    bool synced = fsync(this->output) == 0;
+#endif
+
+    if (!synced)
+        throw ValueException::FromFormat("Could not sync %s: %s",
+            this->filename.c_str(), GetLastErrorString().c_str());
 }
 
 bool FileStream::IsWritable() const
 {
-    return this->ostream != NULL;
+    return this->output != NO_OUTPUT;
 }
 
 size_t FileStream::Read(const char* buffer, size_t size)
 {
+    if (!this->mapped.isNull())
+    {
+        size_t count = std::min(size,
+            this->mapped->Length() - this->mappedPosition);
+        memcpy((char*) buffer, this->mapped->Pointer() + this->mappedPosition, count);
+        this->mappedPosition += count;
+        return count;
+    }
+
     if(!this->istream)
-        throw ValueException::FromString("FileStream must be opened for writing before calling write");
+        throw ValueException::FromString("FileStream must be opened for reading before calling read");
 
     try {
         this->istream->read((char*)buffer, size);
@@ -221,7 +489,35 @@ size_t FileStream::Read(const char* buffer, size_t size)
 
 bool FileStream::IsReadable() const
 {
-    return this->istream != NULL;
+    return this->istream != NULL || !this->mapped.isNull();
+}
+
+BytesRef FileStream::ReadMapped(size_t size)
+{
+    size_t count = std::min(size,
+        this->mapped->Length() - this->mappedPosition);
+    BytesRef slice(new Bytes(this->mapped, this->mappedPosition, count));
+    this->mappedPosition += count;
+    return slice;
+}
+
+BytesRef FileStream::ReadMappedLine()
+{
+    size_t length = this->mapped->Length();
+    if (this->mappedPosition >= length)
+        return 0;
+
+    const char* data = this->mapped->Pointer();
+    const char* start = data + this->mappedPosition;
+    const char* newline = (const char*) memchr(start, '\n', length - this->mappedPosition);
+    const char* end = newline ? newline : data + length;
+
+    // Step over the newline, but leave it and any CR before it out of the line.
+    this->mappedPosition = newline ? (newline - data) + 1 : length;
+    if (end > start && *(end - 1) == '\r')
+        end--;
+
+    return new Bytes(this->mapped, start - data, end - start);
 }
 
 void FileStream::_Open(const ValueList& args, ValueRef result)
@@ -248,16 +544,21 @@ void FileStream::_Close(const ValueList& args, ValueRef result)
 
 void FileStream::_Seek(const ValueList& args, ValueRef result)
 {
-    args.VerifyException("seek", "i?i");
+    args.VerifyException("seek", "n?i");
+
+    // Offsets arrive as JavaScript numbers, which hold whole
+    // numbers exactly only up to 2^53.
+    double offset = args.GetNumber(0);
+    if (!(std::fabs(offset) <= 9007199254740992.0) || std::floor(offset) != offset)
+        throw ValueException::FromString("Seek offset must be a whole number");
 
-    int offset = args.GetInt(0);
     int direction = args.GetInt(1, std::ios::beg);
-    this->Seek(offset, direction);
+    this->Seek((Poco::Int64) offset, direction);
 }
 
 void FileStream::_Tell(const ValueList& args, ValueRef result)
 {
-    result->SetInt(this->Tell());
+    result->SetDouble((double) this->Tell());
 }
 
 void FileStream::_Write(const ValueList& args, ValueRef result)
@@ -318,6 +619,30 @@ void FileStream::_Read(const ValueList& args, ValueRef result)
 {
     args.VerifyException("read", "?i");
 
+    if (!this->mapped.isNull())
+    {
+        if (args.size() >= 1)
+        {
+            int size = args.GetInt(0);
+            if (size <= 0)
+                throw ValueException::FromString("File.read() size must be greater than zero");
+
+            BytesRef slice(this->ReadMapped(size));
+            if (slice->Length() > 0)
+                result->SetObject(slice);
+            else
+                result->SetNull();
+        }
+        else
+        {
+            result->SetObject(this->ReadMapped(-1));
+        }
+        return;
+    }
+
+    if (!this->istream)
+        throw ValueException::FromString("FileStream must be opened for reading before calling read");
+
     try
     {
         if (args.size() >= 1)
@@ -342,9 +667,28 @@ void FileStream::_Read(const ValueList& args, ValueRef result)
         }
         else
         {
-            // If no read size is provided, read the entire file.
-            // TODO: this is not a very efficent method and should be deprecated
-            // and replaced by buffered stream transports
+            // If no read size is provided, read the rest of the file,
+            // straight into a single Bytes when its size is known.
+            std::streampos start = this->istream->tellg();
+            this->istream->seekg(0, std::ios::end);
+            std::streampos end = this->istream->tellg();
+            this->istream->seekg(start);
+            if (start >= 0 && end >= start)
+            {
+                size_t size = (size_t) (end - start);
+                BytesRef bytes(new Bytes(size));
+                this->istream->read(bytes->Pointer(), size);
+                size_t readCount = this->istream->gcount();
+                if (readCount < size)
+                    bytes = new Bytes(bytes, 0, readCount);
+
+                // Leave the stream at EOF, as reading it in chunks did.
+                this->istream->peek();
+                result->SetObject(bytes);
+                return;
+            }
+
+            this->istream->clear();
             std::vector<char> buffer;
             char data[4096];
 
@@ -372,6 +716,16 @@ void FileStream::_Read(const ValueList& args, ValueRef result)
 
 void FileStream::_ReadLine(const ValueList& args, ValueRef result)
 {
+    if (!this->mapped.isNull())
+    {
+        BytesRef line(this->ReadMappedLine());
+        if (line.isNull())
+            result->SetNull();
+        else
+            result->SetObject(line);
+        return;
+    }
+
     try
     {
         if (!this->istream)
@@ -431,7 +785,7 @@ void FileStream::_WriteLine(const ValueList& args, ValueRef result)
 {
     args.VerifyException("writeLine", "s|o|n");
 
-    if(! this->stream)
+    if(!this->IsOpen())
     {
         throw ValueException::FromString("FileStream must be opened before calling readLine");
     }
@@ -494,14 +848,28 @@ void FileStream::_WriteLine(const ValueList& args, ValueRef result)
 
 void FileStream::_Ready(const ValueList& args, ValueRef result)
 {
-    if(!this->stream)
+    if (!this->mapped.isNull())
     {
-        result->SetBool(false);
+        result->SetBool(this->mappedPosition < this->mapped->Length());
+    }
+    else if (this->istream)
+    {
+        result->SetBool(this->istream->eof()==false);
     }
     else
     {
-        result->SetBool(this->stream->eof()==false);
+        result->SetBool(this->output != NO_OUTPUT);
     }
 }
 
+void FileStream::_Flush(const ValueList& args, ValueRef result)
+{
+    this->Flush();
+}
+
+void FileStream::_Sync(const ValueList& args, ValueRef result)
+{
+    this->Sync();
+}
+
 }
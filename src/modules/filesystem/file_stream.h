@@ -40,9 +40,15 @@
 #endif
 
 #include <string>
+#include <vector>
 
 #include <tide/tide.h>
 #include <Poco/FileStream.h>
+#include <Poco/Types.h>
+
+#ifdef OS_WIN32
+#include <windows.h>
+#endif
 
 namespace ti {
 
@@ -51,7 +57,8 @@ public:
     enum FileStreamMode {
         MODE_READ = 1,
         MODE_APPEND = 2,
-        MODE_WRITE = 3
+        MODE_WRITE = 3,
+        MODE_MAPPED = 4
     };
 
     FileStream(std::string filename);
@@ -61,8 +68,13 @@ public:
     bool IsOpen() const;
     void Close();
 
-    void Seek(int offset, int direction);
-    int Tell();
+    void Seek(Poco::Int64 offset, int direction);
+    Poco::Int64 Tell();
+
+    // Hand buffered writes to the operating system, and with
+    // Sync, wait until they have reached the disk.
+    void Flush();
+    void Sync();
 
     virtual void Write(const char* buffer, size_t size);
     virtual bool IsWritable() const;
@@ -83,12 +95,31 @@ private:
     void _ReadLine(const ValueList& args, ValueRef result);
     void _WriteLine(const ValueList& args, ValueRef result);
     void _Ready(const ValueList& args, ValueRef result);
+    void _Flush(const ValueList& args, ValueRef result);
+    void _Sync(const ValueList& args, ValueRef result);
+
+    void OpenOutput(bool append);
+    void WriteOutput(const char* data, size_t size);
+    void CloseOutput();
+    BytesRef ReadMapped(size_t size);
+    BytesRef ReadMappedLine();
 
     std::string filename;
 
     Poco::FileInputStream* istream;
-    Poco::FileOutputStream* ostream;
-    Poco::FileIOS* stream;
+
+    // MODE_MAPPED reads hand out slices of the mapping instead of copies.
+    BytesRef mapped;
+    size_t mappedPosition;
+
+    // Output goes straight to the file, through a large buffer which
+    // is only written out when full, on flush(), sync() and close().
+#ifdef OS_WIN32
+    HANDLE output;
+#else
+    int output;
+#endif
+    std::vector<char> writeBuffer;
 };
 
 }
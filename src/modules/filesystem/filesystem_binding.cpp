@@ -91,6 +91,7 @@ namespace ti
         this->SetInt("MODE_READ", FileStream::MODE_READ);
         this->SetInt("MODE_WRITE", FileStream::MODE_WRITE);
         this->SetInt("MODE_APPEND", FileStream::MODE_APPEND);
+        this->SetInt("MODE_MAPPED", FileStream::MODE_MAPPED);
         this->SetInt("SEEK_START", std::ios::beg);
         this->SetInt("SEEK_CURRENT", std::ios::cur);
         this->SetInt("SEEK_END", std::ios::end);
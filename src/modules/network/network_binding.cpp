@@ -178,6 +178,29 @@ namespace ti
          */
         this->SetMethod("getHTTPSProxy", &NetworkBinding::_GetHTTPSProxy);
 
+        /**
+         * @tiapi(method=True,name=Network.setHTTPMaxConnectionsPerHost,since=1.3.2)
+         * @tiapi Set how many connections asynchronous HTTPClient requests may open
+         * @tiapi to a single host. Further requests to that host wait for a free
+         * @tiapi connection. The default is 6.
+         * @tiarg[Number, connections] The maximum number of connections per host.
+         */
+        this->SetMethod("setHTTPMaxConnectionsPerHost", &NetworkBinding::_SetHTTPMaxConnectionsPerHost);
+
+        /**
+         * @tiapi(method=True,name=Network.getHTTPMaxConnectionsPerHost,since=1.3.2)
+         * @tiresult[Number] The maximum number of connections per host.
+         */
+        this->SetMethod("getHTTPMaxConnectionsPerHost", &NetworkBinding::_GetHTTPMaxConnectionsPerHost);
+
+        /**
+         * @tiapi(method=True,name=Network.getHTTPClientStats,since=1.3.2)
+         * @tiapi Get the counters of the engine which runs asynchronous HTTPClient requests.
+         * @tiresult[Object] An object with the number of active, waiting and completed
+         * @tiresult transfers, the number of reused and idle handles and the per-host limit.
+         */
+        this->SetMethod("getHTTPClientStats", &NetworkBinding::_GetHTTPClientStats);
+
         /**
          * @tiapi(method=True,name=Network.getInterfaces,since=0.9)
          * Get a list of interfaces active on this machine.
@@ -405,6 +428,22 @@ namespace ti
             result->SetString(proxy->ToString().c_str());
     }
 
+    void NetworkBinding::_SetHTTPMaxConnectionsPerHost(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setHTTPMaxConnectionsPerHost", "n");
+        HTTPClientEngine::GetInstance()->SetMaxConnectionsPerHost(args.GetInt(0));
+    }
+
+    void NetworkBinding::_GetHTTPMaxConnectionsPerHost(const ValueList& args, ValueRef result)
+    {
+        result->SetInt(HTTPClientEngine::GetInstance()->GetMaxConnectionsPerHost());
+    }
+
+    void NetworkBinding::_GetHTTPClientStats(const ValueList& args, ValueRef result)
+    {
+        result->SetObject(HTTPClientEngine::GetInstance()->GetStatsObject());
+    }
+
     Host* NetworkBinding::GetHost()
     {
         return this->host;
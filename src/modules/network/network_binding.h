@@ -78,6 +78,9 @@ namespace ti
         void _SetHTTPSProxy(const ValueList& args, ValueRef result);
         void _GetHTTPProxy(const ValueList& args, ValueRef result);
         void _GetHTTPSProxy(const ValueList& args, ValueRef result);
+        void _SetHTTPMaxConnectionsPerHost(const ValueList& args, ValueRef result);
+        void _GetHTTPMaxConnectionsPerHost(const ValueList& args, ValueRef result);
+        void _GetHTTPClientStats(const ValueList& args, ValueRef result);
     };
 }
 
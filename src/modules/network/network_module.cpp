@@ -38,6 +38,8 @@
 using namespace TideUtils;
 
 #include "network_module.h"
+#include "network_reactor.h"
+#include "protocols/http/http_client_engine.h"
 #include <Poco/Mutex.h>
 
 using namespace tide;
@@ -52,6 +54,7 @@ namespace ti
     {
         static Poco::Mutex cookieMutex;
         static Poco::Mutex dnsMutex;
+        static Poco::Mutex sslSessionMutex;
         static Poco::Mutex shareMutex;
 
         switch (data) {
@@ -59,6 +62,8 @@ namespace ti
                 return &cookieMutex;
             case CURL_LOCK_DATA_DNS:
                 return &dnsMutex;
+            case CURL_LOCK_DATA_SSL_SESSION:
+                return &sslSessionMutex;
             case CURL_LOCK_DATA_SHARE:
                 return &shareMutex;
             default:
@@ -92,6 +97,7 @@ namespace ti
         curlShareHandle = curl_share_init();
         curl_share_setopt(curlShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
         curl_share_setopt(curlShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(curlShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
         curl_share_setopt(curlShareHandle, CURLSHOPT_LOCKFUNC, CurlLockCallback);
         curl_share_setopt(curlShareHandle, CURLSHOPT_UNLOCKFUNC, CurlUnlockCallback);
     }
@@ -99,6 +105,8 @@ namespace ti
     void NetworkModule::Stop()
     {
         analyticsBinding->Shutdown();
+        HTTPClientEngine::Shutdown();
+        NetworkReactor::Shutdown();
     }
 
     /*static*/
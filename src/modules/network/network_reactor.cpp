@@ -0,0 +1,540 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* Copyright (c) 2012 Mital Vora
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "network_reactor.h"
+#include <Poco/Net/SocketImpl.h>
+
+#if defined(OS_LINUX)
+#include <sys/epoll.h>
+#endif
+
+#if !defined(OS_WIN32)
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+// Linux spreads sockets across a couple of epoll loops; elsewhere a single
+// poll loop is plenty for the number of sockets an application opens.
+#if defined(OS_LINUX)
+#define REACTOR_LOOP_COUNT 2
+#else
+#define REACTOR_LOOP_COUNT 1
+#endif
+
+// How often idle timeouts are checked while any socket has one set.
+#define TIMEOUT_CHECK_MILLISECONDS 100
+
+#if defined(OS_WIN32)
+// WSAPoll has no way to be woken early, so registration changes
+// are picked up on this interval instead.
+#define POLL_INTERVAL_MILLISECONDS 50
+#endif
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        return Logger::Get("Network.Reactor");
+    }
+
+    class NetworkReactor::EventLoop : public Poco::Runnable
+    {
+    public:
+        EventLoop();
+        ~EventLoop();
+
+        void Start();
+        void Stop();
+        void Add(poco_socket_t fd, Handler* handler, TiObjectRef owner, int events);
+        void Modify(poco_socket_t fd, int events);
+        void SetTimeout(poco_socket_t fd, long milliseconds);
+        void Remove(poco_socket_t fd);
+        size_t Size();
+        void run();
+
+    private:
+        struct Registration
+        {
+            Handler* handler;
+            TiObjectRef owner;
+            int events;
+            long timeout;
+            Poco::Timestamp lastActivity;
+        };
+
+        typedef std::map<poco_socket_t, Registration> RegistrationMap;
+        typedef std::vector<std::pair<poco_socket_t, int> > ReadyList;
+
+        Poco::FastMutex mutex;
+        RegistrationMap registrations;
+        size_t timeoutCount;
+        Poco::Thread thread;
+        volatile bool running;
+
+#if defined(OS_LINUX)
+        int epollFd;
+        void Control(int operation, poco_socket_t fd, int events);
+#endif
+#if !defined(OS_WIN32)
+        int wakeFds[2];
+#endif
+
+        void Wake();
+        void Wait(ReadyList& ready, int timeoutMillis);
+        void Dispatch(poco_socket_t fd, int ready);
+        void CheckTimeouts();
+    };
+
+    NetworkReactor::EventLoop::EventLoop() :
+        timeoutCount(0),
+        running(false)
+    {
+#if !defined(OS_WIN32)
+        if (pipe(wakeFds) != 0)
+            throw ValueException::FromString("Could not create network reactor wake pipe");
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+#endif
+
+#if defined(OS_LINUX)
+        epollFd = epoll_create(256);
+        if (epollFd < 0)
+            throw ValueException::FromString("Could not create network reactor epoll instance");
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = wakeFds[0];
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFds[0], &event);
+#endif
+    }
+
+    NetworkReactor::EventLoop::~EventLoop()
+    {
+#if defined(OS_LINUX)
+        close(epollFd);
+#endif
+#if !defined(OS_WIN32)
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+#endif
+    }
+
+    void NetworkReactor::EventLoop::Start()
+    {
+        running = true;
+        thread.setName("Network Reactor");
+        thread.start(*this);
+    }
+
+    void NetworkReactor::EventLoop::Stop()
+    {
+        running = false;
+        this->Wake();
+        thread.join();
+
+        Poco::FastMutex::ScopedLock lock(mutex);
+        registrations.clear();
+    }
+
+    void NetworkReactor::EventLoop::Wake()
+    {
+#if !defined(OS_WIN32)
+        char byte = 0;
+        // A full pipe already guarantees a wakeup, so errors are fine here.
+        ssize_t written = write(wakeFds[1], &byte, 1);
+        (void) written;
+#endif
+    }
+
+#if defined(OS_LINUX)
+    void NetworkReactor::EventLoop::Control(int operation, poco_socket_t fd, int events)
+    {
+        struct epoll_event event;
+        event.events = 0;
+        if (events & READABLE)
+            event.events |= EPOLLIN;
+        if (events & WRITABLE)
+            event.events |= EPOLLOUT;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, operation, fd, &event);
+    }
+#endif
+
+    void NetworkReactor::EventLoop::Add(poco_socket_t fd, Handler* handler,
+        TiObjectRef owner, int events)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            Registration& registration = registrations[fd];
+            registration.handler = handler;
+            registration.owner = owner;
+            registration.events = events;
+            registration.timeout = 0;
+            registration.lastActivity.update();
+        }
+
+#if defined(OS_LINUX)
+        this->Control(EPOLL_CTL_ADD, fd, events);
+#else
+        this->Wake();
+#endif
+    }
+
+    void NetworkReactor::EventLoop::Modify(poco_socket_t fd, int events)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            RegistrationMap::iterator i = registrations.find(fd);
+            if (i == registrations.end() || i->second.events == events)
+                return;
+            i->second.events = events;
+        }
+
+#if defined(OS_LINUX)
+        this->Control(EPOLL_CTL_MOD, fd, events);
+#else
+        this->Wake();
+#endif
+    }
+
+    void NetworkReactor::EventLoop::SetTimeout(poco_socket_t fd, long milliseconds)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            RegistrationMap::iterator i = registrations.find(fd);
+            if (i == registrations.end())
+                return;
+
+            if (i->second.timeout > 0)
+                timeoutCount--;
+            if (milliseconds > 0)
+                timeoutCount++;
+            i->second.timeout = milliseconds;
+            i->second.lastActivity.update();
+        }
+
+        // The loop may be sleeping without a timeout.
+        this->Wake();
+    }
+
+    void NetworkReactor::EventLoop::Remove(poco_socket_t fd)
+    {
+        // Release the owner outside of the lock, since this
+        // may be the last reference to it.
+        TiObjectRef owner;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            RegistrationMap::iterator i = registrations.find(fd);
+            if (i == registrations.end())
+                return;
+
+            if (i->second.timeout > 0)
+                timeoutCount--;
+            owner = i->second.owner;
+            registrations.erase(i);
+        }
+
+#if defined(OS_LINUX)
+        this->Control(EPOLL_CTL_DEL, fd, 0);
+#else
+        this->Wake();
+#endif
+    }
+
+    size_t NetworkReactor::EventLoop::Size()
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        return registrations.size();
+    }
+
+    void NetworkReactor::EventLoop::Wait(ReadyList& ready, int timeoutMillis)
+    {
+#if defined(OS_LINUX)
+        struct epoll_event events[64];
+        int count = epoll_wait(epollFd, events, 64, timeoutMillis);
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == wakeFds[0])
+            {
+                char buffer[64];
+                while (read(wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+                continue;
+            }
+
+            // Errors and hangups are reported as readable, so that the
+            // handler's next read surfaces them.
+            int flags = 0;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                flags |= READABLE;
+            if (events[i].events & EPOLLOUT)
+                flags |= WRITABLE;
+            ready.push_back(std::make_pair(fd, flags));
+        }
+#else
+
+#if defined(OS_WIN32)
+        std::vector<WSAPOLLFD> fds;
+        if (timeoutMillis < 0 || timeoutMillis > POLL_INTERVAL_MILLISECONDS)
+            timeoutMillis = POLL_INTERVAL_MILLISECONDS;
+#else
+        std::vector<struct pollfd> fds;
+        struct pollfd wakeFd;
+        wakeFd.fd = wakeFds[0];
+        wakeFd.events = POLLIN;
+        wakeFd.revents = 0;
+        fds.push_back(wakeFd);
+#endif
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            RegistrationMap::iterator i = registrations.begin();
+            for (; i != registrations.end(); i++)
+            {
+#if defined(OS_WIN32)
+                WSAPOLLFD fd;
+                fd.events = ((i->second.events & READABLE) ? POLLRDNORM : 0) |
+                    ((i->second.events & WRITABLE) ? POLLWRNORM : 0);
+#else
+                struct pollfd fd;
+                fd.events = ((i->second.events & READABLE) ? POLLIN : 0) |
+                    ((i->second.events & WRITABLE) ? POLLOUT : 0);
+#endif
+                fd.fd = i->first;
+                fd.revents = 0;
+                fds.push_back(fd);
+            }
+        }
+
+#if defined(OS_WIN32)
+        if (fds.empty())
+        {
+            Poco::Thread::sleep(timeoutMillis);
+            return;
+        }
+        int count = WSAPoll(&fds[0], (ULONG) fds.size(), timeoutMillis);
+#else
+        int count = poll(&fds[0], fds.size(), timeoutMillis);
+#endif
+        for (size_t i = 0; count > 0 && i < fds.size(); i++)
+        {
+            if (!fds[i].revents)
+                continue;
+
+#if !defined(OS_WIN32)
+            if (fds[i].fd == wakeFds[0])
+            {
+                char buffer[64];
+                while (read(wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+                continue;
+            }
+#endif
+
+            int flags = 0;
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP))
+                flags |= READABLE;
+            if (fds[i].revents & POLLOUT)
+                flags |= WRITABLE;
+            ready.push_back(std::make_pair((poco_socket_t) fds[i].fd, flags));
+        }
+#endif
+    }
+
+    void NetworkReactor::EventLoop::Dispatch(poco_socket_t fd, int ready)
+    {
+        Handler* handler = 0;
+        TiObjectRef owner;
+        int events = 0;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            RegistrationMap::iterator i = registrations.find(fd);
+            if (i == registrations.end())
+                return;
+
+            handler = i->second.handler;
+            owner = i->second.owner;
+            events = i->second.events;
+            if (ready & READABLE)
+                i->second.lastActivity.update();
+        }
+
+        try
+        {
+            if ((ready & READABLE) && (events & READABLE))
+                handler->OnReadable();
+            if ((ready & WRITABLE) && (events & WRITABLE))
+                handler->OnWritable();
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Socket handler failed: %s", e.ToString().c_str());
+        }
+        catch (Poco::Exception& e)
+        {
+            GetLogger()->Error("Socket handler failed: %s", e.displayText().c_str());
+        }
+    }
+
+    void NetworkReactor::EventLoop::CheckTimeouts()
+    {
+        std::vector<std::pair<Handler*, TiObjectRef> > expired;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            if (timeoutCount == 0)
+                return;
+
+            RegistrationMap::iterator i = registrations.begin();
+            for (; i != registrations.end(); i++)
+            {
+                Registration& registration = i->second;
+                if (registration.timeout <= 0 ||
+                    !registration.lastActivity.isElapsed(registration.timeout * 1000))
+                    continue;
+
+                registration.lastActivity.update();
+                expired.push_back(std::make_pair(registration.handler, registration.owner));
+            }
+        }
+
+        for (size_t i = 0; i < expired.size(); i++)
+            expired[i].first->OnTimeout();
+    }
+
+    void NetworkReactor::EventLoop::run()
+    {
+        ReadyList ready;
+        while (running)
+        {
+            int timeoutMillis = -1;
+            {
+                Poco::FastMutex::ScopedLock lock(mutex);
+                if (timeoutCount > 0)
+                    timeoutMillis = TIMEOUT_CHECK_MILLISECONDS;
+            }
+
+            ready.clear();
+            this->Wait(ready, timeoutMillis);
+
+            for (size_t i = 0; running && i < ready.size(); i++)
+                this->Dispatch(ready[i].first, ready[i].second);
+
+            this->CheckTimeouts();
+        }
+    }
+
+    NetworkReactor* NetworkReactor::instance = 0;
+
+    static Poco::FastMutex& InstanceMutex()
+    {
+        static Poco::FastMutex mutex;
+        return mutex;
+    }
+
+    /*static*/
+    NetworkReactor* NetworkReactor::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        if (!instance)
+            instance = new NetworkReactor(REACTOR_LOOP_COUNT);
+        return instance;
+    }
+
+    /*static*/
+    void NetworkReactor::Shutdown()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        delete instance;
+        instance = 0;
+    }
+
+    NetworkReactor::NetworkReactor(size_t loopCount)
+    {
+        for (size_t i = 0; i < loopCount; i++)
+        {
+            EventLoop* loop = new EventLoop();
+            loop->Start();
+            loops.push_back(loop);
+        }
+    }
+
+    NetworkReactor::~NetworkReactor()
+    {
+        for (size_t i = 0; i < loops.size(); i++)
+        {
+            loops[i]->Stop();
+            delete loops[i];
+        }
+    }
+
+    NetworkReactor::EventLoop* NetworkReactor::LoopFor(poco_socket_t fd)
+    {
+        // A socket always maps to the same loop, so later calls
+        // for it find the loop which holds its registration.
+        return loops[((size_t) fd) % loops.size()];
+    }
+
+    void NetworkReactor::Register(Poco::Net::Socket& socket, Handler* handler,
+        TiObjectRef owner, int events)
+    {
+        poco_socket_t fd = socket.impl()->sockfd();
+        this->LoopFor(fd)->Add(fd, handler, owner, events);
+    }
+
+    void NetworkReactor::SetEvents(Poco::Net::Socket& socket, int events)
+    {
+        poco_socket_t fd = socket.impl()->sockfd();
+        this->LoopFor(fd)->Modify(fd, events);
+    }
+
+    void NetworkReactor::SetTimeout(Poco::Net::Socket& socket, long milliseconds)
+    {
+        poco_socket_t fd = socket.impl()->sockfd();
+        this->LoopFor(fd)->SetTimeout(fd, milliseconds);
+    }
+
+    void NetworkReactor::Unregister(Poco::Net::Socket& socket)
+    {
+        poco_socket_t fd = socket.impl()->sockfd();
+        this->LoopFor(fd)->Remove(fd);
+    }
+
+    size_t NetworkReactor::GetSocketCount()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < loops.size(); i++)
+            count += loops[i]->Size();
+        return count;
+    }
+}
@@ -0,0 +1,106 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef TI_NETWORK_REACTOR_H_
+#define TI_NETWORK_REACTOR_H_
+
+#include <tide/tide.h>
+#include <map>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Net/Socket.h>
+
+namespace ti
+{
+    /**
+     * A small, shared event loop for network sockets. Instead of a thread per
+     * socket, every socket registers a Handler here and a few loop threads
+     * multiplex all of them with epoll (Linux), poll (other POSIX systems)
+     * or WSAPoll (Windows).
+     *
+     * Registrations are level-triggered. Handlers are called on a loop
+     * thread and must not block; anything that needs JavaScript should be
+     * posted to the main thread. While a socket is registered the reactor
+     * keeps its owner object alive, so a connection cannot disappear in the
+     * middle of a callback. A handler may still see one callback after it
+     * has unregistered, and must ignore it.
+     */
+    class NetworkReactor
+    {
+    public:
+        enum
+        {
+            READABLE = 1,
+            WRITABLE = 2
+        };
+
+        class Handler
+        {
+        public:
+            virtual ~Handler() {}
+            virtual void OnReadable() = 0;
+            virtual void OnWritable() {}
+            virtual void OnTimeout() {}
+        };
+
+        static NetworkReactor* GetInstance();
+        static void Shutdown();
+
+        void Register(Poco::Net::Socket& socket, Handler* handler,
+            TiObjectRef owner, int events = READABLE);
+        void SetEvents(Poco::Net::Socket& socket, int events);
+        void SetTimeout(Poco::Net::Socket& socket, long milliseconds);
+        void Unregister(Poco::Net::Socket& socket);
+
+        size_t GetLoopCount() { return loops.size(); }
+        size_t GetSocketCount();
+
+        class EventLoop;
+
+    private:
+        NetworkReactor(size_t loopCount);
+        ~NetworkReactor();
+        EventLoop* LoopFor(poco_socket_t fd);
+
+        std::vector<EventLoop*> loops;
+        static NetworkReactor* instance;
+
+        DISALLOW_EVIL_CONSTRUCTORS(NetworkReactor);
+    };
+}
+
+#endif
@@ -44,6 +44,13 @@ using namespace TideUtils;
 
 using Poco::Net::NameValueCollection;
 
+// Responses received into a file are written in blocks of this size.
+#define RESPONSE_FILE_BUFFER_SIZE (1024 * 1024)
+
+// Data handed to a receive() handler which it has not processed yet. Once
+// this much is waiting the transfer is paused until the handler catches up.
+#define DEFAULT_MAX_BUFFERED_DATA (4 * 1024 * 1024)
+
 namespace ti
 {
     static Logger* GetLogger()
@@ -52,20 +59,39 @@ namespace ti
         return logger;
     }
 
+    static ValueRef DispatchClientEvent(const ValueList& args)
+    {
+        AutoPtr<HTTPClientBinding> client(args.GetObject(0).cast<HTTPClientBinding>());
+        std::string eventName(args.GetString(1));
+        client->DispatchEvent(eventName, args.GetInt(2));
+        return Value::Undefined;
+    }
+
+    static ValueRef DeliverClientChunk(const ValueList& args)
+    {
+        AutoPtr<HTTPClientBinding> client(args.GetObject(0).cast<HTTPClientBinding>());
+        client->DeliverChunk(args.GetObject(1).cast<Bytes>());
+        return Value::Undefined;
+    }
+
     HTTPClientBinding::HTTPClientBinding(Host* host) :
         EventObject("Network.HTTPClient"),
         host(host),
         async(true),
         timeout(5 * 60 * 1000),
         maxRedirects(-1),
+        maxBufferedData(DEFAULT_MAX_BUFFERED_DATA),
         curlHandle(0),
-        thread(0),
+        curlHeaders(0),
         requestBytes(0),
-        responseStream(0),
+        keepResponseData(true),
+        responseTextStale(false),
         requestContentLength(0),
         requestDataSent(0),
         requestDataWritten(0),
         responseDataReceived(0),
+        bufferedData(0),
+        paused(false),
         postData(0),
         sendData(0)
     {
@@ -86,6 +112,8 @@ namespace ti
         this->SetMethod("getTimeout", &HTTPClientBinding::GetTimeout);
         this->SetMethod("getMaxRedirects", &HTTPClientBinding::GetMaxRedirects);
         this->SetMethod("setMaxRedirects", &HTTPClientBinding::SetMaxRedirects);
+        this->SetMethod("getMaxBufferedData", &HTTPClientBinding::GetMaxBufferedData);
+        this->SetMethod("setMaxBufferedData", &HTTPClientBinding::SetMaxBufferedData);
         this->SetInt("readyState", 0);
         this->SetInt("UNSENT", 0);
         this->SetInt("OPENED", 1);
@@ -117,6 +145,14 @@ namespace ti
     void HTTPClientBinding::Abort(const ValueList& args, ValueRef result)
     {
         this->aborted = true;
+
+        // A paused transfer only notices the abort once it runs again.
+        // The handle is read under the lock which CleanupCurl clears it
+        // under, so it can't have gone to another client yet.
+        Poco::FastMutex::ScopedLock lock(responseMutex);
+        if (this->paused && this->curlHandle)
+            HTTPClientEngine::GetInstance()->ResumeTransfer(this->curlHandle);
+        this->paused = false;
     }
 
     void HTTPClientBinding::Open(const ValueList& args, ValueRef result)
@@ -174,28 +210,56 @@ namespace ti
         args.VerifyException("send", "?s|o|0");
         ValueRef sendData(args.GetValue(0));
 
-        // Setup output stream for data
-        this->responseStream = new std::ostringstream(std::ios::binary | std::ios::out);
+        // Keep the response around for responseText and responseData
+        this->keepResponseData = true;
+        this->responseFilePath.clear();
         result->SetBool(this->BeginRequest(sendData));
     }
 
+    static std::string ObjectToNativePath(TiObjectRef dataObject)
+    {
+        TiMethodRef nativePathMethod(dataObject->GetMethod("nativePath", 0));
+        if (nativePathMethod.isNull())
+            return std::string();
+
+        ValueRef pathValue(nativePathMethod->Call());
+        if (!pathValue->IsString())
+            return std::string();
+
+        return pathValue->ToString();
+    }
+
     void HTTPClientBinding::Receive(const ValueList& args, ValueRef result)
     {
-        args.VerifyException("receive", "m|o ?s|o|0");
+        args.VerifyException("receive", "m|o|s ?s|o|0");
 
-        // Set output handler
-        this->responseStream = 0;
+        // The response is streamed to the handler or file, so it is not
+        // also collected in memory.
+        this->keepResponseData = false;
+        this->responseFilePath.clear();
+        this->outputHandler = 0;
         result->SetBool(false);
 
-        if (args.at(0)->IsMethod())
+        if (args.at(0)->IsString())
+        {
+            this->responseFilePath = args.GetString(0);
+        }
+        else if (args.at(0)->IsMethod())
         {
             this->outputHandler = args.at(0)->ToMethod();
         }
         else if (args.at(0)->IsObject())
         {
+            // Files are written natively on the transfer thread instead of
+            // going through the main thread for every chunk.
             TiObjectRef handlerObject(args.at(0)->ToObject());
+            std::string path(ObjectToNativePath(handlerObject));
             TiMethodRef writeMethod(handlerObject->GetMethod("write", 0));
-            if (writeMethod.isNull())
+            if (!path.empty())
+            {
+                this->responseFilePath = path;
+            }
+            else if (writeMethod.isNull())
             {
                 GetLogger()->Error("Unsupported object type as output handler:"
                     " does not have write method");
@@ -314,8 +378,82 @@ namespace ti
         this->maxRedirects = args.GetInt(0);
     }
 
+    void HTTPClientBinding::GetMaxBufferedData(const ValueList& args, ValueRef result)
+    {
+        Poco::FastMutex::ScopedLock lock(responseMutex);
+        result->SetInt(this->maxBufferedData);
+    }
+
+    void HTTPClientBinding::SetMaxBufferedData(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("setMaxBufferedData", "n");
+        int maxBufferedData = args.GetInt(0);
+        if (maxBufferedData < 1)
+            throw ValueException::FromString(
+                "The maximum amount of buffered data must be at least 1 byte");
+
+        Poco::FastMutex::ScopedLock lock(responseMutex);
+        this->maxBufferedData = maxBufferedData;
+    }
+
+    ValueRef HTTPClientBinding::Get(const char* name)
+    {
+        // Joining the received chunks copies the whole response, so it is
+        // only done when a script actually reads responseText.
+        if (!strcmp(name, "responseText"))
+        {
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            if (this->responseTextStale)
+            {
+                this->responseTextStale = false;
+                std::string text(Bytes::Concat(this->responseData)->AsString());
+                if (!text.empty())
+                    this->SetString("responseText", text);
+            }
+        }
+
+        return EventObject::Get(name);
+    }
+
+    bool HTTPClientBinding::PostToMainThread(std::string& eventName, int readyState)
+    {
+        // Asynchronous transfers all run on the shared engine thread, which
+        // must never wait for the main thread, so their events are queued.
+        if (!this->async || IsMainThread())
+            return false;
+
+        ValueList args;
+        args.push_back(Value::NewObject(GetAutoPtr()));
+        args.push_back(Value::NewString(eventName));
+        args.push_back(Value::NewInt(readyState));
+        TiMethodRef dispatch(new FunctionPtrMethod(&DispatchClientEvent));
+
+        if (eventName == Event::HTTP_DATA_RECEIVED || eventName == Event::HTTP_DATA_SENT)
+        {
+            std::ostringstream key;
+            key << "dispatch:" << eventName << ':' << this;
+            RunOnMainThreadCoalesced(key.str(), dispatch, GetAutoPtr(), args);
+        }
+        else
+        {
+            RunOnMainThread(dispatch, args, false);
+        }
+        return true;
+    }
+
+    void HTTPClientBinding::DispatchEvent(std::string& eventName, int readyState)
+    {
+        if (readyState >= 0)
+            this->ChangeState(readyState);
+        else
+            this->FireEvent(eventName);
+    }
+
     bool HTTPClientBinding::FireEvent(std::string& eventName)
     {
+        if (this->PostToMainThread(eventName))
+            return true;
+
         // We're already exposed as an AutoPtr somewhere else, so we must create
         // an AutoPtr version of ourselves with the 'shared' argument set to true.
         ValueList args(Value::NewObject(GetAutoPtr()));
@@ -337,39 +475,23 @@ namespace ti
         }
         else if (eventName == Event::HTTP_DATA_RECEIVED && !this->ondatastream.isNull())
         {
-            RunOnMainThread(this->ondatastream, GetAutoPtr(), args, true);
+            // Progress handlers only care about the latest state, so collapse
+            // chunks which arrive faster than the main thread can keep up.
+            std::ostringstream key;
+            key << Event::HTTP_DATA_RECEIVED << ':' << this;
+            RunOnMainThreadCoalesced(key.str(), this->ondatastream, GetAutoPtr(), args);
         }
 
         return EventObject::FireEvent(eventName);
     }
 
-    void HTTPClientBinding::run()
-    {
-        START_TIDE_THREAD;
-
-        // We need this binding to stay alive at least until we have
-        // finished this thread. So save 'this' in an AutoPtr.
-        TiObjectRef save(this, true);
-        this->ExecuteRequest();
-
-        END_TIDE_THREAD;
-    }
-
     static std::string ObjectToFilename(TiObjectRef dataObject)
     {
-        // Now try to treat this object like as a file-like object with
-        // a .read() method which returns a Bytes. If this fails we'll
-        // return NULL.
-        TiMethodRef nativePathMethod(dataObject->GetMethod("nativePath", 0));
-        if (nativePathMethod.isNull())
-            return "data";
-
-        ValueRef pathValue(nativePathMethod->Call());
-        if (!pathValue->IsString())
+        std::string path(ObjectToNativePath(dataObject));
+        if (path.empty())
             return "data";
 
-        // If this cast fails, it will return NULL, as we expect.
-        return FileUtils::Basename(pathValue->ToString());
+        return FileUtils::Basename(path);
     }
 
     void HTTPClientBinding::AddScalarValueToCurlForm(SharedString propertyName,
@@ -448,7 +570,13 @@ namespace ti
         this->responseCookies.clear();
         this->aborted = false;
         this->requestBytes = 0;
-        this->responseData.clear();
+        {
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            this->responseData.clear();
+            this->responseTextStale = false;
+            this->bufferedData = 0;
+            this->paused = false;
+        }
 
         this->SetInt("dataSent", 0);
         this->SetInt("dataReceived", 0);
@@ -459,21 +587,21 @@ namespace ti
         this->SetNull("status");
         this->SetNull("statusText");
 
-        if (this->async)
-        {
-            this->thread = new Poco::Thread();
-            this->thread->start(*this);
-        }
-        else
-        {
-            this->ExecuteRequest();
-        }
+        if (!this->responseFilePath.empty() && !this->OpenResponseFile())
+            throw ValueException::FromFormat("Could not open %s to receive the response",
+                this->responseFilePath.c_str());
 
+        this->ExecuteRequest();
         return true;
     }
 
     void HTTPClientBinding::ChangeState(int readyState)
     {
+        // The new state is applied on the main thread, so that handlers
+        // always see the readyState their event was fired for.
+        if (this->PostToMainThread(Event::HTTP_STATE_CHANGED, readyState))
+            return;
+
         GetLogger()->Debug("Changing readyState from %d to %d for url:%s",
             this->GetInt("readyState", 0), readyState, this->url.c_str());
         this->SetInt("readyState", readyState);
@@ -542,12 +670,12 @@ namespace ti
         if (requestHeaders.empty())
             return NULL;
 
-        struct curl_slist* curlHeaders = NULL;
+        struct curl_slist* headers = NULL;
         for (size_t i = 0; i < requestHeaders.size(); i++)
-            curlHeaders = curl_slist_append(curlHeaders, requestHeaders[i].c_str());
+            headers = curl_slist_append(headers, requestHeaders[i].c_str());
 
-        SET_CURL_OPTION(curlHandle, CURLOPT_HTTPHEADER, curlHeaders);
-        return curlHeaders;
+        SET_CURL_OPTION(handle, CURLOPT_HTTPHEADER, headers);
+        return headers;
     }
 
     void SetRequestCookies(CURL* handle, NameValueCollection& cookies)
@@ -689,39 +817,141 @@ namespace ti
         return headerLineSize;
     }
 
-    void HTTPClientBinding::DataReceived(char* buffer, size_t bufferSize)
+    bool HTTPClientBinding::OpenResponseFile()
+    {
+        try
+        {
+            this->responseFile = new Poco::FileOutputStream(this->responseFilePath,
+                std::ios::out | std::ios::trunc | std::ios::binary);
+        }
+        catch (Poco::Exception& e)
+        {
+            GetLogger()->Error("Could not open %s: %s",
+                this->responseFilePath.c_str(), e.displayText().c_str());
+            return false;
+        }
+
+        this->responseFileBuffer.reserve(RESPONSE_FILE_BUFFER_SIZE);
+        return this->responseFile->good();
+    }
+
+    bool HTTPClientBinding::FlushResponseFile()
     {
-        // Pass data to handler on main thread
-        BytesRef bytes(new Bytes(bufferSize));
-        bytes->Write(buffer, bufferSize);
-        responseData.push_back(bytes);
+        if (this->responseFile.isNull())
+            return false;
 
-        if (this->responseStream)
+        this->responseFile->write(this->responseFileBuffer.data(),
+            this->responseFileBuffer.size());
+        this->responseFileBuffer.clear();
+        return this->responseFile->good();
+    }
+
+    void HTTPClientBinding::CloseResponseFile()
+    {
+        if (this->responseFile.isNull())
+            return;
+
+        if (!this->FlushResponseFile())
         {
-            this->responseStream->write(buffer, bufferSize);
-            std::string data(this->responseStream->str());
-            if (!data.empty())
-                this->SetString("responseText", data);
+            GetLogger()->Error("Could not write the response to %s",
+                this->responseFilePath.c_str());
         }
 
-        if (this->outputHandler)
+        this->responseFile->close();
+        this->responseFile = 0;
+        std::string().swap(this->responseFileBuffer);
+    }
+
+    size_t HTTPClientBinding::DataReceived(char* buffer, size_t bufferSize)
+    {
+        // Let the progress callback end an aborted transfer.
+        if (this->aborted)
+            return bufferSize;
+
+        BytesRef bytes(0);
+        if (!this->responseFile.isNull())
         {
-            RunOnMainThread(this->outputHandler, GetAutoPtr(),
-                ValueList(Value::NewObject(bytes)));
+            this->responseFileBuffer.append(buffer, bufferSize);
+            if (this->responseFileBuffer.size() >= RESPONSE_FILE_BUFFER_SIZE
+                && !this->FlushResponseFile())
+                return 0;
+        }
+        else
+        {
+            bytes = new Bytes(buffer, bufferSize);
+        }
+
+        if (!this->outputHandler.isNull() && !bytes.isNull())
+        {
+            if (!this->async || IsMainThread())
+            {
+                RunOnMainThread(this->outputHandler, GetAutoPtr(),
+                    ValueList(Value::NewObject(bytes)));
+            }
+            else
+            {
+                // cURL keeps the data of a paused transfer and hands it to
+                // us again once the handler has caught up.
+                {
+                    Poco::FastMutex::ScopedLock lock(responseMutex);
+                    if (this->bufferedData >= this->maxBufferedData)
+                    {
+                        this->paused = true;
+                        return CURL_WRITEFUNC_PAUSE;
+                    }
+                    this->bufferedData += bufferSize;
+                }
+
+                ValueList args;
+                args.push_back(Value::NewObject(GetAutoPtr()));
+                args.push_back(Value::NewObject(bytes));
+                RunOnMainThread(new FunctionPtrMethod(&DeliverClientChunk), args, false);
+            }
+        }
+
+        if (this->keepResponseData && !bytes.isNull())
+        {
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            this->responseData.push_back(bytes);
+            this->responseTextStale = true;
         }
 
         responseDataReceived += bufferSize;
         this->SetInt("dataReceived", responseDataReceived);
         this->FireEvent(Event::HTTP_DATA_RECEIVED);
+        return bufferSize;
+    }
+
+    void HTTPClientBinding::DeliverChunk(BytesRef bytes)
+    {
+        try
+        {
+            if (!this->outputHandler.isNull())
+                RunOnMainThread(this->outputHandler, GetAutoPtr(),
+                    ValueList(Value::NewObject(bytes)));
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Response handler failed: %s", e.ToString().c_str());
+        }
+
+        // Resume only once the handler has worked through half of the
+        // buffer, so a slow handler doesn't pause the transfer every chunk.
+        Poco::FastMutex::ScopedLock lock(responseMutex);
+        this->bufferedData -= bytes->Length();
+        if (this->paused && this->bufferedData <= this->maxBufferedData / 2)
+        {
+            this->paused = false;
+            if (this->curlHandle)
+                HTTPClientEngine::GetInstance()->ResumeTransfer(this->curlHandle);
+        }
     }
 
     // This callback is invoked when cURL needs to handle data coming from the server
     static size_t CurlWriteCallback(void* buffer, size_t size, size_t nmemb,
         HTTPClientBinding* client)
     {
-        size_t dataLength = size * nmemb;
-        client->DataReceived(static_cast<char*>(buffer), dataLength);
-        return dataLength;
+        return client->DataReceived(static_cast<char*>(buffer), size * nmemb);
     }
 
     int CurlProgressCallback(HTTPClientBinding* client, double dltotal, double dlnow, double ultotal, double ulnow)
@@ -814,8 +1044,10 @@ namespace ti
         }
     }
 
-    void HTTPClientBinding::CleanupCurl(curl_slist* headers)
+    void HTTPClientBinding::CleanupCurl()
     {
+        this->CloseResponseFile();
+
         if (this->postData)
         {
             curl_formfree(this->postData);
@@ -823,14 +1055,24 @@ namespace ti
             preservedPostData.clear();
         }
 
-        if (this->curlHandle)
+        if (this->curlHeaders)
         {
-            curl_easy_cleanup(this->curlHandle);
-            this->curlHandle = 0;
+            curl_slist_free_all(this->curlHeaders);
+            this->curlHeaders = 0;
         }
 
-        if (headers)
-            curl_slist_free_all(headers);
+        // Handles go back to the engine's pool, which keeps their caches
+        // for the next request. Resumes read the handle under the same
+        // lock, and the engine drops those still queued when it is
+        // released, so they can't reach the handle's next user.
+        CURL* handle;
+        {
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            handle = this->curlHandle;
+            this->curlHandle = 0;
+        }
+        if (handle)
+            HTTPClientEngine::GetInstance()->ReleaseHandle(handle);
     }
 
     void HTTPClientBinding::SetRequestData()
@@ -865,78 +1107,102 @@ namespace ti
         }
     }
 
-    void HTTPClientBinding::ExecuteRequest()
+    void HTTPClientBinding::PrepareRequest()
     {
-        struct curl_slist* curlHeaders = 0;
-        char curlErrorBuffer[CURL_ERROR_SIZE];
-
-        try
         {
-            this->curlHandle = curl_easy_init();
-            SetStandardCurlHandleOptions(curlHandle);
+            CURL* handle = HTTPClientEngine::GetInstance()->AcquireHandle();
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            this->curlHandle = handle;
+        }
+        SetStandardCurlHandleOptions(curlHandle);
 
-            // This error buffer cannot be shared, because it's not protected by a mutex.
-            SET_CURL_OPTION(curlHandle, CURLOPT_URL, url.c_str());
-            SET_CURL_OPTION(curlHandle, CURLOPT_ERRORBUFFER, &curlErrorBuffer);
+        // This error buffer cannot be shared, because it's not protected by a mutex.
+        SET_CURL_OPTION(curlHandle, CURLOPT_URL, url.c_str());
+        SET_CURL_OPTION(curlHandle, CURLOPT_ERRORBUFFER, this->curlErrorBuffer);
 
-            SET_CURL_OPTION(curlHandle, CURLOPT_HEADERFUNCTION, &CurlHeaderCallback);
-            SET_CURL_OPTION(curlHandle, CURLOPT_WRITEFUNCTION, &CurlWriteCallback);
-            SET_CURL_OPTION(curlHandle, CURLOPT_PROGRESSFUNCTION, &CurlProgressCallback);
-            SET_CURL_OPTION(curlHandle, CURLOPT_WRITEHEADER, this);
-            SET_CURL_OPTION(curlHandle, CURLOPT_WRITEDATA, this);
-            SET_CURL_OPTION(curlHandle, CURLOPT_PROGRESSDATA, this);
-            // non negative number means don't verify peer cert - we might want to 
-            // make this configurable in the future
-            SET_CURL_OPTION(curlHandle, CURLOPT_SSL_VERIFYPEER, 1);
+        SET_CURL_OPTION(curlHandle, CURLOPT_HEADERFUNCTION, &CurlHeaderCallback);
+        SET_CURL_OPTION(curlHandle, CURLOPT_WRITEFUNCTION, &CurlWriteCallback);
+        SET_CURL_OPTION(curlHandle, CURLOPT_PROGRESSFUNCTION, &CurlProgressCallback);
+        SET_CURL_OPTION(curlHandle, CURLOPT_WRITEHEADER, this);
+        SET_CURL_OPTION(curlHandle, CURLOPT_WRITEDATA, this);
+        SET_CURL_OPTION(curlHandle, CURLOPT_PROGRESSDATA, this);
+        // non negative number means don't verify peer cert - we might want to 
+        // make this configurable in the future
+        SET_CURL_OPTION(curlHandle, CURLOPT_SSL_VERIFYPEER, 1);
 
-            // Progress must be turned on for CURLOPT_PROGRESSFUNCTION to be called.
-            SET_CURL_OPTION(curlHandle, CURLOPT_NOPROGRESS, 0);
+        // Progress must be turned on for CURLOPT_PROGRESSFUNCTION to be called.
+        SET_CURL_OPTION(curlHandle, CURLOPT_NOPROGRESS, 0);
 
-            this->SetRequestData();
-            this->SetupCurlMethodType();
+        this->SetRequestData();
+        this->SetupCurlMethodType();
 
-            SET_CURL_OPTION(curlHandle, CURLOPT_MAXREDIRS, this->maxRedirects);
-            SET_CURL_OPTION(curlHandle, CURLOPT_USERAGENT,
-                this->GetString("userAgent").c_str());
+        SET_CURL_OPTION(curlHandle, CURLOPT_MAXREDIRS, this->maxRedirects);
+        SET_CURL_OPTION(curlHandle, CURLOPT_USERAGENT,
+            this->GetString("userAgent").c_str());
 
-            curlHeaders = SetRequestHeaders(curlHandle);
-            SetCurlProxySettings(curlHandle, ProxyConfig::GetProxyForURL(url));
+        this->curlHeaders = SetRequestHeaders(curlHandle);
+        SetCurlProxySettings(curlHandle, ProxyConfig::GetProxyForURL(url));
 
-            if (this->timeout > 0)
-            {
-                SET_CURL_OPTION(curlHandle, CURLOPT_TIMEOUT_MS, this->timeout);
-                SET_CURL_OPTION(curlHandle, CURLOPT_DNS_CACHE_TIMEOUT, this->timeout/1000);
-            }
+        if (this->timeout > 0)
+        {
+            SET_CURL_OPTION(curlHandle, CURLOPT_TIMEOUT_MS, this->timeout);
+            SET_CURL_OPTION(curlHandle, CURLOPT_DNS_CACHE_TIMEOUT, this->timeout/1000);
+        }
 
-            SetRequestCookies(curlHandle, this->requestCookies);
+        SetRequestCookies(curlHandle, this->requestCookies);
 
-            if (!this->username.empty() || !this->password.empty())
-            {
-                std::string usernamePassword(this->username);
-                usernamePassword.append(":");
-                usernamePassword.append(this->password);
-                SET_CURL_OPTION(curlHandle, CURLOPT_USERPWD, usernamePassword.c_str());
-            }
+        if (!this->username.empty() || !this->password.empty())
+        {
+            std::string usernamePassword(this->username);
+            usernamePassword.append(":");
+            usernamePassword.append(this->password);
+            SET_CURL_OPTION(curlHandle, CURLOPT_USERPWD, usernamePassword.c_str());
+        }
+    }
 
+    void HTTPClientBinding::ExecuteRequest()
+    {
+        try
+        {
+            this->PrepareRequest();
             this->Set("connected", Value::NewBool(true));
-            this->HandleCurlResult(curl_easy_perform(curlHandle));
-            this->Set("connected", Value::NewBool(false));
-
-            if (!responseData.empty())
-                this->SetObject("responseData", Bytes::Concat(this->responseData));
 
-            CleanupCurl(curlHeaders);
+            if (this->async)
+            {
+                // The engine keeps us alive until TransferFinished is called.
+                HTTPClientEngine::GetInstance()->StartTransfer(this->curlHandle,
+                    this->url, this, GetAutoPtr());
+                return;
+            }
 
-            this->ChangeState(4); // Done
+            this->TransferFinished(curl_easy_perform(curlHandle));
         }
         catch (ValueException& e)
         {
             GetLogger()->Error("Request to %s failed because: %s",
             this->url.c_str(), e.ToString().c_str());
 
-            this->CleanupCurl(curlHeaders);
+            this->Set("connected", Value::NewBool(false));
+            this->CleanupCurl();
             if (!async)
                 throw e;
         }
     }
+
+    void HTTPClientBinding::TransferFinished(CURLcode result)
+    {
+        this->HandleCurlResult(result);
+        this->Set("connected", Value::NewBool(false));
+
+        {
+            Poco::FastMutex::ScopedLock lock(responseMutex);
+            this->paused = false;
+            if (!responseData.empty())
+                this->SetObject("responseData", Bytes::Concat(this->responseData));
+        }
+
+        CleanupCurl();
+
+        this->ChangeState(4); // Done
+    }
 }
@@ -39,15 +39,15 @@
 
 #include <Poco/Net/NameValueCollection.h>
 #include <Poco/URI.h>
-#include <Poco/Thread.h>
-#include <Poco/Runnable.h>
+#include <Poco/FileStream.h>
 #include <curl/curl.h>
 
 #include "http_cookie.h"
+#include "http_client_engine.h"
 
 namespace ti
 {
-    class HTTPClientBinding : public EventObject, public Poco::Runnable
+    class HTTPClientBinding : public EventObject, public HTTPClientEngine::Transfer
     {
     public:
         HTTPClientBinding(Host* host);
@@ -56,9 +56,13 @@ namespace ti
         size_t WriteRequestDataToBuffer(char* buffer, size_t bufferSize);
         void ParseHTTPStatus(std::string& header);
         void GotHeader(std::string& header);
-        void DataReceived(char* buffer, size_t numberOfBytes);
+        size_t DataReceived(char* buffer, size_t numberOfBytes);
+        void DeliverChunk(BytesRef bytes);
         inline bool IsAborted() { return aborted; }
         void RequestDataSent(size_t sent, size_t total);
+        void DispatchEvent(std::string& eventName, int readyState);
+        virtual void TransferFinished(CURLcode result);
+        virtual ValueRef Get(const char* name);
 
     private:
         Host* host;
@@ -67,8 +71,11 @@ namespace ti
         bool async;
         int timeout;
         long maxRedirects;
+        size_t maxBufferedData;
 
         CURL* curlHandle;
+        struct curl_slist* curlHeaders;
+        char curlErrorBuffer[CURL_ERROR_SIZE];
         std::string username;
         std::string password;
         Poco::Net::NameValueCollection requestCookies;
@@ -84,22 +91,30 @@ namespace ti
         TiMethodRef onload;
 
         // This variables must be reset on each send()
-        SharedPtr<Poco::Thread> thread;
         BytesRef requestBytes;
-        SharedPtr<std::ostringstream> responseStream;
+        bool keepResponseData;
+        bool responseTextStale;
+        std::string responseFilePath;
+        SharedPtr<Poco::FileOutputStream> responseFile;
+        std::string responseFileBuffer;
         int requestContentLength;
         bool aborted;
         bool dirty;
         size_t requestDataSent;
         size_t requestDataWritten;
-        size_t responseDataReceived;;
+        size_t responseDataReceived;
         bool sawHTTPStatus;
+
+        // Guards the response data and the flow control state, which the
+        // engine thread updates while the main thread reads them.
+        Poco::FastMutex responseMutex;
         std::vector<BytesRef> responseData;
+        size_t bufferedData;
+        bool paused;
         std::vector<BytesRef> preservedPostData;
         struct curl_httppost* postData;
         ValueRef sendData;
 
-        void run(); // Poco Thread implementation.
         bool BeginRequest(ValueRef sendData);
         void BeginWithPostDataObject(TiObjectRef object);
         void SetRequestData();
@@ -107,10 +122,15 @@ namespace ti
         void GetResponseCookie(std::string cookieLine);
         struct curl_slist* SetRequestHeaders(CURL* handle);
         void ExecuteRequest();
+        void PrepareRequest();
+        bool PostToMainThread(std::string& eventName, int readyState = -1);
         bool FireEvent(std::string& eventName);
         void HandleCurlResult(CURLcode result);
         void SetupCurlMethodType();
-        void CleanupCurl(curl_slist* headers);
+        bool OpenResponseFile();
+        bool FlushResponseFile();
+        void CloseResponseFile();
+        void CleanupCurl();
         void AddScalarValueToCurlForm(SharedString propertyName, ValueRef value, curl_httppost** last);
 
         void Abort(const ValueList& args, ValueRef result);
@@ -128,6 +148,8 @@ namespace ti
         void SetTimeout(const ValueList& args, ValueRef result);
         void GetMaxRedirects(const ValueList& args, ValueRef result);
         void SetMaxRedirects(const ValueList& args, ValueRef result);
+        void GetMaxBufferedData(const ValueList& args, ValueRef result);
+        void SetMaxBufferedData(const ValueList& args, ValueRef result);
     };
 }
 
@@ -0,0 +1,490 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "http_client_engine.h"
+#include <tide/thread_manager.h>
+#include <Poco/URI.h>
+#include <Poco/Timestamp.h>
+#include <algorithm>
+#include <climits>
+#include <sstream>
+
+#if !defined(OS_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+// Browsers settle on about six connections per server, which keeps a
+// burst of small requests from opening hundreds of sockets at once.
+#define DEFAULT_MAX_CONNECTIONS_PER_HOST 6
+
+// Idle easy handles kept around for reuse by later requests.
+#define MAX_IDLE_HANDLES 16
+
+// Longest time a wait may last while transfers are running. cURL
+// usually asks for less than this through curl_multi_timeout.
+#define MAX_WAIT_MILLISECONDS 1000
+
+// cURL cannot wait on a Windows event, so while transfers are running
+// the engine polls for newly started ones this often.
+#define WIN32_WAKE_INTERVAL_MILLISECONDS 50
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        static Logger* logger = Logger::Get("Network.HTTPClientEngine");
+        return logger;
+    }
+
+    static std::string HostKey(const std::string& url)
+    {
+        try
+        {
+            Poco::URI uri(url);
+            std::ostringstream key;
+            key << uri.getScheme() << "://" << uri.getHost() << ':' << uri.getPort();
+            return key.str();
+        }
+        catch (Poco::Exception&)
+        {
+            return url;
+        }
+    }
+
+    HTTPClientEngine* HTTPClientEngine::instance = 0;
+
+    static Poco::FastMutex& InstanceMutex()
+    {
+        static Poco::FastMutex mutex;
+        return mutex;
+    }
+
+    /*static*/
+    HTTPClientEngine* HTTPClientEngine::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        if (!instance)
+            instance = new HTTPClientEngine();
+        return instance;
+    }
+
+    /*static*/
+    void HTTPClientEngine::Shutdown()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        delete instance;
+        instance = 0;
+    }
+
+    HTTPClientEngine::HTTPClientEngine() :
+        multi(curl_multi_init()),
+        running(true),
+        maxConnectionsPerHost(DEFAULT_MAX_CONNECTIONS_PER_HOST),
+        activeCount(0),
+        waitingCount(0),
+        completedCount(0),
+        reusedHandleCount(0)
+    {
+        if (!multi)
+            throw ValueException::FromString("Could not create cURL multi handle");
+
+#if !defined(OS_WIN32)
+        if (pipe(wakeFds) != 0)
+        {
+            curl_multi_cleanup(multi);
+            throw ValueException::FromString("Could not create HTTP engine wake pipe");
+        }
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+#endif
+
+        thread.setName("HTTPClientEngine");
+        thread.start(*this);
+    }
+
+    HTTPClientEngine::~HTTPClientEngine()
+    {
+        running = false;
+        Wake();
+        thread.join();
+
+        // Anything still in flight is dropped without events, since the
+        // application is going away.
+        std::map<CURL*, Request>::iterator i = active.begin();
+        while (i != active.end())
+        {
+            curl_multi_remove_handle(multi, i->first);
+            curl_easy_cleanup(i->first);
+            i++;
+        }
+
+        std::map<std::string, HostQueue>::iterator h = hosts.begin();
+        while (h != hosts.end())
+        {
+            for (size_t j = 0; j < h->second.waiting.size(); j++)
+                curl_easy_cleanup(h->second.waiting[j].handle);
+            h++;
+        }
+
+        for (size_t j = 0; j < started.size(); j++)
+            curl_easy_cleanup(started[j].handle);
+        for (size_t j = 0; j < idleHandles.size(); j++)
+            curl_easy_cleanup(idleHandles[j]);
+
+        curl_multi_cleanup(multi);
+
+#if !defined(OS_WIN32)
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+#endif
+    }
+
+    CURL* HTTPClientEngine::AcquireHandle()
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            if (!idleHandles.empty())
+            {
+                CURL* handle = idleHandles.back();
+                idleHandles.pop_back();
+                reusedHandleCount++;
+                return handle;
+            }
+        }
+
+        CURL* handle = curl_easy_init();
+        if (!handle)
+            throw ValueException::FromString("Could not create cURL handle");
+        return handle;
+    }
+
+    void HTTPClientEngine::ReleaseHandle(CURL* handle)
+    {
+        {
+            // A resume asked for by the last user must not unpause the
+            // transfer of the next one.
+            Poco::FastMutex::ScopedLock lock(mutex);
+            resumed.erase(std::remove(resumed.begin(), resumed.end(), handle),
+                resumed.end());
+        }
+
+        // Resetting clears the options of the last request, but leaves the
+        // caches of the handle alone.
+        curl_easy_reset(handle);
+
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            if (idleHandles.size() < MAX_IDLE_HANDLES)
+            {
+                idleHandles.push_back(handle);
+                return;
+            }
+        }
+
+        curl_easy_cleanup(handle);
+    }
+
+    void HTTPClientEngine::StartTransfer(CURL* handle, const std::string& url,
+        Transfer* transfer, TiObjectRef owner)
+    {
+        Request request;
+        request.handle = handle;
+        request.host = HostKey(url);
+        request.transfer = transfer;
+        request.owner = owner;
+
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            started.push_back(request);
+        }
+        Wake();
+    }
+
+    void HTTPClientEngine::ResumeTransfer(CURL* handle)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            resumed.push_back(handle);
+        }
+        Wake();
+    }
+
+    void HTTPClientEngine::SetMaxConnectionsPerHost(int maxConnections)
+    {
+        if (maxConnections < 1)
+            throw ValueException::FromString(
+                "The maximum number of connections per host must be at least 1");
+
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            maxConnectionsPerHost = maxConnections;
+        }
+
+        // Waiting requests may be allowed to start now.
+        Wake();
+    }
+
+    int HTTPClientEngine::GetMaxConnectionsPerHost()
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        return maxConnectionsPerHost;
+    }
+
+    TiObjectRef HTTPClientEngine::GetStatsObject()
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetInt("active", activeCount);
+        stats->SetInt("waiting", waitingCount + started.size());
+        stats->SetInt("completed", completedCount);
+        stats->SetInt("reusedHandles", reusedHandleCount);
+        stats->SetInt("idleHandles", idleHandles.size());
+        stats->SetInt("maxConnectionsPerHost", maxConnectionsPerHost);
+        return stats;
+    }
+
+    void HTTPClientEngine::run()
+    {
+        START_TIDE_THREAD;
+
+        while (running)
+        {
+            AddStartedRequests();
+            ResumeTransfers();
+
+            int runningHandles = 0;
+            while (curl_multi_perform(multi, &runningHandles) == CURLM_CALL_MULTI_PERFORM) {}
+
+            CompleteTransfers();
+            if (running)
+                Wait();
+        }
+
+        END_TIDE_THREAD;
+    }
+
+    void HTTPClientEngine::Wake()
+    {
+#if defined(OS_WIN32)
+        wakeEvent.set();
+#else
+        // A full pipe already guarantees a wakeup, so errors are fine here.
+        char byte = 0;
+        ssize_t written = write(wakeFds[1], &byte, 1);
+        (void) written;
+#endif
+    }
+
+    void HTTPClientEngine::Wait()
+    {
+        // curl_multi_wait polls cURL's sockets itself, so unlike select()
+        // it is not limited to descriptors below FD_SETSIZE.
+        long timeout = -1;
+        curl_multi_timeout(multi, &timeout);
+        if (timeout == 0)
+            return;
+        if (timeout < 0 || timeout > MAX_WAIT_MILLISECONDS)
+            timeout = MAX_WAIT_MILLISECONDS;
+
+#if defined(OS_WIN32)
+        if (active.empty())
+        {
+            wakeEvent.wait();
+            return;
+        }
+
+        if (timeout > WIN32_WAKE_INTERVAL_MILLISECONDS)
+            timeout = WIN32_WAKE_INTERVAL_MILLISECONDS;
+
+        Poco::Timestamp start;
+        int ready = 0;
+        if (curl_multi_wait(multi, 0, 0, (int) timeout, &ready) != CURLM_OK)
+            return;
+
+        // cURL may be between sockets, for instance while resolving, and
+        // then returns at once. Sleep out the rest of the interval.
+        long elapsed = (long) (start.elapsed() / 1000);
+        if (ready == 0 && elapsed < timeout)
+            wakeEvent.tryWait(timeout - elapsed);
+#else
+        struct curl_waitfd wakeFd;
+        wakeFd.fd = wakeFds[0];
+        wakeFd.events = CURL_WAIT_POLLIN;
+        wakeFd.revents = 0;
+
+        int ready = 0;
+        if (curl_multi_wait(multi, &wakeFd, 1,
+            active.empty() ? INT_MAX : (int) timeout, &ready) != CURLM_OK)
+            return;
+
+        if (wakeFd.revents)
+        {
+            char buffer[64];
+            while (read(wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+        }
+#endif
+    }
+
+    void HTTPClientEngine::AddStartedRequests()
+    {
+        std::vector<Request> requests;
+        int maxConnections;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            requests.swap(started);
+            maxConnections = maxConnectionsPerHost;
+        }
+
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            HostQueue& queue = hosts[requests[i].host];
+            queue.waiting.push_back(requests[i]);
+        }
+
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            waitingCount += requests.size();
+        }
+
+        // Also covers hosts whose limit has been raised since the last turn.
+        std::map<std::string, HostQueue>::iterator i = hosts.begin();
+        while (i != hosts.end())
+        {
+            ActivateWaiting(i->second, maxConnections);
+            if (i->second.active == 0 && i->second.waiting.empty())
+                hosts.erase(i++);
+            else
+                i++;
+        }
+    }
+
+    void HTTPClientEngine::ResumeTransfers()
+    {
+        std::vector<CURL*> handles;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            handles.swap(resumed);
+        }
+
+        // The transfer may have finished, and its handle gone back to the
+        // pool, since the resume was asked for.
+        for (size_t i = 0; i < handles.size(); i++)
+        {
+            if (active.find(handles[i]) != active.end())
+                curl_easy_pause(handles[i], CURLPAUSE_CONT);
+        }
+    }
+
+    void HTTPClientEngine::ActivateWaiting(HostQueue& queue, int maxConnections)
+    {
+        while (queue.active < maxConnections && !queue.waiting.empty())
+        {
+            Request request(queue.waiting.front());
+            queue.waiting.pop_front();
+            Activate(request);
+        }
+    }
+
+    void HTTPClientEngine::Activate(const Request& request)
+    {
+        CURLMcode result = curl_multi_add_handle(multi, request.handle);
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            waitingCount--;
+            if (result == CURLM_OK)
+                activeCount++;
+        }
+
+        if (result != CURLM_OK)
+        {
+            GetLogger()->Error("Could not start transfer: %s",
+                curl_multi_strerror(result));
+            request.transfer->TransferFinished(CURLE_FAILED_INIT);
+            return;
+        }
+
+        active[request.handle] = request;
+        hosts[request.host].active++;
+    }
+
+    void HTTPClientEngine::CompleteTransfers()
+    {
+        CURLMsg* message;
+        int remaining = 0;
+        while ((message = curl_multi_info_read(multi, &remaining)))
+        {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+
+            // The message is only valid until the handle is removed.
+            CURL* handle = message->easy_handle;
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi, handle);
+
+            std::map<CURL*, Request>::iterator i = active.find(handle);
+            if (i == active.end())
+                continue;
+
+            Request request(i->second);
+            active.erase(i);
+            {
+                Poco::FastMutex::ScopedLock lock(mutex);
+                activeCount--;
+                completedCount++;
+            }
+
+            try
+            {
+                request.transfer->TransferFinished(result);
+            }
+            catch (ValueException& e)
+            {
+                GetLogger()->Error("Transfer completion failed: %s",
+                    e.ToString().c_str());
+            }
+
+            // The freed connection goes to the next request for this host.
+            std::map<std::string, HostQueue>::iterator h = hosts.find(request.host);
+            if (h == hosts.end())
+                continue;
+
+            HostQueue& queue = h->second;
+            queue.active--;
+            ActivateWaiting(queue, GetMaxConnectionsPerHost());
+            if (queue.active == 0 && queue.waiting.empty())
+                hosts.erase(h);
+        }
+    }
+}
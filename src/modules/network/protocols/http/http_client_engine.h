@@ -0,0 +1,165 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _HTTP_CLIENT_ENGINE_H_
+#define _HTTP_CLIENT_ENGINE_H_
+
+#include <tide/tide.h>
+#include <deque>
+#include <map>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <Poco/Event.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <curl/curl.h>
+
+namespace ti
+{
+    /**
+     * Runs every asynchronous HTTPClient transfer on a single thread through
+     * one cURL multi handle, instead of starting a thread per request. Since
+     * all transfers share the multi handle, connections are kept alive and
+     * reused between requests to the same server, and easy handles are
+     * pooled so their DNS and TLS session caches survive too.
+     *
+     * Transfers to one host are limited to a configurable number of
+     * connections; requests beyond that wait in a per-host queue. Transfer
+     * callbacks run on the engine thread and must not block on the main
+     * thread.
+     */
+    class HTTPClientEngine : public Poco::Runnable
+    {
+    public:
+        class Transfer
+        {
+        public:
+            virtual ~Transfer() {}
+
+            /**
+             * Called on the engine thread once the transfer has finished,
+             * after the handle has been removed from the multi handle.
+             */
+            virtual void TransferFinished(CURLcode result) = 0;
+        };
+
+        static HTTPClientEngine* GetInstance();
+        static void Shutdown();
+
+        /**
+         * Get an easy handle from the pool. Pooled handles have been reset
+         * but keep their connection, DNS and TLS session caches.
+         */
+        CURL* AcquireHandle();
+        void ReleaseHandle(CURL* handle);
+
+        /**
+         * Start a transfer on a handle which is fully set up. The engine
+         * keeps owner alive until the transfer has finished.
+         */
+        void StartTransfer(CURL* handle, const std::string& url,
+            Transfer* transfer, TiObjectRef owner);
+
+        /**
+         * Continue a transfer whose write callback returned
+         * CURL_WRITEFUNC_PAUSE. cURL handles may only be touched by the
+         * thread driving them, so the engine thread does the unpausing.
+         * Resumes still queued when the handle is released are dropped.
+         */
+        void ResumeTransfer(CURL* handle);
+
+        void SetMaxConnectionsPerHost(int maxConnections);
+        int GetMaxConnectionsPerHost();
+        TiObjectRef GetStatsObject();
+
+    private:
+        struct Request
+        {
+            CURL* handle;
+            std::string host;
+            Transfer* transfer;
+            TiObjectRef owner;
+        };
+
+        struct HostQueue
+        {
+            HostQueue() : active(0) {}
+            int active;
+            std::deque<Request> waiting;
+        };
+
+        HTTPClientEngine();
+        ~HTTPClientEngine();
+
+        void run();
+        void Wake();
+        void Wait();
+        void AddStartedRequests();
+        void ResumeTransfers();
+        void Activate(const Request& request);
+        void ActivateWaiting(HostQueue& queue, int maxConnections);
+        void CompleteTransfers();
+
+        CURLM* multi;
+        Poco::Thread thread;
+        volatile bool running;
+        int maxConnectionsPerHost;
+
+        // Protects everything the engine thread shares with other threads.
+        Poco::FastMutex mutex;
+        std::vector<Request> started;
+        std::vector<CURL*> resumed;
+        std::vector<CURL*> idleHandles;
+        size_t activeCount;
+        size_t waitingCount;
+        size_t completedCount;
+        size_t reusedHandleCount;
+
+        // Only touched by the engine thread.
+        std::map<CURL*, Request> active;
+        std::map<std::string, HostQueue> hosts;
+
+#if defined(OS_WIN32)
+        Poco::Event wakeEvent;
+#else
+        int wakeFds[2];
+#endif
+
+        static HTTPClientEngine* instance;
+
+        DISALLOW_EVIL_CONSTRUCTORS(HTTPClientEngine);
+    };
+}
+
+#endif
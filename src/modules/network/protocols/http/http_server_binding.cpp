@@ -37,6 +37,7 @@
 #endif
 
 #include <tide/tide.h>
+#include <tide/url_utils.h>
 #include "http_server_binding.h"
 #include "http_server_request_factory.h"
 #include <cstring>
@@ -48,22 +49,56 @@
 #include <Poco/Net/HTTPServerParams.h>
 #include <Poco/Net/ServerSocket.h>
 #include <Poco/Net/SocketAddress.h>
+#include <Poco/ThreadPool.h>
+
+// Poco's own defaults, used when bind() isn't given any options.
+#define DEFAULT_MAX_THREADS 16
 
 namespace ti
 {
+    // Threads of every server come out of one pool, whose capacity grows
+    // and shrinks as servers are bound and closed. A server can't own its
+    // pool, because closing it from a request handler would then have to
+    // wait for the very thread that runs the handler.
+    static Poco::ThreadPool& ServerThreadPool()
+    {
+        static Poco::ThreadPool pool("HTTPServer", 1, 1);
+        return pool;
+    }
+
+    static void GetStaticRoutes(TiObjectRef routes, StaticRouteList& staticRoutes)
+    {
+        SharedStringList prefixes(routes->GetPropertyNames());
+        for (size_t i = 0; i < prefixes->size(); i++)
+        {
+            std::string prefix(*prefixes->at(i));
+            if (prefix.empty() || prefix[0] != '/')
+                throw ValueException::FromFormat(
+                    "Static route '%s' must start with a slash", prefix.c_str());
+
+            std::string directory(URLUtils::URLToPath(routes->GetString(prefix.c_str())));
+            staticRoutes.push_back(std::make_pair(prefix, directory));
+        }
+    }
+
     HTTPServerBinding::HTTPServerBinding(Host* host) :
         StaticBoundObject("Network.HTTPServer"),
         host(host),
         global(host->GetGlobalObject()),
         callback(0),
         socket(0),
-        connection(0)
+        connection(0),
+        threadCapacity(0)
     {
         /**
          * @tiapi(method=True,name=Network.HTTPServer.bind,since=0.3) bind this server to a port on a specific interface
          * @tiarg(for=Network.HTTPServer.bind,name=port,type=Number) port to bind on
          * @tiarg(for=Network.HTTPServer.bind,name=address,type=String,optional=True) address to bind to
-         * @tiarg(for=Network.HTTPServer.bind,name=callback,type=Method) callback for server logic (in seperate thread)
+         * @tiarg(for=Network.HTTPServer.bind,name=callback,type=Method,optional=True) callback for server logic, run on the main thread
+         * @tiarg(for=Network.HTTPServer.bind,name=options,type=Object,optional=True) server options (since 1.3.2): maxThreads, maxQueued,
+         * keepAlive, keepAliveTimeout (seconds), maxKeepAliveRequests, handlerScript (a script defining handleRequest(request, response),
+         * which is run on the server threads in contexts of its own instead of the main thread) and staticFiles (an object mapping URL
+         * path prefixes to directories, which are served natively)
          */
         SetMethod("bind",&HTTPServerBinding::Bind);
         
@@ -87,28 +122,63 @@ namespace ti
     {
         Close();
         
-        // port, callback
-        // port, ipaddress, callback
+        // port, [ipaddress], [callback], [options]
         int port = args.at(0)->ToInt();
         std::string ipaddress = "127.0.0.1";
+        TiObjectRef options(0);
         
-        if (args.at(1)->IsString())
-        {
-            ipaddress = args.at(1)->ToString();
-        }
-        else if (args.at(1)->IsMethod())
+        for (size_t i = 1; i < args.size(); i++)
         {
-            callback = args.at(1)->ToMethod();
+            if (args.at(i)->IsString())
+                ipaddress = args.at(i)->ToString();
+            else if (args.at(i)->IsMethod())
+                callback = args.at(i)->ToMethod();
+            else if (args.at(i)->IsObject())
+                options = args.at(i)->ToObject();
         }
-        if (args.size()==3)
+
+        Poco::Net::HTTPServerParams::Ptr params(new Poco::Net::HTTPServerParams);
+        int maxThreads = DEFAULT_MAX_THREADS;
+        Poco::SharedPtr<HTTPServerScriptPool> scriptPool;
+        StaticRouteList staticRoutes;
+
+        if (!options.isNull())
         {
-            callback = args.at(2)->ToMethod();
+            maxThreads = options->GetInt("maxThreads", maxThreads);
+            if (maxThreads < 1)
+                throw ValueException::FromString("maxThreads must be at least 1");
+
+            params->setMaxQueued(options->GetInt("maxQueued", params->getMaxQueued()));
+            params->setKeepAlive(options->GetBool("keepAlive", params->getKeepAlive()));
+            params->setKeepAliveTimeout(Poco::Timespan(options->GetInt("keepAliveTimeout",
+                params->getKeepAliveTimeout().totalSeconds()), 0));
+            params->setMaxKeepAliveRequests(options->GetInt("maxKeepAliveRequests",
+                params->getMaxKeepAliveRequests()));
+
+            std::string handlerScript(options->GetString("handlerScript"));
+            if (!handlerScript.empty())
+                scriptPool = new HTTPServerScriptPool(URLUtils::URLToPath(handlerScript));
+
+            TiObjectRef routes(options->GetObject("staticFiles"));
+            if (!routes.isNull())
+                GetStaticRoutes(routes, staticRoutes);
         }
+
+        if (callback.isNull() && scriptPool.isNull() && staticRoutes.empty())
+            throw ValueException::FromString("HTTPServer.bind needs a callback, "
+                "a handlerScript or staticFiles to serve requests");
+
+        params->setMaxThreads(maxThreads);
         
         Poco::Net::SocketAddress addr(ipaddress,port);
         this->socket = new Poco::Net::ServerSocket(addr);        
-        
-        connection = new Poco::Net::HTTPServer(new HttpServerRequestFactory(host,callback), *socket, new Poco::Net::HTTPServerParams);
+
+        ServerThreadPool().addCapacity(maxThreads);
+        this->threadCapacity = maxThreads;
+
+        connection = new Poco::Net::HTTPServer(
+            new HttpServerRequestFactory(host, callback, scriptPool, staticRoutes),
+            ServerThreadPool(), *socket, params);
         connection->start();
     }
     void HTTPServerBinding::Close()
@@ -124,6 +194,11 @@ namespace ti
             delete this->socket;
             this->socket = NULL;
         }
+        if (this->threadCapacity > 0)
+        {
+            ServerThreadPool().addCapacity(-this->threadCapacity);
+            this->threadCapacity = 0;
+        }
         this->callback = NULL;
     }
     void HTTPServerBinding::Close(const ValueList& args, ValueRef result)
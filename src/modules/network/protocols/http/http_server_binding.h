@@ -62,6 +62,7 @@ namespace ti
         Poco::Thread *thread;
         Poco::Net::ServerSocket *socket;
         Poco::Net::HTTPServer *connection;
+        int threadCapacity;
         
         static void Run(void*);
         
@@ -35,9 +35,45 @@
 #include "http_server_request.h"
 #include "http_server_response.h"
 #include "http_server_request_factory.h"
+#include <tideutils/file_utils.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/String.h>
+#include <Poco/URI.h>
+#include <Poco/Net/HTTPServerRequestImpl.h>
+
+#if defined(OS_LINUX)
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#elif defined(OS_OSX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#if defined(OS_WIN32)
+#include <tideutils/win/win32_utils.h>
+#else
+#include <climits>
+#include <cstdlib>
+#endif
+
+using namespace TideUtils;
 
 namespace ti
 {
+    static Logger* GetLogger()
+    {
+        static Logger* logger = Logger::Get("Network.HTTPServer");
+        return logger;
+    }
+
     class HTTPRequestHandler : public Poco::Net::HTTPRequestHandler {
         public:
             HTTPRequestHandler(TiMethodRef callback)
@@ -61,9 +97,168 @@ namespace ti
         RunOnMainThread(m_callback, args);
     }
 
-    HttpServerRequestFactory::HttpServerRequestFactory(Host *host, TiMethodRef callback) :
+    class ScriptRequestHandler : public Poco::Net::HTTPRequestHandler {
+        public:
+            ScriptRequestHandler(Poco::SharedPtr<HTTPServerScriptPool> scriptPool)
+                : m_scriptPool(scriptPool)
+            {
+            }
+
+            virtual void handleRequest(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+            {
+                m_scriptPool->HandleRequest(request, response);
+            }
+
+        private:
+            // Keeps the contexts around while the request is in flight,
+            // even if the server has been closed in the meantime.
+            Poco::SharedPtr<HTTPServerScriptPool> m_scriptPool;
+    };
+
+    class StaticFileRequestHandler : public Poco::Net::HTTPRequestHandler {
+        public:
+            StaticFileRequestHandler(const std::string& path)
+                : m_path(path)
+            {
+            }
+
+            virtual void handleRequest(Poco::Net::HTTPServerRequest&, Poco::Net::HTTPServerResponse&);
+
+        private:
+            std::string m_path;
+    };
+
+    class NotFoundRequestHandler : public Poco::Net::HTTPRequestHandler {
+        public:
+            virtual void handleRequest(Poco::Net::HTTPServerRequest& request,
+                Poco::Net::HTTPServerResponse& response)
+            {
+                response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+                response.setContentLength(0);
+                response.send();
+            }
+    };
+
+    static std::string MimeTypeForPath(const std::string& path)
+    {
+        static const char* types[][2] = {
+            { "html", "text/html" },
+            { "htm", "text/html" },
+            { "css", "text/css" },
+            { "js", "application/javascript" },
+            { "json", "application/json" },
+            { "xml", "text/xml" },
+            { "txt", "text/plain" },
+            { "png", "image/png" },
+            { "jpg", "image/jpeg" },
+            { "jpeg", "image/jpeg" },
+            { "gif", "image/gif" },
+            { "svg", "image/svg+xml" },
+            { "ico", "image/x-icon" },
+            { "pdf", "application/pdf" },
+            { "mp3", "audio/mpeg" },
+            { "mp4", "video/mp4" }
+        };
+
+        size_t dot = path.rfind('.');
+        if (dot == std::string::npos)
+            return "application/octet-stream";
+
+        std::string extension(Poco::toLower(path.substr(dot + 1)));
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+        {
+            if (extension == types[i][0])
+                return types[i][1];
+        }
+        return "application/octet-stream";
+    }
+
+    // Hand the file to the kernel, which copies it straight into the
+    // socket instead of through a buffer in this process. Elsewhere the
+    // caller falls back to copying the file through the response stream.
+    static bool SendFileToSocket(Poco::Net::HTTPServerRequest& request,
+        const std::string& path, Poco::UInt64 size)
+    {
+#if defined(OS_LINUX) || defined(OS_OSX)
+        Poco::Net::HTTPServerRequestImpl* requestImpl =
+            dynamic_cast<Poco::Net::HTTPServerRequestImpl*>(&request);
+        if (!requestImpl)
+            return false;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        int socketFd = requestImpl->socket().impl()->sockfd();
+        off_t offset = 0;
+        bool sent = true;
+        while ((Poco::UInt64) offset < size)
+        {
+#if defined(OS_LINUX)
+            ssize_t count = sendfile(socketFd, fd, &offset, size - offset);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+            {
+                sent = false;
+                break;
+            }
+#else
+            off_t count = size - offset;
+            int error = sendfile(fd, socketFd, offset, &count, 0, 0);
+            offset += count;
+            if ((error < 0 && errno != EINTR && errno != EAGAIN)
+                || (error == 0 && count == 0))
+            {
+                sent = false;
+                break;
+            }
+#endif
+        }
+
+        close(fd);
+        if (!sent)
+            throw Poco::IOException("Could not send " + path);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void StaticFileRequestHandler::handleRequest(Poco::Net::HTTPServerRequest& request,
+        Poco::Net::HTTPServerResponse& response)
+    {
+        Poco::File file(m_path);
+        if (!file.exists() || !file.isFile())
+        {
+            NotFoundRequestHandler().handleRequest(request, response);
+            return;
+        }
+
+        Poco::UInt64 size = file.getSize();
+        response.setContentType(MimeTypeForPath(m_path));
+        response.setContentLength64(size);
+        std::ostream& ostr = response.send();
+        if (request.getMethod() == Poco::Net::HTTPRequest::HTTP_HEAD)
+            return;
+
+        // The headers have to reach the socket before the file does.
+        ostr.flush();
+        if (SendFileToSocket(request, m_path, size))
+            return;
+
+        Poco::FileInputStream istr(m_path, std::ios::in | std::ios::binary);
+        Poco::StreamCopier::copyStream(istr, ostr);
+    }
+
+    HttpServerRequestFactory::HttpServerRequestFactory(Host *host, TiMethodRef callback,
+        Poco::SharedPtr<HTTPServerScriptPool> scriptPool,
+        const StaticRouteList& staticRoutes) :
         host(host),
-        callback(callback)
+        callback(callback),
+        scriptPool(scriptPool),
+        staticRoutes(staticRoutes)
     {
     }
 
@@ -71,9 +266,115 @@ namespace ti
     {
     }
 
+    // The absolute path with every "." and "..", and on POSIX every
+    // symbolic link, resolved. Empty when the path cannot be resolved.
+    static std::string CanonicalPath(const std::string& path)
+    {
+#if defined(OS_WIN32)
+        std::wstring widePath(UTF8ToWide(path));
+        DWORD size = GetFullPathNameW(widePath.c_str(), 0, NULL, NULL);
+        if (!size)
+            return std::string();
+
+        std::vector<wchar_t> buffer(size);
+        if (!GetFullPathNameW(widePath.c_str(), size, &buffer[0], NULL))
+            return std::string();
+        return WideToUTF8(&buffer[0]);
+#else
+        char buffer[PATH_MAX];
+        if (!realpath(path.c_str(), buffer))
+            return std::string();
+        return buffer;
+#endif
+    }
+
+    static bool IsInside(const std::string& path, const std::string& root)
+    {
+        if (path.compare(0, root.size(), root) != 0)
+            return false;
+        if (path.size() == root.size())
+            return true;
+
+        char separator = path[root.size()];
+        char last = root[root.size() - 1];
+        return separator == '/' || separator == '\\' || last == '/' || last == '\\';
+    }
+
+    std::string HttpServerRequestFactory::FindStaticFile(const std::string& uri)
+    {
+        if (staticRoutes.empty())
+            return std::string();
+
+        std::string path;
+        try
+        {
+            path = Poco::URI(uri).getPath();
+        }
+        catch (Poco::Exception&)
+        {
+            return std::string();
+        }
+
+        for (size_t i = 0; i < staticRoutes.size(); i++)
+        {
+            const std::string& prefix = staticRoutes[i].first;
+            if (path.compare(0, prefix.size(), prefix) != 0)
+                continue;
+            if (path.size() > prefix.size() && prefix[prefix.size() - 1] != '/'
+                && path[prefix.size()] != '/')
+                continue;
+
+            // Never let a request climb out of the directory. Segments are
+            // already decoded, so they may hold other separators, drive
+            // letters or NUL bytes, none of which belong in a file name.
+            std::vector<std::string> segments;
+            FileUtils::Tokenize(path.substr(prefix.size()), segments, "/");
+            std::string file(staticRoutes[i].second);
+            for (size_t j = 0; j < segments.size(); j++)
+            {
+                const std::string& segment = segments[j];
+                if (segment == ".." || segment.find_first_of(std::string("\\:\0", 3))
+                    != std::string::npos)
+                    return std::string();
+                if (!segment.empty() && segment != ".")
+                    file = FileUtils::Join(file.c_str(), segment.c_str(), NULL);
+            }
+
+            if (FileUtils::IsDirectory(file))
+                file = FileUtils::Join(file.c_str(), "index.html", NULL);
+
+            // A link inside the directory may still point outside of it.
+            // Files which don't exist are left to the handler to answer.
+            std::string canonicalFile(CanonicalPath(file));
+            if (!canonicalFile.empty())
+            {
+                std::string canonicalRoot(CanonicalPath(staticRoutes[i].second));
+                if (canonicalRoot.empty() || !IsInside(canonicalFile, canonicalRoot))
+                    return std::string();
+                return canonicalFile;
+            }
+            return file;
+        }
+
+        return std::string();
+    }
+
     Poco::Net::HTTPRequestHandler* HttpServerRequestFactory::createRequestHandler(
             const Poco::Net::HTTPServerRequest& request)
     {
+        std::string file(FindStaticFile(request.getURI()));
+        if (!file.empty())
+            return new StaticFileRequestHandler(file);
+
+        if (!scriptPool.isNull())
+            return new ScriptRequestHandler(scriptPool);
+
+        if (callback.isNull())
+        {
+            GetLogger()->Warn("No handler for %s", request.getURI().c_str());
+            return new NotFoundRequestHandler();
+        }
+
         return new HTTPRequestHandler(callback);
     }
 }
@@ -39,19 +39,33 @@
 #include <Poco/Net/HTTPRequestHandlerFactory.h>
 #include <Poco/Net/HTTPServerRequest.h>
 #include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/SharedPtr.h>
+#include <utility>
+#include <vector>
+
+#include "http_server_script_pool.h"
 
 namespace ti
 {
+    // URL path prefixes served natively from a directory.
+    typedef std::vector<std::pair<std::string, std::string> > StaticRouteList;
+
     class HttpServerRequestFactory : public Poco::Net::HTTPRequestHandlerFactory
     {
     public:
-        HttpServerRequestFactory(Host *host, TiMethodRef callback);
+        HttpServerRequestFactory(Host *host, TiMethodRef callback,
+            Poco::SharedPtr<HTTPServerScriptPool> scriptPool,
+            const StaticRouteList& staticRoutes);
         virtual ~HttpServerRequestFactory();
         
         Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest &request);
     private:
         Host *host;
         TiMethodRef callback;
+        Poco::SharedPtr<HTTPServerScriptPool> scriptPool;
+        StaticRouteList staticRoutes;
+
+        std::string FindStaticFile(const std::string& uri);
     };
 }
 
@@ -171,7 +171,12 @@ namespace ti
             if (bytes.isNull())
                 throw ValueException::FromString("Don't know how to write that kind of data.");
 
-            ostr.write(bytes->Pointer(), bytes->Length());
+            // Write each piece of a concatenated Bytes separately
+            // rather than gathering them into one buffer first.
+            std::vector<BytesRef> segments;
+            bytes->GetSegments(segments);
+            for (size_t i = 0; i < segments.size(); i++)
+                ostr.write(segments[i]->Pointer(), segments[i]->Length());
         }
         else
         {
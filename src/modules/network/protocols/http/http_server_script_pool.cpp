@@ -0,0 +1,158 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "http_server_script_pool.h"
+#include "http_server_request.h"
+#include "http_server_response.h"
+#include <tide/javascript/javascript_module.h>
+#include <JavaScriptCore/JSContextRef.h>
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        static Logger* logger = Logger::Get("Network.HTTPServer");
+        return logger;
+    }
+
+    static void SendError(Poco::Net::HTTPServerResponse& response)
+    {
+        if (response.sent())
+            return;
+
+        response.setStatusAndReason(
+            Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR);
+        response.setContentLength(0);
+        response.send();
+    }
+
+    HTTPServerScriptPool::HTTPServerScriptPool(const std::string& scriptPath) :
+        scriptPath(scriptPath)
+    {
+        // Evaluate the script once up front, so that a broken script is
+        // reported by bind() rather than by the first request.
+        ReleaseContext(CreateContext());
+    }
+
+    HTTPServerScriptPool::~HTTPServerScriptPool()
+    {
+        for (size_t i = 0; i < idleContexts.size(); i++)
+            DestroyContext(idleContexts[i]);
+    }
+
+    JSGlobalContextRef HTTPServerScriptPool::CreateContext()
+    {
+        JSGlobalContextRef context = JSUtil::CreateGlobalContext();
+        JSGlobalContextRetain(context);
+
+        try
+        {
+            JSUtil::EvaluateFile(context, scriptPath.c_str());
+        }
+        catch (ValueException&)
+        {
+            DestroyContext(context);
+            throw;
+        }
+
+        return context;
+    }
+
+    /*static*/
+    void HTTPServerScriptPool::DestroyContext(JSGlobalContextRef context)
+    {
+        JSUtil::UnregisterGlobalContext(context);
+        JSGlobalContextRelease(context);
+    }
+
+    JSGlobalContextRef HTTPServerScriptPool::AcquireContext()
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            if (!idleContexts.empty())
+            {
+                JSGlobalContextRef context = idleContexts.back();
+                idleContexts.pop_back();
+                return context;
+            }
+        }
+
+        return CreateContext();
+    }
+
+    void HTTPServerScriptPool::ReleaseContext(JSGlobalContextRef context)
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        idleContexts.push_back(context);
+    }
+
+    void HTTPServerScriptPool::HandleRequest(Poco::Net::HTTPServerRequest& request,
+        Poco::Net::HTTPServerResponse& response)
+    {
+        JSGlobalContextRef context;
+        try
+        {
+            context = AcquireContext();
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Could not load %s: %s", scriptPath.c_str(),
+                e.ToString().c_str());
+            SendError(response);
+            return;
+        }
+
+        try
+        {
+            TiObjectRef global(new KKJSObject(context,
+                JSContextGetGlobalObject(context)));
+            TiMethodRef handler(global->GetMethod("handleRequest"));
+            if (handler.isNull())
+                throw ValueException::FromFormat(
+                    "%s does not define a handleRequest function", scriptPath.c_str());
+
+            ValueList args;
+            args.push_back(Value::NewObject(new HttpServerRequest(request)));
+            args.push_back(Value::NewObject(new HttpServerResponse(response)));
+            handler->Call(args);
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Request handler failed: %s", e.ToString().c_str());
+            SendError(response);
+        }
+
+        ReleaseContext(context);
+    }
+}
@@ -0,0 +1,78 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _HTTP_SERVER_SCRIPT_POOL_H_
+#define _HTTP_SERVER_SCRIPT_POOL_H_
+
+#include <tide/tide.h>
+#include <Poco/Mutex.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <JavaScriptCore/JSBase.h>
+#include <vector>
+
+namespace ti
+{
+    /**
+     * Runs HTTPServer requests on the server's own threads instead of the
+     * main thread. Each request borrows a JavaScript context of its own,
+     * much like a Worker, in which the handler script has been evaluated;
+     * the script's global handleRequest(request, response) function is
+     * called for the request. Contexts are created as concurrent requests
+     * need them and are reused afterwards.
+     */
+    class HTTPServerScriptPool
+    {
+    public:
+        HTTPServerScriptPool(const std::string& scriptPath);
+        ~HTTPServerScriptPool();
+
+        void HandleRequest(Poco::Net::HTTPServerRequest& request,
+            Poco::Net::HTTPServerResponse& response);
+
+    private:
+        std::string scriptPath;
+        Poco::FastMutex mutex;
+        std::vector<JSGlobalContextRef> idleContexts;
+
+        JSGlobalContextRef AcquireContext();
+        void ReleaseContext(JSGlobalContextRef context);
+        JSGlobalContextRef CreateContext();
+        static void DestroyContext(JSGlobalContextRef context);
+
+        DISALLOW_EVIL_CONSTRUCTORS(HTTPServerScriptPool);
+    };
+}
+
+#endif
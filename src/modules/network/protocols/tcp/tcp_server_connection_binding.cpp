@@ -41,17 +41,16 @@ namespace ti
         return tide::Logger::Get("Network.TCPServerSocketConnection");
     }
     
-    TCPServerConnectionBinding::TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::Net::SocketReactor & r) :
+    TCPServerConnectionBinding::TCPServerConnectionBinding(Poco::Net::StreamSocket& s) :
         StaticBoundObject("Network.TCPServerSocketConnection"),
         socket(s), 
-        reactor(r),
         closed(false),
+        readFinished(false),
         onRead(0),
         onWrite(0),
         onReadComplete(0),
         currentSendDataOffset(0),
-        readStarted(false),
-        writeReadyHandlerInstalled(false)
+        readStarted(false)
     {
         GetLogger()->Debug("TCPServerConnectionBinding creating");
         
@@ -107,161 +106,183 @@ namespace ti
          */
         this->SetMethod("onReadComplete",&TCPServerConnectionBinding::SetOnReadComplete);
 
-        reactor.addEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ReadableNotification>(*this, &TCPServerConnectionBinding::onReadable));
-        reactor.addEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ShutdownNotification>(*this, &TCPServerConnectionBinding::onShutdown));
-        reactor.addEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ErrorNotification>(*this, &TCPServerConnectionBinding::onErrored));
+        // The reactor keeps this connection alive until it is closed.
+        this->socket.setBlocking(false);
+        NetworkReactor::GetInstance()->Register(this->socket, this,
+            TiObjectRef(this, true));
     }
+
     TCPServerConnectionBinding::~TCPServerConnectionBinding()
     {
-        reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ReadableNotification>(*this, &TCPServerConnectionBinding::onReadable));
-        reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ShutdownNotification>(*this, &TCPServerConnectionBinding::onShutdown));
-        reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::WritableNotification>(*this, &TCPServerConnectionBinding::onWritable));
-        reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::ErrorNotification>(*this, &TCPServerConnectionBinding::onErrored));
-
         if (!this->closed)
         {
             this->socket.close();
         }
     }
-    void TCPServerConnectionBinding::onReadable (const Poco::AutoPtr<Poco::Net::ReadableNotification>& notification)
+
+    int TCPServerConnectionBinding::Interest()
     {
-        if (this->closed)
+        int events = 0;
+        if (!this->readFinished)
+            events |= NetworkReactor::READABLE;
+        if (!this->sendData.empty())
+            events |= NetworkReactor::WRITABLE;
+        return events;
+    }
+
+    void TCPServerConnectionBinding::ReportError(const std::string& message)
+    {
+        GetLogger()->Error("Socket error: %s", message.c_str());
+        if (!this->onError.isNull())
+        {
+            ValueList args(Value::NewString(message));
+            RunOnMainThread(this->onError, args, false);
+        }
+    }
+
+    bool TCPServerConnectionBinding::CloseSocket()
+    {
+        {
+            Poco::Mutex::ScopedLock lock(sendDataMutex);
+            if (this->closed)
+                return false;
+            this->closed = true;
+            this->sendData = std::queue<BytesRef>();
+        }
+
+        NetworkReactor::GetInstance()->Unregister(this->socket);
+        this->socket.close();
+        return true;
+    }
+
+    void TCPServerConnectionBinding::OnReadable()
+    {
+        if (this->closed || this->readFinished)
         {
             return;
         }
-        static std::string eprefix("TCPServerConnectionBinding::OnRead: ");
-        
+
         try
         {
-            // Always read bytes, so that the tubes get cleared.
             char data[BUFFER_SIZE + 1];
             int size = socket.receiveBytes(&data, BUFFER_SIZE);
 
-            // A read is only complete if we've already read some bytes from the socket.
-            bool readComplete = this->readStarted && (size <= 0);
-            this->readStarted = (size > 0);
-
-            if (readComplete && !this->onReadComplete.isNull())
+            if (size > 0)
             {
-                ValueList args;
-                RunOnMainThread(this->onReadComplete, args, false);
+                this->readStarted = true;
+                if (!this->onRead.isNull())
+                {
+                    data[size] = '\0';
+
+                    BytesRef bytes(new Bytes(data, size));
+                    ValueList args(Value::NewObject(bytes));
+                    RunOnMainThread(this->onRead, args, false);
+                }
             }
-            else if (size > 0 && !this->onRead.isNull())
+            else if (size == 0)
             {
-                data[size] = '\0';
+                // A read is only complete if we've already read some bytes from the socket.
+                if (this->readStarted && !this->onReadComplete.isNull())
+                {
+                    ValueList args;
+                    RunOnMainThread(this->onReadComplete, args, false);
+                }
 
-                BytesRef bytes(new Bytes(data, size));
-                ValueList args(Value::NewObject(bytes));
-                RunOnMainThread(this->onRead, args, false);
+                // The peer has finished sending. Stop watching for reads, since
+                // the socket now stays readable, and close the connection once
+                // anything still queued has been written.
+                bool drained;
+                {
+                    Poco::Mutex::ScopedLock lock(sendDataMutex);
+                    this->readFinished = true;
+                    drained = this->sendData.empty();
+                    if (!drained)
+                        NetworkReactor::GetInstance()->SetEvents(socket, Interest());
+                }
+
+                if (drained)
+                    this->CloseSocket();
             }
         }
+        catch (Poco::TimeoutException&)
+        {
+            // Nothing to read after all.
+        }
         catch (ValueException& e)
         {
-            GetLogger()->Error("Read failed: %s", e.ToString().c_str());
-            ValueList args(Value::NewString(e.ToString()));
-
-            if (!this->onError.isNull())
-                RunOnMainThread(this->onError, args, false);
+            this->ReportError(e.ToString());
         }
         catch (Poco::Exception &e)
         {
             // sometimes we'll get a I/O error (9) after closing during
             // a read, we can safely ignore errors if closed
             if (!this->closed)
-            {
-                GetLogger()->Error("Read failed: %s", e.displayText().c_str());
-                ValueList args(Value::NewString(e.displayText()));
-
-                if (!this->onError.isNull())
-                    RunOnMainThread(this->onError, args, false);
-            }
+                this->ReportError(e.displayText());
         }
-        catch (...)
-        {
-            GetLogger()->Error("Read failed: unknown exception");
-            ValueList args(Value::NewString("Unknown exception during read"));
-
-            if (!this->onError.isNull())
-                RunOnMainThread(this->onError, args, false);
-        }
-    }
-    void TCPServerConnectionBinding::onShutdown (const Poco::AutoPtr<Poco::Net::ShutdownNotification>& notification)
-    {
-        this->closed = true;
-        
-        //FIXME? what to do when we shutdown... do we need to auto-release?
     }
-    void TCPServerConnectionBinding::onWritable (const Poco::AutoPtr<Poco::Net::WritableNotification>& notification)
-    {
-        if (this->closed)
-        {
-            return;
-        }
 
-        if (sendData.empty())
-        {
-            this->reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::WritableNotification>(*this, &TCPServerConnectionBinding::onWritable));
-            writeReadyHandlerInstalled = false;
-            return;
-        }
-        
-        BytesRef buffer(0);
+    void TCPServerConnectionBinding::OnWritable()
+    {
+        bool finished = false;
+        try
         {
             Poco::Mutex::ScopedLock lock(sendDataMutex);
-            buffer = sendData.front();
-        }
+            while (!this->closed && !sendData.empty())
+            {
+                BytesRef buffer(sendData.front());
+                const char* data = buffer->Pointer() + currentSendDataOffset;
+                size_t length = buffer->Length() - currentSendDataOffset;
 
-        const char* data = buffer->Pointer() + currentSendDataOffset;
-        size_t length = buffer->Length() - currentSendDataOffset;
-        size_t count = this->socket.sendBytes(data, length);
-        currentSendDataOffset += count;
+                int count = -1;
+                try
+                {
+                    count = this->socket.sendBytes(data, length);
+                }
+                catch (Poco::TimeoutException&)
+                {
+                }
 
-        if (currentSendDataOffset == (size_t) buffer->Length())
-        {
-            // Only send the onWrite message when we've exhausted a Bytes.
-            if (!this->onWrite.isNull())
-            {
-                ValueList args(Value::NewInt(buffer->Length()));
-                RunOnMainThread(this->onWrite, args, false);
-            }
+                // Wait for the reactor to tell us there is room again.
+                if (count < 0)
+                    return;
 
-            Poco::Mutex::ScopedLock lock(sendDataMutex);
-            sendData.pop();
-            currentSendDataOffset = 0;
+                currentSendDataOffset += count;
+                if (currentSendDataOffset < (size_t) buffer->Length())
+                    return;
 
-            // Uninstall the ReadyForWrite reactor handler, because it will push
-            // the CPU to 100% usage if there is nothing to write.
-            if (sendData.size() == 0)
-            {
-                this->reactor.removeEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::WritableNotification>(*this, &TCPServerConnectionBinding::onWritable));
-                writeReadyHandlerInstalled = false;
+                // Only send the onWrite message when we've exhausted a Bytes.
+                if (!this->onWrite.isNull())
+                {
+                    ValueList args(Value::NewInt(buffer->Length()));
+                    RunOnMainThread(this->onWrite, args, false);
+                }
+
+                sendData.pop();
+                currentSendDataOffset = 0;
             }
+
+            // Stop watching for writability, because it will push
+            // the CPU to 100% usage if there is nothing to write.
+            finished = !this->closed && this->readFinished;
+            if (!this->closed && !finished)
+                NetworkReactor::GetInstance()->SetEvents(socket, Interest());
         }
-    }
-    void TCPServerConnectionBinding::onErrored(const Poco::AutoPtr<Poco::Net::ErrorNotification>& notification)
-    {
-        if (this->onError.isNull())
+        catch (Poco::Exception &e)
         {
-            return;
+            if (!this->closed)
+                this->ReportError(e.displayText());
+            finished = true;
         }
-        ValueList args(Value::NewString(notification->name()));
-        RunOnMainThread(this->onError, args, false);
+
+        if (finished)
+            this->CloseSocket();
     }
-    
+
     ///////////////////////////////////////////////////////////////////////////////////
 
     void TCPServerConnectionBinding::Close(const ValueList& args, ValueRef result)
     {
-        if (!closed)
-        {
-            this->closed = true;
-            socket.close();
-            result->SetBool(true);
-        }
-        else
-        {
-            result->SetBool(false);
-        }
+        result->SetBool(this->CloseSocket());
     }
     
     void TCPServerConnectionBinding::Write(const ValueList& args, ValueRef result)
@@ -291,13 +312,10 @@ namespace ti
             Poco::Mutex::ScopedLock lock(sendDataMutex);
             sendData.push(data);
 
-            // Only install the ReadyForWrite handler when there is actually data
+            // Only watch for writability when there is actually data
             // to write, because otherwise the CPU usage will spike to 100%
-            if (!writeReadyHandlerInstalled)
-            {
-                this->reactor.addEventHandler(socket, Poco::NObserver<TCPServerConnectionBinding, Poco::Net::WritableNotification>(*this, &TCPServerConnectionBinding::onWritable));
-                writeReadyHandlerInstalled = true;
-            }
+            if (sendData.size() == 1)
+                NetworkReactor::GetInstance()->SetEvents(socket, Interest());
         }
 
         result->SetBool(true);
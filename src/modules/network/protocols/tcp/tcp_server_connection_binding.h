@@ -36,31 +36,30 @@
 #define _TCP_SERVER_CONNECTION_BINDING_H_
 
 #include <tide/tide.h>
-#include <Poco/Thread.h>
 #include <Poco/Net/StreamSocket.h>
-#include <Poco/Net/SocketReactor.h>
-#include <Poco/Net/SocketAcceptor.h>
-#include <Poco/Net/SocketNotification.h>
-#include <Poco/NObserver.h>
-#include <Poco/RunnableAdapter.h>
 #include <queue>
+#include "../../network_reactor.h"
 
 namespace ti
 {
-    class TCPServerConnectionBinding : public StaticBoundObject
+    class TCPServerConnectionBinding : public StaticBoundObject,
+        public NetworkReactor::Handler
     {
     public:
-        TCPServerConnectionBinding(Poco::Net::StreamSocket& s, Poco::Net::SocketReactor & reactor_);
+        TCPServerConnectionBinding(Poco::Net::StreamSocket& s);
         virtual ~TCPServerConnectionBinding();
 
+        virtual void OnReadable();
+        virtual void OnWritable();
+
     private:
         enum
         {
             BUFFER_SIZE = 1024
         };
         Poco::Net::StreamSocket socket;
-        Poco::Net::SocketReactor& reactor;
         bool closed;
+        bool readFinished;
         TiMethodRef onRead;
         TiMethodRef onWrite;
         TiMethodRef onError;
@@ -69,12 +68,10 @@ namespace ti
         Poco::Mutex sendDataMutex;
         size_t currentSendDataOffset;
         bool readStarted;
-        bool writeReadyHandlerInstalled;
 
-        void onReadable (const Poco::AutoPtr<Poco::Net::ReadableNotification>&);
-        void onShutdown (const Poco::AutoPtr<Poco::Net::ShutdownNotification>&);
-        void onWritable (const Poco::AutoPtr<Poco::Net::WritableNotification>&);
-        void onErrored(const Poco::AutoPtr<Poco::Net::ErrorNotification>&);
+        int Interest();
+        void ReportError(const std::string& message);
+        bool CloseSocket();
 
         void Write(const ValueList& args, ValueRef result);
         void Close(const ValueList& args, ValueRef result);
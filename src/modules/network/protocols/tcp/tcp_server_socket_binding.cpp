@@ -35,30 +35,36 @@
 #include "tcp_server_socket_binding.h"
 #include "tcp_server_connection_binding.h"
 
-#include <Poco/NObserver.h>
-#include <Poco/Net/SocketNotification.h>
-
 namespace ti
 {
     
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    TCPServerSocketConnector::TCPServerSocketConnector(TiMethodRef callback_, Poco::Net::ServerSocket& socket_, Poco::Net::SocketReactor & reactor_) :
-        callback(callback_),socket(socket_),reactor(reactor_)
+    TCPServerSocketConnector::TCPServerSocketConnector(TiMethodRef callback_, Poco::Net::ServerSocket& socket_) :
+        callback(callback_),socket(socket_)
     {
-        reactor.addEventHandler(socket, Poco::Observer<TCPServerSocketConnector, Poco::Net::ReadableNotification>(*this, &TCPServerSocketConnector::onAccept));
     }
     TCPServerSocketConnector::~TCPServerSocketConnector()
     {
-        reactor.removeEventHandler(socket, Poco::Observer<TCPServerSocketConnector, Poco::Net::ReadableNotification>(*this, &TCPServerSocketConnector::onAccept));
     }
-    void TCPServerSocketConnector::onAccept(Poco::Net::ReadableNotification *n)
+    void TCPServerSocketConnector::OnReadable()
     {
         tide::Logger *logger = tide::Logger::Get("Network.TCPServerSocketConnector");
 
-        n->release();
-        Poco::Net::StreamSocket sock = socket.acceptConnection();
-        AutoPtr<TCPServerConnectionBinding> conn = new TCPServerConnectionBinding(sock,reactor);
+        Poco::Net::StreamSocket sock;
+        try
+        {
+            sock = socket.acceptConnection();
+        }
+        catch (Poco::Exception& e)
+        {
+            // The client may have given up before we got to it, or
+            // the server socket was closed while we were woken up.
+            logger->Debug("acceptConnection failed: %s", e.displayText().c_str());
+            return;
+        }
+
+        AutoPtr<TCPServerConnectionBinding> conn = new TCPServerConnectionBinding(sock);
 
         ValueList args = ValueList();
         args.push_back(Value::NewObject(conn));
@@ -80,8 +86,6 @@ namespace ti
         onCreate(create), 
         socket(0),
         acceptor(0),
-        listenAdapter(new Poco::RunnableAdapter<TCPServerSocketBinding>(
-            *this, &TCPServerSocketBinding::ListenThread)),
         listening(false)
     {
         /**
@@ -100,43 +104,34 @@ namespace ti
 
     TCPServerSocketBinding::~TCPServerSocketBinding()
     {
-        if (this->listening)
-        {
-            this->listening = false;
-            this->reactor.stop();
-            this->socket->close();
-        }
-
-        listenThread.join();
-        delete listenAdapter;
-    }
-    
-    void TCPServerSocketBinding::ListenThread()
-    {
-        this->acceptor = new TCPServerSocketConnector(this->onCreate,*this->socket,this->reactor);
-        this->listening = true;
-
-        while(this->listening)
-        {
-            this->reactor.run();
-        }
+        // While listening, the reactor holds a reference to us, so
+        // by now the server socket has already been unregistered.
+        delete this->acceptor;
+        delete this->socket;
     }
     
     void TCPServerSocketBinding::Listen(const ValueList& args, ValueRef result)
     {
         args.VerifyException("listen", "n");
 
-        if (this->listening || listenThread.isRunning())
+        if (this->listening)
         {
             throw ValueException::FromString("Socket is already listening");
         }
         
         //TODO: add support for bind ipaddress
         
+        delete this->acceptor;
+        delete this->socket;
+
         int port = args.at(0)->ToInt();
         this->socket = new Poco::Net::ServerSocket(port);
+        this->socket->setBlocking(false);
+        this->acceptor = new TCPServerSocketConnector(this->onCreate, *this->socket);
 
-        listenThread.start(*listenAdapter);
+        NetworkReactor::GetInstance()->Register(*this->socket, this->acceptor,
+            TiObjectRef(this, true));
+        this->listening = true;
         result->SetBool(true);
     }
     
@@ -145,7 +140,7 @@ namespace ti
         if (this->listening)
         {
             this->listening = false;
-            this->reactor.stop();
+            NetworkReactor::GetInstance()->Unregister(*this->socket);
             this->socket->close();
             result->SetBool(true);
         }
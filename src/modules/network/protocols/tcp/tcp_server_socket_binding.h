@@ -36,13 +36,8 @@
 #define _TCP_SERVER_SOCKET_BINDING_H_
 
 #include <tide/tide.h>
-#include <Poco/Thread.h>
-#include <Poco/Net/StreamSocket.h>
-#include <Poco/Net/SocketReactor.h>
-#include <Poco/Net/SocketAcceptor.h>
-#include <Poco/Net/SocketNotification.h>
-#include <Poco/NObserver.h>
-#include <Poco/RunnableAdapter.h>
+#include <Poco/Net/ServerSocket.h>
+#include "../../network_reactor.h"
 #include "tcp_server_connection_binding.h"
 
 /**
@@ -56,16 +51,15 @@
  */
 namespace ti
 {
-    class TCPServerSocketConnector
+    class TCPServerSocketConnector : public NetworkReactor::Handler
     {
     public:
-        TCPServerSocketConnector(TiMethodRef callback,Poco::Net::ServerSocket& socket,Poco::Net::SocketReactor& reactor);
+        TCPServerSocketConnector(TiMethodRef callback,Poco::Net::ServerSocket& socket);
         virtual ~TCPServerSocketConnector();
-        void onAccept(Poco::Net::ReadableNotification* pNotification);
+        virtual void OnReadable();
     private:
         TiMethodRef callback;
         Poco::Net::ServerSocket& socket;
-        Poco::Net::SocketReactor& reactor;
     };
 
     class TCPServerSocketBinding : public StaticBoundObject
@@ -80,13 +74,9 @@ namespace ti
         };
         TiMethodRef onCreate;
         Poco::Net::ServerSocket* socket;
-        Poco::Net::SocketReactor reactor;
         TCPServerSocketConnector* acceptor;
-        Poco::Thread listenThread;
-        Poco::RunnableAdapter<TCPServerSocketBinding>* listenAdapter;
         bool listening;
         
-        void ListenThread();
         void Listen(const ValueList& args, ValueRef result);
         void Close(const ValueList& args, ValueRef result);
     };
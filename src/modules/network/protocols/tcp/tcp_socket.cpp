@@ -34,21 +34,47 @@
 
 #include "tcp_socket.h"
 
-#include <Poco/ThreadPool.h>
-#include <Poco/Timespan.h>
+#include <Poco/Net/SocketImpl.h>
+#include <cstring>
+#include <sstream>
 
 #define READ_BUFFER_SIZE 40*1024
 #define READ_BUFFER_MIN_SIZE 128
 
 namespace ti
 {
+    static ValueRef DispatchSocketEvent(const ValueList& args)
+    {
+        AutoPtr<TCPSocket> socket(args.GetObject(0).cast<TCPSocket>());
+        std::string event(args.GetString(1));
+
+        ValueList eventArgs;
+        for (size_t i = 2; i < args.size(); i++)
+            eventArgs.push_back(args.at(i));
+
+        socket->FireEvent(event.c_str(), eventArgs);
+        return Value::Undefined;
+    }
+
+    static std::string SocketErrorMessage(int error)
+    {
+#if defined(OS_WIN32)
+        std::ostringstream message;
+        message << "Socket error " << error;
+        return message.str();
+#else
+        return strerror(error);
+#endif
+    }
+
     TCPSocket::TCPSocket(std::string& host, int port) :
         EventObject("Network.TCPSocket"),
         address(host, port),
         socket(address.family()),
         state(CLOSED),
-        reader(*this, &TCPSocket::ReadThread),
-        writer(*this, &TCPSocket::WriteThread)
+        writeOffset(0),
+        readBufferUsed(0),
+        timeout(0)
     {
         SetMethod("connect", &TCPSocket::_Connect);
         SetMethod("setTimeout", &TCPSocket::_SetTimeout);
@@ -67,16 +93,33 @@ namespace ti
 
     void TCPSocket::Connect()
     {
-        Poco::FastMutex::ScopedLock lock(this->mutex);
+        std::string error;
+        {
+            Poco::FastMutex::ScopedLock lock(this->mutex);
 
-        if (this->state != CLOSED)
-            throw ValueException::FromString("socket is already connected");
+            if (this->state != CLOSED)
+                throw ValueException::FromString("socket is already connected");
 
-        // Start up the reading thread.
-        // This thread will establish the connection
-        // and then begin reading data from the socket.
-        this->state = CONNECTING;
-        this->readThread.start(reader);
+            // Start a non-blocking connect and let the reactor tell us
+            // when it finishes. The socket is writable once connected.
+            this->state = CONNECTING;
+            try
+            {
+                this->socket.connectNB(this->address);
+                NetworkReactor* reactor = NetworkReactor::GetInstance();
+                reactor->Register(this->socket, this, TiObjectRef(this, true),
+                    NetworkReactor::WRITABLE);
+                if (this->timeout > 0)
+                    reactor->SetTimeout(this->socket, this->timeout);
+            }
+            catch (Poco::Exception& e)
+            {
+                error = e.displayText();
+            }
+        }
+
+        if (!error.empty())
+            HandleError(error);
     }
 
     bool TCPSocket::Close()
@@ -87,14 +130,16 @@ namespace ti
             if (this->state == CLOSED)
                 return false;
 
+            NetworkReactor::GetInstance()->Unregister(this->socket);
             this->socket.close();
             this->state = CLOSED;
 
             // Delete any remaining buffers in write queue.
             this->writeQueue = std::queue<BytesRef>();
+            this->writeOffset = 0;
         }
 
-        FireEvent("close");
+        PostEvent("close");
         return true;
     }
 
@@ -104,12 +149,9 @@ namespace ti
         if (this->state != DUPLEX && this->state != WRITEONLY)
             throw ValueException::FromString("Socket is not writable");
 
-        if (this->writeQueue.empty())
-        {
-            Poco::ThreadPool::defaultPool().start(this->writer);
-        }
-
         this->writeQueue.push(data);
+        if (this->writeQueue.size() == 1)
+            NetworkReactor::GetInstance()->SetEvents(this->socket, Interest());
     }
 
     void TCPSocket::SetKeepAlive(bool enable)
@@ -119,124 +161,174 @@ namespace ti
 
     void TCPSocket::SetTimeout(long milliseconds)
     {
-        try
-        {
-            Poco::Timespan t(0, milliseconds * 1000);
-            this->socket.setReceiveTimeout(t);
-        }
-        catch (Poco::Exception& e)
-        {
-            HandleError(e);
-        }
+        Poco::FastMutex::ScopedLock lock(this->mutex);
+        this->timeout = milliseconds;
+
+        // If we aren't connected yet, the timeout is
+        // applied when the socket is registered.
+        if (this->state != CLOSED)
+            NetworkReactor::GetInstance()->SetTimeout(this->socket, milliseconds);
     }
 
-    void TCPSocket::ReadThread()
+    int TCPSocket::Interest()
     {
-        try
-        {
-            this->socket.connect(this->address);
-
-            {
-                Poco::FastMutex::ScopedLock lock(this->mutex);
-                this->state = DUPLEX;
-            }
+        if (this->state == CONNECTING)
+            return NetworkReactor::WRITABLE;
+
+        int events = 0;
+        if (this->state == DUPLEX || this->state == READONLY)
+            events |= NetworkReactor::READABLE;
+        if (!this->writeQueue.empty())
+            events |= NetworkReactor::WRITABLE;
+        return events;
+    }
 
-            FireEvent("connect");
-        }
-        catch (Poco::Exception& e)
+    void TCPSocket::OnReadable()
+    {
+        std::string error;
         {
-            HandleError(e);
-            return;
-        }
-
-        BytesRef buffer = new Bytes(READ_BUFFER_SIZE);
-        size_t usedSpace = 0;
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->state != DUPLEX && this->state != READONLY)
+                return;
 
-        while (true)
-        {
             // Re-allocate a new read buffer if the current
             // one has become too small.
-            int freeSpace = READ_BUFFER_SIZE - usedSpace;
-            if (freeSpace < READ_BUFFER_MIN_SIZE)
+            if (this->readBuffer.isNull() ||
+                READ_BUFFER_SIZE - this->readBufferUsed < READ_BUFFER_MIN_SIZE)
             {
-                buffer = new Bytes(READ_BUFFER_SIZE);
-                usedSpace = 0;
-                freeSpace = READ_BUFFER_SIZE;
+                this->readBuffer = new Bytes(READ_BUFFER_SIZE);
+                this->readBufferUsed = 0;
             }
 
-            // Attempt to read data from socket into buffer.
             try
             {
-                char* bufferPtr = buffer->Pointer() + usedSpace;
+                char* bufferPtr = this->readBuffer->Pointer() + this->readBufferUsed;
+                int freeSpace = READ_BUFFER_SIZE - this->readBufferUsed;
                 int bytesRecv = this->socket.receiveBytes(bufferPtr, freeSpace);
                 if (bytesRecv > 0)
                 {
-                    BytesRef data = new Bytes(buffer, usedSpace, bytesRecv);
-                    usedSpace += bytesRecv;
-                    this->FireEvent("data", ValueList(Value::NewObject(data)));
+                    BytesRef data = new Bytes(this->readBuffer,
+                        this->readBufferUsed, bytesRecv);
+                    this->readBufferUsed += bytesRecv;
+                    PostEvent("data", Value::NewObject(data));
                 }
-                else
+                else if (bytesRecv == 0)
                 {
                     // Remote host sent FIN, we are now write only.
-                    {
-                        Poco::FastMutex::ScopedLock lock(this->mutex);
-                        this->state = WRITEONLY;
-                    }
-
-                    FireEvent("end");
-                    return;
+                    this->state = WRITEONLY;
+                    NetworkReactor::GetInstance()->SetEvents(this->socket, Interest());
+                    PostEvent("end");
                 }
             }
-            catch (Poco::TimeoutException& e)
+            catch (Poco::TimeoutException&)
             {
-                this->FireEvent("timeout");
+                // Nothing to read after all.
             }
             catch (Poco::Exception& e)
             {
-                HandleError(e);
-                return;
+                error = e.displayText();
             }
         }
+
+        if (!error.empty())
+            HandleError(error);
     }
 
-    void TCPSocket::WriteThread()
+    void TCPSocket::OnWritable()
     {
-        this->mutex.lock();
-        while (!this->writeQueue.empty())
+        std::string error;
         {
-            BytesRef data = this->writeQueue.front();
-            char* buffer = data->Pointer();
-            size_t remaining = data->Length();
-
-            // Release lock while sending data to avoid blocking write().
-            this->mutex.unlock();
-            while (true)
+            Poco::FastMutex::ScopedLock lock(this->mutex);
+            if (this->state == CONNECTING)
+            {
+                int socketError = this->socket.impl()->socketError();
+                if (socketError != 0)
+                {
+                    error = SocketErrorMessage(socketError);
+                }
+                else
+                {
+                    this->state = DUPLEX;
+                    NetworkReactor::GetInstance()->SetEvents(this->socket, Interest());
+                    PostEvent("connect");
+                }
+            }
+            else if (this->state == DUPLEX || this->state == WRITEONLY)
             {
                 try
                 {
-                    size_t sent = this->socket.sendBytes(buffer, remaining);
-                    if (sent == remaining) break;
+                    if (Flush())
+                    {
+                        NetworkReactor::GetInstance()->SetEvents(this->socket, Interest());
 
-                    buffer += sent;
-                    remaining -= sent;
+                        // Notify listeners we have fully drained the queue.
+                        PostEvent("drain");
+                    }
                 }
                 catch (Poco::Exception& e)
                 {
-                    HandleError(e);
-                    return;
+                    error = e.displayText();
                 }
             }
+        }
+
+        if (!error.empty())
+            HandleError(error);
+    }
+
+    bool TCPSocket::Flush()
+    {
+        // Send as much as the socket will take right now. Returns true
+        // once the write queue has been completely drained.
+        while (!this->writeQueue.empty())
+        {
+            BytesRef data(this->writeQueue.front());
+            size_t remaining = data->Length() - this->writeOffset;
+
+            int sent = -1;
+            try
+            {
+                sent = this->socket.sendBytes(
+                    data->Pointer() + this->writeOffset, remaining);
+            }
+            catch (Poco::TimeoutException&)
+            {
+            }
+
+            // The kernel buffer is full, so wait until we're writable again.
+            if (sent < 0)
+                return false;
+
+            if ((size_t) sent < remaining)
+            {
+                this->writeOffset += sent;
+                return false;
+            }
 
-            this->mutex.lock();
             this->writeQueue.pop();
+            this->writeOffset = 0;
         }
+        return true;
+    }
 
-        // Notify listeners we have fully drained the queue.
-        this->mutex.unlock();
-        FireEvent("drain");
+    void TCPSocket::OnTimeout()
+    {
+        PostEvent("timeout");
+    }
+
+    void TCPSocket::PostEvent(const char* event, ValueRef arg)
+    {
+        // Events are delivered on the main thread without waiting, so the
+        // reactor never blocks on JavaScript and they keep their order.
+        ValueList args(Value::NewObject(TiObjectRef(this, true)),
+            Value::NewString(event));
+        if (!arg.isNull())
+            args.push_back(arg);
+
+        RunOnMainThread(new FunctionPtrMethod(&DispatchSocketEvent), args, false);
     }
 
-    void TCPSocket::HandleError(Poco::Exception& e)
+    void TCPSocket::HandleError(const std::string& message)
     {
         {
             Poco::FastMutex::ScopedLock lock(this->mutex);
@@ -245,7 +337,7 @@ namespace ti
             this->state = CLOSING;
         }
 
-        FireErrorEvent(e);
+        PostEvent("error", Value::NewString(message));
         Close();
     }
 
@@ -39,14 +39,14 @@
 #include <string>
 
 #include <Poco/Net/StreamSocket.h>
-#include <Poco/Thread.h>
 #include <Poco/Mutex.h>
 
 #include <tide/tide.h>
+#include "../../network_reactor.h"
 
 namespace ti
 {
-    class TCPSocket : public EventObject
+    class TCPSocket : public EventObject, public NetworkReactor::Handler
     {
     public:
         TCPSocket(std::string& host, int port);
@@ -58,11 +58,15 @@ namespace ti
         void SetKeepAlive(bool enable);
         void SetTimeout(long milliseconds);
 
-        void ReadThread();
-        void WriteThread();
+        virtual void OnReadable();
+        virtual void OnWritable();
+        virtual void OnTimeout();
 
     private:
-        void HandleError(Poco::Exception& e);
+        void HandleError(const std::string& message);
+        void PostEvent(const char* event, ValueRef arg = 0);
+        bool Flush();
+        int Interest();
 
         void _Connect(const ValueList& args, ValueRef result);
         void _SetTimeout(const ValueList& args, ValueRef result);
@@ -77,9 +81,11 @@ namespace ti
         Poco::Net::SocketAddress address;
         Poco::Net::StreamSocket socket;
         enum { CONNECTING, READONLY, WRITEONLY, DUPLEX, CLOSING, CLOSED } state;
-        Poco::Thread readThread;
-        Poco::RunnableAdapter<TCPSocket> reader, writer;
         std::queue<BytesRef> writeQueue;
+        size_t writeOffset;
+        BytesRef readBuffer;
+        size_t readBufferUsed;
+        long timeout;
         Poco::FastMutex mutex;
     };
 }
@@ -62,6 +62,7 @@ namespace ti
     void NativePipe::StopMonitors()
     {
         closed = true;
+        buffersAvailable.set();
         try
         {
             if (readThread.isRunning())
@@ -81,6 +82,7 @@ namespace ti
         if (!isReader)
         {
             closed = true;
+            buffersAvailable.set();
         }
         Pipe::Close();
     }
@@ -111,6 +113,7 @@ namespace ti
             // our writer thread.:
             Poco::Mutex::ScopedLock lock(buffersMutex);
             buffers.push(bytes);
+            buffersAvailable.set();
         }
 
         return bytes->Length();
@@ -151,11 +154,17 @@ namespace ti
     {
         TiObjectRef save(this, true);
 
-        BytesRef bytes = 0;
-        while (!closed || buffers.size() > 0)
+        // Sleep until Write or Close signals us, then drain everything which
+        // has been queued. Data queued before a close is still written.
+        while (true)
         {
             PollForWriteIteration();
-            Poco::Thread::sleep(50);
+            if (closed)
+            {
+                PollForWriteIteration();
+                break;
+            }
+            buffersAvailable.wait();
         }
 
         this->CloseNativeWrite();
@@ -163,19 +172,18 @@ namespace ti
 
     void NativePipe::PollForWriteIteration()
     {
-        BytesRef bytes = 0;
-        while (buffers.size() > 0)
+        while (true)
         {
+            BytesRef bytes = 0;
             {
                 Poco::Mutex::ScopedLock lock(buffersMutex);
+                if (buffers.empty())
+                    return;
                 bytes = buffers.front();
                 buffers.pop();
             }
             if (!bytes.isNull())
-            {
                 this->RawWrite(bytes);
-                bytes = 0;
-            }
         }
     }
 
@@ -183,7 +191,10 @@ namespace ti
     {
         try
         {
-            this->RawWrite((char*) bytes->Pointer(), bytes->Length());
+            std::vector<BytesRef> segments;
+            bytes->GetSegments(segments);
+            for (size_t i = 0; i < segments.size(); i++)
+                this->RawWrite(segments[i]->Pointer(), segments[i]->Length());
         }
         catch (Poco::Exception& e)
         {
@@ -69,6 +69,7 @@ namespace ti
         TiMethodRef readCallback;
         Logger* logger;
         Poco::Mutex buffersMutex;
+        Poco::Event buffersAvailable;
         std::queue<BytesRef> buffers;
 
         void PollForReads();
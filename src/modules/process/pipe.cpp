@@ -45,18 +45,22 @@
 
 namespace ti
 {
+    // Pipe events are fired from a single dispatcher thread, which sleeps
+    // on eventsAvailable until a pipe queues a read, a close or some other
+    // event. All three queues share eventsMutex so a batch can be taken
+    // out in one step.
     static void FireEvents();
     static Poco::ThreadTarget eventsThreadTarget(&FireEvents);
     static Poco::Thread eventsThread;
-    Poco::Mutex pipesNeedingReadEventsMutex;
-    std::queue<AutoPipe> pipesNeedingReadEvents;
-    Poco::Mutex pipesNeedingCloseEventsMutex;
-    std::queue<AutoPipe> pipesNeedingCloseEvents;
-    Poco::Mutex otherEventsMutex;
-    std::vector<AutoPtr<Event> > otherEvents;
+    static Poco::Mutex eventsMutex;
+    static Poco::Event eventsAvailable;
+    static std::vector<AutoPipe> pipesNeedingReadEvents;
+    static std::vector<AutoPipe> pipesNeedingCloseEvents;
+    static std::vector<AutoPtr<Event> > otherEvents;
 
     Pipe::Pipe(const char *type) :
         EventObject(type),
+        readEventPending(false),
         logger(Logger::Get("Process.Pipe"))
     {
         /**
@@ -219,11 +223,17 @@ namespace ti
     int Pipe::Write(BytesRef bytes)
     {
         { // Start the callbacks
-            Poco::Mutex::ScopedLock lock(pipesNeedingReadEventsMutex);
+            Poco::Mutex::ScopedLock lock(eventsMutex);
             readData.push_back(bytes);
 
-            this->duplicate();
-            pipesNeedingReadEvents.push(this);
+            // Data which arrives before the dispatcher gets to this pipe
+            // is delivered along with what is already queued, as one event.
+            if (!this->readEventPending)
+            {
+                this->readEventPending = true;
+                pipesNeedingReadEvents.push_back(AutoPipe(this, true));
+                eventsAvailable.set();
+            }
         }
 
         // We want this to execute on the same thread and to make all
@@ -268,9 +278,9 @@ namespace ti
     void Pipe::Close()
     {
         {
-            Poco::Mutex::ScopedLock lock(pipesNeedingCloseEventsMutex);
-            this->duplicate();
-            pipesNeedingCloseEvents.push(this);
+            Poco::Mutex::ScopedLock lock(eventsMutex);
+            pipesNeedingCloseEvents.push_back(AutoPipe(this, true));
+            eventsAvailable.set();
         }
 
         // Call the close method on our attached objects
@@ -315,82 +325,58 @@ namespace ti
     /*static*/
     void Pipe::FireEventAsynchronously(AutoPtr<Event> event)
     {
-        Poco::Mutex::ScopedLock lock(otherEventsMutex);
+        Poco::Mutex::ScopedLock lock(eventsMutex);
         otherEvents.push_back(event);
+        eventsAvailable.set();
     }
 
     static void FireEvents()
     {
         while (true)
         {
-
-            // We need to collect all the events in the reverse order
-            // that they should be fired. This avoid a race condition where
-            // a CLOSE or EXIT event happens before a READ event.
-            std::queue<AutoPtr<Event> > otherEventsCopy;
+            eventsAvailable.wait();
+
+            // Take everything queued so far in one step. Within a batch, READ
+            // events are fired before CLOSE events, which are fired before
+            // any other events, so a CLOSE or EXIT event never overtakes
+            // data which was read before it.
+            std::vector<AutoPipe> readPipes;
+            std::vector<AutoPipe> closePipes;
+            std::vector<AutoPtr<Event> > otherEventsCopy;
+            std::vector<AutoPtr<Event> > readEvents;
             {
-                Poco::Mutex::ScopedLock lock(otherEventsMutex);
-                for (size_t i = 0; i < otherEvents.size(); i++)
-                    otherEventsCopy.push(otherEvents[i]);
-
-                otherEvents.clear();
-            }
-
-            std::queue<AutoPtr<Event> > closeEvents;
-            {
-                Poco::Mutex::ScopedLock lock(pipesNeedingCloseEventsMutex);
-                while (pipesNeedingCloseEvents.size() > 0)
-                {
-                    AutoPipe pipe = pipesNeedingCloseEvents.front();
-                    pipesNeedingCloseEvents.pop();
-
-                    AutoPtr<Event> closeEvent = new Event(pipe, Event::CLOSE);
-                    AutoPtr<Event> closedEvent = new Event(pipe, Event::CLOSED);
-                    closeEvents.push(closeEvent);
-                    closeEvents.push(closedEvent);
-                }
-            }
+                Poco::Mutex::ScopedLock lock(eventsMutex);
+                readPipes.swap(pipesNeedingReadEvents);
+                closePipes.swap(pipesNeedingCloseEvents);
+                otherEventsCopy.swap(otherEvents);
 
-            std::queue<AutoPtr<Event> > readEvents;
-            {
-                Poco::Mutex::ScopedLock lock(pipesNeedingReadEventsMutex);
-                while (pipesNeedingReadEvents.size() > 0)
+                for (size_t i = 0; i < readPipes.size(); i++)
                 {
-                    AutoPipe pipe = pipesNeedingReadEvents.front();
-                    pipesNeedingReadEvents.pop();
-
+                    AutoPipe pipe = readPipes[i];
+                    pipe->readEventPending = false;
                     if (pipe->readData.size() > 0)
                     {
                         BytesRef glob(Bytes::Concat(pipe->readData));
-                        AutoPtr<Event> event = new ReadEvent(pipe, glob);
-                        readEvents.push(event);
+                        readEvents.push_back(new ReadEvent(pipe, glob));
                         pipe->readData.clear();
                     }
                 }
             }
 
-            while (readEvents.size() > 0)
-            {
-                AutoPtr<Event> event = readEvents.front();
-                event->target->FireEvent(event);
-                readEvents.pop();
-            }
-
-            while (closeEvents.size() > 0)
-            {
-                AutoPtr<Event> event = closeEvents.front();
-                event->target->FireEvent(event);
-                closeEvents.pop();
-            }
+            for (size_t i = 0; i < readEvents.size(); i++)
+                readEvents[i]->target->FireEvent(readEvents[i]);
 
-            while (otherEventsCopy.size() > 0)
+            for (size_t i = 0; i < closePipes.size(); i++)
             {
-                AutoPtr<Event> event = otherEventsCopy.front();
-                event->target->FireEvent(event);
-                otherEventsCopy.pop();
+                AutoPipe pipe = closePipes[i];
+                AutoPtr<Event> closeEvent = new Event(pipe, Event::CLOSE);
+                AutoPtr<Event> closedEvent = new Event(pipe, Event::CLOSED);
+                pipe->FireEvent(closeEvent);
+                pipe->FireEvent(closedEvent);
             }
 
-            Poco::Thread::sleep(5);
+            for (size_t i = 0; i < otherEventsCopy.size(); i++)
+                otherEventsCopy[i]->target->FireEvent(otherEventsCopy[i]);
         }
     }
 }
@@ -39,6 +39,7 @@
 #include <queue>
 #include <Poco/Thread.h>
 #include <Poco/ThreadTarget.h>
+#include <Poco/Event.h>
 
 namespace ti
 {
@@ -60,6 +61,7 @@ namespace ti
         bool IsAttached();
         AutoPipe Clone();
         std::vector<BytesRef> readData;
+        bool readEventPending;
         static void FireEventAsynchronously(AutoPtr<Event> event);
 
         protected:
@@ -33,20 +33,26 @@
 **/
 
 #include "posix_pipe.h"
+#include "posix_spawn.h"
+#include "process_reactor.h"
+#include <errno.h>
+#include <unistd.h>
 
 namespace ti
 {
     PosixPipe::PosixPipe(bool isReader) :
         NativePipe(isReader),
         readHandle(-1),
-        writeHandle(-1)
+        writeHandle(-1),
+        writeIndex(0),
+        writeOffset(0)
     {
     }
 
     void PosixPipe::CreateHandles()
     {
         int fds[2];
-        int rc = pipe(fds);
+        int rc = CreateSpawnPipe(fds);
         if (rc == 0)
         {
             readHandle = fds[0];
@@ -59,13 +65,99 @@ namespace ti
         }
     }
 
+    int PosixPipe::Write(BytesRef bytes)
+    {
+        if (isReader)
+            return NativePipe::Write(bytes);
+
+        // The process reactor does the actual writing once the
+        // child is ready for more input.
+        {
+            Poco::Mutex::ScopedLock lock(buffersMutex);
+            buffers.push(bytes);
+        }
+        ProcessReactor::GetInstance()->WriteQueued(
+            AutoPtr<PosixPipe>(this, true));
+        return bytes->Length();
+    }
+
     void PosixPipe::Close()
     {
-        // Close should only be called if the process (or whatever)
-        // it is attached to closes. Thus we want to make sure all
-        // the output is cleared from the pipe before closing them.
-        // A widowed pipe will eventually stop reading data.
-        NativePipe::Close();
+        // Reader pipes close once the process does, after all of its
+        // output has been read. A writer closes its native pipe after
+        // writing everything queued before this call.
+        if (!isReader)
+        {
+            closed = true;
+            ProcessReactor::GetInstance()->WriteQueued(
+                AutoPtr<PosixPipe>(this, true));
+        }
+        Pipe::Close();
+    }
+
+    bool PosixPipe::FlushWrites()
+    {
+        while (true)
+        {
+            if (writeIndex == writeSegments.size())
+            {
+                writeSegments.clear();
+                writeIndex = 0;
+                writeOffset = 0;
+
+                BytesRef bytes(0);
+                {
+                    Poco::Mutex::ScopedLock lock(buffersMutex);
+                    if (buffers.empty())
+                        return false;
+                    bytes = buffers.front();
+                    buffers.pop();
+                }
+                if (!bytes.isNull())
+                    bytes->GetSegments(writeSegments);
+                continue;
+            }
+
+            BytesRef segment(writeSegments[writeIndex]);
+            int n;
+            do
+            {
+                n = write(writeHandle, segment->Pointer() + writeOffset,
+                    segment->Length() - writeOffset);
+            }
+            while (n < 0 && errno == EINTR);
+
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return true;
+
+            if (n < 0)
+            {
+                // The process has stopped reading, so the rest
+                // of its input can never be delivered.
+                logger->Error("Error writing Bytes data to pipe: %s",
+                    strerror(errno));
+                closed = true;
+                this->DiscardWrites();
+                return false;
+            }
+
+            writeOffset += n;
+            if (writeOffset == (size_t) segment->Length())
+            {
+                writeIndex++;
+                writeOffset = 0;
+            }
+        }
+    }
+
+    void PosixPipe::DiscardWrites()
+    {
+        writeSegments.clear();
+        writeIndex = 0;
+        writeOffset = 0;
+
+        Poco::Mutex::ScopedLock lock(buffersMutex);
+        buffers = std::queue<BytesRef>();
     }
 
     int PosixPipe::RawRead(char *buffer, int size)
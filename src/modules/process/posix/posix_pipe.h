@@ -45,15 +45,25 @@ namespace ti
     public:
         PosixPipe(bool isReader);
         virtual void CreateHandles();
+        virtual int Write(BytesRef bytes);
         virtual void Close();
         virtual void CloseNativeRead();
         virtual void CloseNativeWrite();
+        bool FlushWrites();
+        void DiscardWrites();
+        inline bool IsClosed() { return closed; }
         inline int GetReadHandle() { return readHandle; }
         inline int GetWriteHandle() { return writeHandle; }
 
     protected:
         int readHandle;
         int writeHandle;
+
+        // The Bytes currently being written by FlushWrites.
+        std::vector<BytesRef> writeSegments;
+        size_t writeIndex;
+        size_t writeOffset;
+
         virtual int RawRead(char *buffer, int size);
         virtual int RawWrite(const char *buffer, int size);
     };
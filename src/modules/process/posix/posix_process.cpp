@@ -34,8 +34,12 @@
 **/
 
 #include "posix_process.h"
+#include "posix_spawn.h"
+#include "process_reactor.h"
 #include <errno.h>
+#include <map>
 #include <signal.h>
+#include <string.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/resource.h>
@@ -56,7 +60,8 @@ namespace ti
         logger(Logger::Get("Process.PosixProcess")),
         nativeIn(new PosixPipe(false)),
         nativeOut(new PosixPipe(true)),
-        nativeErr(new PosixPipe(true))
+        nativeErr(new PosixPipe(true)),
+        synchronous(false)
     {
         stdinPipe->Attach(this->GetNativeStdin());
     }
@@ -97,50 +102,53 @@ namespace ti
 
     void PosixProcess::ForkAndExec()
     {
+        std::vector<std::string> arguments;
+        for (size_t i = 0; i < args->Size(); i++)
+            arguments.push_back(args->At(i)->ToString());
+
+        // The child sees our environment with this process'
+        // variables layered on top of it.
+#if defined(OS_OSX)
+        char** parentEnvironment = *_NSGetEnviron();
+#else
+        char** parentEnvironment = environ;
+#endif
+        std::map<std::string, std::string> variables;
+        for (size_t i = 0; parentEnvironment[i]; i++)
+        {
+            std::string variable(parentEnvironment[i]);
+            size_t equals = variable.find('=');
+            if (equals != std::string::npos)
+                variables[variable.substr(0, equals)] = variable.substr(equals + 1);
+        }
+
+        SharedStringList envNames = environment->GetPropertyNames();
+        for (size_t i = 0; i < envNames->size(); i++)
+        {
+            const char* key = envNames->at(i)->c_str();
+            variables[key] = environment->Get(key)->ToString();
+        }
+
+        std::vector<std::string> childEnvironment;
+        std::map<std::string, std::string>::iterator i = variables.begin();
+        for (; i != variables.end(); i++)
+            childEnvironment.push_back(i->first + "=" + i->second);
+
         nativeIn->CreateHandles();
         nativeOut->CreateHandles();
         nativeErr->CreateHandles();
 
-        int pid = fork();
+        int fds[3] = { nativeIn->GetReadHandle(), nativeOut->GetWriteHandle(),
+            nativeErr->GetWriteHandle() };
+        pid_t pid = SpawnProcess(arguments, childEnvironment, fds);
         if (pid < 0)
         {
-            throw ValueException::FromFormat("Cannot fork process for %s", 
-                args->At(0)->ToString());
-        }
-        else if (pid == 0)
-        {
-            // outPipe and errPipe may be the same, so we dup first and close later
-            dup2(nativeIn->GetReadHandle(), STDIN_FILENO);
-            dup2(nativeOut->GetWriteHandle(), STDOUT_FILENO);
-            dup2(nativeErr->GetWriteHandle(), STDERR_FILENO);
+            int error = errno;
             nativeIn->CloseNative();
             nativeOut->CloseNative();
             nativeErr->CloseNative();
-
-            // close all open file descriptors other than stdin, stdout, stderr
-            for (int i = 3; i < getdtablesize(); ++i)
-                close(i);
-
-            size_t i = 0;
-            char** argv = new char*[args->Size() + 1];
-            //argv[i++] = const_cast<char*>(command.c_str());
-            for (;i < args->Size(); i++)
-            {
-                argv[i] = const_cast<char*>(args->At(i)->ToString());
-            }
-            argv[i] = NULL;
-
-            SharedStringList envNames = environment->GetPropertyNames();
-            for (i = 0; i < envNames->size(); i++)
-            {
-                const char* key = envNames->at(i)->c_str();
-                std::string value(environment->Get(key)->ToString());
-                setenv(key, value.c_str(), 1);
-            }
-
-            const char *command = args->At(0)->ToString();
-            execvp(command, argv);
-            _exit(72);
+            throw ValueException::FromFormat("Cannot launch process for %s: %s",
+                args->At(0)->ToString(), strerror(error));
         }
 
         SetPID(pid);
@@ -151,9 +159,9 @@ namespace ti
 
     void PosixProcess::MonitorAsync()
     {
-        nativeIn->StartMonitor();
-        nativeOut->StartMonitor();
-        nativeErr->StartMonitor();
+        this->synchronous = false;
+        ProcessReactor::GetInstance()->Watch(AutoPtr<PosixProcess>(this, true),
+            nativeIn, nativeOut, nativeErr);
     }
 
     BytesRef PosixProcess::MonitorSync()
@@ -166,11 +174,13 @@ namespace ti
         nativeOut->SetReadCallback(readCallback);
         nativeErr->SetReadCallback(readCallback);
 
-        nativeIn->StartMonitor();
-        nativeOut->StartMonitor();
-        nativeErr->StartMonitor();
+        this->synchronous = true;
+        ProcessReactor::GetInstance()->Watch(AutoPtr<PosixProcess>(this, true),
+            nativeIn, nativeOut, nativeErr);
+        this->finishedEvent.wait();
 
-        this->ExitMonitorSync();
+        if (!exitCallback.isNull())
+            RunOnMainThread(exitCallback, ValueList());
 
         // Unset the callbacks just in case these pipes are used again
         nativeOut->SetReadCallback(0);
@@ -184,6 +194,23 @@ namespace ti
         return output;
     }
 
+    void PosixProcess::Finished(int status)
+    {
+        this->exitCode = Value::NewInt(WEXITSTATUS(status));
+
+        if (synchronous)
+        {
+            this->finishedEvent.set();
+        }
+        else if (!exitCallback.isNull())
+        {
+            // The callback holds a reference to us until it has run, since
+            // the reactor lets go of this process as soon as we return.
+            ValueList args(Value::NewMethod(TiMethodRef(this, true)));
+            RunOnMainThread(exitCallback, args, false);
+        }
+    }
+
     int PosixProcess::Wait()
     {
         int status;
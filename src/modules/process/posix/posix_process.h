@@ -37,6 +37,7 @@
 
 #include <sstream>
 #include <Poco/Thread.h>
+#include <Poco/Event.h>
 #include "posix_pipe.h"
 #include "../process.h"
 
@@ -59,6 +60,7 @@ namespace ti
         virtual int Wait();
         virtual void RecreateNativePipes();
         virtual void SetArguments(TiListRef args);
+        void Finished(int status);
         void ReadCallback(const ValueList& args, ValueRef result);
         inline virtual AutoPtr<NativePipe> GetNativeStdin() { return nativeIn; }
         inline virtual AutoPtr<NativePipe> GetNativeStdout() { return nativeOut; }
@@ -71,6 +73,10 @@ namespace ti
         AutoPtr<PosixPipe> nativeOut;
         AutoPtr<PosixPipe> nativeErr;
 
+        // Set by the process reactor when a synchronous launch finishes.
+        bool synchronous;
+        Poco::Event finishedEvent;
+
         // For synchronous process execution store
         // process output as a vector of Bytes for speed.
         Poco::Mutex processOutputMutex;
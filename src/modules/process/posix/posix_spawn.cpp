@@ -0,0 +1,262 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "posix_spawn.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#if defined(OS_OSX)
+#include <spawn.h>
+#else
+#include <pthread.h>
+#include <sys/syscall.h>
+#ifndef __NR_close_range
+#define __NR_close_range 436
+#endif
+#endif
+
+// What execvp searches when the environment has no PATH.
+#define DEFAULT_SEARCH_PATH "/usr/bin:/bin"
+
+namespace ti
+{
+    static std::string GetSearchPath(const std::vector<std::string>& environment)
+    {
+        for (size_t i = 0; i < environment.size(); i++)
+        {
+            if (environment[i].compare(0, 5, "PATH=") == 0)
+                return environment[i].substr(5);
+        }
+        return DEFAULT_SEARCH_PATH;
+    }
+
+    // Every file execvp would try for this command, in the same order.
+    static void GetCandidates(const std::string& command,
+        const std::vector<std::string>& environment,
+        std::vector<std::string>& candidates)
+    {
+        if (command.empty() || command.find('/') != std::string::npos)
+        {
+            candidates.push_back(command);
+            return;
+        }
+
+        std::string path(GetSearchPath(environment));
+        size_t start = 0;
+        while (true)
+        {
+            size_t end = path.find(':', start);
+            std::string directory(path, start,
+                end == std::string::npos ? std::string::npos : end - start);
+            if (directory.empty())
+                directory = ".";
+            candidates.push_back(directory + "/" + command);
+
+            if (end == std::string::npos)
+                break;
+            start = end + 1;
+        }
+    }
+
+    static void GetPointers(const std::vector<std::string>& strings,
+        std::vector<char*>& pointers)
+    {
+        for (size_t i = 0; i < strings.size(); i++)
+            pointers.push_back(const_cast<char*>(strings[i].c_str()));
+        pointers.push_back(0);
+    }
+
+    // Whether execvp would move on to the next PATH entry after this error.
+    static bool TryNextCandidate(int error)
+    {
+        return error == ENOENT || error == ENOTDIR || error == EACCES;
+    }
+
+    int CreateSpawnPipe(int fds[2])
+    {
+#if defined(OS_OSX)
+        if (pipe(fds) != 0)
+            return -1;
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return 0;
+#else
+        return pipe2(fds, O_CLOEXEC);
+#endif
+    }
+
+#if defined(OS_OSX)
+    pid_t SpawnProcess(const std::vector<std::string>& args,
+        const std::vector<std::string>& environment, const int fds[3])
+    {
+        std::vector<std::string> candidates;
+        GetCandidates(args[0], environment, candidates);
+        std::vector<char*> argv, envp;
+        GetPointers(args, argv);
+        GetPointers(environment, envp);
+
+        // The dup2 actions run in order, so a source descriptor must not
+        // be one of the targets that an earlier action overwrites.
+        int sources[3];
+        int moved[3] = { -1, -1, -1 };
+        for (int i = 0; i < 3; i++)
+        {
+            sources[i] = fds[i];
+            if (fds[i] < 3 && fds[i] != i)
+                sources[i] = moved[i] = fcntl(fds[i], F_DUPFD, 3);
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        for (int i = 0; i < 3; i++)
+            posix_spawn_file_actions_adddup2(&actions, sources[i], i);
+
+        // Everything which isn't one of the three standard descriptors
+        // is closed in the child, whether or not it was close-on-exec.
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_CLOEXEC_DEFAULT);
+
+        pid_t pid = -1;
+        int error = ENOENT;
+        bool denied = false;
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            error = posix_spawn(&pid, candidates[i].c_str(), &actions,
+                &attributes, &argv[0], &envp[0]);
+            if (error == 0 || !TryNextCandidate(error))
+                break;
+            denied = denied || error == EACCES;
+        }
+
+        posix_spawnattr_destroy(&attributes);
+        posix_spawn_file_actions_destroy(&actions);
+        for (int i = 0; i < 3; i++)
+        {
+            if (moved[i] != -1)
+                close(moved[i]);
+        }
+
+        if (error != 0)
+        {
+            errno = (denied && error == ENOENT) ? EACCES : error;
+            return -1;
+        }
+        return pid;
+    }
+#else
+    pid_t SpawnProcess(const std::vector<std::string>& args,
+        const std::vector<std::string>& environment, const int fds[3])
+    {
+        // Everything the child touches is prepared here, because between
+        // vfork and exec it borrows our memory and must not allocate.
+        std::vector<std::string> candidates;
+        GetCandidates(args[0], environment, candidates);
+        std::vector<char*> paths, argv, envp;
+        GetPointers(candidates, paths);
+        GetPointers(args, argv);
+        GetPointers(environment, envp);
+
+        // Only used by kernels older than 5.9, which lack close_range.
+        int maxDescriptor = getdtablesize();
+
+        // Keep signals blocked until the child has dropped our handlers,
+        // so none of them can run on the borrowed stack.
+        sigset_t all, previous;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &previous);
+
+        pid_t pid = vfork();
+        if (pid == 0)
+        {
+            for (int signal = 1; signal < NSIG; signal++)
+            {
+                struct sigaction action;
+                if (sigaction(signal, 0, &action) != 0 ||
+                    action.sa_handler == SIG_IGN || action.sa_handler == SIG_DFL)
+                    continue;
+
+                action.sa_handler = SIG_DFL;
+                action.sa_flags = 0;
+                sigemptyset(&action.sa_mask);
+                sigaction(signal, &action, 0);
+            }
+
+            // Move sources out of the way of the targets before dup2, so
+            // that no dup2 overwrites a pipe which is still to be copied.
+            int sources[3];
+            for (int i = 0; i < 3; i++)
+            {
+                sources[i] = fds[i];
+                if (fds[i] < 3 && fds[i] != i)
+                    sources[i] = fcntl(fds[i], F_DUPFD, 3);
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                // dup2 onto itself would leave close-on-exec set.
+                if (sources[i] == i)
+                    fcntl(i, F_SETFD, 0);
+                else
+                    dup2(sources[i], i);
+            }
+
+            if (syscall(__NR_close_range, 3U, ~0U, 0U) != 0)
+            {
+                for (int fd = 3; fd < maxDescriptor; fd++)
+                    close(fd);
+            }
+
+            pthread_sigmask(SIG_SETMASK, &previous, 0);
+            for (size_t i = 0; paths[i]; i++)
+            {
+                execve(paths[i], &argv[0], &envp[0]);
+                if (!TryNextCandidate(errno))
+                    break;
+            }
+            _exit(72);
+        }
+
+        int error = errno;
+        pthread_sigmask(SIG_SETMASK, &previous, 0);
+        if (pid < 0)
+        {
+            errno = error;
+            return -1;
+        }
+        return pid;
+    }
+#endif
+}
@@ -32,65 +32,39 @@
 * limitations under the License.
 **/
 
-#include "../tide.h"
-#include <cstdio>
-#include <cstring>
+#ifndef _POSIX_SPAWN_H_
+#define _POSIX_SPAWN_H_
 
-namespace tide
-{
-    ProfiledBoundList::ProfiledBoundList(TiListRef delegate) :
-        ProfiledBoundObject(delegate),
-        list(delegate),
-        count(1)
-    {
-    }
-
-    ProfiledBoundList::~ProfiledBoundList()
-    {
-    }
-
-    void ProfiledBoundList::Append(ValueRef value)
-    {
-        list->Append(value);
-    }
-
-    unsigned int ProfiledBoundList::Size()
-    {
-        return list->Size();
-    }
-
-    ValueRef ProfiledBoundList::At(unsigned int index)
-    {
-        return list->At(index);
-    }
-
-    void ProfiledBoundList::SetAt(unsigned int index, ValueRef value)
-    {
-        list->SetAt(index,value);
-    }
+#include <string>
+#include <vector>
+#include <sys/types.h>
 
-    bool ProfiledBoundList::Remove(unsigned int index)
-    {
-        return list->Remove(index);
-    }
-
-    void ProfiledBoundList::Set(const char *name, ValueRef value)
-    {
-        list->Set(name, value);
-    }
-
-    ValueRef ProfiledBoundList::Get(const char *name)
-    {
-        return list->Get(name);
-    }
-
-    SharedStringList ProfiledBoundList::GetPropertyNames()
-    {
-        return list->GetPropertyNames();
-    }
+namespace ti
+{
+    /**
+     * Start args[0] as a child process with the given "NAME=value"
+     * environment, looking it up on that environment's PATH the way
+     * execvp does. The child gets fds[0], fds[1] and fds[2] as its stdin,
+     * stdout and stderr and no other descriptors.
+     *
+     * Linux uses vfork and close_range, so the cost does not grow with
+     * the size of our address space or descriptor table. OS X uses
+     * posix_spawn with POSIX_SPAWN_CLOEXEC_DEFAULT. If the program cannot
+     * be executed the Linux child exits with status 72, while OS X fails
+     * the spawn itself.
+     *
+     * This depends only on libc, so it is usable outside of a Host.
+     * @return the pid of the child, or -1 with errno set
+     */
+    pid_t SpawnProcess(const std::vector<std::string>& args,
+        const std::vector<std::string>& environment, const int fds[3]);
 
-    bool ProfiledBoundList::HasProperty(const char* name)
-    {
-        return list->HasProperty(name);
-    }
+    /**
+     * Create a pipe whose descriptors are closed on exec, so that spawning
+     * another child from a different thread can never inherit them.
+     * @return 0, or -1 with errno set
+     */
+    int CreateSpawnPipe(int fds[2]);
 }
+
+#endif
@@ -0,0 +1,586 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "process_reactor.h"
+#include "posix_pipe.h"
+#include "posix_process.h"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#if defined(OS_LINUX)
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+#endif
+
+// Output is read in chunks of this size, and at most this many chunks
+// are taken from one pipe before the other pipes get their turn.
+#define READ_BUFFER_SIZE 65536
+#define READS_PER_WAKEUP 4
+
+// How often exits are polled for a child which we couldn't get a pidfd for.
+#define EXIT_POLL_MILLISECONDS 100
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        return Logger::Get("Process.Reactor");
+    }
+
+    // Used when pidfds are not available. The handler only records that
+    // some child changed state and wakes the loop, which then checks the
+    // processes it is watching. Other handlers still see the signal.
+    static volatile sig_atomic_t childSignalled = 0;
+    static int childSignalFd = -1;
+    static struct sigaction previousChildAction;
+
+    static void OnChildSignal(int signal, siginfo_t* info, void* context)
+    {
+        int savedErrno = errno;
+        childSignalled = 1;
+        char byte = 0;
+        ssize_t written = write(childSignalFd, &byte, 1);
+        (void) written;
+
+        if (previousChildAction.sa_flags & SA_SIGINFO)
+        {
+            if (previousChildAction.sa_sigaction)
+                previousChildAction.sa_sigaction(signal, info, context);
+        }
+        else if (previousChildAction.sa_handler != SIG_DFL &&
+            previousChildAction.sa_handler != SIG_IGN)
+        {
+            previousChildAction.sa_handler(signal);
+        }
+        errno = savedErrno;
+    }
+
+    static void SetNonBlocking(int fd)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    ProcessReactor* ProcessReactor::instance = 0;
+
+    static Poco::FastMutex& InstanceMutex()
+    {
+        static Poco::FastMutex mutex;
+        return mutex;
+    }
+
+    /*static*/
+    ProcessReactor* ProcessReactor::GetInstance()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        if (!instance)
+            instance = new ProcessReactor();
+        return instance;
+    }
+
+    /*static*/
+    void ProcessReactor::Shutdown()
+    {
+        Poco::FastMutex::ScopedLock lock(InstanceMutex());
+        delete instance;
+        instance = 0;
+    }
+
+    ProcessReactor::ProcessReactor() :
+        buffer(READ_BUFFER_SIZE),
+        running(true),
+        usePidFds(false),
+        pollingCount(0)
+    {
+        if (pipe(wakeFds) != 0)
+            throw ValueException::FromString("Could not create process reactor wake pipe");
+        for (int i = 0; i < 2; i++)
+        {
+            fcntl(wakeFds[i], F_SETFD, FD_CLOEXEC);
+            SetNonBlocking(wakeFds[i]);
+        }
+
+#if defined(OS_LINUX)
+        epollFd = epoll_create(64);
+        if (epollFd < 0)
+            throw ValueException::FromString("Could not create process reactor epoll instance");
+        fcntl(epollFd, F_SETFD, FD_CLOEXEC);
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = wakeFds[0];
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFds[0], &event);
+
+        // pidfds arrived in Linux 5.3.
+        int pidFd = syscall(__NR_pidfd_open, getpid(), 0);
+        if (pidFd >= 0)
+        {
+            close(pidFd);
+            usePidFds = true;
+        }
+#endif
+
+        if (!usePidFds)
+        {
+            childSignalFd = wakeFds[1];
+            struct sigaction action;
+            action.sa_sigaction = &OnChildSignal;
+            action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGCHLD, &action, &previousChildAction);
+        }
+
+        thread.setName("Process Reactor");
+        thread.start(*this);
+    }
+
+    ProcessReactor::~ProcessReactor()
+    {
+        running = false;
+        this->Wake();
+        thread.join();
+
+        if (!usePidFds)
+        {
+            sigaction(SIGCHLD, &previousChildAction, 0);
+            childSignalFd = -1;
+        }
+
+        // Processes which are still running are simply let go.
+        for (size_t i = 0; i < starting.size(); i++)
+            delete starting[i];
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (children[i]->pidFd != -1)
+                close(children[i]->pidFd);
+            delete children[i];
+        }
+
+#if defined(OS_LINUX)
+        close(epollFd);
+#endif
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+    }
+
+    void ProcessReactor::Watch(AutoPtr<PosixProcess> process,
+        AutoPtr<PosixPipe> in, AutoPtr<PosixPipe> out, AutoPtr<PosixPipe> err)
+    {
+        Child* child = new Child();
+        child->process = process;
+        child->in = in;
+        child->out = out;
+        child->err = err;
+        child->pidFd = -1;
+        child->exited = false;
+        child->status = 0;
+
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            starting.push_back(child);
+        }
+        this->Wake();
+    }
+
+    void ProcessReactor::WriteQueued(AutoPtr<PosixPipe> pipe)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            writers.push_back(pipe);
+        }
+        this->Wake();
+    }
+
+    void ProcessReactor::Wake()
+    {
+        char byte = 0;
+        // A full pipe already guarantees a wakeup, so errors are fine here.
+        ssize_t written = write(wakeFds[1], &byte, 1);
+        (void) written;
+    }
+
+    void ProcessReactor::Add(int fd, Child* child, Role role, bool watching)
+    {
+        Registration& registration = registrations[fd];
+        registration.child = child;
+        registration.role = role;
+        registration.watching = false;
+        this->SetWatching(fd, watching);
+    }
+
+    void ProcessReactor::SetWatching(int fd, bool watching)
+    {
+        // A descriptor which isn't wanted is left out of the set entirely,
+        // because errors and hangups are reported even with no events
+        // requested and would otherwise wake us in a loop.
+        RegistrationMap::iterator i = registrations.find(fd);
+        if (i == registrations.end() || i->second.watching == watching)
+            return;
+        i->second.watching = watching;
+
+#if defined(OS_LINUX)
+        struct epoll_event event;
+        event.events = i->second.role == STDIN ? EPOLLOUT : EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, watching ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &event);
+#endif
+    }
+
+    void ProcessReactor::Remove(int fd)
+    {
+        this->SetWatching(fd, false);
+        registrations.erase(fd);
+    }
+
+    void ProcessReactor::Wait(std::vector<int>& ready)
+    {
+#if defined(OS_LINUX)
+        struct epoll_event events[64];
+        int timeoutMillis = pollingCount > 0 ? EXIT_POLL_MILLISECONDS : -1;
+        int count = epoll_wait(epollFd, events, 64, timeoutMillis);
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.fd == wakeFds[0])
+            {
+                char bytes[64];
+                while (read(wakeFds[0], bytes, sizeof(bytes)) > 0) {}
+                continue;
+            }
+            ready.push_back(events[i].data.fd);
+        }
+#else
+        std::vector<struct pollfd> fds;
+        struct pollfd wakeFd;
+        wakeFd.fd = wakeFds[0];
+        wakeFd.events = POLLIN;
+        wakeFd.revents = 0;
+        fds.push_back(wakeFd);
+
+        RegistrationMap::iterator i = registrations.begin();
+        for (; i != registrations.end(); i++)
+        {
+            if (!i->second.watching)
+                continue;
+
+            struct pollfd fd;
+            fd.fd = i->first;
+            fd.events = i->second.role == STDIN ? POLLOUT : POLLIN;
+            fd.revents = 0;
+            fds.push_back(fd);
+        }
+
+        int timeoutMillis = pollingCount > 0 ? EXIT_POLL_MILLISECONDS : -1;
+        int count = poll(&fds[0], fds.size(), timeoutMillis);
+        for (size_t i = 0; count > 0 && i < fds.size(); i++)
+        {
+            if (!fds[i].revents)
+                continue;
+
+            if (fds[i].fd == wakeFds[0])
+            {
+                char bytes[64];
+                while (read(wakeFds[0], bytes, sizeof(bytes)) > 0) {}
+                continue;
+            }
+            ready.push_back(fds[i].fd);
+        }
+#endif
+    }
+
+    void ProcessReactor::Start(Child* child)
+    {
+        children.push_back(child);
+        int in = child->in->GetWriteHandle();
+        int out = child->out->GetReadHandle();
+        int err = child->err->GetReadHandle();
+
+        SetNonBlocking(in);
+        SetNonBlocking(out);
+        SetNonBlocking(err);
+        this->Add(in, child, STDIN, false);
+        this->Add(out, child, STDOUT, true);
+        this->Add(err, child, STDERR, true);
+
+#if defined(OS_LINUX)
+        if (usePidFds)
+        {
+            child->pidFd = syscall(__NR_pidfd_open, child->process->GetPID(), 0);
+            if (child->pidFd >= 0)
+            {
+                fcntl(child->pidFd, F_SETFD, FD_CLOEXEC);
+                this->Add(child->pidFd, child, EXIT, true);
+            }
+            else
+            {
+                GetLogger()->Warn("Could not watch process %d for its exit: %s",
+                    child->process->GetPID(), strerror(errno));
+                pollingCount++;
+            }
+        }
+#endif
+
+        // Anything written before the launch is waiting in the queue.
+        this->Flush(child);
+    }
+
+    void ProcessReactor::Dispatch(int fd)
+    {
+        RegistrationMap::iterator i = registrations.find(fd);
+        if (i == registrations.end())
+            return;
+
+        Child* child = i->second.child;
+        switch (i->second.role)
+        {
+            case STDIN:
+                this->Flush(child);
+                break;
+            case STDOUT:
+                this->Read(child, child->out.get());
+                break;
+            case STDERR:
+                this->Read(child, child->err.get());
+                break;
+            case EXIT:
+                this->CheckExit(child);
+                break;
+        }
+        this->FinishIfDone(child);
+    }
+
+    void ProcessReactor::Read(Child* child, PosixPipe* pipe)
+    {
+        int fd = pipe->GetReadHandle();
+        for (int reads = 0; reads < READS_PER_WAKEUP; reads++)
+        {
+            ssize_t count;
+            do
+            {
+                count = read(fd, &buffer[0], buffer.size());
+            }
+            while (count < 0 && errno == EINTR);
+
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+
+            if (count <= 0)
+            {
+                this->Remove(fd);
+                pipe->CloseNativeRead();
+                return;
+            }
+
+            try
+            {
+                pipe->Write(new Bytes(&buffer[0], count));
+            }
+            catch (ValueException& e)
+            {
+                GetLogger()->Error("Exception while reading from process: %s",
+                    e.ToString().c_str());
+            }
+            catch (Poco::Exception& e)
+            {
+                GetLogger()->Error("Exception while reading from process: %s",
+                    e.displayText().c_str());
+            }
+
+            if ((size_t) count < buffer.size())
+                return;
+        }
+    }
+
+    void ProcessReactor::Flush(Child* child)
+    {
+        PosixPipe* pipe = child->in.get();
+        int fd = pipe->GetWriteHandle();
+        if (fd == -1)
+            return;
+
+        bool pending = pipe->FlushWrites();
+        if (!pending && pipe->IsClosed())
+        {
+            this->Remove(fd);
+            pipe->CloseNativeWrite();
+            return;
+        }
+        this->SetWatching(fd, pending);
+    }
+
+    void ProcessReactor::CheckExit(Child* child)
+    {
+        if (child->exited)
+            return;
+
+        int status = 0;
+        pid_t pid = child->process->GetPID();
+        pid_t result;
+        do
+        {
+            result = waitpid(pid, &status, WNOHANG);
+        }
+        while (result < 0 && errno == EINTR);
+
+        // Zero means the process is still running. Anything else but our
+        // pid means that something else has already collected it, and
+        // the exit status is lost.
+        if (result == 0)
+            return;
+        if (result != pid)
+        {
+            GetLogger()->Warn("Could not get the exit status of process %d", pid);
+            status = 0;
+        }
+
+        child->exited = true;
+        child->status = status;
+        if (child->pidFd != -1)
+        {
+            this->Remove(child->pidFd);
+            close(child->pidFd);
+            child->pidFd = -1;
+        }
+        else if (usePidFds)
+        {
+            pollingCount--;
+        }
+    }
+
+    void ProcessReactor::ReapChildren()
+    {
+        for (size_t i = 0; i < children.size(); )
+        {
+            // Finishing a child removes it from the list.
+            this->CheckExit(children[i]);
+            if (!this->FinishIfDone(children[i]))
+                i++;
+        }
+    }
+
+    bool ProcessReactor::FinishIfDone(Child* child)
+    {
+        if (!child->exited || child->out->GetReadHandle() != -1 ||
+            child->err->GetReadHandle() != -1)
+            return false;
+
+        // Nobody is left to read whatever is still queued for stdin.
+        int in = child->in->GetWriteHandle();
+        if (in != -1)
+        {
+            this->Remove(in);
+            child->in->DiscardWrites();
+            child->in->CloseNativeWrite();
+        }
+
+        std::vector<Child*>::iterator i =
+            std::find(children.begin(), children.end(), child);
+        if (i != children.end())
+            children.erase(i);
+
+        try
+        {
+            child->process->Finished(child->status);
+        }
+        catch (ValueException& e)
+        {
+            GetLogger()->Error("Exception while finishing process: %s",
+                e.ToString().c_str());
+        }
+        delete child;
+        return true;
+    }
+
+    void ProcessReactor::run()
+    {
+        // Writing to a child which has stopped reading should fail with
+        // EPIPE here rather than raise SIGPIPE for the whole application.
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &signals, 0);
+
+        std::vector<int> ready;
+        while (running)
+        {
+            ready.clear();
+            this->Wait(ready);
+
+            std::vector<Child*> newChildren;
+            std::vector<AutoPtr<PosixPipe> > newWriters;
+            {
+                Poco::FastMutex::ScopedLock lock(mutex);
+                newChildren.swap(starting);
+                newWriters.swap(writers);
+            }
+
+            for (size_t i = 0; running && i < newChildren.size(); i++)
+                this->Start(newChildren[i]);
+
+            for (size_t i = 0; running && i < newWriters.size(); i++)
+            {
+                int fd = newWriters[i]->GetWriteHandle();
+                RegistrationMap::iterator r = registrations.find(fd);
+                if (fd != -1 && r != registrations.end() &&
+                    r->second.child->in.get() == newWriters[i].get())
+                {
+                    Child* child = r->second.child;
+                    this->Flush(child);
+                    this->FinishIfDone(child);
+                }
+            }
+
+            for (size_t i = 0; running && i < ready.size(); i++)
+                this->Dispatch(ready[i]);
+
+            // A child may have exited before we started watching it, so
+            // without pidfds new children are always checked once.
+            bool reap = usePidFds ? pollingCount > 0 :
+                (childSignalled || !newChildren.empty());
+            if (running && reap)
+            {
+                childSignalled = 0;
+                this->ReapChildren();
+            }
+        }
+    }
+}
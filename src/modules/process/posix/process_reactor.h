@@ -0,0 +1,142 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _PROCESS_REACTOR_H_
+#define _PROCESS_REACTOR_H_
+
+#include <tide/tide.h>
+#include <map>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+
+namespace ti
+{
+    class PosixPipe;
+    class PosixProcess;
+
+    /**
+     * A single thread which looks after every running child process.
+     * Instead of a reader thread per output pipe, a writer thread per
+     * stdin and a thread blocked in waitpid for every process, all pipes
+     * and exit notifications are multiplexed with epoll (Linux) or poll
+     * (OS X).
+     *
+     * Exits are noticed through a pidfd where the kernel supports them and
+     * through a SIGCHLD handler otherwise. A process is finished once it
+     * has exited and both of its output pipes have reached end of file, so
+     * every read is delivered before the exit. The reactor keeps a process
+     * alive while it watches it and never waits for the main thread.
+     */
+    class ProcessReactor : public Poco::Runnable
+    {
+    public:
+        static ProcessReactor* GetInstance();
+        static void Shutdown();
+
+        void Watch(AutoPtr<PosixProcess> process, AutoPtr<PosixPipe> in,
+            AutoPtr<PosixPipe> out, AutoPtr<PosixPipe> err);
+        void WriteQueued(AutoPtr<PosixPipe> pipe);
+        void run();
+
+    private:
+        enum Role
+        {
+            STDIN,
+            STDOUT,
+            STDERR,
+            EXIT
+        };
+
+        struct Child
+        {
+            AutoPtr<PosixProcess> process;
+            AutoPtr<PosixPipe> in;
+            AutoPtr<PosixPipe> out;
+            AutoPtr<PosixPipe> err;
+            int pidFd;
+            bool exited;
+            int status;
+        };
+
+        struct Registration
+        {
+            Child* child;
+            Role role;
+            bool watching;
+        };
+
+        typedef std::map<int, Registration> RegistrationMap;
+
+        ProcessReactor();
+        ~ProcessReactor();
+        void Wake();
+        void Wait(std::vector<int>& ready);
+        void Add(int fd, Child* child, Role role, bool watching);
+        void SetWatching(int fd, bool watching);
+        void Remove(int fd);
+        void Start(Child* child);
+        void Dispatch(int fd);
+        void Read(Child* child, PosixPipe* pipe);
+        void Flush(Child* child);
+        void CheckExit(Child* child);
+        void ReapChildren();
+        bool FinishIfDone(Child* child);
+
+        // Guards the hand-off lists below; everything else is only
+        // touched by the loop thread.
+        Poco::FastMutex mutex;
+        std::vector<Child*> starting;
+        std::vector<AutoPtr<PosixPipe> > writers;
+
+        RegistrationMap registrations;
+        std::vector<Child*> children;
+        std::vector<char> buffer;
+        Poco::Thread thread;
+        volatile bool running;
+        bool usePidFds;
+        size_t pollingCount;
+        int wakeFds[2];
+#if defined(OS_LINUX)
+        int epollFd;
+#endif
+
+        static ProcessReactor* instance;
+
+        DISALLOW_EVIL_CONSTRUCTORS(ProcessReactor);
+    };
+}
+
+#endif
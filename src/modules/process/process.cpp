@@ -279,11 +279,11 @@ namespace ti
 
         this->AttachPipes(true);
         ForkAndExec();
-        MonitorAsync();
 
+        // The monitor may see the process exit before MonitorAsync returns.
         this->exitCallback = StaticBoundMethod::FromMethod<Process>(
             this, &Process::ExitCallback);
-        this->exitMonitorThread.start(*exitMonitorAdapter);
+        MonitorAsync();
     }
 
     BytesRef Process::LaunchSync()
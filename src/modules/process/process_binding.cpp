@@ -35,8 +35,10 @@
 #include <tide/tide.h>
 #include <Poco/Environment.h>
 #include <Poco/Process.h>
+#include <tideutils/platform_utils.h>
 #include "process_binding.h"
 #include "process.h"
+#include "process_pool.h"
 #include <signal.h>
 
 namespace ti
@@ -65,6 +67,26 @@ namespace ti
          */
         SetMethod("createPipe", &ProcessBinding::CreatePipe);
 
+        /**
+         * @tiapi(method=True,name=Process.createPool,since=1.3.2)
+         * @tiapi Create a pool of long-running helper processes which answer
+         * @tiapi requests over stdin and stdout, for commands which would
+         * @tiapi otherwise be launched over and over. For example:
+         * @tiapi  var pool = Ti.Process.createPool(['myhelper', '--serve'],
+         * @tiapi     {size: 4, idleTimeout: 30000, framing: 'line'});
+         * @tiapi  pool.request('input', function(response) { ... });
+         * @tiarg[Array<String>|Object, command] The command to run, or an
+         * @tiarg object with 'args' and optionally 'env', as for createProcess.
+         * @tiarg[Object, options, optional] 'size' is the number of processes
+         * @tiarg (default: the number of processors), 'idleTimeout' is how many
+         * @tiarg milliseconds an unused process is kept (default: forever) and
+         * @tiarg 'framing' is either 'line' (default), for newline-terminated
+         * @tiarg requests and responses, or 'length', for ones prefixed with
+         * @tiarg their length as a 4-byte big-endian number.
+         * @tiresult[Process.ProcessPool] The new pool, with its processes started
+         */
+        SetMethod("createPool", &ProcessBinding::CreatePool);
+
 #if defined(OS_OSX) || (OS_LINUX)
         /**
          * @tiapi(property=True,name=Process.SIGHUP,since=0.5,platforms=osx|linux)
@@ -335,4 +357,56 @@ namespace ti
     {
         result->SetObject(new Pipe());
     }
+
+    void ProcessBinding::CreatePool(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("createPool", "o|l ?o");
+
+        TiListRef argList = 0;
+        TiObjectRef environment = 0;
+        if (args.at(0)->IsList())
+        {
+            argList = args.at(0)->ToList();
+        }
+        else
+        {
+            TiObjectRef command = args.GetObject(0);
+            argList = command->GetList("args", 0);
+            environment = command->GetObject("env", 0);
+        }
+
+        if (argList.isNull() || argList->Size() == 0)
+        {
+            throw ValueException::FromString(
+                "Ti.Process.createPool command must have at least 1 element");
+        }
+
+        TiObjectRef options = args.GetObject(1, new StaticBoundObject());
+        int size = options->GetInt("size", PlatformUtils::GetProcessorCount());
+        long idleTimeout = (long) options->GetNumber("idleTimeout", 0);
+        std::string framing = options->GetString("framing", "line");
+
+        if (size < 1)
+            throw ValueException::FromString("Process pool size must be at least 1");
+        if (framing != "line" && framing != "length")
+            throw ValueException::FromFormat("Unknown process pool framing: %s",
+                framing.c_str());
+
+        TiListRef argsClone = new StaticBoundList();
+        ExtendArgs(argsClone, argList);
+
+        AutoPtr<ProcessPool> pool(new ProcessPool(argsClone, environment,
+            size, idleTimeout, framing == "line" ?
+                ProcessPool::LINES : ProcessPool::LENGTH_PREFIXED));
+        try
+        {
+            pool->Start();
+        }
+        catch (ValueException&)
+        {
+            pool->Close();
+            throw;
+        }
+        result->SetObject(pool);
+    }
 }
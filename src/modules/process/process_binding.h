@@ -52,6 +52,7 @@ namespace ti
     private:
         void CreateProcess(const ValueList& args, ValueRef result);
         void CreatePipe(const ValueList& args, ValueRef result);
+        void CreatePool(const ValueList& args, ValueRef result);
         void GetCurrentProcess(const ValueList& args, ValueRef result);
         void ExtendArgs(TiListRef dest, TiListRef args);
     };
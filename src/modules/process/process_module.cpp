@@ -35,6 +35,9 @@
 #include <tide/tide.h>
 #include "process_module.h"
 #include "process_binding.h"
+#if !defined(OS_WIN32)
+#include "posix/process_reactor.h"
+#endif
 
 using namespace tide;
 using namespace ti;
@@ -61,6 +64,9 @@ namespace ti
 
     void ProcessModule::Stop()
     {
+#if !defined(OS_WIN32)
+        ProcessReactor::Shutdown();
+#endif
     }
     
 }
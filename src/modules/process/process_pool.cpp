@@ -0,0 +1,517 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#include "process_pool.h"
+
+namespace ti
+{
+    static Logger* GetLogger()
+    {
+        return Logger::Get("Process.ProcessPool");
+    }
+
+    /**
+     * One helper process. The worker is attached to the process' stdout,
+     * so everything the helper prints arrives in _Write on the thread which
+     * reads the pipe, where it is split into responses.
+     */
+    class ProcessPool::Worker : public StaticBoundObject
+    {
+    public:
+        Worker(ProcessPool* pool, AutoProcess process) :
+            StaticBoundObject("Process.ProcessPool.Worker"),
+            link(pool->link),
+            framing(pool->framing),
+            process(process),
+            busy(false),
+            responses(0),
+            bufferStart(0)
+        {
+            this->SetMethod("write", &Worker::_Write);
+            this->SetMethod("close", &Worker::_Close);
+        }
+
+        void _Write(const ValueList& args, ValueRef result)
+        {
+            BytesRef bytes(args.GetObject(0).cast<Bytes>());
+            if (bytes.isNull())
+                return;
+
+            Poco::Mutex::ScopedLock lock(link->mutex);
+            ProcessPool* pool = link->pool;
+            if (!pool)
+                return;
+
+            buffer.append(bytes->Pointer(), bytes->Length());
+            BytesRef response(this->NextResponse());
+            while (!response.isNull())
+            {
+                pool->OnResponse(this, response);
+                response = this->NextResponse();
+            }
+
+            // Drop what has been consumed once it makes up most of the buffer.
+            if (bufferStart > buffer.size() / 2)
+            {
+                buffer.erase(0, bufferStart);
+                bufferStart = 0;
+            }
+        }
+
+        void _Close(const ValueList& args, ValueRef result)
+        {
+        }
+
+        void _OnExit(const ValueList& args, ValueRef result)
+        {
+            // The pool and the process' stdout let go of this worker,
+            // which may be the last references to it.
+            AutoPtr<Worker> self(this, true);
+            process->GetStdout()->Detach(this);
+
+            Poco::Mutex::ScopedLock lock(link->mutex);
+            if (link->pool)
+                link->pool->OnExit(this);
+        }
+
+        BytesRef NextResponse()
+        {
+            size_t available = buffer.size() - bufferStart;
+            const char* data = buffer.data() + bufferStart;
+
+            if (framing == LINES)
+            {
+                const char* end = (const char*) memchr(data, '\n', available);
+                if (!end)
+                    return 0;
+
+                size_t length = end - data;
+                bufferStart += length + 1;
+                if (length > 0 && data[length - 1] == '\r')
+                    length--;
+                return new Bytes(data, length);
+            }
+
+            if (available < 4)
+                return 0;
+
+            const unsigned char* header = (const unsigned char*) data;
+            size_t length = ((size_t) header[0] << 24) | ((size_t) header[1] << 16) |
+                ((size_t) header[2] << 8) | (size_t) header[3];
+            if (available - 4 < length)
+                return 0;
+
+            bufferStart += 4 + length;
+            return new Bytes(data + 4, length);
+        }
+
+        Poco::SharedPtr<Link> link;
+        Framing framing;
+        AutoProcess process;
+        Request current;
+        bool busy;
+        int responses;
+        Poco::Timestamp lastUsed;
+        std::string buffer;
+        size_t bufferStart;
+    };
+
+    ProcessPool::ProcessPool(TiListRef args, TiObjectRef environment,
+        size_t size, long idleTimeout, Framing framing) :
+        StaticBoundObject("Process.ProcessPool"),
+        link(new Link(this)),
+        args(args),
+        environment(environment),
+        size(size),
+        idleTimeout(idleTimeout),
+        framing(framing),
+        closed(false),
+        idleTimer(0),
+        restarts(0),
+        completed(0),
+        failed(0)
+    {
+        /**
+         * @tiapi(method=True,name=Process.ProcessPool.request,since=1.3.2)
+         * @tiapi Send a request to the next free process in the pool.
+         * @tiarg[String|Bytes, data] The request. In line mode a newline is
+         * @tiarg added if the request doesn't end with one.
+         * @tiarg[Function, onResponse] Called with a Bytes holding the
+         * @tiarg response, without its newline or length.
+         * @tiarg[Function, onError, optional] Called with a message if the
+         * @tiarg process exits before responding or the pool is closed.
+         */
+        SetMethod("request", &ProcessPool::_Request);
+
+        /**
+         * @tiapi(method=True,name=Process.ProcessPool.getStats,since=1.3.2)
+         * @tiresult[Object] An object with the pool's size, and how many
+         * @tiresult processes are running, busy and idle, how many requests
+         * @tiresult are queued, completed and failed, and how many processes
+         * @tiresult exited unexpectedly and had to be restarted.
+         */
+        SetMethod("getStats", &ProcessPool::_GetStats);
+
+        /**
+         * @tiapi(method=True,name=Process.ProcessPool.close,since=1.3.2)
+         * @tiapi Stop every process in the pool. Requests which have not
+         * @tiapi been answered fail.
+         */
+        SetMethod("close", &ProcessPool::_Close);
+    }
+
+    ProcessPool::~ProcessPool()
+    {
+        // Waits for a worker which is calling into the pool to finish.
+        {
+            Poco::Mutex::ScopedLock lock(link->mutex);
+            link->pool = 0;
+        }
+
+        // The workers can't report their processes' exits to us any more,
+        // so the requests they are running fail now.
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            for (size_t i = 0; i < workers.size(); i++)
+            {
+                if (!workers[i]->busy)
+                    continue;
+
+                this->Fail(workers[i]->current, "The process pool was closed");
+                workers[i]->current = Request();
+                workers[i]->busy = false;
+            }
+        }
+
+        this->Close();
+        delete idleTimer;
+    }
+
+    void ProcessPool::Start()
+    {
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            while (workers.size() < size)
+                workers.push_back(this->StartWorker());
+        }
+
+        if (idleTimeout > 0)
+        {
+            idleTimer = new Poco::Timer(idleTimeout, idleTimeout);
+            idleTimer->start(Poco::TimerCallback<ProcessPool>(
+                *this, &ProcessPool::OnIdleTimer));
+        }
+    }
+
+    AutoPtr<ProcessPool::Worker> ProcessPool::StartWorker()
+    {
+        AutoProcess process(Process::CreateProcess());
+        process->SetArguments(args);
+        if (!environment.isNull())
+            process->SetEnvironment(environment);
+
+        AutoPtr<Worker> worker(new Worker(this, process));
+        process->GetStdout()->Attach(worker);
+        process->AddEventListener(Event::EXIT,
+            StaticBoundMethod::FromMethod<Worker>(worker.get(), &Worker::_OnExit));
+
+        try
+        {
+            process->LaunchAsync();
+        }
+        catch (...)
+        {
+            process->GetStdout()->Detach(worker);
+            throw;
+        }
+        return worker;
+    }
+
+    void ProcessPool::Dispatch()
+    {
+        while (!closed && !queue.empty())
+        {
+            AutoPtr<Worker> worker(0);
+            for (size_t i = 0; i < workers.size(); i++)
+            {
+                if (!workers[i]->busy && (worker.isNull() ||
+                    workers[i]->lastUsed > worker->lastUsed))
+                    worker = workers[i];
+            }
+
+            if (worker.isNull())
+            {
+                if (workers.size() >= size)
+                    return;
+
+                try
+                {
+                    worker = this->StartWorker();
+                    workers.push_back(worker);
+                }
+                catch (ValueException& e)
+                {
+                    this->Fail(queue.front(), e.ToString());
+                    queue.pop_front();
+                    continue;
+                }
+            }
+
+            Request request(queue.front());
+            queue.pop_front();
+            this->Send(worker, request);
+        }
+    }
+
+    void ProcessPool::Send(AutoPtr<Worker> worker, Request& request)
+    {
+        worker->busy = true;
+        worker->current = request;
+        worker->lastUsed.update();
+
+        std::vector<BytesRef> frame;
+        if (framing == LINES)
+        {
+            frame.push_back(request.data);
+            int length = request.data->Length();
+            if (length == 0 || request.data->Pointer()[length - 1] != '\n')
+                frame.push_back(new Bytes("\n", 1));
+        }
+        else
+        {
+            size_t length = request.data->Length();
+            char header[4];
+            header[0] = (char) (length >> 24);
+            header[1] = (char) (length >> 16);
+            header[2] = (char) (length >> 8);
+            header[3] = (char) length;
+            frame.push_back(new Bytes(header, 4));
+            frame.push_back(request.data);
+        }
+        worker->process->GetStdin()->Write(Bytes::Concat(frame));
+    }
+
+    void ProcessPool::Fail(Request& request, const std::string& message)
+    {
+        failed++;
+        if (!request.onError.isNull())
+            RunOnMainThread(request.onError, ValueList(Value::NewString(message)), false);
+        else
+            GetLogger()->Error("Request failed: %s", message.c_str());
+    }
+
+    void ProcessPool::OnResponse(Worker* worker, BytesRef response)
+    {
+        Request request;
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            if (!worker->busy)
+            {
+                GetLogger()->Warn("Ignoring output which process %d sent "
+                    "without a request", worker->process->GetPID());
+                return;
+            }
+
+            request = worker->current;
+            worker->current = Request();
+            worker->busy = false;
+            worker->responses++;
+            worker->lastUsed.update();
+            completed++;
+            this->Dispatch();
+        }
+
+        if (!request.onResponse.isNull())
+        {
+            RunOnMainThread(request.onResponse,
+                ValueList(Value::NewObject(response)), false);
+        }
+    }
+
+    void ProcessPool::OnExit(Worker* worker)
+    {
+        Poco::Mutex::ScopedLock lock(mutex);
+        if (worker->busy)
+        {
+            this->Fail(worker->current,
+                "The pool process exited before responding");
+            worker->current = Request();
+            worker->busy = false;
+        }
+
+        // Workers which were stopped have already been removed.
+        std::vector<AutoPtr<Worker> >::iterator i = workers.begin();
+        while (i != workers.end() && i->get() != worker)
+            i++;
+        if (i == workers.end() || closed)
+            return;
+
+        workers.erase(i);
+        restarts++;
+
+        // Only replace a helper right away if it has worked before, so
+        // that a command which can never start doesn't restart forever.
+        if (worker->responses > 0 && queue.empty())
+        {
+            try
+            {
+                workers.push_back(this->StartWorker());
+            }
+            catch (ValueException& e)
+            {
+                GetLogger()->Error("Could not restart pool process: %s",
+                    e.ToString().c_str());
+            }
+        }
+        this->Dispatch();
+    }
+
+    void ProcessPool::OnIdleTimer(Poco::Timer& timer)
+    {
+        std::vector<AutoPtr<Worker> > idle;
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            std::vector<AutoPtr<Worker> >::iterator i = workers.begin();
+            while (i != workers.end())
+            {
+                if (!(*i)->busy && (*i)->lastUsed.isElapsed(
+                    (Poco::Timestamp::TimeDiff) idleTimeout * 1000))
+                {
+                    idle.push_back(*i);
+                    i = workers.erase(i);
+                }
+                else
+                {
+                    i++;
+                }
+            }
+        }
+
+        this->Stop(idle);
+    }
+
+    void ProcessPool::Stop(std::vector<AutoPtr<Worker> >& stopping)
+    {
+        // Most helpers exit when their input ends; the rest are asked to.
+        for (size_t i = 0; i < stopping.size(); i++)
+        {
+            try
+            {
+                stopping[i]->process->GetStdin()->Close();
+                stopping[i]->process->Terminate();
+            }
+            catch (ValueException& e)
+            {
+                GetLogger()->Warn("Could not stop pool process: %s",
+                    e.ToString().c_str());
+            }
+        }
+    }
+
+    void ProcessPool::Close()
+    {
+        if (idleTimer)
+            idleTimer->stop();
+
+        std::vector<AutoPtr<Worker> > stopping;
+        {
+            Poco::Mutex::ScopedLock lock(mutex);
+            if (closed)
+                return;
+            closed = true;
+
+            for (size_t i = 0; i < queue.size(); i++)
+                this->Fail(queue[i], "The process pool was closed");
+            queue.clear();
+            stopping.swap(workers);
+        }
+
+        // Requests which are still running fail when their process exits,
+        // or already have if the pool is being destroyed.
+        this->Stop(stopping);
+    }
+
+    void ProcessPool::_Request(const ValueList& args, ValueRef result)
+    {
+        args.VerifyException("request", "s|o m ?m");
+
+        Request request;
+        if (args.at(0)->IsString())
+        {
+            std::string data(args.GetString(0));
+            request.data = new Bytes(data.c_str(), data.size());
+        }
+        else
+        {
+            request.data = args.GetObject(0).cast<Bytes>();
+            if (request.data.isNull())
+                throw ValueException::FromString("Request data must be a String or Bytes");
+        }
+        request.onResponse = args.GetMethod(1);
+        request.onError = args.GetMethod(2, 0);
+
+        Poco::Mutex::ScopedLock lock(mutex);
+        if (closed)
+            throw ValueException::FromString("The process pool is closed");
+        queue.push_back(request);
+        this->Dispatch();
+    }
+
+    void ProcessPool::_GetStats(const ValueList& args, ValueRef result)
+    {
+        Poco::Mutex::ScopedLock lock(mutex);
+        int busy = 0;
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            if (workers[i]->busy)
+                busy++;
+        }
+
+        TiObjectRef stats(new StaticBoundObject());
+        stats->SetInt("size", (int) size);
+        stats->SetInt("running", (int) workers.size());
+        stats->SetInt("busy", busy);
+        stats->SetInt("idle", (int) workers.size() - busy);
+        stats->SetInt("queued", (int) queue.size());
+        stats->SetInt("completed", completed);
+        stats->SetInt("failed", failed);
+        stats->SetInt("restarts", restarts);
+        result->SetObject(stats);
+    }
+
+    void ProcessPool::_Close(const ValueList& args, ValueRef result)
+    {
+        this->Close();
+    }
+}
@@ -0,0 +1,129 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+#ifndef _PROCESS_POOL_H_
+#define _PROCESS_POOL_H_
+
+#include <tide/tide.h>
+#include <deque>
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timer.h>
+#include <Poco/Timestamp.h>
+#include "process.h"
+
+namespace ti
+{
+    /**
+     * A set of long-lived helper processes which all run the same command
+     * and answer requests over their stdin and stdout. Requests are framed
+     * either as lines or as 4-byte big-endian lengths followed by data, and
+     * each helper works on one request at a time. A request goes to the
+     * idle helper which was used most recently, so that helpers the pool
+     * doesn't need stay idle and can time out; otherwise it waits in a
+     * queue until a helper is free.
+     *
+     * Helpers which exit are started again when there is work for them.
+     * Responses and errors are delivered on the main thread. The pool
+     * lives as long as script holds on to it and is closed when it goes.
+     */
+    class ProcessPool : public StaticBoundObject
+    {
+    public:
+        enum Framing
+        {
+            LINES,
+            LENGTH_PREFIXED
+        };
+
+        ProcessPool(TiListRef args, TiObjectRef environment, size_t size,
+            long idleTimeout, Framing framing);
+        virtual ~ProcessPool();
+        void Start();
+        void Close();
+
+        class Worker;
+
+    private:
+        struct Request
+        {
+            BytesRef data;
+            TiMethodRef onResponse;
+            TiMethodRef onError;
+        };
+
+        // The workers' way back to the pool. They only hold a raw pointer,
+        // since they outlive the pool until their processes exit, and the
+        // pool clears it under the mutex when it is destroyed.
+        struct Link
+        {
+            Link(ProcessPool* pool) : pool(pool) {}
+            Poco::Mutex mutex;
+            ProcessPool* pool;
+        };
+
+        void _Request(const ValueList& args, ValueRef result);
+        void _GetStats(const ValueList& args, ValueRef result);
+        void _Close(const ValueList& args, ValueRef result);
+
+        AutoPtr<Worker> StartWorker();
+        void Dispatch();
+        void Send(AutoPtr<Worker> worker, Request& request);
+        void Fail(Request& request, const std::string& message);
+        void OnResponse(Worker* worker, BytesRef response);
+        void OnExit(Worker* worker);
+        void OnIdleTimer(Poco::Timer& timer);
+        void Stop(std::vector<AutoPtr<Worker> >& stopping);
+
+        Poco::SharedPtr<Link> link;
+        TiListRef args;
+        TiObjectRef environment;
+        size_t size;
+        long idleTimeout;
+        Framing framing;
+        bool closed;
+
+        Poco::Mutex mutex;
+        std::vector<AutoPtr<Worker> > workers;
+        std::deque<Request> queue;
+        Poco::Timer* idleTimer;
+        int restarts;
+        int completed;
+        int failed;
+
+        friend class Worker;
+    };
+}
+
+#endif
@@ -210,6 +210,7 @@ namespace ti
         nativeIn->StartMonitor();
         nativeOut->StartMonitor();
         nativeErr->StartMonitor();
+        this->exitMonitorThread.start(*exitMonitorAdapter);
     }
 
     BytesRef Win32Process::MonitorSync()
@@ -66,8 +66,6 @@ namespace ti
     protected:
         std::string ArgListToString(TiListRef argList);
         
-        Poco::Thread exitMonitorThread;
-        Poco::RunnableAdapter<Win32Process>* exitMonitorAdapter;
         AutoPtr<Win32Pipe> nativeIn, nativeOut, nativeErr;
         Poco::Mutex mutex;
         
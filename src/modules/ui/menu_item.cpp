@@ -144,7 +144,6 @@ namespace ti
         if (args.at(0)->IsObject())
         {
             TiObjectRef o = args.at(0)->ToObject();
-            o = TiObject::Unwrap(o);
             newSubmenu = o.cast<Menu>();
         }
 
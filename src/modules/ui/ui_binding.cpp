@@ -74,6 +74,8 @@ namespace ti
         this->SetBool("nativeNotifications", Notification::InitializeImpl());
 
         this->SetObject("Clipboard", new Clipboard());
+
+        this->logForwarder = StaticBoundMethod::FromMethod(this, &UIBinding::_ForwardLog);
         Logger::AddLoggerCallback(&UIBinding::Log);
     }
 
@@ -406,9 +408,20 @@ namespace ti
 
     void UIBinding::Log(Logger::Level level, std::string& message)
     {
-        if (level > Logger::LWARN)
+        // Logger callbacks run on the logger's writer thread, so leave
+        // the windows and their consoles to the main thread.
+        if (level > Logger::LWARN || !instance)
             return;
 
+        RunOnMainThread(instance->logForwarder, ValueList(
+            Value::NewInt(level), Value::NewString(message)), false);
+    }
+
+    void UIBinding::_ForwardLog(const ValueList& args, ValueRef result)
+    {
+        Logger::Level level = (Logger::Level) args.GetInt(0);
+        std::string message(args.GetString(1));
+
         std::string methodName("warn");
         if (level < Logger::LWARN)
             methodName = "error";
@@ -416,7 +429,7 @@ namespace ti
         std::string origMethodName(methodName);
         origMethodName.append("_orig");
 
-        std::vector<AutoUserWindow>& openWindows = UIBinding::GetInstance()->GetOpenWindows();
+        std::vector<AutoUserWindow>& openWindows = this->GetOpenWindows();
         for (size_t i = 0; i < openWindows.size(); i++)
         {
             TiObjectRef domWindow = openWindows[i]->GetDOMWindow();
@@ -430,8 +443,10 @@ namespace ti
             TiMethodRef method = console->GetMethod(origMethodName.c_str(), 0);
             if (method.isNull())
                 method = console->GetMethod(methodName.c_str(), 0);
+            if (method.isNull())
+                continue;
 
-            RunOnMainThread(method, ValueList(Value::NewString(message)), false);
+            method->Call(Value::NewString(message));
         }
     }
 }
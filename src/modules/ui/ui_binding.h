@@ -113,7 +113,10 @@ namespace ti
         std::vector<AutoTrayItem> trayItems;
         std::string iconURL;
 
+        TiMethodRef logForwarder;
+
         static void Log(Logger::Level level, std::string& message);
+        void _ForwardLog(const ValueList& args, ValueRef result);
     };
 }
 
@@ -0,0 +1,198 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Compares the Codec module's base64 and hex kernels, at each SIMD
+ * level the processor supports, against Poco's stream-based encoders
+ * which Codec used to go through.
+ */
+
+#include <Poco/Base64Encoder.h>
+#include <Poco/Base64Decoder.h>
+#include <Poco/HexBinaryEncoder.h>
+#include <Poco/HexBinaryDecoder.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/Timestamp.h>
+#include <codec/base64.h>
+#include <codec/cpu_features.h>
+#include <codec/hex_binary.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace ti;
+
+static const size_t DATA_SIZE = 4 * 1024 * 1024;
+static const int PASSES = 8;
+
+static std::vector<char> data(DATA_SIZE);
+static std::vector<char> text;
+static std::vector<char> output(DATA_SIZE * 2);
+
+static double MegabytesPerSecond(Poco::Timestamp& start)
+{
+    double seconds = (double) start.elapsed() / 1000000.0;
+    return (double) DATA_SIZE * PASSES / (1024.0 * 1024.0) / seconds;
+}
+
+static void Report(const char* name, double encode, double decode)
+{
+    printf("%-20s encode %8.1f MB/s   decode %8.1f MB/s\n",
+        name, encode, decode);
+}
+
+static void BenchmarkPocoBase64()
+{
+    Poco::Timestamp start;
+    std::string encoded;
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        std::ostringstream stream;
+        Poco::Base64Encoder encoder(stream);
+        encoder.write(&data[0], DATA_SIZE);
+        encoder.close();
+        encoded = stream.str();
+    }
+    double encode = MegabytesPerSecond(start);
+
+    start.update();
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        std::istringstream stream(encoded);
+        Poco::Base64Decoder decoder(stream);
+        std::string decoded;
+        Poco::StreamCopier::copyToString(decoder, decoded);
+    }
+    Report("Poco base64", encode, MegabytesPerSecond(start));
+}
+
+static void BenchmarkPocoHex()
+{
+    Poco::Timestamp start;
+    std::string encoded;
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        std::ostringstream stream;
+        Poco::HexBinaryEncoder encoder(stream);
+        encoder.write(&data[0], DATA_SIZE);
+        encoder.close();
+        encoded = stream.str();
+    }
+    double encode = MegabytesPerSecond(start);
+
+    start.update();
+    for (int pass = 0; pass < PASSES; pass++)
+    {
+        std::istringstream stream(encoded);
+        Poco::HexBinaryDecoder decoder(stream);
+        std::string decoded;
+        Poco::StreamCopier::copyToString(decoder, decoded);
+    }
+    Report("Poco hex", encode, MegabytesPerSecond(start));
+}
+
+static void BenchmarkBase64(const char* name)
+{
+    text.resize(Base64::EncodedLength(DATA_SIZE, true));
+    Poco::Timestamp start;
+    for (int pass = 0; pass < PASSES; pass++)
+        Base64::Encode(&data[0], DATA_SIZE, &text[0], false, true);
+    double encode = MegabytesPerSecond(start);
+
+    start.update();
+    size_t length = 0;
+    for (int pass = 0; pass < PASSES; pass++)
+        Base64::Decode(&text[0], text.size(), &output[0], length, false);
+    Report(name, encode, MegabytesPerSecond(start));
+
+    if (length != DATA_SIZE || memcmp(&output[0], &data[0], DATA_SIZE))
+        printf("  (base64 round trip failed)\n");
+}
+
+static void BenchmarkHex(const char* name)
+{
+    text.resize(DATA_SIZE * 2);
+    Poco::Timestamp start;
+    for (int pass = 0; pass < PASSES; pass++)
+        HexBinary::Encode(&data[0], DATA_SIZE, &text[0]);
+    double encode = MegabytesPerSecond(start);
+
+    start.update();
+    size_t length = 0;
+    for (int pass = 0; pass < PASSES; pass++)
+        HexBinary::Decode(&text[0], text.size(), &output[0], length);
+    Report(name, encode, MegabytesPerSecond(start));
+
+    if (length != DATA_SIZE || memcmp(&output[0], &data[0], DATA_SIZE))
+        printf("  (hex round trip failed)\n");
+}
+
+int main(int argc, char** argv)
+{
+    srand(42);
+    for (size_t i = 0; i < DATA_SIZE; i++)
+        data[i] = (char) rand();
+
+    static const char* levelNames[] = { "scalar", "SSSE3", "SSE4.2", "AVX2" };
+    CPUFeatures::SIMDLevel best = CPUFeatures::GetSIMDLevel();
+
+    printf("%d passes over %lu MB of binary data\n", PASSES,
+        (unsigned long) (DATA_SIZE / (1024 * 1024)));
+    BenchmarkPocoBase64();
+    for (int level = CPUFeatures::SCALAR; level <= best; level++)
+    {
+        // SSE 4.2 adds nothing these kernels use.
+        if (level == CPUFeatures::SSE42)
+            continue;
+        CPUFeatures::LimitSIMDLevel((CPUFeatures::SIMDLevel) level);
+        char name[32];
+        snprintf(name, sizeof(name), "base64 %s", levelNames[level]);
+        BenchmarkBase64(name);
+    }
+
+    CPUFeatures::LimitSIMDLevel(best);
+    BenchmarkPocoHex();
+    for (int level = CPUFeatures::SCALAR; level <= best; level++)
+    {
+        if (level == CPUFeatures::SSE42)
+            continue;
+        CPUFeatures::LimitSIMDLevel((CPUFeatures::SIMDLevel) level);
+        char name[32];
+        snprintf(name, sizeof(name), "hex %s", levelNames[level]);
+        BenchmarkHex(name);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures the throughput, in MB/s, of the Codec module's digest and
+ * checksum engines on a large in-memory buffer, and the cost of creating
+ * a new engine for every small message compared with reusing one.
+ */
+
+#include <Poco/Checksum.h>
+#include <Poco/DigestEngine.h>
+#include <Poco/MD5Engine.h>
+#include <Poco/SHA1Engine.h>
+#include <Poco/Timestamp.h>
+#include <codec/crc32c.h>
+#include <codec/sha2_engine.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const size_t BUFFER_SIZE = 16 * 1024 * 1024;
+static const int PASSES = 8;
+static const size_t MESSAGE_SIZE = 64;
+static const int MESSAGES = 200000;
+
+static std::vector<char> data(BUFFER_SIZE);
+static volatile unsigned int sink;
+
+static void Report(const char* name, Poco::Timestamp& start)
+{
+    double seconds = (double) start.elapsed() / 1000000.0;
+    double megabytes = (double) BUFFER_SIZE * PASSES / (1024.0 * 1024.0);
+    printf("%-24s %9.1f MB/s\n", name, megabytes / seconds);
+}
+
+template <typename Engine>
+static void BenchmarkDigest(const char* name)
+{
+    Engine engine;
+    Poco::Timestamp start;
+    for (int pass = 0; pass < PASSES; pass++)
+        engine.update(&data[0], (unsigned) BUFFER_SIZE);
+    sink = engine.digest()[0];
+    Report(name, start);
+}
+
+static void BenchmarkChecksum(const char* name, Poco::Checksum::Type type)
+{
+    Poco::Checksum checksum(type);
+    Poco::Timestamp start;
+    for (int pass = 0; pass < PASSES; pass++)
+        checksum.update(&data[0], (unsigned) BUFFER_SIZE);
+    sink = checksum.checksum();
+    Report(name, start);
+}
+
+static void BenchmarkCRC32C(const char* name,
+    Poco::UInt32 (*update)(Poco::UInt32, const void*, size_t))
+{
+    Poco::UInt32 crc = 0;
+    Poco::Timestamp start;
+    for (int pass = 0; pass < PASSES; pass++)
+        crc = update(crc, &data[0], BUFFER_SIZE);
+    sink = crc;
+    Report(name, start);
+}
+
+// Codec.digestToHex used to allocate an engine for every call.
+template <typename Engine>
+static void BenchmarkSmallMessages(const char* name)
+{
+    Poco::Timestamp start;
+    for (int i = 0; i < MESSAGES; i++)
+    {
+        Engine* engine = new Engine();
+        engine->update(&data[i % 1024], MESSAGE_SIZE);
+        sink = engine->digest()[0];
+        delete engine;
+    }
+    double fresh = (double) start.elapsed() * 1000.0 / MESSAGES;
+
+    Engine engine;
+    start.update();
+    for (int i = 0; i < MESSAGES; i++)
+    {
+        engine.update(&data[i % 1024], MESSAGE_SIZE);
+        sink = engine.digest()[0];
+    }
+    double reused = (double) start.elapsed() * 1000.0 / MESSAGES;
+
+    printf("%-24s new engine %7.1f ns/msg   reused %7.1f ns/msg\n",
+        name, fresh, reused);
+}
+
+int main(int argc, char** argv)
+{
+    srand(42);
+    for (size_t i = 0; i < BUFFER_SIZE; i++)
+        data[i] = (char) rand();
+
+    printf("%d passes over a %lu MB buffer\n", PASSES,
+        (unsigned long) (BUFFER_SIZE / (1024 * 1024)));
+    BenchmarkDigest<Poco::MD5Engine>("MD5");
+    BenchmarkDigest<Poco::SHA1Engine>("SHA1");
+    BenchmarkDigest<ti::SHA256Engine>("SHA256");
+    BenchmarkDigest<ti::SHA512Engine>("SHA512");
+    BenchmarkChecksum("CRC32", Poco::Checksum::TYPE_CRC32);
+    BenchmarkChecksum("ADLER32", Poco::Checksum::TYPE_ADLER32);
+    BenchmarkCRC32C("CRC32C (software)", &ti::CRC32C::UpdateSoftware);
+    if (ti::CRC32C::IsHardwareAccelerated())
+        BenchmarkCRC32C("CRC32C (SSE 4.2)", &ti::CRC32C::Update);
+
+    printf("\n%d messages of %lu bytes\n", MESSAGES,
+        (unsigned long) MESSAGE_SIZE);
+    BenchmarkSmallMessages<Poco::MD5Engine>("MD5");
+    BenchmarkSmallMessages<ti::SHA256Engine>("SHA256");
+    return 0;
+}
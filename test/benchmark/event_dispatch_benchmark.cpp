@@ -0,0 +1,201 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures how many events per second an EventObject with 1000 listeners
+ * can fire, from one thread and from four at once. The fired event has no
+ * listeners of its own. That is the common case for GlobalObject, which
+ * sees every event in the application. Listeners are not called, so only
+ * finding them is timed.
+ *
+ * The "copy + scan" column reproduces the previous dispatch: copy the
+ * whole listener list under a mutex, then compare every listener's event
+ * name.
+ */
+
+#include <tide/tide.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+#include <list>
+
+using namespace tide;
+
+static const int LISTENERS = 1000;
+static const int EVENT_NAMES = 100;
+static const int FIRES = 200000;
+static const int THREADS = 4;
+
+// Keeps the compiler from discarding the work.
+static volatile int sink;
+
+// The listener storage EventObject used before it indexed listeners.
+class LegacyListeners
+{
+public:
+    struct Listener
+    {
+        std::string event;
+        bool Handles(const char* name)
+        {
+            return event.compare(name) == 0 || event == Event::ALL;
+        }
+    };
+
+    ~LegacyListeners()
+    {
+        std::list<Listener*>::iterator i = listeners.begin();
+        while (i != listeners.end())
+            delete *i++;
+    }
+
+    void Add(const char* event)
+    {
+        Poco::FastMutex::ScopedLock lock(mutex);
+        Listener* listener = new Listener();
+        listener->event = event;
+        listeners.push_back(listener);
+    }
+
+    void Fire(const char* event)
+    {
+        std::list<Listener*> copy;
+        {
+            Poco::FastMutex::ScopedLock lock(mutex);
+            copy = listeners;
+        }
+
+        int handled = 0;
+        std::list<Listener*>::iterator i = copy.begin();
+        while (i != copy.end())
+        {
+            if ((*i++)->Handles(event))
+                handled++;
+        }
+        sink = handled;
+    }
+
+private:
+    std::list<Listener*> listeners;
+    Poco::FastMutex mutex;
+};
+
+class IndexedListeners
+{
+public:
+    IndexedListeners() : object(new EventObject()) {}
+
+    void Add(const char* event)
+    {
+        object->AddEventListener(event, TiMethodRef(0));
+    }
+
+    void Fire(const char* event)
+    {
+        object->FireEvent(event, args);
+    }
+
+private:
+    AutoPtr<EventObject> object;
+    ValueList args;
+};
+
+template <typename T>
+static void Fill(T& listeners)
+{
+    char name[32];
+    for (int i = 0; i < LISTENERS; i++)
+    {
+        snprintf(name, sizeof(name), "event%d", i % EVENT_NAMES);
+        listeners.Add(name);
+    }
+}
+
+template <typename T>
+class Firer : public Poco::Runnable
+{
+public:
+    Firer(T& listeners) : listeners(listeners) {}
+
+    void run()
+    {
+        for (int i = 0; i < FIRES; i++)
+            listeners.Fire("unheard");
+    }
+
+private:
+    T& listeners;
+};
+
+template <typename T>
+static double EventsPerSecond(T& listeners, int threadCount)
+{
+    std::vector<Firer<T>*> firers;
+    std::vector<Poco::Thread*> threads;
+    Poco::Timestamp start;
+    for (int i = 0; i < threadCount; i++)
+    {
+        firers.push_back(new Firer<T>(listeners));
+        threads.push_back(new Poco::Thread());
+        threads[i]->start(*firers[i]);
+    }
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+        delete firers[i];
+    }
+
+    return (double) FIRES * threadCount * 1000000.0 / start.elapsed();
+}
+
+static void Report(const char* label, double legacy, double indexed)
+{
+    printf("%-12s copy + scan %12.0f events/s   indexed %12.0f events/s   %7.1fx\n",
+        label, legacy, indexed, indexed / legacy);
+}
+
+int main(int argc, const char* argv[])
+{
+    LegacyListeners legacy;
+    IndexedListeners indexed;
+    Fill(legacy);
+    Fill(indexed);
+
+    Report("1 thread", EventsPerSecond(legacy, 1), EventsPerSecond(indexed, 1));
+    Report("4 threads", EventsPerSecond(legacy, THREADS), EventsPerSecond(indexed, THREADS));
+    return 0;
+}
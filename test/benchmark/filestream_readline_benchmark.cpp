@@ -0,0 +1,162 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures how many lines per second a script can read from, and write
+ * to, a FileStream. Lines are read through the bound readLine method,
+ * the way a script reading a log file calls it.
+ *
+ * MODE_READ goes through Poco's input stream, std::getline and a copy
+ * into a new Bytes for every line. MODE_MAPPED finds each line with
+ * memchr in a mapping of the file and returns it as a slice. Writes
+ * are compared against the Poco output stream FileStream used before.
+ */
+
+#include <tide/tide.h>
+#include <filesystem/file_stream.h>
+#include <Poco/FileStream.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+
+using namespace tide;
+using ti::FileStream;
+
+// Short lines like a typical log, then long ones where copying
+// each line starts to cost more than finding it.
+static const int SHORT_LINES = 1000000;
+static const int LONG_LINES = 50000;
+static const size_t LONG_LINE_LENGTH = 4096;
+
+// Keeps the compiler from discarding the work.
+static volatile size_t sink;
+
+static std::string MakeLine(int i, size_t length)
+{
+    char prefix[128];
+    snprintf(prefix, sizeof(prefix),
+        "2012-06-01 12:00:%02d [INFO] request %d served in %d ms",
+        i % 60, i, i % 997);
+
+    std::string line(prefix);
+    if (line.length() < length)
+        line.append(length - line.length(), '.');
+    line += "\n";
+    return line;
+}
+
+static double LegacyWriteLinesPerSecond(const std::string& path, int lines, size_t length)
+{
+    Poco::Timestamp start;
+    Poco::FileOutputStream stream(path, std::ios::out | std::ios::trunc);
+    for (int i = 0; i < lines; i++)
+    {
+        std::string line(MakeLine(i, length));
+        stream.write(line.c_str(), line.length());
+    }
+    stream.close();
+    return lines * 1000000.0 / start.elapsed();
+}
+
+static double WriteLinesPerSecond(const std::string& path, int lines, size_t length)
+{
+    Poco::Timestamp start;
+    AutoPtr<FileStream> stream(new FileStream(path));
+    stream->Open(FileStream::MODE_WRITE);
+    for (int i = 0; i < lines; i++)
+    {
+        std::string line(MakeLine(i, length));
+        stream->Write(line.c_str(), line.length());
+    }
+    stream->Close();
+    return lines * 1000000.0 / start.elapsed();
+}
+
+static double ReadLinesPerSecond(const std::string& path, int expected,
+    FileStream::FileStreamMode mode)
+{
+    Poco::Timestamp start;
+    AutoPtr<FileStream> stream(new FileStream(path));
+    stream->Open(mode);
+
+    TiMethodRef readLine(stream->Get("readLine")->ToMethod());
+    ValueList args;
+    int lines = 0;
+    size_t bytes = 0;
+    while (true)
+    {
+        ValueRef line(readLine->Call(args));
+        if (line->IsNull())
+            break;
+
+        bytes += line->ToObject().cast<Bytes>()->Length();
+        lines++;
+    }
+    stream->Close();
+    sink = bytes;
+
+    if (lines != expected)
+        fprintf(stderr, "read %d lines instead of %d\n", lines, expected);
+    return lines * 1000000.0 / start.elapsed();
+}
+
+static void Report(const char* label, const char* legacyName, double legacy,
+    const char* currentName, double current)
+{
+    printf("%-9s %-9s %10.0f lines/s   %-11s %10.0f lines/s   %5.1fx\n",
+        label, legacyName, legacy, currentName, current, current / legacy);
+}
+
+static void Run(const std::string& path, int lines, size_t length)
+{
+    printf("%d lines of about %d bytes\n", lines, (int) MakeLine(0, length).length());
+
+    double legacyWrite = LegacyWriteLinesPerSecond(path, lines, length);
+    double write = WriteLinesPerSecond(path, lines, length);
+    Report("write", "ostream", legacyWrite, "buffered", write);
+
+    // Read once first so both modes start with the file in the page cache.
+    ReadLinesPerSecond(path, lines, FileStream::MODE_READ);
+    double read = ReadLinesPerSecond(path, lines, FileStream::MODE_READ);
+    double mapped = ReadLinesPerSecond(path, lines, FileStream::MODE_MAPPED);
+    Report("readLine", "MODE_READ", read, "MODE_MAPPED", mapped);
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string path(argc > 1 ? argv[1] : "filestream_benchmark.log");
+    Run(path, SHORT_LINES, 0);
+    Run(path, LONG_LINES, LONG_LINE_LENGTH);
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,229 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * A small wrk-style load generator for Network.HTTPServer. It keeps a
+ * number of keep-alive connections busy with GET requests for a while and
+ * reports throughput and latency percentiles.
+ *
+ *   http_load_benchmark [url] [connections] [seconds]
+ *
+ * Point it at a server bound by an application, for instance one using a
+ * handlerScript or staticFiles. Without a URL it measures a bare Poco
+ * server on a local port, which is the ceiling for the others.
+ */
+
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/NullStream.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <Poco/URI.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const int DEFAULT_CONNECTIONS = 8;
+static const int DEFAULT_SECONDS = 10;
+static const int MAX_CONNECTIONS = 256;
+
+class HelloHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    void handleRequest(Poco::Net::HTTPServerRequest& request,
+        Poco::Net::HTTPServerResponse& response)
+    {
+        static const std::string body("Hello, world!");
+        response.setContentType("text/plain");
+        response.setContentLength(body.size());
+        response.send() << body;
+    }
+};
+
+class HelloHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+    Poco::Net::HTTPRequestHandler* createRequestHandler(
+        const Poco::Net::HTTPServerRequest& request)
+    {
+        return new HelloHandler();
+    }
+};
+
+class Connection : public Poco::Runnable
+{
+public:
+    Connection(const Poco::URI& uri, Poco::Timestamp::TimeDiff duration) :
+        uri(uri),
+        duration(duration),
+        bytes(0),
+        errors(0)
+    {
+    }
+
+    void run()
+    {
+        Poco::Net::HTTPClientSession session(uri.getHost(), uri.getPort());
+        session.setKeepAlive(true);
+        std::string path(uri.getPathAndQuery());
+        if (path.empty())
+            path = "/";
+
+        Poco::Timestamp start;
+        while (start.elapsed() < duration)
+        {
+            Poco::Timestamp requestStart;
+            try
+            {
+                Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET,
+                    path, Poco::Net::HTTPMessage::HTTP_1_1);
+                session.sendRequest(request);
+
+                Poco::Net::HTTPResponse response;
+                std::istream& body = session.receiveResponse(response);
+                Poco::NullOutputStream discard;
+                bytes += Poco::StreamCopier::copyStream(body, discard);
+
+                if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+                    errors++;
+            }
+            catch (Poco::Exception&)
+            {
+                errors++;
+                session.reset();
+            }
+            latencies.push_back(requestStart.elapsed());
+        }
+    }
+
+    Poco::URI uri;
+    Poco::Timestamp::TimeDiff duration;
+    std::vector<Poco::Timestamp::TimeDiff> latencies;
+    Poco::UInt64 bytes;
+    int errors;
+};
+
+static double Percentile(std::vector<Poco::Timestamp::TimeDiff>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = (size_t) (fraction * (sorted.size() - 1));
+    return sorted[index] / 1000.0;
+}
+
+int main(int argc, const char* argv[])
+{
+    int connectionCount = argc > 2 ? atoi(argv[2]) : DEFAULT_CONNECTIONS;
+    int seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+    if (connectionCount < 1 || connectionCount > MAX_CONNECTIONS || seconds < 1)
+    {
+        fprintf(stderr, "usage: %s [url] [connections (1-%d)] [seconds]\n",
+            argv[0], MAX_CONNECTIONS);
+        return 1;
+    }
+
+    Poco::Net::HTTPServer* server = 0;
+    std::string url;
+    if (argc > 1)
+    {
+        url = argv[1];
+    }
+    else
+    {
+        Poco::Net::ServerSocket socket(0);
+        Poco::Net::HTTPServerParams* params = new Poco::Net::HTTPServerParams;
+        params->setMaxThreads(connectionCount);
+        server = new Poco::Net::HTTPServer(new HelloHandlerFactory(), socket, params);
+        server->start();
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "http://127.0.0.1:%d/",
+            (int) socket.address().port());
+        url = buffer;
+    }
+
+    printf("Running %ds test @ %s with %d connections\n",
+        seconds, url.c_str(), connectionCount);
+
+    Poco::URI uri(url);
+    Poco::Timestamp::TimeDiff duration = (Poco::Timestamp::TimeDiff) seconds * 1000000;
+    std::vector<Connection*> connections;
+    std::vector<Poco::Thread*> threads;
+    for (int i = 0; i < connectionCount; i++)
+    {
+        connections.push_back(new Connection(uri, duration));
+        threads.push_back(new Poco::Thread());
+        threads.back()->start(*connections.back());
+    }
+
+    std::vector<Poco::Timestamp::TimeDiff> latencies;
+    Poco::UInt64 bytes = 0;
+    int errors = 0;
+    for (int i = 0; i < connectionCount; i++)
+    {
+        threads[i]->join();
+        latencies.insert(latencies.end(), connections[i]->latencies.begin(),
+            connections[i]->latencies.end());
+        bytes += connections[i]->bytes;
+        errors += connections[i]->errors;
+        delete threads[i];
+        delete connections[i];
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%lu requests, %d errors\n", (unsigned long) latencies.size(), errors);
+    printf("Requests/sec: %10.1f\n", (double) latencies.size() / seconds);
+    printf("Transfer/sec: %10.1f KB\n", (double) bytes / 1024.0 / seconds);
+    printf("Latency  50%%: %8.2f ms  90%%: %8.2f ms  99%%: %8.2f ms  max: %8.2f ms\n",
+        Percentile(latencies, 0.5), Percentile(latencies, 0.9),
+        Percentile(latencies, 0.99), Percentile(latencies, 1.0));
+
+    if (server)
+    {
+        server->stop();
+        delete server;
+    }
+    return errors ? 2 : 0;
+}
@@ -0,0 +1,105 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures property access on native objects from JavaScript: reading a
+ * number, reading an object (which has to be wrapped for JavaScript),
+ * probing with "in" and calling a method. Run it before and after
+ * changes to the JavaScriptCore bridge in javascript/js_util.cpp.
+ */
+
+#include <tide/tide.h>
+#include <tide/javascript/javascript_module.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+
+using namespace tide;
+
+static const int ITERATIONS = 1000000;
+
+class BenchmarkObject : public StaticBoundObject
+{
+public:
+    BenchmarkObject() : StaticBoundObject("Benchmark")
+    {
+        this->SetInt("number", 42);
+        this->SetObject("child", new StaticBoundObject("Benchmark.Child"));
+        this->SetMethod("method", &BenchmarkObject::Method);
+    }
+
+    void Method(const ValueList& args, ValueRef result)
+    {
+        result->SetInt(args.size());
+    }
+};
+
+static void TimeScript(JSGlobalContextRef context, const char* name, const char* body)
+{
+    char script[512];
+    snprintf(script, sizeof(script),
+        "(function () { var o = benchmark; var r = 0;"
+        " for (var i = 0; i < %d; i++) { %s } return r; })()",
+        ITERATIONS, body);
+
+    Poco::Timestamp start;
+    JSUtil::Evaluate(context, script);
+    Poco::Timestamp::TimeDiff elapsed = start.elapsed();
+
+    printf("%-24s %8.1f ns/access\n", name, (double) elapsed * 1000.0 / ITERATIONS);
+}
+
+int main(int argc, const char* argv[])
+{
+    JSGlobalContextRef context = JSGlobalContextCreate(0);
+    JSObjectRef globalObject = JSContextGetGlobalObject(context);
+
+    TiObjectRef benchmark(new BenchmarkObject());
+    JSValueRef jsBenchmark = JSUtil::ToJSValue(Value::NewObject(benchmark), context);
+    JSStringRef propertyName = JSStringCreateWithUTF8CString("benchmark");
+    JSObjectSetProperty(context, globalObject, propertyName, jsBenchmark,
+        kJSPropertyAttributeNone, NULL);
+    JSStringRelease(propertyName);
+
+    TimeScript(context, "number property", "r += o.number;");
+    TimeScript(context, "object property", "if (o.child) r++;");
+    TimeScript(context, "'in' probe", "if ('number' in o) r++;");
+    TimeScript(context, "special 'in' probe", "if ('toString' in o) r++;");
+    TimeScript(context, "method call", "r += o.method(1, 2);");
+
+    ValueRef same(JSUtil::Evaluate(context, "benchmark.child === benchmark.child"));
+    printf("object identity preserved: %s\n", same->ToBool() ? "yes" : "no");
+
+    JSGlobalContextRelease(context);
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures what a Logger::Debug call costs the thread which makes it, with
+ * debug logging enabled and written to a file, for one thread and for
+ * several threads logging at once. The writer thread's time to catch up
+ * is reported separately.
+ */
+
+#include <tide/tide.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+#include <vector>
+
+using namespace tide;
+
+static const int MESSAGES = 200000;
+static const int LOGGING_THREADS = 4;
+
+class LoggingThread : public Poco::Runnable
+{
+public:
+    LoggingThread(int index) : index(index), elapsed(0) {}
+
+    void run()
+    {
+        Logger* logger = Logger::Get("Benchmark");
+        Poco::Timestamp start;
+        for (int i = 0; i < MESSAGES; i++)
+            logger->Debug("thread %d wrote message %d of %d", index, i, MESSAGES);
+        elapsed = start.elapsed();
+    }
+
+    int index;
+    Poco::Timestamp::TimeDiff elapsed;
+};
+
+static void TimeThreads(int threadCount)
+{
+    std::vector<LoggingThread*> loggers;
+    std::vector<Poco::Thread*> threads;
+    unsigned int droppedBefore = Logger::GetDroppedCount();
+
+    Poco::Timestamp start;
+    for (int i = 0; i < threadCount; i++)
+    {
+        loggers.push_back(new LoggingThread(i));
+        threads.push_back(new Poco::Thread());
+        threads[i]->start(*loggers[i]);
+    }
+
+    Poco::Timestamp::TimeDiff callTime = 0;
+    for (int i = 0; i < threadCount; i++)
+    {
+        threads[i]->join();
+        callTime += loggers[i]->elapsed;
+        delete threads[i];
+        delete loggers[i];
+    }
+    Poco::Timestamp::TimeDiff logged = start.elapsed();
+
+    Logger::Flush();
+    Poco::Timestamp::TimeDiff written = start.elapsed();
+
+    printf("%d thread(s): %8.1f ns/call   logged in %6.1f ms   written in %6.1f ms   dropped %u\n",
+        threadCount, (double) callTime * 1000.0 / (MESSAGES * threadCount),
+        logged / 1000.0, written / 1000.0, Logger::GetDroppedCount() - droppedBefore);
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string logFile(argc > 1 ? argv[1] : "logger_benchmark.log");
+    Logger::Initialize(false, logFile, Logger::LDEBUG);
+
+    Logger::SetOverflowPolicy(Logger::DROP_WHEN_FULL);
+    printf("drop when full\n");
+    TimeThreads(1);
+    TimeThreads(LOGGING_THREADS);
+
+    Logger::SetOverflowPolicy(Logger::BLOCK_WHEN_FULL);
+    printf("block when full\n");
+    TimeThreads(1);
+    TimeThreads(LOGGING_THREADS);
+
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Counts the heap allocations made to create and destroy a Bytes, an
+ * Event and an EventObject, and times them. Each is compared against a
+ * class which binds the same number of methods and constants on every
+ * instance, the way these classes were set up before they shared a
+ * Prototype.
+ */
+
+#include <tide/tide.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace tide;
+
+static const int ITERATIONS = 200000;
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) throw (std::bad_alloc)
+{
+    allocations++;
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) throw (std::bad_alloc)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) throw ()
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) throw ()
+{
+    free(pointer);
+}
+
+// Bytes as it was set up before: fourteen methods and "length" on each instance.
+class EagerBytes : public Bytes
+{
+public:
+    EagerBytes(const char* data, size_t length) : Bytes(data, length)
+    {
+        const char* names[] = { "write", "toString", "indexOf", "lastIndexOf",
+            "charAt", "byteAt", "split", "substring", "substr", "toLowerCase",
+            "toUpperCase", "concat", "slice", "toArray" };
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+            this->SetMethod(names[i], &EagerBytes::Method);
+    }
+
+    void Method(const ValueList&, ValueRef) {}
+};
+
+// Event as it was set up before: the event constants and five methods.
+class EagerEvent : public AccessorObject
+{
+public:
+    EagerEvent() : AccessorObject("Event")
+    {
+        Event::SetEventConstants(this);
+        this->SetMethod("getTarget", &EagerEvent::Method);
+        this->SetMethod("getType", &EagerEvent::Method);
+        this->SetMethod("getTimestamp", &EagerEvent::Method);
+        this->SetMethod("stopPropagation", &EagerEvent::Method);
+        this->SetMethod("preventDefault", &EagerEvent::Method);
+    }
+
+    void Method(const ValueList&, ValueRef) {}
+};
+
+// EventObject as it was set up before: three methods and the constants.
+class EagerEventObject : public AccessorObject
+{
+public:
+    EagerEventObject() : AccessorObject("EventObject")
+    {
+        this->SetMethod("on", &EagerEventObject::Method);
+        this->SetMethod("addEventListener", &EagerEventObject::Method);
+        this->SetMethod("removeEventListener", &EagerEventObject::Method);
+        Event::SetEventConstants(this);
+    }
+
+    void Method(const ValueList&, ValueRef) {}
+};
+
+// Keeps the compiler from discarding the work.
+static volatile int sink;
+
+struct Result
+{
+    double allocations;
+    double nanoseconds;
+};
+
+template <typename Factory>
+static Result Measure(Factory create)
+{
+    // Create one first, so that one-time setup is not counted.
+    create()->release();
+
+    size_t before = allocations;
+    Poco::Timestamp start;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        TiObject* object = create();
+        sink = object->GetType().size();
+        object->release();
+    }
+
+    Result result;
+    result.nanoseconds = (double) start.elapsed() * 1000.0 / ITERATIONS;
+    result.allocations = (double) (allocations - before) / ITERATIONS;
+    return result;
+}
+
+static AutoPtr<EventObject> target;
+
+static TiObject* CreateBytes() { return new Bytes("0123456789abcdef", 16); }
+static TiObject* CreateEagerBytes() { return new EagerBytes("0123456789abcdef", 16); }
+static TiObject* CreateEvent() { return new Event(target, Event::READ); }
+static TiObject* CreateEagerEvent() { return new EagerEvent(); }
+static TiObject* CreateEventObject() { return new EventObject(); }
+static TiObject* CreateEagerEventObject() { return new EagerEventObject(); }
+
+static void Report(const char* label, Result eager, Result shared)
+{
+    printf("%-12s per-instance %6.1f allocs %8.1f ns   prototype %6.1f allocs %8.1f ns\n",
+        label, eager.allocations, eager.nanoseconds,
+        shared.allocations, shared.nanoseconds);
+}
+
+// Looking a method up the first time binds it; later lookups reuse it.
+static void CheckMethodLookup()
+{
+    BytesRef bytes(new Bytes("hello", 5));
+    TiMethodRef first(bytes->GetMethod("toUpperCase"));
+    TiMethodRef second(bytes->GetMethod("toUpperCase"));
+    ValueRef upper(first->Call());
+    printf("bytes.toUpperCase() = %s, same method on second lookup: %s\n",
+        upper->ToString(),
+        first.get() == second.get() ? "yes" : "no");
+}
+
+int main(int argc, const char* argv[])
+{
+    target = new EventObject();
+    Report("Bytes", Measure(CreateEagerBytes), Measure(CreateBytes));
+    Report("Event", Measure(CreateEagerEvent), Measure(CreateEvent));
+    Report("EventObject", Measure(CreateEagerEventObject), Measure(CreateEventObject));
+    CheckMethodLookup();
+    target = 0;
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures how many short-lived children per second Process.launch can
+ * start, comparing the fork, close-every-descriptor and execvp sequence it
+ * used to run with ti::SpawnProcess. A large, touched heap stands in for
+ * the runtime's address space, which fork has to copy the page tables of.
+ */
+
+#include <Poco/Timestamp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if !defined(OS_WIN32)
+#include <process/posix/posix_spawn.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static const size_t HEAP_SIZE = 512 * 1024 * 1024;
+static const int SPAWNS = 2000;
+
+static std::vector<std::string> args;
+static std::vector<std::string> environment;
+
+static pid_t ForkAndExec(const int fds[3])
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(fds[0], STDIN_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[2], STDERR_FILENO);
+        for (int i = 3; i < getdtablesize(); ++i)
+            close(i);
+
+        char* argv[] = { const_cast<char*>(args[0].c_str()), 0 };
+        execvp(argv[0], argv);
+        _exit(72);
+    }
+    return pid;
+}
+
+static pid_t Spawn(const int fds[3])
+{
+    return ti::SpawnProcess(args, environment, fds);
+}
+
+static void Benchmark(const char* name, pid_t (*launch)(const int[3]))
+{
+    int fds[3];
+    fds[0] = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    fds[1] = fds[2] = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    Poco::Timestamp start;
+    for (int i = 0; i < SPAWNS; i++)
+    {
+        pid_t pid = launch(fds);
+        int status;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || WEXITSTATUS(status) != 0)
+        {
+            printf("%s: could not run %s\n", name, args[0].c_str());
+            exit(1);
+        }
+    }
+    double seconds = (double) start.elapsed() / 1000000.0;
+    printf("%-24s %8.0f spawns/s\n", name, SPAWNS / seconds);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(int argc, char** argv)
+{
+    args.push_back(argc > 1 ? argv[1] : "true");
+    for (size_t i = 0; environ[i]; i++)
+        environment.push_back(environ[i]);
+
+    // Applications often raise their descriptor limit, which is what
+    // the old close loop walks.
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    printf("%d runs of %s, descriptor limit %lu\n", SPAWNS, args[0].c_str(),
+        (unsigned long) getdtablesize());
+
+    printf("\nsmall heap\n");
+    Benchmark("fork + execvp", &ForkAndExec);
+    Benchmark("SpawnProcess", &Spawn);
+
+    char* heap = (char*) malloc(HEAP_SIZE);
+    for (size_t i = 0; i < HEAP_SIZE; i += 4096)
+        heap[i] = (char) i;
+
+    printf("\n%lu MB heap\n", (unsigned long) (HEAP_SIZE / (1024 * 1024)));
+    Benchmark("fork + execvp", &ForkAndExec);
+    Benchmark("SpawnProcess", &Spawn);
+    free(heap);
+    return 0;
+}
+#else
+int main(int argc, char** argv)
+{
+    printf("Process spawning is only benchmarked on POSIX systems\n");
+    return 0;
+}
+#endif
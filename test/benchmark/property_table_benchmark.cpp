@@ -0,0 +1,167 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Compares StaticBoundObject's PropertyTable against the std::map and
+ * mutex storage it replaced, for single-threaded lookups, missed lookups
+ * and concurrent readers with an occasional writer.
+ */
+
+#include <tide/tide.h>
+#include <Poco/Thread.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
+#include <cstdio>
+#include <map>
+
+using namespace tide;
+
+static const int PROPERTY_COUNT = 24;
+static const int LOOKUPS = 2000000;
+static const int READER_THREADS = 4;
+
+// The storage StaticBoundObject used before PropertyTable.
+class MapTable
+{
+public:
+    ValueRef Get(const char* name)
+    {
+        Poco::Mutex::ScopedLock lock(mutex);
+        std::map<std::string, ValueRef>::iterator iter =
+            properties.find(std::string(name));
+        if (iter == properties.end())
+            return 0;
+        return iter->second;
+    }
+
+    void Set(const char* name, ValueRef value)
+    {
+        Poco::Mutex::ScopedLock lock(mutex);
+        properties[std::string(name)] = value;
+    }
+
+private:
+    std::map<std::string, ValueRef> properties;
+    Poco::Mutex mutex;
+};
+
+static char names[PROPERTY_COUNT][32];
+static char missingNames[PROPERTY_COUNT][32];
+
+// Keeps the compiler from discarding the lookups.
+static volatile int sink;
+
+template <typename T>
+static void Fill(T& table)
+{
+    for (int i = 0; i < PROPERTY_COUNT; i++)
+        table.Set(names[i], Value::NewInt(i));
+}
+
+template <typename T>
+static double TimeLookups(T& table, char (*lookupNames)[32])
+{
+    Poco::Timestamp start;
+    int found = 0;
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        if (!table.Get(lookupNames[i % PROPERTY_COUNT]).isNull())
+            found++;
+    }
+    sink = found;
+    return (double) start.elapsed() * 1000.0 / LOOKUPS;
+}
+
+template <typename T>
+class Reader : public Poco::Runnable
+{
+public:
+    Reader(T& table) : table(table) {}
+    void run() { TimeLookups(table, names); }
+
+private:
+    T& table;
+};
+
+template <typename T>
+static double TimeContended(T& table)
+{
+    std::vector<Reader<T>*> readers;
+    std::vector<Poco::Thread*> threads;
+    Poco::Timestamp start;
+    for (int i = 0; i < READER_THREADS; i++)
+    {
+        readers.push_back(new Reader<T>(table));
+        threads.push_back(new Poco::Thread());
+        threads[i]->start(*readers[i]);
+    }
+
+    // One writer keeps updating a property, like readyState on an HTTPClient.
+    for (int i = 0; i < LOOKUPS / 100; i++)
+        table.Set(names[0], Value::NewInt(i));
+
+    for (int i = 0; i < READER_THREADS; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+        delete readers[i];
+    }
+
+    return (double) start.elapsed() * 1000.0 / (LOOKUPS * READER_THREADS);
+}
+
+static void Report(const char* label, double mapTime, double tableTime)
+{
+    printf("%-28s map %8.1f ns/op   table %8.1f ns/op   %5.2fx\n",
+        label, mapTime, tableTime, mapTime / tableTime);
+}
+
+int main(int argc, const char* argv[])
+{
+    for (int i = 0; i < PROPERTY_COUNT; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "property%d", i);
+        snprintf(missingNames[i], sizeof(missingNames[i]), "absent%d", i);
+    }
+
+    MapTable map;
+    PropertyTable table;
+    Fill(map);
+    Fill(table);
+
+    Report("hit", TimeLookups(map, names), TimeLookups(table, names));
+    Report("miss", TimeLookups(map, missingNames), TimeLookups(table, missingNames));
+    Report("4 readers + writer", TimeContended(map), TimeContended(table));
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+* This file has been modified from its orginal sources.
+*
+* Copyright (c) 2012 Software in the Public Interest Inc (SPI)
+* Copyright (c) 2012 David Pratt
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+***
+* Copyright (c) 2008-2012 Appcelerator Inc.
+* 
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+**/
+
+/**
+ * Measures the per-call overhead of invoking a bound method from native
+ * code: creating argument Values, building the ValueList and calling
+ * through StaticBoundMethod. Bytes.byteAt is used as the target since
+ * it does almost no work of its own.
+ *
+ * The "legacy list" row rebuilds arguments the way ArgList used to store
+ * them (a shared, heap-allocated vector) for a direct comparison. To
+ * compare Value allocation before and after, run this program against a
+ * libtide built from the previous revision.
+ */
+
+#include <tide/tide.h>
+#include <Poco/Timestamp.h>
+#include <Poco/SharedPtr.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace tide;
+
+static const int ITERATIONS = 2000000;
+
+// Keeps the compiler from discarding the work.
+static volatile int sink;
+
+static double TimeNewInt()
+{
+    Poco::Timestamp start;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        ValueRef value(Value::NewInt(i));
+        sink = value->ToInt();
+    }
+    return (double) start.elapsed() * 1000.0 / ITERATIONS;
+}
+
+static double TimeValueList()
+{
+    Poco::Timestamp start;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        ValueList args(Value::NewInt(i), Value::NewBool(true), Value::Null);
+        sink = args.size();
+    }
+    return (double) start.elapsed() * 1000.0 / ITERATIONS;
+}
+
+static double TimeLegacyList()
+{
+    Poco::Timestamp start;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        SharedPtr<std::vector<ValueRef> > args(new std::vector<ValueRef>);
+        args->push_back(Value::NewInt(i));
+        args->push_back(Value::NewBool(true));
+        args->push_back(Value::Null);
+        sink = args->size();
+    }
+    return (double) start.elapsed() * 1000.0 / ITERATIONS;
+}
+
+static double TimeByteAt()
+{
+    BytesRef bytes(new Bytes(4096));
+    memset(bytes->Pointer(), 'x', bytes->Length());
+    TiMethodRef byteAt(bytes->GetMethod("byteAt"));
+
+    Poco::Timestamp start;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        ValueRef result(byteAt->Call(ValueList(Value::NewInt(i & 4095))));
+        sink = result->ToInt();
+    }
+    return (double) start.elapsed() * 1000.0 / ITERATIONS;
+}
+
+int main(int argc, const char* argv[])
+{
+    printf("%-32s %8.1f ns/op\n", "Value::NewInt", TimeNewInt());
+    printf("%-32s %8.1f ns/op\n", "ValueList, 3 arguments", TimeValueList());
+    printf("%-32s %8.1f ns/op\n", "legacy list, 3 arguments", TimeLegacyList());
+    printf("%-32s %8.1f ns/op\n", "Bytes.byteAt call", TimeByteAt());
+    return 0;
+}
@@ -992,5 +992,116 @@ describe("API Types Tests", {
       .should_be("Mozilla 123456");
     value_of(blob.concat(blob2))
       .should_be("Mozilla");
+  },
+  test_blob_concat_chain: function () {
+    var blob = Ti.API.createBytes("Moz");
+    var joined = blob.concat("il", Ti.API.createBytes("la"));
+    value_of(joined.length)
+      .should_be(7);
+    value_of(joined.indexOf("zil"))
+      .should_be(2);
+    value_of(joined.concat(" Firefox").toString())
+      .should_be("Mozilla Firefox");
+    value_of(joined.byteAt(6))
+      .should_be(97);
+
+    var parts = Ti.API.createBytes("a::b::::c").split("::");
+    value_of(parts.length)
+      .should_be(4);
+    value_of(parts[2])
+      .should_be("");
+    value_of(parts[3])
+      .should_be("c");
+  },
+  test_blob_slice_copy_on_write: function () {
+    var blob = Ti.API.createBytes("abcdefg");
+    var slice = blob.slice(2, 3);
+    value_of(slice.toString())
+      .should_be("cde");
+    value_of(slice.write("X"))
+      .should_be(1);
+    value_of(slice.toString())
+      .should_be("Xde");
+    value_of(blob.toString())
+      .should_be("abcdefg");
+
+    // Writing to the parent must not show through in the slice either.
+    slice = blob.slice(2, 3);
+    value_of(blob.write("Y", 3))
+      .should_be(1);
+    value_of(blob.toString())
+      .should_be("abcYefg");
+    value_of(slice.toString())
+      .should_be("cde");
+  },
+  test_blob_concat_write_input: function () {
+    var blob = Ti.API.createBytes("Moz");
+    var blob2 = Ti.API.createBytes("illa");
+    var joined = blob.concat(blob2);
+    blob.write("X");
+    blob2.write("Y", 3);
+    value_of(blob.toString())
+      .should_be("Xoz");
+    value_of(joined.toString())
+      .should_be("Mozilla");
+
+    var single = blob.concat();
+    blob.write("M");
+    value_of(single.toString())
+      .should_be("Xoz");
+  },
+  test_blob_arrays: function () {
+    var blob = Ti.API.createBytes([104, 105, 0, 255]);
+    value_of(blob.length)
+      .should_be(4);
+    value_of(blob.byteAt(3))
+      .should_be(255);
+
+    var array = blob.toArray();
+    value_of(array)
+      .should_be_array();
+    value_of(array.length)
+      .should_be(4);
+    value_of(array[0])
+      .should_be(104);
+    value_of(array[3])
+      .should_be(255);
+    value_of(blob.toArray(1, 2).join(","))
+      .should_be("105,0");
+
+    var typed = new Uint8Array([65, 66, 67]);
+    var fromTyped = Ti.API.createBytes(typed);
+    value_of(fromTyped.toString())
+      .should_be("ABC");
+    value_of(new Uint8Array(fromTyped.toArray())[2])
+      .should_be(67);
+
+    var target = Ti.API.createBytes("abcdef");
+    value_of(target.write([88, 89], 2))
+      .should_be(2);
+    value_of(target.write(typed, 4))
+      .should_be(2);
+    value_of(target.toString())
+      .should_be("abXYAB");
+    value_of(target.toArray === blob.toArray)
+      .should_be_true();
+
+    var threw = false;
+    try {
+      blob.toArray(-1);
+    } catch (e) {
+      threw = true;
+    }
+    value_of(threw)
+      .should_be_true();
+
+    threw = false;
+    try {
+      target.write({length: -1});
+    } catch (e) {
+      threw = true;
+    }
+    value_of(threw)
+      .should_be_true();
   }
 });
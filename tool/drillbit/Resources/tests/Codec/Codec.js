@@ -46,6 +46,40 @@ describe("Codec Tests", {
       .should_be("abc");
   },
 
+  test_base64_line_breaks: function () {
+    var data = new Array(61).join("a");
+    var line = "YWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFhYWFh";
+    value_of(Ti.Codec.encodeBase64(data))
+      .should_be(line + "\n" + "YWFhYWFh");
+    value_of(Ti.Codec.encodeBase64(data, {lineLength: 0}))
+      .should_be(line + "YWFhYWFh");
+    value_of(Ti.Codec.decodeBase64(line + "\r\n" + "YWFhYWFh"))
+      .should_be(data);
+  },
+
+  test_base64_url_safe: function () {
+    var bytes = Ti.Codec.decodeBase64("+/+/", {asBytes: true});
+    value_of(bytes.length)
+      .should_be(3);
+    value_of(bytes.byteAt(0))
+      .should_be(0xfb);
+    value_of(Ti.Codec.encodeBase64(bytes, {urlSafe: true}))
+      .should_be("-_-_");
+    value_of(Ti.Codec.encodeBase64("abcd", {urlSafe: true}))
+      .should_be("YWJjZA");
+    value_of(Ti.Codec.decodeBase64("YWJjZA", {urlSafe: true}))
+      .should_be("abcd");
+
+    var threw = false;
+    try {
+      Ti.Codec.decodeBase64("-_-_");
+    } catch (e) {
+      threw = true;
+    }
+    value_of(threw)
+      .should_be_true();
+  },
+
   test_md2: function () {
     value_of(Ti.Codec.digestToHex(Ti.Codec.MD2, "abc"))
       .should_be("da853b0d3f88d99b30283a69e6ded6bb");
@@ -66,6 +100,16 @@ describe("Codec Tests", {
       .should_be("a9993e364706816aba3e25717850c26c9cd0d89d");
   },
 
+  test_sha256: function () {
+    value_of(Ti.Codec.digestToHex(Ti.Codec.SHA256, "abc"))
+      .should_be("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  },
+
+  test_sha512: function () {
+    value_of(Ti.Codec.digestToHex(Ti.Codec.SHA512, "abc"))
+      .should_be("ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+  },
+
   test_hmac_md5: function () {
     value_of(Ti.Codec.digestHMACToHex(Ti.Codec.MD5, "abc", "123"))
       .should_be("ffb7c0fc166f7ca075dfa04d59aed232");
@@ -76,6 +120,29 @@ describe("Codec Tests", {
       .should_be("540b0c53d4925837bd92b3f71abe7a9d70b676c4");
   },
 
+  test_hmac_sha256: function () {
+    value_of(Ti.Codec.digestHMACToHex(Ti.Codec.SHA256, "abc", "123"))
+      .should_be("8f16771f9f8851b26f4d460fa17de93e2711c7e51337cb8a608a0f81e1c1b6ae");
+  },
+
+  test_streaming_digest: function () {
+    var digest = Ti.Codec.createDigest(Ti.Codec.SHA256);
+    digest.update("abc");
+    digest.update(Ti.API.createBytes("def"));
+    value_of(digest.digest())
+      .should_be("bef57ec7f53a6d40beb640a780a639c83bc29ac8a9816f1fc6c5c6dcd93c4721");
+
+    // digest() starts the object over again.
+    digest.update("abc");
+    value_of(digest.digest())
+      .should_be("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    digest.update("junk");
+    digest.reset();
+    value_of(digest.digest())
+      .should_be(Ti.Codec.digestToHex(Ti.Codec.SHA256, ""));
+  },
+
   test_encode_hex_binary: function () {
     value_of(Ti.Codec.encodeHexBinary("ABCDEF"))
       .should_be("414243444546");
@@ -86,6 +153,25 @@ describe("Codec Tests", {
       .should_be("ABCDEF");
   },
 
+  test_hex_binary_bytes: function () {
+    var hex = Ti.Codec.encodeHexBinary(Ti.API.createBytes("ABC"), {asBytes: true});
+    value_of(hex.length)
+      .should_be(6);
+    value_of(hex.toString())
+      .should_be("414243");
+    value_of(Ti.Codec.decodeHexBinary("41 42\n4a"))
+      .should_be("ABJ");
+
+    var threw = false;
+    try {
+      Ti.Codec.decodeHexBinary("4G");
+    } catch (e) {
+      threw = true;
+    }
+    value_of(threw)
+      .should_be_true();
+  },
+
   test_checksum_crc32: function () {
     value_of(Ti.Codec.checksum("abc"))
       .should_be(891568578);
@@ -105,6 +191,40 @@ describe("Codec Tests", {
       .should_be(38600999);
   },
 
+  test_checksum_crc32c: function () {
+    var checksum = Ti.Codec.createChecksum(Ti.Codec.CRC32C);
+    checksum.update("1234");
+    checksum.update(Ti.API.createBytes("56789"));
+    value_of(checksum.getValue())
+      .should_be(3808858755);
+
+    var crc32 = Ti.Codec.createChecksum();
+    crc32.update("a");
+    crc32.update("bc");
+    value_of(crc32.getValue())
+      .should_be(Ti.Codec.checksum("abc"));
+  },
+
+  test_digestFile_as_async: function (callback) {
+    var path = Ti.App.appURLToPath("app://zipdir/file1.txt");
+
+    var timer = 0;
+    Ti.Codec.digestFile(Ti.Codec.SHA1, path, function (digest) {
+      clearTimeout(timer);
+      try {
+        value_of(digest)
+          .should_be("51c79e08a7986b23085fddd9c6d284a3a591efda");
+        callback.passed();
+      } catch (e) {
+        callback.failed(e);
+      }
+    });
+
+    timer = setTimeout(function () {
+      callback.failed("timed out waiting for digestFile callback");
+    }, 5000);
+  },
+
   test_createZip_as_async: function (callback) {
     var fs = Ti.Filesystem;
 
@@ -136,10 +256,10 @@ describe("Codec Tests", {
           .should_be(zipFile);
         var file = fs.getFile(destFile);
         value_of(file.size())
-          .should_be(5791);
+          .should_be(5786);
         var blob = file.read();
         value_of(blob.length)
-          .should_be(5791);
+          .should_be(5786);
 
         // in OSX, the the file contents seem to change each time the zip is created
         // so, a SHA1 is unreliable (weird). We'll just check the files
@@ -233,6 +353,27 @@ describe("Codec Tests", {
       }
     });
 
+    timer = setTimeout(function () {
+      callback.failed("timed out waiting for extract zip callback");
+    }, 5000);
+  },
+
+  test_extractZip_progress_as_async: function (callback) {
+    var zipFile = Ti.App.appURLToPath("app://stuff.zip");
+    var destDir = Ti.Filesystem.createTempDirectory();
+
+    var timer = 0;
+    var job = Ti.Codec.extractZip(zipFile, destDir, function (dest) {
+      clearTimeout(timer);
+      try {
+        value_of(job.getProgress())
+          .should_be(1);
+        callback.passed();
+      } catch (e) {
+        callback.failed(e);
+      }
+    });
+
     timer = setTimeout(function () {
       callback.failed("timed out waiting for extract zip callback");
     }, 5000);
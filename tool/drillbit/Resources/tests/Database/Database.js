@@ -465,6 +465,289 @@ describe("Database Tests", {
     datab.remove();
     value_of(file.exists())
       .should_be_false();
+  },
+  test_execute_many: function () {
+    this.db.execute("CREATE TABLE MANY (name TEXT, size INT)");
+ 
+    var rows = [];
+    for (var i = 0; i < 1000; i++) {
+      rows.push(['row' + i, i]);
+    }
+    this.db.executeMany("insert into MANY values (?,?)", rows);
+    value_of(this.db.rowsAffected)
+      .should_be(1000);
+    value_of(this.db.lastInsertRowId)
+      .should_be(1000);
+ 
+    // single values don't need to be wrapped in an array
+    this.db.executeMany("delete from MANY where size = ?", [0, 1, 2]);
+    value_of(this.db.rowsAffected)
+      .should_be(3);
+ 
+    var rs = this.db.execute("select count(*), sum(size) from MANY");
+    value_of(rs.field(0))
+      .should_be(997);
+    value_of(rs.field(1))
+      .should_be(499497);
+    rs.close();
+ 
+    // a failing row rolls back the whole batch
+    var ok = false;
+    try {
+      this.db.executeMany("insert into MANY values (?,?)", [['x', 1], ['y', 2, 3]]);
+    } catch (e) {
+      ok = true;
+    }
+    value_of(ok)
+      .should_be_true();
+    rs = this.db.execute("select count(*) from MANY where name = 'x'");
+    value_of(rs.field(0))
+      .should_be(0);
+    rs.close();
+ 
+    this.db.execute("DROP TABLE MANY");
+  },
+  test_transaction: function () {
+    this.db.execute("CREATE TABLE TX (name TEXT)");
+ 
+    var result = this.db.transaction(function (db) {
+      db.execute("insert into TX values (?)", 'committed');
+      return 42;
+    });
+    value_of(result)
+      .should_be(42);
+ 
+    var ok = false;
+    try {
+      this.db.transaction(function (db) {
+        db.execute("insert into TX values (?)", 'rolled back');
+        throw "failure";
+      });
+    } catch (e) {
+      ok = true;
+    }
+    value_of(ok)
+      .should_be_true();
+ 
+    // a failing nested transaction only undoes its own work
+    this.db.transaction(function (db) {
+      db.execute("insert into TX values (?)", 'outer');
+      try {
+        db.transaction(function (db) {
+          db.execute("insert into TX values (?)", 'inner');
+          throw "failure";
+        });
+      } catch (e) {
+      }
+    });
+ 
+    var rs = this.db.execute("select name from TX order by rowid");
+    value_of(rs.rowCount())
+      .should_be(2);
+    value_of(rs.field(0))
+      .should_be('committed');
+    rs.next();
+    value_of(rs.field(0))
+      .should_be('outer');
+    rs.close();
+ 
+    this.db.execute("DROP TABLE TX");
+  },
+  test_statement_reuse: function () {
+    this.db.execute("CREATE TABLE REUSE (size INT)");
+    for (var i = 0; i < 100; i++) {
+      this.db.execute("insert into REUSE values (?)", i);
+      value_of(this.db.lastInsertRowId)
+        .should_be(i + 1);
+      value_of(this.db.rowsAffected)
+        .should_be(1);
+    }
+ 
+    // the same query must see fresh bindings each time
+    for (var i = 0; i < 5; i++) {
+      var rs = this.db.execute("select size from REUSE where size = ?", i * 10);
+      value_of(rs.field(0))
+        .should_be(i * 10);
+      rs.close();
+    }
+ 
+    this.db.execute("DROP TABLE REUSE");
+  },
+  test_query_cursor: function () {
+    this.db.execute("CREATE TABLE CURSOR (name TEXT, size INT)");
+    var rows = [];
+    for (var i = 0; i < 500; i++) {
+      rows.push(['row' + i, i]);
+    }
+    this.db.executeMany("insert into CURSOR values (?,?)", rows);
+ 
+    var rs = this.db.query("select name, size from CURSOR where size >= ? order by size", 100);
+    value_of(rs.isValidRow())
+      .should_be_true();
+    value_of(rs.fieldCount())
+      .should_be(2);
+    value_of(rs.fieldByName('name'))
+      .should_be('row100');
+    rs.next();
+    value_of(rs.field(1))
+      .should_be(101);
+ 
+    var batch = rs.fetchAll(10);
+    value_of(batch)
+      .should_be_array();
+    value_of(batch.length)
+      .should_be(10);
+    value_of(batch[0][0])
+      .should_be('row101');
+    value_of(batch[9][1])
+      .should_be(110);
+    value_of(rs.field(1))
+      .should_be(111);
+ 
+    var columns = rs.fetchColumns(5);
+    value_of(columns.name.length)
+      .should_be(5);
+    value_of(columns.name[0])
+      .should_be('row111');
+    value_of(columns.size[4])
+      .should_be(115);
+ 
+    var rest = rs.fetchAll();
+    value_of(rest.length)
+      .should_be(384);
+    value_of(rest[383][1])
+      .should_be(499);
+    value_of(rs.isValidRow())
+      .should_be_false();
+    value_of(rs.fetchAll().length)
+      .should_be(0);
+    rs.close();
+ 
+    // rowCount reads ahead without losing the current row
+    rs = this.db.query("select size from CURSOR order by size");
+    value_of(rs.rowCount())
+      .should_be(500);
+    value_of(rs.field(0))
+      .should_be(0);
+    value_of(rs.fetchAll().length)
+      .should_be(500);
+    rs.close();
+ 
+    // statements which return no rows run straight away
+    rs = this.db.query("delete from CURSOR where size < ?", 250);
+    value_of(rs.isValidRow())
+      .should_be_false();
+    value_of(this.db.rowsAffected)
+      .should_be(250);
+ 
+    this.db.execute("DROP TABLE CURSOR");
+  },
+  test_query_cursor_outlives_database: function () {
+    var db = Ti.Database.open("test_cursor_db");
+    db.execute("CREATE TABLE IF NOT EXISTS T (size INT)");
+    db.executeMany("insert into T values (?)", [1, 2, 3]);
+ 
+    var rs = db.query("select size from T order by size");
+    value_of(rs.field(0))
+      .should_be(1);
+    db.close();
+ 
+    // the row which was already read is still there, but no more
+    value_of(rs.field(0))
+      .should_be(1);
+    rs.next();
+    value_of(rs.isValidRow())
+      .should_be_false();
+    rs.close();
+ 
+    db = Ti.Database.open("test_cursor_db");
+    db.remove();
+  },
+  test_connection_options: function () {
+    // WebKit's databases keep sqlite's journal unless asked otherwise.
+    var db = Ti.Database.open("test_options_db");
+    var rs = db.execute("PRAGMA journal_mode");
+    value_of(rs.field(0))
+      .should_be('delete');
+    rs.close();
+    db.close();
+ 
+    var datadir = Ti.Filesystem.getApplicationDataDirectory();
+    var testFile = Ti.Filesystem.getFile(datadir, "test_options_file.db");
+    var fileDB = Ti.Database.openFile(testFile);
+    rs = fileDB.execute("PRAGMA journal_mode");
+    value_of(rs.field(0))
+      .should_be('wal');
+    rs.close();
+    fileDB.remove();
+ 
+    db = Ti.Database.open("test_options_db", {
+      synchronous: 'full',
+      cacheSize: 500
+    });
+    rs = db.execute("PRAGMA synchronous");
+    value_of(rs.field(0))
+      .should_be(2);
+    rs.close();
+    rs = db.execute("PRAGMA cache_size");
+    value_of(rs.field(0))
+      .should_be(500);
+    rs.close();
+    db.remove();
+ 
+    var ok = false;
+    try {
+      Ti.Database.open("test_options_db", { journalMode: 'WAL; DROP TABLE X' });
+    } catch (e) {
+      ok = true;
+    }
+    value_of(ok)
+      .should_be_true();
+  },
+  test_execute_async_as_async: function (callback) {
+    var db = Ti.Database.open("test_async_db");
+    db.execute("CREATE TABLE IF NOT EXISTS ASYNC (name TEXT, size INT)");
+    db.executeMany("insert into ASYNC values (?,?)", [['a', 1], ['b', 2], ['c', 3]]);
+ 
+    var timer = setTimeout(function () {
+      db.remove();
+      callback.failed("executeAsync callback was not called");
+    }, 5000);
+ 
+    db.executeAsync("select name from ASYNC where size >= ? order by size", 2,
+      function (rs, error) {
+      try {
+        value_of(error)
+          .should_be_undefined();
+        value_of(rs.rowCount())
+          .should_be(2);
+        value_of(rs.field(0))
+          .should_be('b');
+        value_of(db.rowsAffected)
+          .should_be(2);
+        rs.close();
+      } catch (e) {
+        clearTimeout(timer);
+        db.remove();
+        callback.failed(e);
+        return;
+      }
+ 
+      db.executeAsync("select * from NO_SUCH_TABLE", function (rs, error) {
+        clearTimeout(timer);
+        try {
+          value_of(rs)
+            .should_be_null();
+          value_of(error)
+            .should_be_string();
+          db.remove();
+          callback.passed();
+        } catch (e) {
+          db.remove();
+          callback.failed(e);
+        }
+      });
+    });
   }
  
 });
\ No newline at end of file
@@ -419,6 +419,82 @@ describe("Network.HTTPClient", {
     });
   },
 
+  test_receive_to_file_as_async: function (callback) {
+    var timer = 0;
+    var file = Ti.Filesystem.createTempFile();
+    var client = this.client;
+
+    this.client.addEventListener(Ti.HTTP_DONE, function () {
+      try {
+        value_of(file.size())
+          .should_be(64 * 65536);
+        value_of(client.responseData)
+          .should_be_null();
+
+        clearTimeout(timer);
+        callback.passed();
+      } catch (e) {
+        clearTimeout(timer);
+        callback.failed(e);
+      }
+    });
+
+    timer = setTimeout(function () {
+      callback.failed('Receive to file test timed out');
+    }, 20000);
+
+    this.client.open("GET", this.url + "bigdata");
+    this.client.receive(file);
+  },
+
+  test_receive_slow_handler_as_async: function (callback) {
+    var timer = 0;
+    var received = 0;
+    var chunks = 0;
+
+    // Keep very little in flight, so the transfer has to be paused
+    // while the handler is busy.
+    this.client.setMaxBufferedData(16 * 1024);
+    value_of(this.client.getMaxBufferedData())
+      .should_be(16 * 1024);
+
+    this.client.addEventListener(Ti.HTTP_DONE, function () {
+      try {
+        value_of(received)
+          .should_be(64 * 65536);
+        value_of(chunks)
+          .should_be_greater_than(1);
+
+        clearTimeout(timer);
+        callback.passed();
+      } catch (e) {
+        clearTimeout(timer);
+        callback.failed(e);
+      }
+    });
+
+    timer = setTimeout(function () {
+      callback.failed('Slow handler test timed out');
+    }, 30000);
+
+    this.client.open("GET", this.url + "bigdata");
+    this.client.receive(function (data) {
+      var start = new Date().getTime();
+      while (new Date().getTime() - start < 2) {}
+      received += data.length;
+      chunks++;
+    });
+  },
+
+  test_response_text_is_complete: function () {
+    this.client.open("GET", this.url + "bigdata", false);
+    this.client.send(null);
+    value_of(this.client.responseText.length)
+      .should_be(64 * 65536);
+    value_of(this.client.responseData.length)
+      .should_be(64 * 65536);
+  },
+
   test_send_cookie: function () {
     this.client.setCookie("peanutbutter", "yummy");
     this.client.open("GET", this.url + "sendcookie", false);
@@ -611,5 +687,55 @@ describe("Network.HTTPClient", {
     timer = setTimeout(function () {
       callback.failed('Test timed out');
     }, 10000);
+  },
+
+  test_many_requests_share_connections_as_async: function (callback) {
+    var count = 50;
+    var finished = 0;
+    var text = this.text;
+    var limit = Ti.Network.getHTTPMaxConnectionsPerHost();
+    var before = Ti.Network.getHTTPClientStats();
+
+    // Only two connections to the test server, so most requests
+    // have to wait for one of those to become free.
+    Ti.Network.setHTTPMaxConnectionsPerHost(2);
+    value_of(Ti.Network.getHTTPMaxConnectionsPerHost())
+      .should_be(2);
+
+    var timer = setTimeout(function () {
+      Ti.Network.setHTTPMaxConnectionsPerHost(limit);
+      callback.failed('Test timed out after ' + finished + ' requests');
+    }, 20000);
+
+    function onload() {
+      if (this.responseText != text) {
+        clearTimeout(timer);
+        Ti.Network.setHTTPMaxConnectionsPerHost(limit);
+        callback.failed("Unexpected response: " + this.responseText);
+        return;
+      }
+
+      finished++;
+      if (finished == count) {
+        clearTimeout(timer);
+        Ti.Network.setHTTPMaxConnectionsPerHost(limit);
+        var stats = Ti.Network.getHTTPClientStats();
+        if (stats.completed - before.completed < count) {
+          callback.failed("Only " + (stats.completed - before.completed) +
+            " transfers completed");
+        } else if (stats.reusedHandles == before.reusedHandles) {
+          callback.failed("No cURL handles were reused");
+        } else {
+          callback.passed();
+        }
+      }
+    }
+
+    for (var i = 0; i < count; i++) {
+      var client = Ti.Network.createHTTPClient();
+      client.onload = onload;
+      client.open("GET", this.url);
+      client.send();
+    }
   }
 });
\ No newline at end of file
@@ -155,6 +155,16 @@ class MyHandler(BaseHTTPServer.BaseHTTPRequestHandler):
 
 		self.send_text('I got it!');
 
+	# Send a large response in many chunks
+	def send_big_data(self):
+		block = 'x' * 65535 + '\n'
+		self.send_response(200)
+		self.send_header("Content-type", "text/plain")
+		self.send_header("Content-Length", len(block) * 64)
+		self.end_headers()
+		for i in range(64):
+			self.wfile.write(block)
+
 	def recv_file(self):
 		correct_text = """Just some test text that will be sent
 to the http server to verify file sending works
@@ -189,6 +199,7 @@ with the http client.
 		'/requestheaders': recv_headers,
 		'/responseheaders': send_headers,
 		'/continue': send_continue_headers,
+		'/bigdata': send_big_data,
 	}
 
 if __name__ == '__main__':
@@ -212,5 +212,80 @@ describe("Network.HTTPServer", {
     };
     xhr.open("GET", "http://127.0.0.1:8082/foo");
     xhr.send(null);
+  },
+  static_files_as_async: function (callback) {
+    var blob = Ti.Filesystem.getFile(
+    Ti.API.application.resourcesPath, "test.bin")
+      .read();
+
+    var server = Ti.Network.createHTTPServer();
+    server.bind(8082, {
+      staticFiles: { "/files": Ti.API.application.resourcesPath }
+    });
+
+    var xhr = Ti.Network.createHTTPClient();
+    xhr.onload = function () {
+      try {
+        value_of(this.status)
+          .should_be(200);
+        value_of(this.getResponseHeader('Content-Type'))
+          .should_be('application/octet-stream');
+        value_of(this.responseData.length)
+          .should_be(blob.length);
+
+        var missing = Ti.Network.createHTTPClient();
+        missing.open("GET", "http://127.0.0.1:8082/files/../test.bin", false);
+        missing.send(null);
+        value_of(missing.status)
+          .should_be(404);
+
+        server.close();
+        callback.passed();
+      } catch (e) {
+        server.close();
+        callback.failed(e);
+      }
+    };
+    xhr.open("GET", "http://127.0.0.1:8082/files/test.bin");
+    xhr.send(null);
+  },
+  handler_script_as_async: function (callback) {
+    var server = Ti.Network.createHTTPServer();
+    server.bind(8082, {
+      maxThreads: 4,
+      maxQueued: 16,
+      keepAlive: true,
+      handlerScript: Ti.API.application.resourcesPath + "/server_handler.js"
+    });
+
+    var count = 20;
+    var finished = 0;
+    var timer = setTimeout(function () {
+      server.close();
+      callback.failed('Test timed out after ' + finished + ' requests');
+    }, 20000);
+
+    function onload() {
+      if (this.responseText != "handled /req") {
+        clearTimeout(timer);
+        server.close();
+        callback.failed("Unexpected response: " + this.responseText);
+        return;
+      }
+
+      finished++;
+      if (finished == count) {
+        clearTimeout(timer);
+        server.close();
+        callback.passed();
+      }
+    }
+
+    for (var i = 0; i < count; i++) {
+      var xhr = Ti.Network.createHTTPClient();
+      xhr.onload = onload;
+      xhr.open("GET", "http://127.0.0.1:8082/req");
+      xhr.send(null);
+    }
   }
-});
+});
\ No newline at end of file
@@ -0,0 +1,7 @@
+function handleRequest(request, response) {
+  var body = "handled " + request.getURI();
+  response.setContentType('text/plain');
+  response.setContentLength(body.length);
+  response.setStatusAndReason('200', 'OK');
+  response.write(body);
+}
@@ -149,5 +149,67 @@ describe("Network.TCPSocket Tests", {
     timer = setTimeout(function () {
       test.failed("Test timed out");
     }, 2000);
+  },
+  test_connection_scaling_as_async: function (test) {
+    // Every socket shares the network reactor, so opening many of them at
+    // once should not need a thread per connection.
+    var count = 100;
+    var echoed = 0;
+    var done = false;
+    var start = new Date().getTime();
+    var sockets = [];
+    var timer;
+
+    function finish(error) {
+      if (done) return;
+      done = true;
+      clearTimeout(timer);
+      for (var i = 0; i < sockets.length; i++) {
+        if (!sockets[i].isClosed())
+          sockets[i].close();
+      }
+      if (error) {
+        test.failed(error);
+        return;
+      }
+      Ti.API.info(count + " sockets echoed in " +
+        (new Date().getTime() - start) + "ms");
+      test.passed();
+    }
+
+    function openSocket(index) {
+      var message = "socket " + index;
+      var received = "";
+      var socket = Ti.Network.createTCPSocket("127.0.0.1", 8080);
+      sockets.push(socket);
+      socket.on("connect", function () {
+        socket.write(message);
+      });
+      socket.on("data", function (data) {
+        received += data.toString();
+        if (received.length < message.length) return;
+        try {
+          value_of(received)
+            .should_be(message);
+        } catch (e) {
+          finish(e);
+          return;
+        }
+        socket.close();
+        if (++echoed == count)
+          finish();
+      });
+      socket.on("error", function (err) {
+        finish(err);
+      });
+      socket.connect();
+    }
+
+    for (var i = 0; i < count; i++)
+      openSocket(i);
+
+    timer = setTimeout(function () {
+      finish("Test timed out after " + echoed + " of " + count + " echoes");
+    }, 20000);
   }
 });
\ No newline at end of file
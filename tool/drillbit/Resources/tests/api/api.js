@@ -481,6 +481,41 @@ describe("API Tests", {
 
   },
 
+  test_api_event_listener_order: function () {
+    var calls = [];
+    var first = function () { calls.push("first"); };
+    var second = function () { calls.push("second"); };
+    var all = function (e) {
+      if (e.getType().indexOf("order.") === 0) {
+        calls.push("all");
+      }
+    };
+
+    // Listeners for one event and for all events run in the order they
+    // were added, even though they are stored separately.
+    Ti.API.addEventListener("order.a", first);
+    Ti.API.addEventListener(all);
+    Ti.API.addEventListener("order.a", second);
+
+    Ti.API.fireEvent("order.a");
+    value_of(calls.join(",")).should_be("first,all,second");
+
+    calls = [];
+    Ti.API.fireEvent("order.b");
+    value_of(calls.join(",")).should_be("all");
+
+    calls = [];
+    Ti.API.removeEventListener("order.a", first);
+    Ti.API.removeEventListener("all", all);
+    Ti.API.fireEvent("order.a");
+    value_of(calls.join(",")).should_be("second");
+
+    Ti.API.removeEventListener("order.a", second);
+    calls = [];
+    Ti.API.fireEvent("order.a");
+    value_of(calls.length).should_be(0);
+  },
+
   test_api_global_object: function () {
     // set a global object
     Ti.API.set("foo", "bar");
@@ -506,5 +541,102 @@ describe("API Tests", {
     Ti.API.runOnMainThread(test, "works!");
     value_of(Ti.API.foo)
       .should_be("works!");
+  },
+
+  test_thread_pool_stats: function () {
+    value_of(Ti.API.getThreadPoolStats)
+      .should_be_function();
+
+    var stats = Ti.API.getThreadPoolStats();
+    value_of(stats)
+      .should_be_object();
+    value_of(stats.threads)
+      .should_be_number();
+    value_of(stats.queued)
+      .should_be_number();
+    value_of(stats.executed)
+      .should_be_number();
+    value_of(stats.stolen)
+      .should_be_number();
+    value_of(stats.averageWaitTime)
+      .should_be_number();
+  },
+
+  test_main_thread_queue_stats: function () {
+    value_of(Ti.API.getMainThreadQueueStats)
+      .should_be_function();
+
+    Ti.API.runOnMainThreadAsync(function () {});
+
+    var stats = Ti.API.getMainThreadQueueStats();
+    value_of(stats.depth)
+      .should_be_number();
+    value_of(stats.executed)
+      .should_be_number();
+    value_of(stats.latency.length)
+      .should_be(10);
+
+    var budget = Ti.API.getMainThreadJobBudget();
+    Ti.API.setMainThreadJobBudget(5);
+    value_of(Ti.API.getMainThreadJobBudget())
+      .should_be(5);
+    Ti.API.setMainThreadJobBudget(budget);
+  },
+
+  test_native_object_identity: function () {
+    value_of(Ti.API === Ti.API)
+      .should_be_true();
+    value_of(Ti.API.log === Ti.API.log)
+      .should_be_true();
+    var api = Ti.API;
+    value_of(api === Ti.API)
+      .should_be_true();
+    value_of('toString' in Ti.API)
+      .should_be_true();
+    value_of('equals' in Ti.API)
+      .should_be_true();
+  },
+
+  test_profiler: function () {
+    value_of(Ti.API.startProfiling)
+      .should_be_function();
+
+    Ti.API.startProfiling();
+    value_of(Ti.API.isProfiling())
+      .should_be_true();
+    for (var i = 0; i < 10; i++) {
+      Ti.API.getMainThreadJobBudget();
+    }
+    Ti.API.stopProfiling();
+    value_of(Ti.API.isProfiling())
+      .should_be_false();
+
+    var stats = Ti.API.getProfileStats();
+    value_of(stats.events)
+      .should_be_number();
+
+    var found = null;
+    for (var i = 0; i < stats.paths.length; i++) {
+      var path = stats.paths[i];
+      if (path.path == "API.getMainThreadJobBudget" && path.type == "call") {
+        found = path;
+      }
+    }
+    value_of(found)
+      .should_not_be_null();
+    value_of(found.count >= 10)
+      .should_be_true();
+    value_of(found.histogram.length)
+      .should_be(10);
+
+    var traceFile = Ti.Filesystem.createTempFile();
+    Ti.API.writeProfileTrace(traceFile.nativePath());
+    var trace = JSON.parse(traceFile.read().toString());
+    value_of(trace.traceEvents.length > 0)
+      .should_be_true();
+
+    Ti.API.clearProfile();
+    value_of(Ti.API.getProfileStats().paths.length)
+      .should_be(0);
   }
 });
\ No newline at end of file
@@ -199,6 +199,74 @@ describe("Ti.Filesystem FileStream tests", {
     value_of(textToWrite + textToAppend)
       .should_be(textRead);
   },
+
+  mapped_read_line: function () {
+    var filename = "mappedReadTestFile.txt";
+    var fs = Ti.Filesystem.getFileStream(this.base, filename);
+    fs.open(Ti.Filesystem.MODE_WRITE);
+    fs.write("first\r\n\nthird\nlast");
+    fs.close();
+
+    value_of(fs.MODE_MAPPED)
+      .should_be(Ti.Filesystem.MODE_MAPPED);
+
+    fs.open(Ti.Filesystem.MODE_MAPPED);
+    value_of(fs.ready())
+      .should_be_true();
+    value_of(fs.readLine().toString())
+      .should_be("first");
+    value_of(fs.readLine().toString())
+      .should_be("");
+    value_of(fs.readLine().toString())
+      .should_be("third");
+    value_of(fs.readLine().toString())
+      .should_be("last");
+    value_of(fs.readLine())
+      .should_be_null();
+    value_of(fs.ready())
+      .should_be_false();
+
+    fs.seek(2, Ti.Filesystem.SEEK_START);
+    value_of(fs.read(3).toString())
+      .should_be("rst");
+    value_of(fs.tell())
+      .should_be(5);
+    value_of(fs.read().toString())
+      .should_be("\r\n\nthird\nlast");
+    value_of(fs.read(3))
+      .should_be_null();
+
+    // Lines stay usable after the stream is closed.
+    fs.seek(0, Ti.Filesystem.SEEK_START);
+    var line = fs.readLine();
+    fs.close();
+    value_of(line.toString())
+      .should_be("first");
+  },
+
+  flush_sync: function () {
+    var filename = "flushTestFile.txt";
+    var fs = Ti.Filesystem.getFileStream(this.base, filename);
+    var f = Ti.Filesystem.getFile(this.base, filename);
+
+    fs.open(Ti.Filesystem.MODE_WRITE);
+    fs.write("buffered");
+    value_of(fs.tell())
+      .should_be(8);
+    fs.flush();
+    value_of(f.size())
+      .should_be(8);
+    fs.write(" and synced");
+    fs.sync();
+    value_of(f.size())
+      .should_be(19);
+    fs.close();
+
+    fs.open(Ti.Filesystem.MODE_READ);
+    value_of(function () { fs.flush(); })
+      .should_throw_exception();
+    fs.close();
+  },
   // old JIRA issues for regression
   TI328_open_and_write_filestream: function () {
     var filename = ".data.txt";
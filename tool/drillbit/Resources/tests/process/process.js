@@ -477,6 +477,62 @@ describe("Process Tests", {
     o.close();
   },
 
+  test_stdin_round_trip_latency_as_async: function (callback) {
+    // more.com buffers its input, so only measure this with cat.
+    if (Ti.platform == "win32") {
+      callback.passed();
+      return;
+    }
+
+    var p = Ti.Process.createProcess(this.moreCmd);
+    var roundTrips = 20;
+    var completed = 0;
+    var received = "";
+    var sentAt = 0;
+    var totalLatency = 0;
+    var timer = 0;
+
+    function send() {
+      sentAt = new Date().getTime();
+      p.stdin.write("ping\n");
+    }
+
+    p.setOnRead(function (event) {
+      received += event.data.toString();
+      while (received.indexOf("\n") != -1) {
+        received = received.substring(received.indexOf("\n") + 1);
+        totalLatency += new Date().getTime() - sentAt;
+        completed++;
+        if (completed < roundTrips) {
+          send();
+          return;
+        }
+
+        clearTimeout(timer);
+        p.kill();
+        var average = totalLatency / roundTrips;
+        Ti.API.info("stdin round trip latency: " + average + "ms average");
+        try {
+          // Writes used to wait on a 50ms poll, so this would regularly fail.
+          value_of(average)
+            .should_be_less_than(45);
+        } catch (e) {
+          callback.failed(e);
+          return;
+        }
+        callback.passed();
+        return;
+      }
+    });
+    p.launch();
+    send();
+
+    timer = setTimeout(function () {
+      if (p.isRunning()) p.kill();
+      callback.failed("Timed out after " + completed + " round trips");
+    }, 10000);
+  },
+
   test_environment: function () {
     var env = Ti.API.getEnvironment();
     value_of(env["foobar"])
@@ -596,6 +652,140 @@ describe("Process Tests", {
     }, 5000);
   },
 
+  test_concurrent_processes_as_async: function (test) {
+    var count = 50;
+    var exited = 0;
+    var timer = null;
+    var echoCmd = this.echoCmd;
+
+    function launch(index) {
+      var p = Ti.Process.createProcess(echoCmd.concat(["process" + index]));
+      var output = "";
+      p.setOnRead(function (event) {
+        output += event.data.toString();
+      });
+      p.setOnExit(function (event) {
+        try {
+          value_of(output.replace(/\s+$/, ""))
+            .should_be("process" + index);
+          value_of(p.getExitCode())
+            .should_be(0);
+        } catch (e) {
+          clearTimeout(timer);
+          test.failed(e);
+          return;
+        }
+
+        exited++;
+        if (exited == count) {
+          clearTimeout(timer);
+          test.passed();
+        }
+      });
+      p.launch();
+    }
+
+    for (var i = 0; i < count; i++)
+      launch(i);
+
+    timer = setTimeout(function () {
+      test.failed("Only " + exited + " of " + count + " processes exited");
+    }, 10000);
+  },
+
+  test_process_pool_as_async: function (test) {
+    // more.com buffers its output, so pools are only tested with cat.
+    if (Ti.platform == "win32") {
+      test.passed();
+      return;
+    }
+
+    var pool = Ti.Process.createPool(this.moreCmd, {size: 3});
+    var count = 30;
+    var responses = 0;
+    var timer = null;
+
+    function check(index, response) {
+      try {
+        value_of(response.toString())
+          .should_be("request " + index);
+      } catch (e) {
+        clearTimeout(timer);
+        pool.close();
+        test.failed(e);
+        return;
+      }
+
+      responses++;
+      if (responses < count)
+        return;
+
+      clearTimeout(timer);
+      try {
+        var stats = pool.getStats();
+        value_of(stats.size)
+          .should_be(3);
+        value_of(stats.completed)
+          .should_be(count);
+        value_of(stats.queued)
+          .should_be(0);
+        value_of(stats.restarts)
+          .should_be(0);
+        pool.close();
+        test.passed();
+      } catch (e) {
+        pool.close();
+        test.failed(e);
+      }
+    }
+
+    function send(index) {
+      pool.request("request " + index, function (response) {
+        check(index, response);
+      }, function (message) {
+        clearTimeout(timer);
+        test.failed(message);
+      });
+    }
+
+    for (var i = 0; i < count; i++)
+      send(i);
+
+    value_of(pool.getStats().running)
+      .should_be(3);
+
+    timer = setTimeout(function () {
+      pool.close();
+      test.failed("Only " + responses + " of " + count + " responses arrived");
+    }, 10000);
+  },
+
+  test_process_pool_length_framing_as_async: function (test) {
+    if (Ti.platform == "win32") {
+      test.passed();
+      return;
+    }
+
+    var pool = Ti.Process.createPool(this.moreCmd, {size: 1, framing: "length"});
+    var timer = setTimeout(function () {
+      pool.close();
+      test.failed("timed out");
+    }, 5000);
+
+    // Length framing carries newlines inside a request.
+    pool.request("two\nlines", function (response) {
+      clearTimeout(timer);
+      pool.close();
+      try {
+        value_of(response.toString())
+          .should_be("two\nlines");
+        test.passed();
+      } catch (e) {
+        test.failed(e);
+      }
+    });
+  },
+
   test_long_running_process_as_async: function (test) {
     value_of(Ti.Process)
       .should_not_be_null();